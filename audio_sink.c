@@ -0,0 +1,223 @@
+#include "audio_sink.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+
+void vadc_audio_sinks_init(VADC_Audio_Sinks *sinks, VADC_Audio_Sink_Overflow overflow, VADC_Metrics *metrics)
+{
+   memset(sinks, 0, sizeof(*sinks));
+   sinks->overflow = overflow;
+   sinks->metrics = metrics;
+}
+
+VADC_Audio_Sink *vadc_audio_sinks_add(VADC_Audio_Sinks *sinks, FILE *file)
+{
+   if (!file || sinks->running || sinks->count == VADC_AUDIO_SINK_MAX)
+   {
+      return NULL;
+   }
+
+   VADC_Audio_Sink *sink = sinks->sinks + sinks->count;
+   sink->ring = (u8 *)malloc(VADC_AUDIO_SINK_RING_BYTES);
+   if (!sink->ring)
+   {
+      return NULL;
+   }
+   sink->file = file;
+   sink->capacity = VADC_AUDIO_SINK_RING_BYTES;
+   atomic_init(&sink->head, 0);
+   atomic_init(&sink->tail, 0);
+   ++sinks->count;
+   return sink;
+}
+
+VADC_Audio_Sink *vadc_audio_sinks_find(VADC_Audio_Sinks *sinks, FILE *file)
+{
+   if (!sinks->running)
+   {
+      return NULL;
+   }
+   for (int i = 0; i < sinks->count; ++i)
+   {
+      if (sinks->sinks[i].file == file)
+      {
+         return sinks->sinks + i;
+      }
+   }
+   return NULL;
+}
+
+// NOTE: the sink's I/O thread, writes out everything the producer has published. Returns the bytes taken off the ring.
+static size_t audio_sink_drain(VADC_Audio_Sinks *sinks, VADC_Audio_Sink *sink)
+{
+   size_t head = atomic_load_explicit(&sink->head, memory_order_acquire);
+   size_t tail = atomic_load_explicit(&sink->tail, memory_order_relaxed);
+   size_t pending = head - tail;
+   if (!pending)
+   {
+      return 0;
+   }
+
+   size_t written = 0;
+   size_t offset = tail & (sink->capacity - 1);
+   size_t first = sink->capacity - offset;
+   first = first < pending ? first : pending;
+   written += fwrite(sink->ring + offset, 1, first, sink->file);
+   if (pending > first)
+   {
+      written += fwrite(sink->ring, 1, pending - first, sink->file);
+   }
+   if (fflush(sink->file) != 0 && written == pending)
+   {
+      // NOTE: the data sat in the stdio buffer and was lost on flush, count all of it
+      written = 0;
+   }
+
+   atomic_fetch_add_explicit(&sinks->written_bytes, written, memory_order_relaxed);
+   if (written < pending)
+   {
+      atomic_fetch_add_explicit(&sinks->dropped_bytes, pending - written, memory_order_relaxed);
+      VADC_METRIC_ADD(sinks->metrics, dropped_output_bytes, pending - written);
+   }
+
+   atomic_store_explicit(&sink->tail, head, memory_order_release);
+   return pending;
+}
+
+// NOTE: one per sink, a blocking fwrite to a stalled pipe holds up only this ring
+static void *audio_sink_proc(void *param)
+{
+   VADC_Audio_Sink *sink = param;
+   VADC_Audio_Sinks *sinks = sink->sinks;
+   const int idle_sleep_ms = 2;
+
+   for (;;)
+   {
+      // NOTE: read before draining, everything published before quit was set is then written out
+      int quit = atomic_load(&sinks->quit);
+
+      if (!audio_sink_drain(sinks, sink))
+      {
+         if (quit)
+         {
+            break;
+         }
+         poll(NULL, 0, idle_sleep_ms);
+      }
+   }
+   return NULL;
+}
+
+static void audio_sinks_join(VADC_Audio_Sinks *sinks)
+{
+   atomic_store(&sinks->quit, 1);
+   for (int i = 0; i < sinks->count; ++i)
+   {
+      VADC_Audio_Sink *sink = sinks->sinks + i;
+      if (sink->running)
+      {
+         pthread_join(sink->thread, NULL);
+         sink->running = 0;
+      }
+   }
+}
+
+int vadc_audio_sinks_start(VADC_Audio_Sinks *sinks)
+{
+   if (!sinks->count || sinks->running)
+   {
+      return 0;
+   }
+
+   atomic_store(&sinks->quit, 0);
+   for (int i = 0; i < sinks->count; ++i)
+   {
+      VADC_Audio_Sink *sink = sinks->sinks + i;
+      sink->sinks = sinks;
+      if (pthread_create(&sink->thread, NULL, audio_sink_proc, sink) != 0)
+      {
+         audio_sinks_join(sinks);
+         return -1;
+      }
+      sink->running = 1;
+   }
+   sinks->running = 1;
+   return 0;
+}
+
+void vadc_audio_sink_write(VADC_Audio_Sinks *sinks, VADC_Audio_Sink *sink, const void *data, size_t bytes)
+{
+   const u8 *source = (const u8 *)data;
+   s64 block_start_ns = 0;
+
+   while (bytes > 0)
+   {
+      size_t head = atomic_load_explicit(&sink->head, memory_order_relaxed);
+      size_t tail = atomic_load_explicit(&sink->tail, memory_order_acquire);
+      size_t room = sink->capacity - (head - tail);
+
+      if (sinks->overflow == VADC_Audio_Sink_Overflow_Drop && room < bytes)
+      {
+         // NOTE: all of the block or nothing, a partial block would shift the samples after it
+         atomic_fetch_add_explicit(&sinks->dropped_bytes, bytes, memory_order_relaxed);
+         VADC_METRIC_ADD(sinks->metrics, dropped_output_bytes, bytes);
+         return;
+      }
+
+      if (!room)
+      {
+         if (!block_start_ns)
+         {
+            block_start_ns = vadc_now_ns();
+         }
+         poll(NULL, 0, 1);
+         continue;
+      }
+
+      // NOTE: with block a block larger than the room goes in piece by piece
+      size_t count = room < bytes ? room : bytes;
+      size_t offset = head & (sink->capacity - 1);
+      size_t first = sink->capacity - offset;
+      first = first < count ? first : count;
+      memcpy(sink->ring + offset, source, first);
+      memcpy(sink->ring, source + first, count - first);
+
+      atomic_store_explicit(&sink->head, head + count, memory_order_release);
+      source += count;
+      bytes -= count;
+   }
+
+   if (block_start_ns)
+   {
+      atomic_fetch_add_explicit(&sinks->blocked_ns, (unsigned long long)(vadc_now_ns() - block_start_ns), memory_order_relaxed);
+   }
+}
+
+void vadc_audio_sinks_stop(VADC_Audio_Sinks *sinks)
+{
+   if (sinks->running)
+   {
+      audio_sinks_join(sinks);
+      sinks->running = 0;
+   }
+   for (int i = 0; i < sinks->count; ++i)
+   {
+      free(sinks->sinks[i].ring);
+      sinks->sinks[i].ring = NULL;
+   }
+   sinks->count = 0;
+}
+
+VADC_Audio_Sink_Overflow vadc_audio_sink_overflow_from_string(const char *name)
+{
+   static const char *names[VADC_Audio_Sink_Overflow_COUNT] = { "block", "drop" };
+   for (int overflow = 0; overflow < VADC_Audio_Sink_Overflow_COUNT; ++overflow)
+   {
+      if (strcmp(name, names[overflow]) == 0)
+      {
+         return (VADC_Audio_Sink_Overflow)overflow;
+      }
+   }
+   return VADC_Audio_Sink_Overflow_COUNT;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "utils.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// NOTE: the audio outputs of a run (--save_audio, the speech/noise files and the playback pipes) are
+//       written by I/O threads instead of the inference thread, so a slow disk or a stalled aplay
+//       doesn't hold up inference. Each sink is a single producer/single consumer ring with an I/O
+//       thread of its own, so a stalled pipe only stalls its own ring: the inference thread copies a
+//       block in and publishes it with a release store of head, the sink's thread writes out everything
+//       up to head and hands the space back with a release store of tail. No locks on either side; an
+//       I/O thread sleeps a little when its ring is empty.
+//       When a ring is full the producer either waits for room (block, nothing is lost) or drops the
+//       whole block (drop, the deadline holds). Dropped bytes go to the metrics and the stats either way.
+
+#define VADC_AUDIO_SINK_MAX 5
+// NOTE: per sink, ~32 s of 16 kHz s16 audio. A power of two, so the ring offsets are a mask.
+#define VADC_AUDIO_SINK_RING_BYTES (1u << 20)
+
+typedef enum VADC_Audio_Sink_Overflow
+{
+   VADC_Audio_Sink_Overflow_Block = 0,
+   VADC_Audio_Sink_Overflow_Drop,
+
+   VADC_Audio_Sink_Overflow_COUNT
+} VADC_Audio_Sink_Overflow;
+
+typedef struct VADC_Audio_Sinks VADC_Audio_Sinks;
+
+typedef struct VADC_Audio_Sink VADC_Audio_Sink;
+struct VADC_Audio_Sink
+{
+   FILE *file;
+   u8 *ring;
+   size_t capacity;
+   // NOTE: byte counts since the start, head written by the producer, tail by the I/O thread
+   atomic_size_t head;
+   atomic_size_t tail;
+
+   VADC_Audio_Sinks *sinks;
+   pthread_t thread;
+   b32 running;
+};
+
+struct VADC_Audio_Sinks
+{
+   VADC_Audio_Sink sinks[VADC_AUDIO_SINK_MAX];
+   int count;
+   VADC_Audio_Sink_Overflow overflow;
+   // NOTE: dropped bytes are counted here too, NULL when not exporting
+   VADC_Metrics *metrics;
+
+   b32 running;
+   atomic_int quit;
+
+   atomic_ullong written_bytes;
+   atomic_ullong dropped_bytes;
+   // NOTE: time the producer spent waiting for room with VADC_Audio_Sink_Overflow_Block
+   atomic_ullong blocked_ns;
+};
+
+void vadc_audio_sinks_init( VADC_Audio_Sinks *sinks, VADC_Audio_Sink_Overflow overflow, VADC_Metrics *metrics );
+
+// NOTE: before vadc_audio_sinks_start. Returns NULL if there is no room or no memory, then the caller
+//       writes to file itself.
+VADC_Audio_Sink *vadc_audio_sinks_add( VADC_Audio_Sinks *sinks, FILE *file );
+
+// NOTE: the sink that writes to file, NULL if there is none
+VADC_Audio_Sink *vadc_audio_sinks_find( VADC_Audio_Sinks *sinks, FILE *file );
+
+// NOTE: starts the I/O threads, one per sink. Returns 0 on success.
+int vadc_audio_sinks_start( VADC_Audio_Sinks *sinks );
+
+// NOTE: inference thread only
+void vadc_audio_sink_write( VADC_Audio_Sinks *sinks, VADC_Audio_Sink *sink, const void *data, size_t bytes );
+
+// NOTE: writes out what is still queued, stops the threads and frees the rings. The files stay open.
+void vadc_audio_sinks_stop( VADC_Audio_Sinks *sinks );
+
+// NOTE: "block" or "drop", VADC_Audio_Sink_Overflow_COUNT for anything else
+VADC_Audio_Sink_Overflow vadc_audio_sink_overflow_from_string( const char *name );
@@ -0,0 +1,118 @@
+#include "checkpoint.h"
+#include "prob_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+static const char vadc_checkpoint_magic[8] = { 'V', 'A', 'D', 'C', 'C', 'K', 'P', 'T' };
+
+static u64 checkpoint_checksum(const VADC_Checkpoint_Section *sections, int section_count)
+{
+   u64 hash = VADC_FNV1A_BASIS;
+   for (int i = 0; i < section_count; ++i)
+   {
+      hash = vadc_fnv1a(hash, &sections[i].size, sizeof(sections[i].size));
+      hash = vadc_fnv1a(hash, sections[i].data, sections[i].size);
+   }
+   return hash;
+}
+
+int vadc_checkpoint_write(const char *path, u64 key, s64 position_samples,
+                          const VADC_Checkpoint_Section *sections, int section_count)
+{
+   if (section_count > VADC_CHECKPOINT_SECTIONS_MAX)
+   {
+      return -1;
+   }
+
+   VADC_Checkpoint_Header header = {0};
+   memcpy(header.magic, vadc_checkpoint_magic, sizeof(header.magic));
+   header.version = VADC_CHECKPOINT_VERSION;
+   header.section_count = (u32)section_count;
+   header.key = key;
+   header.position_samples = position_samples;
+   header.checksum = checkpoint_checksum(sections, section_count);
+
+   char temp_path[1100];
+   int path_length = snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", path, (int)getpid());
+   if (path_length < 0 || (size_t)path_length >= sizeof(temp_path))
+   {
+      return -1;
+   }
+   FILE *file = fopen(temp_path, "wb");
+   if (!file)
+   {
+      return -1;
+   }
+
+   b32 written = fwrite(&header, sizeof(header), 1, file) == 1;
+   for (int i = 0; written && i < section_count; ++i)
+   {
+      written = fwrite(&sections[i].size, sizeof(sections[i].size), 1, file) == 1 &&
+                (sections[i].size == 0 || fwrite(sections[i].data, sections[i].size, 1, file) == 1);
+   }
+   // NOTE: on disk before the rename, or a power cut could leave an empty checkpoint behind the name
+   written = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+   if (fclose(file) != 0 || !written || rename(temp_path, path) != 0)
+   {
+      unlink(temp_path);
+      return -1;
+   }
+   return 0;
+}
+
+VADC_Checkpoint_Result vadc_checkpoint_read(const char *path, u64 key, s64 *position_samples,
+                                            const VADC_Checkpoint_Section *sections, int section_count)
+{
+   FILE *file = fopen(path, "rb");
+   if (!file)
+   {
+      return errno == ENOENT ? VADC_Checkpoint_Missing : VADC_Checkpoint_Error;
+   }
+
+   VADC_Checkpoint_Header header;
+   VADC_Checkpoint_Result result = VADC_Checkpoint_Mismatch;
+   if (fread(&header, sizeof(header), 1, file) == 1 &&
+       memcmp(header.magic, vadc_checkpoint_magic, sizeof(header.magic)) == 0 &&
+       header.version == VADC_CHECKPOINT_VERSION &&
+       header.key == key &&
+       header.section_count == (u32)section_count)
+   {
+      // NOTE: read into scratch first, the caller's state stays untouched unless everything checks out
+      u32 total_size = 0;
+      for (int i = 0; i < section_count; ++i)
+      {
+         total_size += sections[i].size;
+      }
+      u8 *scratch = malloc(total_size ? total_size : 1);
+      VADC_Checkpoint_Section read_sections[VADC_CHECKPOINT_SECTIONS_MAX];
+      b32 matches = (scratch != NULL) && section_count <= VADC_CHECKPOINT_SECTIONS_MAX;
+
+      u32 offset = 0;
+      for (int i = 0; matches && i < section_count; ++i)
+      {
+         u32 size = 0;
+         matches = fread(&size, sizeof(size), 1, file) == 1 && size == sections[i].size &&
+                   (size == 0 || fread(scratch + offset, size, 1, file) == 1);
+         read_sections[i].data = scratch + offset;
+         read_sections[i].size = size;
+         offset += size;
+      }
+
+      if (matches && checkpoint_checksum(read_sections, section_count) == header.checksum)
+      {
+         for (int i = 0; i < section_count; ++i)
+         {
+            memcpy(sections[i].data, read_sections[i].data, sections[i].size);
+         }
+         *position_samples = header.position_samples;
+         result = VADC_Checkpoint_Ok;
+      }
+      free(scratch);
+   }
+   fclose(file);
+   return result;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "utils.h"
+#include <stddef.h>
+
+// NOTE: the stream state of a run at a window boundary, so a run that was killed can go on from there
+//       (--checkpoint, --resume). A checkpoint file is a fixed header and the state as a list of
+//       sections, each stored with its size. The caller says which sections it expects; a different
+//       key (other input, model or settings), another section layout or a bad checksum is a mismatch
+//       and nothing is restored. Written next to the target and renamed, so a crash while writing
+//       leaves the previous checkpoint.
+
+#define VADC_CHECKPOINT_VERSION 1
+#define VADC_CHECKPOINT_SECTIONS_MAX 8
+
+typedef struct VADC_Checkpoint_Header VADC_Checkpoint_Header;
+struct VADC_Checkpoint_Header
+{
+   char magic[8];
+   u32 version;
+   u32 section_count;
+   // NOTE: of everything that changes the results, see run_checkpoint_key in vadc.c
+   u64 key;
+   // NOTE: samples of input read and processed when the checkpoint was taken
+   s64 position_samples;
+   // NOTE: FNV-1a of the section sizes and the sections
+   u64 checksum;
+};
+
+typedef struct VADC_Checkpoint_Section VADC_Checkpoint_Section;
+struct VADC_Checkpoint_Section
+{
+   void *data;
+   u32 size;
+};
+
+typedef enum VADC_Checkpoint_Result
+{
+   VADC_Checkpoint_Ok = 0,
+   VADC_Checkpoint_Missing,
+   VADC_Checkpoint_Mismatch,
+   VADC_Checkpoint_Error,
+} VADC_Checkpoint_Result;
+
+// NOTE: returns 0 on success
+int vadc_checkpoint_write( const char *path, u64 key, s64 position_samples,
+                           const VADC_Checkpoint_Section *sections, int section_count );
+
+// NOTE: fills the sections and position_samples only on VADC_Checkpoint_Ok
+VADC_Checkpoint_Result vadc_checkpoint_read( const char *path, u64 key, s64 *position_samples,
+                                             const VADC_Checkpoint_Section *sections, int section_count );
@@ -0,0 +1,143 @@
+#include "energy_gate.h"
+
+#include <math.h>
+#include <string.h>
+
+void vadc_gate_init(VADC_Gate *gate, const VADC_Gate_Options *options)
+{
+   memset(gate, 0, sizeof(*gate));
+   gate->options = *options;
+   // NOTE: seeded at the absolute floor rather than from the first window, a stream that starts in
+   //       speech would otherwise put the floor under the speech and gate it out
+   gate->noise_floor_dbfs = options->absolute_floor_dbfs;
+}
+
+static float gate_dbfs(double value)
+{
+   // NOTE: clamped so digital silence doesn't give -inf
+   const double full_scale = 32768.0;
+   double ratio = value / full_scale;
+   return ratio > 1e-6 ? (float)(20.0 * log10(ratio)) : -120.0f;
+}
+
+VADC_Gate_Features vadc_gate_measure(const short *samples, int count)
+{
+   VADC_Gate_Features features = {-120.0f, -120.0f, 0.0f};
+   if (count <= 0)
+   {
+      return features;
+   }
+
+   // NOTE: branch free loops over int16 so the compiler vectorizes them, one pass per feature keeps
+   //       each loop simple enough for that
+   s64 sum_squares = 0;
+   for (int i = 0; i < count; ++i)
+   {
+      s32 value = samples[i];
+      sum_squares += value * value;
+   }
+
+   s32 peak = 0;
+   for (int i = 0; i < count; ++i)
+   {
+      s32 value = samples[i];
+      s32 abs_value = value < 0 ? -value : value;
+      peak = abs_value > peak ? abs_value : peak;
+   }
+
+   s32 crossings = 0;
+   for (int i = 1; i < count; ++i)
+   {
+      crossings += ((samples[i - 1] ^ samples[i]) < 0);
+   }
+
+   features.rms_dbfs = gate_dbfs(sqrt((double)sum_squares / count));
+   features.peak_dbfs = gate_dbfs(peak);
+   features.zcr = (float)crossings / count;
+   return features;
+}
+
+b32 vadc_gate_window_is_silent(VADC_Gate *gate, VADC_Gate_Features features)
+{
+   const VADC_Gate_Options *options = &gate->options;
+
+   b32 below_absolute = (features.peak_dbfs < options->absolute_floor_dbfs);
+   b32 near_floor = (features.rms_dbfs < gate->noise_floor_dbfs + options->margin_db);
+   b32 silent = below_absolute || near_floor;
+
+   // NOTE: down fast to a quieter window, up slowly and only on noise like windows
+   if (features.rms_dbfs < gate->noise_floor_dbfs)
+   {
+      gate->noise_floor_dbfs += (features.rms_dbfs - gate->noise_floor_dbfs) * 0.5f;
+   }
+   else if (near_floor || features.zcr >= options->noise_zcr)
+   {
+      gate->noise_floor_dbfs += (features.rms_dbfs - gate->noise_floor_dbfs) * 0.01f;
+   }
+
+   return vadc_gate_window_hangover(gate, silent);
+}
+
+b32 vadc_gate_window_hangover(VADC_Gate *gate, b32 silent)
+{
+   gate->silent_run = silent ? gate->silent_run + 1 : 0;
+   return gate->silent_run > gate->options.hangover_windows;
+}
+
+void vadc_gate_apply_lstm_policy(const VADC_Gate *gate, float *lstm_h, float *lstm_c, int lstm_count, int skipped_windows)
+{
+   switch (gate->options.lstm_policy)
+   {
+      case VADC_Gate_Lstm_Reset:
+      {
+         memset(lstm_h, 0, lstm_count * sizeof(float));
+         memset(lstm_c, 0, lstm_count * sizeof(float));
+      } break;
+
+      case VADC_Gate_Lstm_Decay:
+      {
+         float scale = powf(gate->options.decay, (float)skipped_windows);
+         for (int i = 0; i < lstm_count; ++i)
+         {
+            lstm_h[i] *= scale;
+            lstm_c[i] *= scale;
+         }
+      } break;
+
+      default:
+      {
+      } break;
+   }
+}
+
+VADC_Gate_Lstm vadc_gate_lstm_from_string(const char *name)
+{
+   static const char *names[VADC_Gate_Lstm_COUNT] = { "hold", "reset", "decay" };
+   for (int policy = 0; policy < VADC_Gate_Lstm_COUNT; ++policy)
+   {
+      if (strcmp(name, names[policy]) == 0)
+      {
+         return (VADC_Gate_Lstm)policy;
+      }
+   }
+   return VADC_Gate_Lstm_COUNT;
+}
+
+static const char *vadc_gate_stage_names[VADC_Gate_Stage_COUNT] = { "energy", "c" };
+
+VADC_Gate_Stage vadc_gate_stage_from_string(const char *name)
+{
+   for (int stage = 0; stage < VADC_Gate_Stage_COUNT; ++stage)
+   {
+      if (strcmp(name, vadc_gate_stage_names[stage]) == 0)
+      {
+         return (VADC_Gate_Stage)stage;
+      }
+   }
+   return VADC_Gate_Stage_COUNT;
+}
+
+const char *vadc_gate_stage_name(VADC_Gate_Stage stage)
+{
+   return stage < VADC_Gate_Stage_COUNT ? vadc_gate_stage_names[stage] : "unknown";
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "utils.h"
+
+// NOTE: cheap pre-gate on the int16 samples, in front of the model. A window is confidently silent
+//       when its peak is below the absolute floor, or its RMS is within margin_db of an adaptive noise
+//       floor, for longer than the hangover. The noise floor starts at the absolute floor, follows
+//       quiet windows down quickly and rises slowly, and only on windows that look like noise (near
+//       the floor, or a high zero crossing rate like line hiss), so speech never drags it up.
+//       The same hangover also serves a cascade, where the first stage is a cheap model instead of the
+//       energy measurements (VADC_Gate_Stage_C, run by the caller) and only its candidates reach the
+//       expensive one.
+
+typedef enum VADC_Gate_Lstm
+{
+   VADC_Gate_Lstm_Hold = 0,   // NOTE: keep the state of the last model call
+   VADC_Gate_Lstm_Reset,      // NOTE: zero it, like the start of a stream
+   VADC_Gate_Lstm_Decay,      // NOTE: scale it by decay for every skipped window
+
+   VADC_Gate_Lstm_COUNT
+} VADC_Gate_Lstm;
+
+typedef enum VADC_Gate_Stage
+{
+   VADC_Gate_Stage_Energy = 0,
+   VADC_Gate_Stage_C,         // NOTE: the pure C Silero v3.1 engine, see silero_c.h
+
+   VADC_Gate_Stage_COUNT
+} VADC_Gate_Stage;
+
+typedef struct VADC_Gate_Options VADC_Gate_Options;
+struct VADC_Gate_Options
+{
+   b32 enabled;
+   VADC_Gate_Stage stage;
+   // NOTE: how far above the noise floor a window still counts as silent
+   float margin_db;
+   // NOTE: windows peaking below this level are silent whatever the noise floor, e.g. digital
+   //       silence. Also where the noise floor starts.
+   float absolute_floor_dbfs;
+   // NOTE: zero crossings per sample above which a window looks like hiss rather than voiced speech
+   float noise_zcr;
+   // NOTE: silent windows in a row before the gate trusts the silence
+   int hangover_windows;
+   VADC_Gate_Lstm lstm_policy;
+   float decay;
+   // NOTE: skipped windows run through the model (outputs discarded) before trusting it again
+   int rewarm_windows;
+   // NOTE: also run the model on every window and report how far the gated segments drift
+   b32 measure_drift;
+
+   // NOTE: VADC_Gate_Stage_C, windows the first stage scores below this are silent
+   float candidate_threshold;
+   const char *c_weights_path;
+};
+
+typedef struct VADC_Gate_Features VADC_Gate_Features;
+struct VADC_Gate_Features
+{
+   float rms_dbfs;
+   float peak_dbfs;
+   float zcr;
+};
+
+typedef struct VADC_Gate VADC_Gate;
+struct VADC_Gate
+{
+   VADC_Gate_Options options;
+   float noise_floor_dbfs;
+   int silent_run;
+};
+
+void vadc_gate_init( VADC_Gate *gate, const VADC_Gate_Options *options );
+
+VADC_Gate_Features vadc_gate_measure( const short *samples, int count );
+
+// NOTE: feeds one window's features to the gate, in stream order. Returns whether it's confidently silent.
+b32 vadc_gate_window_is_silent( VADC_Gate *gate, VADC_Gate_Features features );
+
+// NOTE: the hangover alone, for a first stage that decides on its own whether a window is silent
+b32 vadc_gate_window_hangover( VADC_Gate *gate, b32 silent );
+
+// NOTE: applies the lstm policy to the state the next model call starts from
+void vadc_gate_apply_lstm_policy( const VADC_Gate *gate, float *lstm_h, float *lstm_c, int lstm_count, int skipped_windows );
+
+// NOTE: "hold", "reset" or "decay", VADC_Gate_Lstm_COUNT for anything else
+VADC_Gate_Lstm vadc_gate_lstm_from_string( const char *name );
+
+// NOTE: "energy" or "c", VADC_Gate_Stage_COUNT for anything else
+VADC_Gate_Stage vadc_gate_stage_from_string( const char *name );
+const char *vadc_gate_stage_name( VADC_Gate_Stage stage );
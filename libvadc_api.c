@@ -25,6 +25,34 @@ void vadc_destroy_arena(MemoryArena* arena)
     free(arena);
 }
 
+size_t vadc_arena_bytes_needed(const char* model_path,
+                               const char* filename,
+                               int preferred_batch_size,
+                               float desired_sequence_count,
+                               int audio_source,
+                               float start_seconds)
+{
+    String8 model_arg = {0};
+    if (model_path && model_path[0]) {
+        model_arg.begin = (u8*)model_path;
+        model_arg.size = (int)strlen(model_path);
+    }
+
+    String8 filename_arg = {0};
+    if (filename && filename[0]) {
+        filename_arg.begin = (u8*)filename;
+        filename_arg.size = (int)strlen(filename);
+    }
+
+    return arena_bytes_required(model_arg,
+                                (s32)preferred_batch_size,
+                                desired_sequence_count,
+                                NULL,
+                                filename_arg,
+                                audio_source,
+                                start_seconds);
+}
+
 int vadc_run(const char* model_path,
              MemoryArena* arena,
              float min_silence_duration_ms,
@@ -58,24 +86,145 @@ int vadc_run(const char* model_path,
         filename_arg.size = (int)strlen(filename);
     }
 
+    VADC_Options options = {0};
+    options.min_silence_duration_ms = min_silence_duration_ms;
+    options.min_speech_duration_ms = min_speech_duration_ms;
+    options.threshold = threshold;
+    options.neg_threshold = neg_threshold;
+    options.speech_pad_ms = speech_pad_ms;
+    options.raw_probabilities = raw_probabilities ? 1 : 0;
+    options.output_format = output_format_centi_seconds ? Segment_Output_Format_CentiSeconds : Segment_Output_Format_Seconds;
+    options.stats_output_enabled = stats_output_enabled ? 1 : 0;
+    options.audio_source = audio_source;
+    options.start_seconds = start_seconds;
+
     return run_inference(model_arg,
                          arena,
-                         min_silence_duration_ms,
-                         min_speech_duration_ms,
-                         threshold,
-                         neg_threshold,
-                         speech_pad_ms,
+                         &options,
                          desired_sequence_count,
-                         raw_probabilities ? 1 : 0,
-                         output_format_centi_seconds ? Segment_Output_Format_CentiSeconds : Segment_Output_Format_Seconds,
-                         filename_arg,
-                         stats_output_enabled ? 1 : 0,
                          (s32)preferred_batch_size,
-                         audio_source,
-                         start_seconds,
+                         filename_arg,
                          audio_output_file,
                          log_output_file,
                          speech_audio_file,
                          noise_audio_file,
-                         verbose_logging ? 1 : 0);
+                         verbose_logging ? 1 : 0,
+                         NULL);
+}
+
+int vadc_run_many(const char* model_path,
+                  MemoryArena* arena,
+                  const char* const* filenames,
+                  int file_count,
+                  const char* output_dir,
+                  int jobs,
+                  float min_silence_duration_ms,
+                  float min_speech_duration_ms,
+                  float threshold,
+                  float neg_threshold,
+                  float speech_pad_ms,
+                  float desired_sequence_count,
+                  int raw_probabilities,
+                  int output_format_centi_seconds,
+                  int preferred_batch_size,
+                  int audio_source,
+                  float start_seconds)
+{
+    if (!arena || (!filenames && file_count > 0)) return -1;
+
+    String8 model_arg = {0};
+    if (model_path && model_path[0]) {
+        model_arg.begin = (u8*)model_path;
+        model_arg.size = (int)strlen(model_path);
+    }
+
+    String8 output_dir_arg = {0};
+    if (output_dir && output_dir[0]) {
+        output_dir_arg.begin = (u8*)output_dir;
+        output_dir_arg.size = (int)strlen(output_dir);
+    }
+
+    String8* filename_args = pushArray(arena, file_count > 0 ? file_count : 1, String8);
+    if (!filename_args) return -1;
+    for (int i = 0; i < file_count; ++i) {
+        filename_args[i].begin = (u8*)filenames[i];
+        filename_args[i].size = (int)strlen(filenames[i]);
+    }
+
+    VADC_Options options = {0};
+    options.min_silence_duration_ms = min_silence_duration_ms;
+    options.min_speech_duration_ms = min_speech_duration_ms;
+    options.threshold = threshold;
+    options.neg_threshold = neg_threshold;
+    options.speech_pad_ms = speech_pad_ms;
+    options.raw_probabilities = raw_probabilities ? 1 : 0;
+    options.output_format = output_format_centi_seconds ? Segment_Output_Format_CentiSeconds : Segment_Output_Format_Seconds;
+    options.audio_source = audio_source;
+    options.start_seconds = start_seconds;
+
+    return run_inference_many(model_arg,
+                              arena,
+                              &options,
+                              desired_sequence_count,
+                              (s32)preferred_batch_size,
+                              filename_args,
+                              file_count,
+                              output_dir_arg,
+                              jobs);
+}
+
+int vadc_crossval(const char* model_path,
+                  const char* c_weights_path,
+                  MemoryArena* arena,
+                  const char* filename,
+                  float min_silence_duration_ms,
+                  float min_speech_duration_ms,
+                  float threshold,
+                  float neg_threshold,
+                  float speech_pad_ms,
+                  int audio_source,
+                  float start_seconds,
+                  VadcCrossvalReport* report)
+{
+    if (!arena || !report) return -1;
+
+    String8 model_arg = {0};
+    if (model_path && model_path[0]) {
+        model_arg.begin = (u8*)model_path;
+        model_arg.size = (int)strlen(model_path);
+    }
+
+    String8 filename_arg = {0};
+    if (filename && filename[0]) {
+        filename_arg.begin = (u8*)filename;
+        filename_arg.size = (int)strlen(filename);
+    }
+
+    VADC_Options options = {0};
+    options.min_silence_duration_ms = min_silence_duration_ms;
+    options.min_speech_duration_ms = min_speech_duration_ms;
+    options.threshold = threshold;
+    options.neg_threshold = neg_threshold;
+    options.speech_pad_ms = speech_pad_ms;
+    options.audio_source = audio_source;
+    options.start_seconds = start_seconds;
+
+    VADC_Crossval_Report internal_report;
+    int result = run_crossval(model_arg, arena, c_weights_path, &options, filename_arg, &internal_report);
+
+    report->windows = internal_report.windows;
+    report->audio_seconds = internal_report.audio_seconds;
+    report->max_abs_diff = internal_report.max_abs_diff;
+    report->mean_abs_diff = internal_report.mean_abs_diff;
+    report->max_abs_diff_window = internal_report.max_abs_diff_window;
+    report->threshold_disagreements = internal_report.threshold_disagreements;
+    report->speech_state_disagreements = internal_report.speech_state_disagreements;
+    for (int i = 0; i < 2; ++i) {
+        report->segments[i] = internal_report.segments[i];
+        report->unmatched_segments[i] = internal_report.unmatched_segments[i];
+        report->inference_seconds[i] = internal_report.inference_seconds[i];
+    }
+    report->max_boundary_diff_s = internal_report.max_boundary_diff_s;
+
+    return result;
 }
@@ -25,11 +25,24 @@ MemoryArena* vadc_create_arena(size_t arena_bytes);
 /* Free arena previously created by vadc_create_arena */
 void vadc_destroy_arena(MemoryArena* arena);
 
+/* Exact arena bytes one vadc_run with this model, batch size and sequence
+   count needs, measured by a dry run that loads the model into a scratch
+   arena and runs one inference call on silence. filename may be NULL for a
+   stdin run; a file run also holds its ffmpeg command line, so pass the same
+   name. Returns 0 if the model could not be loaded. */
+size_t vadc_arena_bytes_needed(const char* model_path,
+                               const char* filename,
+                               int preferred_batch_size,
+                               float desired_sequence_count,
+                               int audio_source,
+                               float start_seconds);
+
 /* Run the same inference pipeline as the CLI's main() by forwarding
    parameters into run_inference(). Parameters match the CLI defaults in
    vadc.c. model_path may be NULL or empty string to use default.
    filename may be NULL to indicate stdin. Returns the same int result as
-   run_inference(). */
+   run_inference(). Several runs may go on concurrently in different
+   threads as long as each uses its own arena and output files. */
 int vadc_run(const char* model_path,
              MemoryArena* arena,
              float min_silence_duration_ms,
@@ -51,6 +64,68 @@ int vadc_run(const char* model_path,
              const char* noise_audio_file,
              int verbose_logging);
 
+/* Run many files through one loaded model with `jobs` worker threads
+   pulling files from a shared queue. The segments of each file are written
+   to <output_dir>/<file name>.txt, or to <file>.txt next to the input when
+   output_dir is NULL or empty. Nothing is written to stdout. Returns the
+   number of files that failed, or -1 if the model could not be loaded or
+   two inputs in different directories share a file name under output_dir. */
+int vadc_run_many(const char* model_path,
+                  MemoryArena* arena,
+                  const char* const* filenames,
+                  int file_count,
+                  const char* output_dir,
+                  int jobs,
+                  float min_silence_duration_ms,
+                  float min_speech_duration_ms,
+                  float threshold,
+                  float neg_threshold,
+                  float speech_pad_ms,
+                  float desired_sequence_count,
+                  int raw_probabilities,
+                  int output_format_centi_seconds,
+                  int preferred_batch_size,
+                  int audio_source,
+                  float start_seconds);
+
+/* Result of vadc_crossval. Probability differences are absolute, segment
+   boundaries in seconds. Index 0 of the per-backend arrays is onnxruntime,
+   index 1 the pure C backend. */
+typedef struct VadcCrossvalReport
+{
+    long long windows;
+    double audio_seconds;
+    double max_abs_diff;
+    double mean_abs_diff;
+    long long max_abs_diff_window;
+    long long threshold_disagreements;
+    long long speech_state_disagreements;
+    int segments[2];
+    int unmatched_segments[2];
+    double max_boundary_diff_s;
+    double inference_seconds[2];
+} VadcCrossvalReport;
+
+/* Run the onnxruntime backend and the pure C backend side by side on the
+   same audio, one 1536 sample window at a time, and report how far their
+   probabilities and speech segments are apart. model_path must be a Silero
+   v3 model (NULL or empty for the default); c_weights_path is the C
+   backend's .testtensor weights file, NULL for
+   testdata/silero_v31_16k.testtensor. filename may be NULL to read stdin.
+   Returns 0 on success. */
+int vadc_crossval(const char* model_path,
+                  const char* c_weights_path,
+                  MemoryArena* arena,
+                  const char* filename,
+                  float min_silence_duration_ms,
+                  float min_speech_duration_ms,
+                  float threshold,
+                  float neg_threshold,
+                  float speech_pad_ms,
+                  int audio_source,
+                  float start_seconds,
+                  VadcCrossvalReport* report);
+
 #ifdef __cplusplus
 }
 #endif
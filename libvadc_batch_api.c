@@ -0,0 +1,394 @@
+#include "libvadc_batch_api.h"
+#include "vadc.h"
+#include "memory.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <TracyC.h>
+
+/* Windows a single stream may have queued before vadc_batch_submit blocks.
+   A stream can only contribute one window per batch (its lstm state of the
+   next window depends on the previous one), so a deep queue only helps to
+   absorb bursts. */
+#define VADC_BATCH_STREAM_QUEUE 8
+
+struct VadcBatchStream {
+    VadcBatchEngine* engine;
+    VadcBatchCallback callback;
+    void* user_data;
+
+    // NOTE: per-stream state, [layers, hidden]; only touched by the dispatcher thread
+    float* lstm_h;
+    float* lstm_c;
+    // NOTE: v5 only, last context_size samples of the previous window
+    float* context;
+
+    // NOTE: ring of queued windows, guarded by engine->mutex
+    float* queue;
+    s64 queue_timestamps[VADC_BATCH_STREAM_QUEUE];
+    int queue_head;
+    int queue_count;
+    b32 in_flight;
+
+    s64 next_window_index;
+    VadcBatchStream* next_ready;
+};
+
+struct VadcBatchEngine {
+    MemoryArena arena;
+    u8* arena_base;
+    void* backend;
+    Silero_Config config;
+
+    int max_batch;
+    s64 max_wait_ns;
+    int window_samples;
+    int row_samples;
+    int layer_count;
+    int hidden_size;
+
+    // NOTE: batch tensors sized for max_batch, state in [layers, max_batch, hidden] layout
+    Tensor_Buffers buffers;
+    VadcBatchStream** batch_streams;
+    float* batch_probabilities;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+
+    // NOTE: FIFO of streams that have a window queued and are not in the batch being run
+    VadcBatchStream* ready_head;
+    VadcBatchStream* ready_tail;
+    int ready_count;
+
+    int stream_count;
+    int flush_requests;
+    b32 batch_in_flight;
+    b32 quit;
+    b32 thread_started;
+};
+
+static void batch_push_ready(VadcBatchEngine* e, VadcBatchStream* s) {
+    s->next_ready = NULL;
+    if (e->ready_tail) e->ready_tail->next_ready = s;
+    else e->ready_head = s;
+    e->ready_tail = s;
+    ++e->ready_count;
+    TracyCPlot("batch ready streams", (double)e->ready_count);
+}
+
+static VadcBatchStream* batch_pop_ready(VadcBatchEngine* e) {
+    VadcBatchStream* s = e->ready_head;
+    if (s) {
+        e->ready_head = s->next_ready;
+        if (!e->ready_head) e->ready_tail = NULL;
+        s->next_ready = NULL;
+        --e->ready_count;
+        TracyCPlot("batch ready streams", (double)e->ready_count);
+    }
+    return s;
+}
+
+// NOTE: called with the mutex held; returns once a batch should be dispatched, or when quitting with nothing left to run
+static void batch_wait_for_dispatch(VadcBatchEngine* e) {
+    while (!e->quit) {
+        if (e->ready_count >= e->max_batch) return;
+        if (e->ready_count > 0 && e->flush_requests > 0) return;
+
+        if (e->ready_count > 0) {
+            VadcBatchStream* oldest = e->ready_head;
+            s64 deadline = oldest->queue_timestamps[oldest->queue_head] + e->max_wait_ns;
+            if (vadc_now_ns() >= deadline) return;
+
+            struct timespec deadline_ts;
+            deadline_ts.tv_sec = deadline / 1000000000LL;
+            deadline_ts.tv_nsec = deadline % 1000000000LL;
+            pthread_cond_timedwait(&e->wake, &e->mutex, &deadline_ts);
+        } else {
+            pthread_cond_wait(&e->wake, &e->mutex);
+        }
+    }
+}
+
+static void* batch_dispatcher_thread(void* param) {
+    VadcBatchEngine* e = (VadcBatchEngine*)param;
+    Silero_Config config = e->config;
+    const int context_size = config.context_size;
+
+    TracyCSetThreadName("vadc batch dispatcher");
+
+    pthread_mutex_lock(&e->mutex);
+    for (;;) {
+        batch_wait_for_dispatch(e);
+        if (e->ready_count == 0) {
+            if (e->quit) break;
+            continue;
+        }
+
+        // NOTE: gather one window per stream while holding the lock, the queue slots may be written by submitters
+        int batch_size = 0;
+        while (batch_size < e->max_batch && e->ready_count > 0) {
+            VadcBatchStream* s = batch_pop_ready(e);
+            s->in_flight = 1;
+
+            float* row = e->buffers.input_samples + batch_size * e->row_samples;
+            if (context_size) {
+                memcpy(row, s->context, context_size * sizeof(float));
+            }
+            memcpy(row + context_size, s->queue + s->queue_head * e->window_samples, e->window_samples * sizeof(float));
+
+            e->batch_streams[batch_size++] = s;
+        }
+        e->batch_in_flight = 1;
+        pthread_mutex_unlock(&e->mutex);
+
+        TracyCPlot("batch size", (double)batch_size);
+
+        // NOTE: scatter each stream's [layers, hidden] state into the [layers, batch, hidden] batch state
+        for (int b = 0; b < batch_size; ++b) {
+            VadcBatchStream* s = e->batch_streams[b];
+            for (int layer = 0; layer < e->layer_count; ++layer) {
+                size_t batch_offset = ((size_t)layer * batch_size + b) * e->hidden_size;
+                memcpy(e->buffers.lstm_h + batch_offset, s->lstm_h + layer * e->hidden_size, e->hidden_size * sizeof(float));
+                memcpy(e->buffers.lstm_c + batch_offset, s->lstm_c + layer * e->hidden_size, e->hidden_size * sizeof(float));
+            }
+        }
+
+        ort_run_batch((ONNX_Specific*)e->backend, config, batch_size, e->buffers);
+
+        for (int b = 0; b < batch_size; ++b) {
+            VadcBatchStream* s = e->batch_streams[b];
+            for (int layer = 0; layer < e->layer_count; ++layer) {
+                size_t batch_offset = ((size_t)layer * batch_size + b) * e->hidden_size;
+                memcpy(s->lstm_h + layer * e->hidden_size, e->buffers.lstm_h_out + batch_offset, e->hidden_size * sizeof(float));
+                memcpy(s->lstm_c + layer * e->hidden_size, e->buffers.lstm_c_out + batch_offset, e->hidden_size * sizeof(float));
+            }
+            if (context_size) {
+                float* row = e->buffers.input_samples + b * e->row_samples;
+                memcpy(s->context, row + e->row_samples - context_size, context_size * sizeof(float));
+            }
+
+            float p = e->buffers.output[b * config.output_stride + config.silero_probability_out_index];
+            if (p < 0.0f) p = 0.0f;
+            if (p > 1.0f) p = 1.0f;
+            e->batch_probabilities[b] = p;
+        }
+
+        for (int b = 0; b < batch_size; ++b) {
+            VadcBatchStream* s = e->batch_streams[b];
+            if (s->callback) {
+                s->callback(s, s->user_data, s->next_window_index, e->batch_probabilities[b]);
+            }
+        }
+
+        pthread_mutex_lock(&e->mutex);
+        for (int b = 0; b < batch_size; ++b) {
+            VadcBatchStream* s = e->batch_streams[b];
+            s->queue_head = (s->queue_head + 1) % VADC_BATCH_STREAM_QUEUE;
+            --s->queue_count;
+            ++s->next_window_index;
+            s->in_flight = 0;
+            if (s->queue_count > 0) {
+                batch_push_ready(e, s);
+            }
+        }
+        e->batch_in_flight = 0;
+        if (e->ready_count == 0) {
+            e->flush_requests = 0;
+        }
+        pthread_cond_broadcast(&e->done);
+
+        TracyCFrameMarkNamed("batch");
+    }
+    pthread_mutex_unlock(&e->mutex);
+
+    return NULL;
+}
+
+VadcBatchEngine* vadc_batch_engine_create(const char* model_path, int max_batch, int max_wait_us) {
+    if (max_batch < 1) max_batch = 1;
+    if (max_wait_us < 0) max_wait_us = 0;
+
+    VadcBatchEngine* e = (VadcBatchEngine*)malloc(sizeof(VadcBatchEngine));
+    if (!e) return NULL;
+    memset(e, 0, sizeof(*e));
+
+    // NOTE: per batch entry: one 576 sample row, the output and four state buffers of up to 2x128 floats
+    size_t arena_bytes = Megabytes(1) + (size_t)max_batch * Kilobytes(8);
+    e->arena_base = (u8*)malloc(arena_bytes);
+    if (!e->arena_base) { free(e); return NULL; }
+    initializeMemoryArena(&e->arena, e->arena_base, arena_bytes);
+
+    String8 model_arg = {0};
+    if (model_path && model_path[0]) {
+        model_arg.begin = (const s8*)model_path;
+        model_arg.size = (strSize)strlen(model_path);
+    }
+
+    e->backend = backend_init(&e->arena, model_arg, &e->config);
+    if (!e->backend) {
+        free(e->arena_base); free(e); return NULL;
+    }
+
+    if (e->config.input_batch_size != -1 || e->config.lstm_batch_size != -1) {
+        fprintf(stderr, "Error: model has a fixed batch dimension (input %d, lstm state %d), "
+                        "cross-stream batching needs a model with a dynamic batch\n",
+                e->config.input_batch_size, e->config.lstm_batch_size);
+        backend_release(e->backend);
+        free(e->arena_base); free(e); return NULL;
+    }
+
+    // NOTE: the smallest window the model takes, i.e. 512 samples (32ms) for all current models
+    silero_config_finalize(&e->config, 1, (float)e->config.input_size_min);
+
+    e->max_batch = max_batch;
+    e->max_wait_ns = (s64)max_wait_us * 1000LL;
+    e->window_samples = e->config.input_count;
+    e->row_samples = e->config.input_count + e->config.context_size;
+    e->layer_count = e->config.is_silero_v5 ? 1 : 2;
+    e->hidden_size = e->config.lstm_hidden_size;
+
+    int state_count = e->layer_count * max_batch * e->hidden_size;
+    e->buffers.window_size_samples = e->window_samples;
+    e->buffers.input_samples = pushArray(&e->arena, e->row_samples * max_batch, float);
+    e->buffers.output = pushArray(&e->arena, e->config.output_stride * max_batch, float);
+    e->buffers.lstm_count = state_count;
+    e->buffers.lstm_h = pushArray(&e->arena, state_count, float);
+    e->buffers.lstm_c = pushArray(&e->arena, state_count, float);
+    e->buffers.lstm_h_out = pushArray(&e->arena, state_count, float);
+    e->buffers.lstm_c_out = pushArray(&e->arena, state_count, float);
+    e->batch_streams = pushArray(&e->arena, max_batch, VadcBatchStream*);
+    e->batch_probabilities = pushArray(&e->arena, max_batch, float);
+
+    ort_query_io_names((ONNX_Specific*)e->backend);
+
+    pthread_mutex_init(&e->mutex, NULL);
+    // NOTE: batch_wait_for_dispatch computes its deadline with vadc_now_ns, so wake waits on the
+    //       same monotonic clock and a wall clock step doesn't stretch or cut the wait
+    pthread_condattr_t wake_attr;
+    pthread_condattr_init(&wake_attr);
+    pthread_condattr_setclock(&wake_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&e->wake, &wake_attr);
+    pthread_condattr_destroy(&wake_attr);
+    pthread_cond_init(&e->done, NULL);
+
+    if (pthread_create(&e->thread, NULL, batch_dispatcher_thread, e) != 0) {
+        fprintf(stderr, "Error: couldn't start batch dispatcher thread\n");
+        vadc_batch_engine_destroy(e);
+        return NULL;
+    }
+    e->thread_started = 1;
+
+    return e;
+}
+
+void vadc_batch_engine_destroy(VadcBatchEngine* e) {
+    if (!e) return;
+
+    if (e->thread_started) {
+        pthread_mutex_lock(&e->mutex);
+        Assert(e->stream_count == 0);
+        e->quit = 1;
+        pthread_cond_signal(&e->wake);
+        pthread_mutex_unlock(&e->mutex);
+        pthread_join(e->thread, NULL);
+    }
+
+    pthread_cond_destroy(&e->done);
+    pthread_cond_destroy(&e->wake);
+    pthread_mutex_destroy(&e->mutex);
+
+    if (e->backend) backend_release(e->backend);
+    if (e->arena_base) free(e->arena_base);
+    free(e);
+}
+
+void vadc_batch_engine_flush(VadcBatchEngine* e) {
+    if (!e) return;
+    pthread_mutex_lock(&e->mutex);
+    ++e->flush_requests;
+    pthread_cond_signal(&e->wake);
+    while (e->ready_count > 0 || e->batch_in_flight) {
+        pthread_cond_wait(&e->done, &e->mutex);
+    }
+    pthread_mutex_unlock(&e->mutex);
+}
+
+int vadc_batch_engine_window_samples(VadcBatchEngine* e) {
+    return e ? e->window_samples : 0;
+}
+
+VadcBatchStream* vadc_batch_stream_open(VadcBatchEngine* e, VadcBatchCallback callback, void* user_data) {
+    if (!e) return NULL;
+
+    int state_count = e->layer_count * e->hidden_size;
+    size_t floats_count = (size_t)state_count * 2 + e->config.context_size + (size_t)VADC_BATCH_STREAM_QUEUE * e->window_samples;
+
+    VadcBatchStream* s = (VadcBatchStream*)malloc(sizeof(VadcBatchStream) + floats_count * sizeof(float));
+    if (!s) return NULL;
+    memset(s, 0, sizeof(VadcBatchStream) + floats_count * sizeof(float));
+
+    float* floats = (float*)(s + 1);
+    s->lstm_h = floats;
+    s->lstm_c = s->lstm_h + state_count;
+    s->context = s->lstm_c + state_count;
+    s->queue = s->context + e->config.context_size;
+
+    s->engine = e;
+    s->callback = callback;
+    s->user_data = user_data;
+
+    pthread_mutex_lock(&e->mutex);
+    ++e->stream_count;
+    pthread_mutex_unlock(&e->mutex);
+
+    return s;
+}
+
+void vadc_batch_stream_close(VadcBatchStream* s) {
+    if (!s) return;
+    VadcBatchEngine* e = s->engine;
+
+    pthread_mutex_lock(&e->mutex);
+    if (s->queue_count > 0) {
+        ++e->flush_requests;
+        pthread_cond_signal(&e->wake);
+    }
+    while (s->queue_count > 0) {
+        pthread_cond_wait(&e->done, &e->mutex);
+    }
+    --e->stream_count;
+    pthread_mutex_unlock(&e->mutex);
+
+    free(s);
+}
+
+int vadc_batch_submit(VadcBatchStream* s, const int16_t* pcm_data, size_t samples) {
+    if (!s || !pcm_data) return -1;
+    VadcBatchEngine* e = s->engine;
+    if (samples != (size_t)e->window_samples) return -1;
+
+    pthread_mutex_lock(&e->mutex);
+    while (s->queue_count == VADC_BATCH_STREAM_QUEUE) {
+        pthread_cond_wait(&e->done, &e->mutex);
+    }
+
+    int slot = (s->queue_head + s->queue_count) % VADC_BATCH_STREAM_QUEUE;
+    float* window = s->queue + slot * e->window_samples;
+    for (size_t i = 0; i < samples; ++i) {
+        window[i] = (float)pcm_data[i] / 32768.0f;
+    }
+    s->queue_timestamps[slot] = vadc_now_ns();
+    ++s->queue_count;
+
+    // NOTE: a stream whose head window is in the running batch is re-queued by the dispatcher when that batch is done
+    if (s->queue_count == 1 && !s->in_flight) {
+        batch_push_ready(e, s);
+        pthread_cond_signal(&e->wake);
+    }
+    pthread_mutex_unlock(&e->mutex);
+
+    return 0;
+}
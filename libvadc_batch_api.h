@@ -0,0 +1,54 @@
+// Cross-stream dynamic batching C API for running many independent audio
+// streams through one model with one inference call per batch.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct VadcBatchEngine VadcBatchEngine;
+typedef struct VadcBatchStream VadcBatchStream;
+
+/* Called from the engine's dispatcher thread once a submitted window has
+   been run. window_index counts the windows submitted on that stream,
+   starting at 0. Keep the callback short: the next batch is not dispatched
+   until all callbacks of the current one have returned. */
+typedef void (*VadcBatchCallback)(VadcBatchStream* stream, void* user_data,
+                                  int64_t window_index, float probability);
+
+/* Create an engine that loads model_path (may be NULL to use defaults) and
+   starts a dispatcher thread. A batch is dispatched as soon as max_batch
+   streams have a window pending, or when the oldest pending window has
+   waited max_wait_us microseconds, whichever comes first.
+   The model must have a dynamic batch dimension on both its sample input
+   and its lstm state inputs, so each batch entry is an independent stream.
+   Returns NULL on failure. */
+VadcBatchEngine* vadc_batch_engine_create(const char* model_path, int max_batch, int max_wait_us);
+
+/* Stop the dispatcher and free the engine. All streams must be closed. */
+void vadc_batch_engine_destroy(VadcBatchEngine* engine);
+
+/* Dispatch everything that is pending right now, ignoring max_wait_us, and
+   wait until those windows have been run. */
+void vadc_batch_engine_flush(VadcBatchEngine* engine);
+
+/* Number of samples in one window, the size vadc_batch_submit expects. */
+int vadc_batch_engine_window_samples(VadcBatchEngine* engine);
+
+/* Open a stream with its own zeroed lstm state and context. */
+VadcBatchStream* vadc_batch_stream_open(VadcBatchEngine* engine, VadcBatchCallback callback, void* user_data);
+
+/* Wait for the stream's pending windows to be run, then close it. */
+void vadc_batch_stream_close(VadcBatchStream* stream);
+
+/* Queue one window of int16 mono samples at 16kHz. samples must equal
+   vadc_batch_engine_window_samples(). Windows of one stream are always run
+   in submission order, one per batch. Blocks while the stream's queue is
+   full. Returns 0 on success. */
+int vadc_batch_submit(VadcBatchStream* stream, const int16_t* pcm_data, size_t samples);
+
+#ifdef __cplusplus
+}
+#endif
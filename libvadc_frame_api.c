@@ -3,16 +3,89 @@
 #include "memory.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <TracyC.h>
+
+struct VadcModel {
+    MemoryArena arena;
+    u8* arena_base;
+    void* backend; // backend handle from backend_init, owns env, session and io names
+    Silero_Config config;
+    atomic_int refcount;
+};
 
 struct VadcWrapper {
     MemoryArena arena;
     u8* arena_base;
+    VadcModel* model;
+    // per-stream copy of the model's backend state: shares session and names, owns its tensors
+    ONNX_Specific onnx;
     VADC_Context context;
     Silero_Config config;
-    void* backend; // backend handle from backend_init
 };
 
-VadcWrapper* vadc_wrapper_create(size_t arena_bytes, const char* model_path) {
+static VadcModel* vadc_model_load_with_arena(size_t arena_bytes, const char* model_path) {
+    VadcModel* m = (VadcModel*)malloc(sizeof(VadcModel));
+    if (!m) return NULL;
+    memset(m, 0, sizeof(*m));
+    m->arena_base = (u8*)malloc(arena_bytes);
+    if (!m->arena_base) { free(m); return NULL; }
+    initializeMemoryArena(&m->arena, m->arena_base, arena_bytes);
+
+    // build model path String8
+    String8 model_arg = {0};
+    if (model_path && model_path[0]) {
+        model_arg.begin = (u8*)model_path;
+        model_arg.size = (int)strlen(model_path);
+    }
+
+    m->backend = backend_init(&m->arena, model_arg, &m->config);
+    if (!m->backend) {
+        free(m->arena_base); free(m); return NULL;
+    }
+
+    // one window per call, the smallest the model accepts
+    silero_config_finalize(&m->config, 1, (float)m->config.input_size_min);
+
+    // query names once so every wrapper shares them instead of allocating its own
+    ort_query_io_names((ONNX_Specific*)m->backend);
+
+    atomic_init(&m->refcount, 1);
+    return m;
+}
+
+VadcModel* vadc_model_load(const char* model_path) {
+    // the model arena only holds the backend struct
+    return vadc_model_load_with_arena(Kilobytes(64), model_path);
+}
+
+void vadc_model_retain(VadcModel* m) {
+    if (!m) return;
+    atomic_fetch_add(&m->refcount, 1);
+}
+
+void vadc_model_release(VadcModel* m) {
+    if (!m) return;
+    if (atomic_fetch_sub(&m->refcount, 1) != 1) return;
+
+    backend_release(m->backend);
+    if (m->arena_base) free(m->arena_base);
+    free(m);
+}
+
+// max_batch > 1 only takes effect for models that accept several consecutive windows per call
+static VadcWrapper* vadc_wrapper_create_batched(VadcModel* model, int max_batch) {
+    if (!model) return NULL;
+
+    Silero_Config config = model->config;
+    silero_config_finalize(&config, max_batch, (float)config.input_count);
+
+    int row_count = config.context_size + config.input_count;
+    int state_count = (config.is_silero_v5 ? 1 : 2) * config.lstm_hidden_size;
+
+    // input rows, output and four state buffers, plus alignment slack for each push
+    size_t arena_bytes = ((size_t)row_count * config.batch_size + config.prob_tensor_element_count + 4 * (size_t)state_count) * sizeof(float) + 6 * 16;
+
     VadcWrapper* w = (VadcWrapper*)malloc(sizeof(VadcWrapper));
     if (!w) return NULL;
     memset(w, 0, sizeof(*w));
@@ -20,62 +93,82 @@ VadcWrapper* vadc_wrapper_create(size_t arena_bytes, const char* model_path) {
     if (!w->arena_base) { free(w); return NULL; }
     initializeMemoryArena(&w->arena, w->arena_base, arena_bytes);
 
-    memset(&w->config, 0, sizeof(w->config));
-    w->config.is_silero_v5 = true;
-    w->config.batch_size = 1;
-    w->config.batch_size_restriction = 1;
-
-    memset(&w->context, 0, sizeof(w->context));
-    w->context.buffers.window_size_samples = 512;
-    w->context.buffers.lstm_count = 128;
+    w->config = config;
 
     // allocate buffers
-    w->context.buffers.input_samples = (float*)pushSize(&w->arena, 512 * sizeof(float), 16);
-    w->context.buffers.output = (float*)pushSize(&w->arena, sizeof(float), 16);
-    w->context.buffers.lstm_h = (float*)pushSize(&w->arena, 128 * sizeof(float), 16);
-    w->context.buffers.lstm_c = (float*)pushSize(&w->arena, 128 * sizeof(float), 16);
-    w->context.buffers.lstm_h_out = (float*)pushSize(&w->arena, 128 * sizeof(float), 16);
-    w->context.buffers.lstm_c_out = (float*)pushSize(&w->arena, 128 * sizeof(float), 16);
+    w->context.buffers.window_size_samples = config.input_count;
+    w->context.buffers.lstm_count = state_count;
+    w->context.buffers.input_samples = (float*)pushSize(&w->arena, (size_t)row_count * config.batch_size * sizeof(float), 16);
+    w->context.buffers.output = (float*)pushSize(&w->arena, config.prob_tensor_element_count * sizeof(float), 16);
+    w->context.buffers.lstm_h = (float*)pushSize(&w->arena, state_count * sizeof(float), 16);
+    w->context.buffers.lstm_c = (float*)pushSize(&w->arena, state_count * sizeof(float), 16);
+    w->context.buffers.lstm_h_out = (float*)pushSize(&w->arena, state_count * sizeof(float), 16);
+    w->context.buffers.lstm_c_out = (float*)pushSize(&w->arena, state_count * sizeof(float), 16);
 
-    if (!w->context.buffers.input_samples || !w->context.buffers.output) {
-        free(w->arena_base); free(w); return NULL;
-    }
+    w->onnx = *(ONNX_Specific*)model->backend;
+    memset(w->onnx.input_tensors, 0, sizeof(w->onnx.input_tensors));
+    memset(w->onnx.output_tensors, 0, sizeof(w->onnx.output_tensors));
 
-    // build model path String8
-    String8 model_arg = {0};
-    if (model_path && model_path[0]) {
-        model_arg.begin = (u8*)model_path;
-        model_arg.size = (int)strlen(model_path);
-    }
+    w->context.backend = &w->onnx;
+    backend_create_tensors(w->config, w->context.backend, w->context.buffers);
+    vadc_wrapper_reset(w);
 
-    w->backend = backend_init(&w->arena, model_arg, &w->config);
-    if (!w->backend) {
-        free(w->arena_base); free(w); return NULL;
-    }
-    backend_create_tensors(w->config, w->backend, w->context.buffers);
+    vadc_model_retain(model);
+    w->model = model;
+    return w;
+}
+
+VadcWrapper* vadc_wrapper_create_shared(VadcModel* model) {
+    return vadc_wrapper_create_batched(model, 1);
+}
+
+VadcWrapper* vadc_wrapper_create(size_t arena_bytes, const char* model_path) {
+    VadcModel* model = vadc_model_load_with_arena(arena_bytes, model_path);
+    if (!model) return NULL;
+
+    VadcWrapper* w = vadc_wrapper_create_shared(model);
+    // the wrapper holds its own reference, the model goes away with it
+    vadc_model_release(model);
     return w;
 }
 
 void vadc_wrapper_destroy(VadcWrapper* w) {
     if (!w) return;
-    // Note: upstream may provide a backend_free; if not, ignore
+    backend_release_tensors(&w->onnx);
+    vadc_model_release(w->model);
     if (w->arena_base) free(w->arena_base);
     free(w);
 }
 
 int vadc_wrapper_process_frame(VadcWrapper* w, const int16_t* pcm_data, size_t samples, float* out_probability) {
     if (!w || !pcm_data || samples == 0 || !out_probability) return -1;
-    size_t tocopy = samples < (size_t)512 ? samples : 512;
+
+    const size_t window_count = (size_t)w->config.input_count;
+    const size_t context_size = (size_t)w->config.context_size;
+    float* window = w->context.buffers.input_samples + context_size;
+
+    size_t tocopy = samples < window_count ? samples : window_count;
     for (size_t i = 0; i < tocopy; ++i) {
-        w->context.buffers.input_samples[i] = (float)pcm_data[i] / 32768.0f;
+        window[i] = (float)pcm_data[i] / 32768.0f;
     }
+    // zero-pad a short last frame
+    for (size_t i = tocopy; i < window_count; ++i) {
+        window[i] = 0.0f;
+    }
+
     // copy LSTM state
-    memcpy(w->context.buffers.lstm_h, w->context.buffers.lstm_h_out, 128 * sizeof(float));
-    memcpy(w->context.buffers.lstm_c, w->context.buffers.lstm_c_out, 128 * sizeof(float));
+    const size_t state_bytes = (size_t)w->context.buffers.lstm_count * sizeof(float);
+    memcpy(w->context.buffers.lstm_h, w->context.buffers.lstm_h_out, state_bytes);
+    memcpy(w->context.buffers.lstm_c, w->context.buffers.lstm_c_out, state_bytes);
 
     backend_run(&w->arena, &w->context, w->config);
 
-    float p = *w->context.buffers.output;
+    // v5: the tail of this window is the context of the next one
+    if (context_size) {
+        memmove(w->context.buffers.input_samples, w->context.buffers.input_samples + window_count, context_size * sizeof(float));
+    }
+
+    float p = w->context.buffers.output[w->config.silero_probability_out_index];
     if (p < 0.0f) p = 0.0f;
     if (p > 1.0f) p = 1.0f;
     *out_probability = p;
@@ -87,8 +180,278 @@ int vadc_wrapper_sample_rate(void) { return 16000; }
 
 void vadc_wrapper_reset(VadcWrapper* w) {
     if (!w) return;
-    if (w->context.buffers.lstm_h) memset(w->context.buffers.lstm_h, 0, 128 * sizeof(float));
-    if (w->context.buffers.lstm_c) memset(w->context.buffers.lstm_c, 0, 128 * sizeof(float));
-    if (w->context.buffers.lstm_h_out) memset(w->context.buffers.lstm_h_out, 0, 128 * sizeof(float));
-    if (w->context.buffers.lstm_c_out) memset(w->context.buffers.lstm_c_out, 0, 128 * sizeof(float));
+    const size_t state_bytes = (size_t)w->context.buffers.lstm_count * sizeof(float);
+    if (w->context.buffers.lstm_h) memset(w->context.buffers.lstm_h, 0, state_bytes);
+    if (w->context.buffers.lstm_c) memset(w->context.buffers.lstm_c, 0, state_bytes);
+    if (w->context.buffers.lstm_h_out) memset(w->context.buffers.lstm_h_out, 0, state_bytes);
+    if (w->context.buffers.lstm_c_out) memset(w->context.buffers.lstm_c_out, 0, state_bytes);
+    if (w->context.buffers.input_samples) {
+        size_t row_count = (size_t)w->config.context_size + w->config.input_count;
+        memset(w->context.buffers.input_samples, 0, row_count * w->config.batch_size * sizeof(float));
+    }
+}
+
+struct VadcStream {
+    VadcWrapper* core;
+    VadcStreamParams params;
+    VadcSpeechStartCallback on_start;
+    VadcSpeechEndCallback on_end;
+    VadcEventCallback on_event;
+    void* user_data;
+
+    int window_samples;
+    int windows_per_run;
+    int min_speech_chunks;
+    int min_silence_chunks;
+    float seconds_per_chunk;
+    int64_t pad_samples;
+
+    // samples not yet run, up to windows_per_run windows
+    float* pending;
+    size_t pending_count;
+    float* probabilities;
+
+    FeedState state;
+    FeedProbabilityResult buffered;
+    VADC_Event_Tracker events;
+    // a start callback has fired and its end has not yet
+    int segment_open;
+    int chunk_index;
+    int64_t samples_pushed;
+};
+
+void vadc_stream_params_default(VadcStreamParams* params) {
+    if (!params) return;
+    // same defaults as the CLI
+    params->threshold = 0.5f;
+    params->neg_threshold = 0.5f - 0.15f;
+    params->min_silence_ms = 200.0f;
+    params->min_speech_ms = 250.0f;
+    params->speech_pad_ms = 30.0f;
+    params->max_batch = 1;
+}
+
+static int ms_to_chunks(float ms, float chunk_ms) {
+    int chunks = (int)(ms / chunk_ms + 0.5f);
+    return chunks < 1 ? 1 : chunks;
+}
+
+static void stream_emit_start(VadcStream* st, int speech_start_chunk) {
+    int64_t start_sample = (int64_t)speech_start_chunk * st->window_samples - st->pad_samples;
+    if (start_sample < 0) start_sample = 0;
+    st->segment_open = 1;
+    if (st->on_start) st->on_start(st->user_data, start_sample);
+}
+
+static void stream_emit_end(VadcStream* st, FeedProbabilityResult segment) {
+    if (!st->segment_open) stream_emit_start(st, segment.speech_start);
+
+    int64_t start_sample = (int64_t)segment.speech_start * st->window_samples - st->pad_samples;
+    if (start_sample < 0) start_sample = 0;
+    int64_t end_sample = (int64_t)segment.speech_end * st->window_samples + st->pad_samples;
+    if (end_sample > st->samples_pushed) end_sample = st->samples_pushed;
+
+    st->segment_open = 0;
+    if (st->on_end) st->on_end(st->user_data, start_sample, end_sample);
+}
+
+// VadcEventType is VADC_Event_Type in the same order
+static void stream_emit_events(VadcStream* st, const VADC_Event* events, int event_count) {
+    for (int i = 0; i < event_count; ++i) {
+        VADC_Event e = events[i];
+        VadcEvent event;
+        event.type = (VadcEventType)e.type;
+        event.sample = (int64_t)(vadc_event_seconds(e, st->params.speech_pad_ms, st->seconds_per_chunk) * HARDCODED_SAMPLE_RATE + 0.5f);
+        if (event.sample > st->samples_pushed) event.sample = st->samples_pushed;
+        event.latency_samples = (int64_t)(e.decided_chunks - e.chunk) * st->window_samples;
+        st->on_event(st->user_data, &event);
+    }
+}
+
+static void stream_feed(VadcStream* st, float probability) {
+    const int chunk_index = st->chunk_index++;
+    const float pad_ms = st->params.speech_pad_ms;
+    const float spc = st->seconds_per_chunk;
+
+    FeedProbabilityResult feed_result = feed_probability(&st->state,
+                                                         st->min_silence_chunks,
+                                                         st->min_speech_chunks,
+                                                         probability,
+                                                         st->params.threshold,
+                                                         st->params.neg_threshold,
+                                                         chunk_index);
+    if (st->on_event) {
+        VADC_Event events[VADC_EVENTS_PER_WINDOW_MAX];
+        int event_count = vadc_event_tracker_feed(&st->events, &st->state, feed_result, chunk_index, events);
+        stream_emit_events(st, events, event_count);
+    }
+
+    if (feed_result.is_valid) {
+        FeedProbabilityResult finished = {0};
+        st->buffered = combine_speech_segment(st->buffered, feed_result, pad_ms, spc, &finished);
+        if (finished.is_valid) stream_emit_end(st, finished);
+        if (!st->segment_open) stream_emit_start(st, st->buffered.speech_start);
+    }
+
+    // report the start as soon as the running speech is long enough that feed_probability can't drop it
+    if (st->state.triggered) {
+        int end_candidate = st->state.temp_end ? st->state.temp_end : chunk_index + 1;
+        if (end_candidate - st->state.current_speech_start >= st->min_speech_chunks) {
+            if (st->buffered.is_valid &&
+                !speech_segments_touch(st->buffered, st->state.current_speech_start, pad_ms, spc)) {
+                stream_emit_end(st, st->buffered);
+                st->buffered.is_valid = 0;
+            }
+            if (!st->segment_open) stream_emit_start(st, st->state.current_speech_start);
+        }
+    }
+
+    // finish the buffered segment once no later speech can merge into it any more
+    if (st->buffered.is_valid) {
+        int next_start = st->state.triggered ? st->state.current_speech_start : chunk_index + 1;
+        if (!speech_segments_touch(st->buffered, next_start, pad_ms, spc)) {
+            stream_emit_end(st, st->buffered);
+            st->buffered.is_valid = 0;
+        }
+    }
+}
+
+static void stream_run_pending(VadcStream* st, int windows_count) {
+    VadcWrapper* w = st->core;
+    const size_t run_samples = (size_t)st->windows_per_run * st->window_samples;
+
+    // zero-pad to a full run, only happens for the last one
+    for (size_t i = st->pending_count; i < run_samples; ++i) {
+        st->pending[i] = 0.0f;
+    }
+
+    if (w->config.is_silero_v5) {
+        process_chunks_v5(&w->arena, w->context, w->config, run_samples, st->pending, st->probabilities);
+    } else {
+        process_chunks(&w->arena, w->context, w->config, run_samples, st->pending, st->probabilities);
+    }
+
+    for (int i = 0; i < windows_count; ++i) {
+        TracyCPlot("stream probability", st->probabilities[i]);
+        stream_feed(st, st->probabilities[i]);
+        TracyCFrameMarkNamed("stream window");
+    }
+    st->pending_count = 0;
+}
+
+VadcStream* vadc_stream_create(VadcModel* model, const VadcStreamParams* params,
+                               VadcSpeechStartCallback on_start, VadcSpeechEndCallback on_end,
+                               void* user_data) {
+    if (!model) return NULL;
+
+    VadcStreamParams p;
+    if (params) p = *params;
+    else vadc_stream_params_default(&p);
+    if (p.max_batch < 1) p.max_batch = 1;
+
+    VadcStream* st = (VadcStream*)malloc(sizeof(VadcStream));
+    if (!st) return NULL;
+    memset(st, 0, sizeof(*st));
+
+    st->core = vadc_wrapper_create_batched(model, p.max_batch);
+    if (!st->core) { free(st); return NULL; }
+
+    st->params = p;
+    st->on_start = on_start;
+    st->on_end = on_end;
+    st->user_data = user_data;
+
+    const Silero_Config* config = &st->core->config;
+    st->window_samples = config->input_count;
+    st->windows_per_run = config->batch_size;
+
+    const float chunk_ms = config->input_count / (float)HARDCODED_SAMPLE_RATE * 1000.0f;
+    st->min_speech_chunks = ms_to_chunks(p.min_speech_ms, chunk_ms);
+    st->min_silence_chunks = ms_to_chunks(p.min_silence_ms, chunk_ms);
+    st->seconds_per_chunk = (float)config->input_count / HARDCODED_SAMPLE_RATE;
+    st->pad_samples = (int64_t)(p.speech_pad_ms * HARDCODED_SAMPLE_RATE / 1000.0f + 0.5f);
+    st->events.min_speech_duration_chunks = st->min_speech_chunks;
+
+    size_t run_samples = (size_t)st->windows_per_run * st->window_samples;
+    st->pending = (float*)malloc(run_samples * sizeof(float) + st->windows_per_run * sizeof(float));
+    if (!st->pending) { vadc_wrapper_destroy(st->core); free(st); return NULL; }
+    st->probabilities = st->pending + run_samples;
+
+    return st;
+}
+
+int vadc_stream_push(VadcStream* st, const int16_t* pcm_data, size_t samples) {
+    if (!st || (!pcm_data && samples)) return -1;
+
+    const size_t run_samples = (size_t)st->windows_per_run * st->window_samples;
+    while (samples > 0) {
+        size_t room = run_samples - st->pending_count;
+        size_t tocopy = samples < room ? samples : room;
+        float* dst = st->pending + st->pending_count;
+        for (size_t i = 0; i < tocopy; ++i) {
+            dst[i] = (float)pcm_data[i] / 32768.0f;
+        }
+        st->pending_count += tocopy;
+        st->samples_pushed += (int64_t)tocopy;
+        pcm_data += tocopy;
+        samples -= tocopy;
+
+        if (st->pending_count == run_samples) {
+            stream_run_pending(st, st->windows_per_run);
+        }
+    }
+    return 0;
+}
+
+int vadc_stream_finish(VadcStream* st) {
+    if (!st) return -1;
+
+    // like the CLI, a trailing partial window is not run
+    int windows_count = (int)(st->pending_count / st->window_samples);
+    if (windows_count > 0) {
+        stream_run_pending(st, windows_count);
+    }
+    st->pending_count = 0;
+
+    // close speech still running at the end of the audio, snapped to the audio length
+    if (st->state.triggered) {
+        int speech_chunks = st->chunk_index - st->state.current_speech_start;
+        if (st->segment_open || speech_chunks > st->min_speech_chunks) {
+            FeedProbabilityResult final_segment = {0};
+            final_segment.is_valid = 1;
+            final_segment.speech_start = st->state.current_speech_start;
+            final_segment.speech_end = st->chunk_index;
+
+            FeedProbabilityResult finished = {0};
+            st->buffered = combine_speech_segment(st->buffered, final_segment, st->params.speech_pad_ms, st->seconds_per_chunk, &finished);
+            if (finished.is_valid) stream_emit_end(st, finished);
+        }
+    }
+
+    if (st->buffered.is_valid) {
+        stream_emit_end(st, st->buffered);
+    }
+
+    if (st->on_event) {
+        VADC_Event events[VADC_EVENTS_PER_WINDOW_MAX];
+        int event_count = vadc_event_tracker_finish(&st->events, st->chunk_index, st->chunk_index, events);
+        stream_emit_events(st, events, event_count);
+    }
+
+    memset(&st->state, 0, sizeof(st->state));
+    memset(&st->buffered, 0, sizeof(st->buffered));
+    return 0;
+}
+
+void vadc_stream_set_event_callback(VadcStream* st, VadcEventCallback on_event, int provisional) {
+    if (!st) return;
+    st->on_event = on_event;
+    st->events.provisional = provisional ? 1 : 0;
+}
+
+void vadc_stream_destroy(VadcStream* st) {
+    if (!st) return;
+    vadc_wrapper_destroy(st->core);
+    free(st->pending);
+    free(st);
 }
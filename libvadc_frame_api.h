@@ -7,14 +7,35 @@
 extern "C" {
 #endif
 
+typedef struct VadcModel VadcModel;
 typedef struct VadcWrapper VadcWrapper;
 
-/* Create a VADC wrapper which allocates an internal MemoryArena of
-   arena_bytes and initializes the ONNX backend using model_path (may be
-   NULL to use defaults). Returns NULL on failure. */
+/* Load a model once (ONNX env, session and model metadata) so that many
+   wrappers can share it. model_path may be NULL to use defaults. The
+   returned model holds one reference. Returns NULL on failure. */
+VadcModel* vadc_model_load(const char* model_path);
+
+/* Add a reference to the model. */
+void vadc_model_retain(VadcModel* model);
+
+/* Drop a reference; the session is freed when the last one is gone.
+   Each wrapper holds its own reference, so the caller may release its
+   reference right after creating the wrappers it needs. */
+void vadc_model_release(VadcModel* model);
+
+/* Create a lightweight per-stream wrapper on a shared model. Only the
+   stream's LSTM state, context and in/out buffers are allocated. Wrappers
+   of the same model may be used from different threads concurrently.
+   Returns NULL on failure. */
+VadcWrapper* vadc_wrapper_create_shared(VadcModel* model);
+
+/* Create a VADC wrapper with a private model loaded from model_path (may
+   be NULL to use defaults). arena_bytes sizes the arena that holds the
+   model state. Returns NULL on failure. */
 VadcWrapper* vadc_wrapper_create(size_t arena_bytes, const char* model_path);
 
-/* Destroy wrapper and free associated memory. */
+/* Destroy wrapper and free associated memory, releasing its model
+   reference. */
 void vadc_wrapper_destroy(VadcWrapper* w);
 
 /* Process a single frame of int16 samples (mono). Samples count should
@@ -25,6 +46,76 @@ int vadc_wrapper_process_frame(VadcWrapper* w, const int16_t* pcm_data, size_t s
 /* Reset internal LSTM states to zeros. */
 void vadc_wrapper_reset(VadcWrapper* w);
 
+/* Streaming segmentation on top of a shared model: push PCM of any length,
+   the stream buffers partial windows, runs full ones and reports speech
+   segments through callbacks. Nothing is written to stdout. */
+typedef struct VadcStream VadcStream;
+
+typedef struct VadcStreamParams {
+    float threshold;      /* speech starts at or above this probability */
+    float neg_threshold;  /* and ends below this one */
+    float min_silence_ms;
+    float min_speech_ms;
+    float speech_pad_ms;
+    int max_batch;        /* windows per inference call, 1 gives the lowest latency */
+} VadcStreamParams;
+
+/* Called once speech is certain to form a segment. start_sample is the
+   padded start, counted from the first pushed sample. */
+typedef void (*VadcSpeechStartCallback)(void* user_data, int64_t start_sample);
+
+/* Called when a segment is complete: [start_sample, end_sample) padded and
+   after merging segments whose padding overlaps. Every start callback is
+   followed by exactly one end callback with the same start_sample. */
+typedef void (*VadcSpeechEndCallback)(void* user_data, int64_t start_sample, int64_t end_sample);
+
+/* Endpoint events, for reacting while speech is still going on (barge-in).
+   Unlike the start/end callbacks they are never merged: SPEECH_START fires
+   as soon as min_speech_ms is met, SPEECH_END as soon as min_silence_ms
+   confirms the end. The provisional types only come when asked for. */
+typedef enum VadcEventType {
+    VADC_EVENT_SPEECH_START = 0,
+    VADC_EVENT_SPEECH_END,
+    VADC_EVENT_PROVISIONAL_START, /* first window at or above threshold */
+    VADC_EVENT_PROVISIONAL_END,   /* first window below neg_threshold after a start */
+    VADC_EVENT_START_RETRACTED,   /* the provisional start was too short */
+    VADC_EVENT_END_RETRACTED      /* speech resumed after a provisional end */
+} VadcEventType;
+
+typedef struct VadcEvent {
+    VadcEventType type;
+    int64_t sample;          /* padded like the segments, from the first pushed sample */
+    int64_t latency_samples; /* audio between the unpadded boundary and the decision */
+} VadcEvent;
+
+typedef void (*VadcEventCallback)(void* user_data, const VadcEvent* event);
+
+/* Fill params with the CLI defaults. */
+void vadc_stream_params_default(VadcStreamParams* params);
+
+/* Create a stream on model (it takes its own reference). params may be
+   NULL for defaults; either callback may be NULL. Returns NULL on failure. */
+VadcStream* vadc_stream_create(VadcModel* model, const VadcStreamParams* params,
+                               VadcSpeechStartCallback on_start, VadcSpeechEndCallback on_end,
+                               void* user_data);
+
+/* Push int16 mono samples at 16kHz. Callbacks fire from inside this call.
+   Returns 0 on success. */
+int vadc_stream_push(VadcStream* stream, const int16_t* pcm_data, size_t samples);
+
+/* End of audio: run the buffered full windows and close any open segment.
+   A trailing partial window is dropped, as in the CLI. Only
+   vadc_stream_destroy may follow. */
+int vadc_stream_finish(VadcStream* stream);
+
+/* Report endpoint events through on_event (NULL turns them off), with the
+   provisional ones too if provisional is non-zero. Set it before the first
+   push. Events fire from inside push and finish, with the stream's
+   user_data. */
+void vadc_stream_set_event_callback(VadcStream* stream, VadcEventCallback on_event, int provisional);
+
+void vadc_stream_destroy(VadcStream* stream);
+
 /* Query constants used by the wrapper */
 int vadc_wrapper_frame_samples(void);
 int vadc_wrapper_sample_rate(void);
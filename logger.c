@@ -0,0 +1,829 @@
+#include "logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <poll.h>
+#include <pthread.h>
+
+// NOTE: record.level of the filler in front of a wrap, a record never straddles the end of the ring
+#define VADC_LOG_PADDING 0xffffffffu
+
+typedef struct VADC_Log_Record VADC_Log_Record;
+struct VADC_Log_Record
+{
+   // NOTE: header and arguments, a multiple of 8
+   u32 size;
+   u32 level;
+   s64 time_ns;
+   const char *format;
+   FILE *file;
+};
+
+static _Atomic(VADC_Log_Ring *) g_log_rings;
+static _Thread_local VADC_Log_Ring *g_log_this_ring;
+static pthread_key_t g_log_ring_key;
+
+static atomic_int g_log_level = VADC_Log_Info;
+static atomic_int g_log_rate;
+
+static pthread_once_t g_log_once = PTHREAD_ONCE_INIT;
+static pthread_t g_log_thread;
+static atomic_int g_log_running;
+static atomic_int g_log_quit;
+
+void vadc_log_set_level(VADC_Log_Level level)
+{
+   atomic_store(&g_log_level, (int)level);
+}
+
+VADC_Log_Level vadc_log_level(void)
+{
+   return (VADC_Log_Level)atomic_load_explicit(&g_log_level, memory_order_relaxed);
+}
+
+b32 vadc_log_enabled(VADC_Log_Level level)
+{
+   return (int)level <= atomic_load_explicit(&g_log_level, memory_order_relaxed);
+}
+
+void vadc_log_set_rate(int messages_per_second)
+{
+   atomic_store(&g_log_rate, messages_per_second > 0 ? messages_per_second : 0);
+}
+
+VADC_Log_Level vadc_log_level_from_string(const char *name)
+{
+   static const char *names[VADC_Log_COUNT] = { "error", "warn", "info", "debug" };
+   for (int level = 0; level < VADC_Log_COUNT; ++level)
+   {
+      if (strcmp(name, names[level]) == 0)
+      {
+         return (VADC_Log_Level)level;
+      }
+   }
+   return VADC_Log_COUNT;
+}
+
+//
+// Format specs, parsed the same way when the arguments are copied and when they are formatted
+//
+
+typedef enum Log_Arg_Kind
+{
+   Log_Arg_Invalid = 0,
+   Log_Arg_Percent,
+   Log_Arg_Signed,
+   Log_Arg_Unsigned,
+   Log_Arg_Char,
+   Log_Arg_Double,
+   Log_Arg_String,
+   Log_Arg_Pointer,
+} Log_Arg_Kind;
+
+typedef struct Log_Spec Log_Spec;
+struct Log_Spec
+{
+   char flags[8];
+   int flag_count;
+   b32 width_star;
+   int width;
+   b32 precision_star;
+   int precision;
+   char length[3];
+   char conversion;
+   Log_Arg_Kind kind;
+};
+
+// NOTE: p points past the '%', returns the text after the conversion
+static const char *log_parse_spec(const char *p, Log_Spec *spec)
+{
+   memset(spec, 0, sizeof(*spec));
+   spec->width = -1;
+   spec->precision = -1;
+
+   while (*p && strchr("-+ #0'", *p))
+   {
+      if (spec->flag_count < (int)sizeof(spec->flags) - 1)
+      {
+         spec->flags[spec->flag_count++] = *p;
+      }
+      ++p;
+   }
+
+   if (*p == '*')
+   {
+      spec->width_star = 1;
+      ++p;
+   }
+   else if (*p >= '0' && *p <= '9')
+   {
+      spec->width = 0;
+      while (*p >= '0' && *p <= '9')
+      {
+         spec->width = spec->width * 10 + (*p++ - '0');
+      }
+   }
+
+   if (*p == '.')
+   {
+      ++p;
+      if (*p == '*')
+      {
+         spec->precision_star = 1;
+         ++p;
+      }
+      else
+      {
+         spec->precision = 0;
+         while (*p >= '0' && *p <= '9')
+         {
+            spec->precision = spec->precision * 10 + (*p++ - '0');
+         }
+      }
+   }
+
+   int length_count = 0;
+   while (*p && strchr("hlLqjzt", *p) && length_count < 2)
+   {
+      spec->length[length_count++] = *p++;
+   }
+
+   spec->conversion = *p;
+   switch (*p)
+   {
+      case '%': spec->kind = Log_Arg_Percent; break;
+      case 'd': case 'i': spec->kind = Log_Arg_Signed; break;
+      case 'o': case 'u': case 'x': case 'X': spec->kind = Log_Arg_Unsigned; break;
+      case 'c': spec->kind = Log_Arg_Char; break;
+      case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': spec->kind = Log_Arg_Double; break;
+      // NOTE: wide strings aren't supported
+      case 's': spec->kind = spec->length[0] ? Log_Arg_Invalid : Log_Arg_String; break;
+      case 'p': spec->kind = Log_Arg_Pointer; break;
+      default: spec->kind = Log_Arg_Invalid; break;
+   }
+   return *p ? p + 1 : p;
+}
+
+static b32 log_length_is(const Log_Spec *spec, const char *length)
+{
+   return strcmp(spec->length, length) == 0;
+}
+
+//
+// Caller side, the arguments copied into the record
+//
+
+typedef struct Log_Payload Log_Payload;
+struct Log_Payload
+{
+   u8 *data;
+   size_t size;
+   size_t capacity;
+};
+
+static b32 log_put(Log_Payload *payload, const void *value, size_t size)
+{
+   size_t padded = (size + 7) & ~(size_t)7;
+   if (payload->size + padded > payload->capacity)
+   {
+      payload->size = payload->capacity;
+      return 0;
+   }
+   memcpy(payload->data + payload->size, value, size);
+   payload->size += padded;
+   return 1;
+}
+
+static s64 log_va_signed(const Log_Spec *spec, va_list *args)
+{
+   if (log_length_is(spec, "hh")) return (signed char)va_arg(*args, int);
+   if (log_length_is(spec, "h")) return (short)va_arg(*args, int);
+   if (log_length_is(spec, "l")) return va_arg(*args, long);
+   if (log_length_is(spec, "ll") || log_length_is(spec, "q")) return va_arg(*args, long long);
+   if (log_length_is(spec, "j")) return va_arg(*args, intmax_t);
+   if (log_length_is(spec, "z")) return (ptrdiff_t)va_arg(*args, size_t);
+   if (log_length_is(spec, "t")) return va_arg(*args, ptrdiff_t);
+   return va_arg(*args, int);
+}
+
+static u64 log_va_unsigned(const Log_Spec *spec, va_list *args)
+{
+   if (log_length_is(spec, "hh")) return (unsigned char)va_arg(*args, unsigned int);
+   if (log_length_is(spec, "h")) return (unsigned short)va_arg(*args, unsigned int);
+   if (log_length_is(spec, "l")) return va_arg(*args, unsigned long);
+   if (log_length_is(spec, "ll") || log_length_is(spec, "q")) return va_arg(*args, unsigned long long);
+   if (log_length_is(spec, "j")) return va_arg(*args, uintmax_t);
+   if (log_length_is(spec, "z")) return va_arg(*args, size_t);
+   if (log_length_is(spec, "t")) return (u64)va_arg(*args, ptrdiff_t);
+   return va_arg(*args, unsigned int);
+}
+
+static void log_capture(Log_Payload *payload, const char *format, va_list *args)
+{
+   const char *p = format;
+   while (*p && payload->size < payload->capacity)
+   {
+      if (*p++ != '%')
+      {
+         continue;
+      }
+
+      Log_Spec spec;
+      p = log_parse_spec(p, &spec);
+      if (spec.kind == Log_Arg_Invalid)
+      {
+         break;
+      }
+
+      if (spec.width_star)
+      {
+         s64 width = va_arg(*args, int);
+         log_put(payload, &width, sizeof(width));
+      }
+      if (spec.precision_star)
+      {
+         s64 precision = va_arg(*args, int);
+         spec.precision = (int)precision;
+         log_put(payload, &precision, sizeof(precision));
+      }
+
+      switch (spec.kind)
+      {
+         case Log_Arg_Signed:
+         {
+            s64 value = log_va_signed(&spec, args);
+            log_put(payload, &value, sizeof(value));
+         } break;
+
+         case Log_Arg_Unsigned:
+         {
+            u64 value = log_va_unsigned(&spec, args);
+            log_put(payload, &value, sizeof(value));
+         } break;
+
+         case Log_Arg_Char:
+         {
+            s64 value = va_arg(*args, int);
+            log_put(payload, &value, sizeof(value));
+         } break;
+
+         case Log_Arg_Double:
+         {
+            double value = log_length_is(&spec, "L") ? (double)va_arg(*args, long double) : va_arg(*args, double);
+            log_put(payload, &value, sizeof(value));
+         } break;
+
+         case Log_Arg_String:
+         {
+            const char *value = va_arg(*args, const char *);
+            if (!value)
+            {
+               value = "(null)";
+            }
+            u64 length = spec.precision >= 0 ? strnlen(value, (size_t)spec.precision) : strlen(value);
+            // NOTE: cut to what is left of the record
+            size_t room = payload->capacity - payload->size;
+            room = room > sizeof(u64) ? room - sizeof(u64) : 0;
+            length = length < room ? length : room;
+            if (log_put(payload, &length, sizeof(length)))
+            {
+               log_put(payload, value, (size_t)length);
+            }
+         } break;
+
+         case Log_Arg_Pointer:
+         {
+            u64 value = (u64)(uintptr_t)va_arg(*args, void *);
+            log_put(payload, &value, sizeof(value));
+         } break;
+
+         default:
+         {
+         } break;
+      }
+   }
+}
+
+//
+// Flusher side, the record formatted into one line
+//
+
+typedef struct Log_Reader Log_Reader;
+struct Log_Reader
+{
+   const u8 *data;
+   size_t size;
+   size_t at;
+};
+
+static const void *log_get(Log_Reader *reader, size_t size)
+{
+   size_t padded = (size + 7) & ~(size_t)7;
+   if (reader->at + size > reader->size)
+   {
+      return NULL;
+   }
+   const void *value = reader->data + reader->at;
+   reader->at += padded;
+   return value;
+}
+
+static b32 log_get_s64(Log_Reader *reader, s64 *value)
+{
+   const void *stored = log_get(reader, sizeof(*value));
+   if (!stored)
+   {
+      return 0;
+   }
+   memcpy(value, stored, sizeof(*value));
+   return 1;
+}
+
+static size_t log_append(size_t capacity, size_t length, int written)
+{
+   if (written < 0)
+   {
+      return length;
+   }
+   length += (size_t)written;
+   return length < capacity ? length : capacity - 1;
+}
+
+// NOTE: the line without its newline, returns the length
+static size_t log_format(char *out, size_t capacity, const char *format, const u8 *payload, size_t payload_size)
+{
+   Log_Reader reader = { payload, payload_size, 0 };
+   size_t length = 0;
+   out[0] = 0;
+
+   const char *p = format;
+   while (*p && length < capacity - 1)
+   {
+      if (*p != '%')
+      {
+         out[length++] = *p++;
+         out[length] = 0;
+         continue;
+      }
+
+      Log_Spec spec;
+      const char *spec_begin = p;
+      p = log_parse_spec(p + 1, &spec);
+      if (spec.kind == Log_Arg_Invalid)
+      {
+         // NOTE: printed as is, like the arguments after it were never copied
+         length = log_append(capacity, length, snprintf(out + length, capacity - length, "%s", spec_begin));
+         break;
+      }
+      if (spec.kind == Log_Arg_Percent)
+      {
+         out[length++] = '%';
+         out[length] = 0;
+         continue;
+      }
+
+      s64 width = spec.width;
+      s64 precision = spec.precision;
+      b32 complete = 1;
+      if (spec.width_star)
+      {
+         complete = complete && log_get_s64(&reader, &width);
+      }
+      if (spec.precision_star)
+      {
+         complete = complete && log_get_s64(&reader, &precision);
+      }
+
+      char spec_text[64];
+      int spec_length = 0;
+      spec_text[spec_length++] = '%';
+      for (int i = 0; i < spec.flag_count; ++i)
+      {
+         spec_text[spec_length++] = spec.flags[i];
+      }
+      if (spec.width_star && width < 0)
+      {
+         // NOTE: a negative * width is the '-' flag
+         spec_text[spec_length++] = '-';
+         width = -width;
+      }
+
+      s64 value = 0;
+      u64 string_length = 0;
+      const char *string = NULL;
+      if (complete && spec.kind == Log_Arg_String)
+      {
+         const u64 *stored_length = log_get(&reader, sizeof(u64));
+         if (stored_length)
+         {
+            memcpy(&string_length, stored_length, sizeof(string_length));
+            string = log_get(&reader, (size_t)string_length);
+         }
+         complete = (string != NULL);
+         string = string ? string : "";
+         // NOTE: the copy isn't terminated, its length is the precision
+         precision = (s64)string_length;
+      }
+      else if (complete)
+      {
+         complete = log_get_s64(&reader, &value);
+      }
+
+      if (!complete)
+      {
+         length = log_append(capacity, length, snprintf(out + length, capacity - length, "..."));
+         break;
+      }
+
+      if (width >= 0)
+      {
+         spec_length += snprintf(spec_text + spec_length, sizeof(spec_text) - spec_length, "%d", (int)width);
+      }
+      if (precision >= 0)
+      {
+         spec_length += snprintf(spec_text + spec_length, sizeof(spec_text) - spec_length, ".%d", (int)precision);
+      }
+      if (spec.kind == Log_Arg_Signed || spec.kind == Log_Arg_Unsigned)
+      {
+         spec_text[spec_length++] = 'l';
+         spec_text[spec_length++] = 'l';
+      }
+      spec_text[spec_length++] = spec.conversion;
+      spec_text[spec_length] = 0;
+
+      char *target = out + length;
+      size_t room = capacity - length;
+      int written = -1;
+      switch (spec.kind)
+      {
+         case Log_Arg_Signed: written = snprintf(target, room, spec_text, (long long)value); break;
+         case Log_Arg_Unsigned: written = snprintf(target, room, spec_text, (unsigned long long)(u64)value); break;
+         case Log_Arg_Char: written = snprintf(target, room, spec_text, (int)value); break;
+         case Log_Arg_Double:
+         {
+            double number;
+            memcpy(&number, &value, sizeof(number));
+            written = snprintf(target, room, spec_text, number);
+         } break;
+         case Log_Arg_String: written = snprintf(target, room, spec_text, string); break;
+         case Log_Arg_Pointer: written = snprintf(target, room, spec_text, (void *)(uintptr_t)(u64)value); break;
+         default: break;
+      }
+      length = log_append(capacity, length, written);
+   }
+   return length;
+}
+
+// NOTE: the first record after ring->read that is a message, NULL if the ring is empty
+static const VADC_Log_Record *log_peek(VADC_Log_Ring *ring)
+{
+   size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+   while (ring->read != head)
+   {
+      const VADC_Log_Record *record = (const VADC_Log_Record *)(ring->buffer + (ring->read & (VADC_LOG_RING_BYTES - 1)));
+      if (record->level != VADC_LOG_PADDING)
+      {
+         return record;
+      }
+      ring->read += record->size;
+   }
+   return NULL;
+}
+
+// NOTE: writes what all threads logged so far, oldest first. Returns the number of messages.
+static int log_drain(void)
+{
+   // NOTE: a batch is bounded so the rings get their space back regularly
+   const int batch_max = 256;
+   char line[2048];
+   FILE *touched[8];
+   int touched_count = 0;
+   int message_count = 0;
+
+   VADC_Log_Ring *rings = atomic_load_explicit(&g_log_rings, memory_order_acquire);
+   while (message_count < batch_max)
+   {
+      VADC_Log_Ring *oldest_ring = NULL;
+      const VADC_Log_Record *oldest = NULL;
+      for (VADC_Log_Ring *ring = rings; ring; ring = ring->next)
+      {
+         const VADC_Log_Record *record = log_peek(ring);
+         if (record && (!oldest || record->time_ns < oldest->time_ns))
+         {
+            oldest = record;
+            oldest_ring = ring;
+         }
+      }
+      if (!oldest)
+      {
+         break;
+      }
+
+      size_t length = log_format(line, sizeof(line) - 1, oldest->format,
+                                 (const u8 *)(oldest + 1), oldest->size - sizeof(VADC_Log_Record));
+      line[length++] = '\n';
+      fwrite(line, 1, length, stderr);
+      if (oldest->file)
+      {
+         fwrite(line, 1, length, oldest->file);
+
+         int touched_index = 0;
+         while (touched_index < touched_count && touched[touched_index] != oldest->file)
+         {
+            ++touched_index;
+         }
+         if (touched_index == touched_count)
+         {
+            if (touched_count < (int)ArrayCount(touched))
+            {
+               touched[touched_count++] = oldest->file;
+            }
+            else
+            {
+               fflush(oldest->file);
+            }
+         }
+      }
+
+      oldest_ring->read += oldest->size;
+      ++message_count;
+   }
+
+   fflush(stderr);
+   for (int i = 0; i < touched_count; ++i)
+   {
+      fflush(touched[i]);
+   }
+
+   // NOTE: only now, a thread waiting in vadc_log_flush may close the files once its tail moves
+   for (VADC_Log_Ring *ring = rings; ring; ring = ring->next)
+   {
+      atomic_store_explicit(&ring->tail, ring->read, memory_order_release);
+
+      unsigned long long dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+      if (dropped != ring->dropped_reported)
+      {
+         fprintf(stderr, "Warning: %llu log messages dropped, the log ring was full\n", dropped - ring->dropped_reported);
+         fflush(stderr);
+         ring->dropped_reported = dropped;
+      }
+   }
+   return message_count;
+}
+
+static void *log_flusher_proc(void *param)
+{
+   (void)param;
+   const int idle_sleep_ms = 5;
+
+   for (;;)
+   {
+      // NOTE: read before draining, everything logged before quit was set is then written out
+      int quit = atomic_load(&g_log_quit);
+      if (!log_drain())
+      {
+         if (quit)
+         {
+            break;
+         }
+         poll(NULL, 0, idle_sleep_ms);
+      }
+   }
+   return NULL;
+}
+
+static void log_stop_at_exit(void)
+{
+   if (atomic_exchange(&g_log_running, 0))
+   {
+      atomic_store(&g_log_quit, 1);
+      pthread_join(g_log_thread, NULL);
+   }
+}
+
+// NOTE: a thread's ring goes back to the pool when it ends, the next new thread takes it over
+static void log_release_ring(void *value)
+{
+   VADC_Log_Ring *ring = value;
+   memset(ring->rate_sites, 0, sizeof(ring->rate_sites));
+   atomic_store_explicit(&ring->owned, 0, memory_order_release);
+}
+
+static void log_start(void)
+{
+   pthread_key_create(&g_log_ring_key, log_release_ring);
+   if (pthread_create(&g_log_thread, NULL, log_flusher_proc, NULL) == 0)
+   {
+      atomic_store(&g_log_running, 1);
+      atexit(log_stop_at_exit);
+   }
+}
+
+static VADC_Log_Ring *log_this_ring(void)
+{
+   VADC_Log_Ring *ring = g_log_this_ring;
+   if (ring)
+   {
+      return ring;
+   }
+
+   for (ring = atomic_load(&g_log_rings); ring; ring = ring->next)
+   {
+      int owned = 0;
+      if (atomic_compare_exchange_strong(&ring->owned, &owned, 1))
+      {
+         break;
+      }
+   }
+
+   if (!ring)
+   {
+      // NOTE: never freed, the flusher may still be reading a ring after its thread ended
+      ring = calloc(1, sizeof(VADC_Log_Ring));
+      u8 *buffer = malloc(VADC_LOG_RING_BYTES);
+      if (!ring || !buffer)
+      {
+         free(ring);
+         free(buffer);
+         return NULL;
+      }
+      ring->buffer = buffer;
+      atomic_init(&ring->owned, 1);
+
+      VADC_Log_Ring *head = atomic_load(&g_log_rings);
+      do
+      {
+         ring->next = head;
+      } while (!atomic_compare_exchange_weak(&g_log_rings, &head, ring));
+   }
+
+   pthread_setspecific(g_log_ring_key, ring);
+   g_log_this_ring = ring;
+   return ring;
+}
+
+static void log_push(VADC_Log_Ring *ring, VADC_Log_Level level, FILE *file, s64 now_ns, const char *format, va_list *args)
+{
+   u64 storage[VADC_LOG_RECORD_MAX / sizeof(u64)];
+   VADC_Log_Record *record = (VADC_Log_Record *)storage;
+   Log_Payload payload = { (u8 *)(record + 1), 0, sizeof(storage) - sizeof(VADC_Log_Record) };
+   log_capture(&payload, format, args);
+
+   record->size = (u32)(sizeof(VADC_Log_Record) + payload.size);
+   record->level = (u32)level;
+   record->time_ns = now_ns;
+   record->format = format;
+   record->file = file;
+
+   size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+   size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+   size_t offset = head & (VADC_LOG_RING_BYTES - 1);
+   size_t contiguous = VADC_LOG_RING_BYTES - offset;
+   size_t needed = contiguous < record->size ? contiguous + record->size : record->size;
+   if (VADC_LOG_RING_BYTES - (head - tail) < needed)
+   {
+      atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+      return;
+   }
+
+   if (contiguous < record->size)
+   {
+      // NOTE: offsets are multiples of 8, so size and level of the filler always fit
+      u32 padding[2] = { (u32)contiguous, VADC_LOG_PADDING };
+      memcpy(ring->buffer + offset, padding, sizeof(padding));
+      head += contiguous;
+      offset = 0;
+   }
+   memcpy(ring->buffer + offset, record, record->size);
+   atomic_store_explicit(&ring->head, head + record->size, memory_order_release);
+}
+
+static void log_dispatch(VADC_Log_Ring *ring, VADC_Log_Level level, FILE *file, s64 now_ns, const char *format, va_list args)
+{
+   va_list copy;
+   if (ring && atomic_load_explicit(&g_log_running, memory_order_relaxed))
+   {
+      va_copy(copy, args);
+      log_push(ring, level, file, now_ns, format, &copy);
+      va_end(copy);
+      return;
+   }
+
+   // NOTE: no flusher, written here. Each vfprintf needs its own copy, the arguments are used up after one.
+   va_copy(copy, args);
+   vfprintf(stderr, format, copy);
+   va_end(copy);
+   fputc('\n', stderr);
+   fflush(stderr);
+   if (file)
+   {
+      va_copy(copy, args);
+      vfprintf(file, format, copy);
+      va_end(copy);
+      fputc('\n', file);
+      fflush(file);
+   }
+}
+
+static void log_dispatchf(VADC_Log_Ring *ring, VADC_Log_Level level, FILE *file, s64 now_ns, const char *format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   log_dispatch(ring, level, file, now_ns, format, args);
+   va_end(args);
+}
+
+static void log_report_suppressed(VADC_Log_Ring *ring, VADC_Log_Rate_Site *site, s64 now_ns)
+{
+   if (site->suppressed)
+   {
+      log_dispatchf(ring, site->level, site->file, now_ns, "(%d more messages like \"%s\" suppressed by the rate limit)",
+                    site->suppressed, site->format);
+      site->suppressed = 0;
+   }
+}
+
+static b32 log_rate_allow(VADC_Log_Ring *ring, VADC_Log_Level level, FILE *file, const char *format, s64 now_ns)
+{
+   int rate = atomic_load_explicit(&g_log_rate, memory_order_relaxed);
+   if (!rate)
+   {
+      return 1;
+   }
+
+   size_t first = ((uintptr_t)format >> 3) % VADC_LOG_RATE_SITES;
+   for (size_t probe = 0; probe < VADC_LOG_RATE_SITES; ++probe)
+   {
+      VADC_Log_Rate_Site *site = ring->rate_sites + (first + probe) % VADC_LOG_RATE_SITES;
+      if (site->format && site->format != format)
+      {
+         continue;
+      }
+
+      if (!site->format || now_ns - site->window_start_ns >= 1000000000LL)
+      {
+         if (site->format)
+         {
+            log_report_suppressed(ring, site, now_ns);
+         }
+         site->format = format;
+         site->window_start_ns = now_ns;
+         site->count = 0;
+      }
+      site->level = level;
+      site->file = file;
+
+      if (site->count < rate)
+      {
+         ++site->count;
+         return 1;
+      }
+      ++site->suppressed;
+      return 0;
+   }
+   return 1;
+}
+
+void vadc_log_write(VADC_Log_Level level, FILE *file, const char *format, va_list args)
+{
+   if (!vadc_log_enabled(level))
+   {
+      return;
+   }
+
+   pthread_once(&g_log_once, log_start);
+   VADC_Log_Ring *ring = log_this_ring();
+   s64 now_ns = vadc_now_ns();
+
+   if (ring && !log_rate_allow(ring, level, file, format, now_ns))
+   {
+      return;
+   }
+   log_dispatch(ring, level, file, now_ns, format, args);
+}
+
+void vadc_log_flush(void)
+{
+   VADC_Log_Ring *ring = g_log_this_ring;
+   if (!ring)
+   {
+      return;
+   }
+
+   s64 now_ns = vadc_now_ns();
+   for (int i = 0; i < VADC_LOG_RATE_SITES; ++i)
+   {
+      log_report_suppressed(ring, ring->rate_sites + i, now_ns);
+   }
+   // NOTE: the sites remember the file, which the caller is about to close
+   memset(ring->rate_sites, 0, sizeof(ring->rate_sites));
+
+   size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+   while (atomic_load_explicit(&g_log_running, memory_order_relaxed) &&
+          atomic_load_explicit(&ring->tail, memory_order_acquire) != head)
+   {
+      poll(NULL, 0, 1);
+   }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "utils.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+
+// NOTE: vad_log goes through here. A message is not formatted where it is logged: the caller copies
+//       the format pointer and the raw arguments (numbers as 8 bytes, strings by value) into a record
+//       in a ring only its thread writes, and a background flusher formats the records of all threads
+//       in time order, writes them to stderr and the log file and flushes once per batch. Logging is
+//       a level check, a rate check and a copy, it never waits: a full ring drops the message and the
+//       flusher reports how many were lost.
+//       The format has to be a string literal (it is read later, on the flusher), and %n isn't
+//       supported. Long doubles are logged as doubles.
+
+#define VADC_LOG_RING_BYTES (64 * 1024)
+// NOTE: one message, header and arguments, strings are cut to fit
+#define VADC_LOG_RECORD_MAX 1024
+// NOTE: call sites per thread the rate limit keeps track of, later ones aren't limited
+#define VADC_LOG_RATE_SITES 64
+
+typedef enum VADC_Log_Level
+{
+   VADC_Log_Error = 0,
+   VADC_Log_Warn,
+   VADC_Log_Info,
+   VADC_Log_Debug,
+
+   VADC_Log_COUNT
+} VADC_Log_Level;
+
+typedef struct VADC_Log_Rate_Site VADC_Log_Rate_Site;
+struct VADC_Log_Rate_Site
+{
+   const char *format;
+   s64 window_start_ns;
+   int count;
+   int suppressed;
+   // NOTE: of the last message, for the line that sums up the suppressed ones
+   VADC_Log_Level level;
+   FILE *file;
+};
+
+typedef struct VADC_Log_Ring VADC_Log_Ring;
+struct VADC_Log_Ring
+{
+   VADC_Log_Ring *next;
+   // NOTE: a thread is logging through it, rings of finished threads are taken over by new ones
+   atomic_int owned;
+   u8 *buffer;
+   // NOTE: byte counts since the start, head written by the owning thread, tail by the flusher
+   atomic_size_t head;
+   atomic_size_t tail;
+   atomic_ullong dropped;
+
+   // NOTE: owning thread only
+   VADC_Log_Rate_Site rate_sites[VADC_LOG_RATE_SITES];
+
+   // NOTE: flusher only
+   size_t read;
+   unsigned long long dropped_reported;
+};
+
+// NOTE: messages above level are not logged, VADC_Log_Info until set
+void vadc_log_set_level( VADC_Log_Level level );
+VADC_Log_Level vadc_log_level( void );
+b32 vadc_log_enabled( VADC_Log_Level level );
+
+// NOTE: messages per second from one call site (one format string) of one thread, the rest are
+//       counted and summed up in a single line. 0 is no limit.
+void vadc_log_set_rate( int messages_per_second );
+
+// NOTE: one line to stderr and, if not NULL, file
+void vadc_log_write( VADC_Log_Level level, FILE *file, const char *format, va_list args );
+
+// NOTE: returns once everything this thread logged is written and flushed. Call before closing a
+//       file messages were logged to.
+void vadc_log_flush( void );
+
+// NOTE: "error", "warn", "info" or "debug", VADC_Log_COUNT for anything else
+VADC_Log_Level vadc_log_level_from_string( const char *name );
@@ -11,7 +11,11 @@ struct MemoryArena
    size_t size;
    size_t previous_used;
    size_t used;
+   // NOTE: high water mark of used, only ever raised by pushSize. Reset it to used to start a new measurement.
+   size_t peak_used;
    int temporaryMemoryCount;
+   // NOTE: deepest temporary memory nesting seen, reset together with peak_used
+   int peak_temporaryMemoryCount;
 };
 
 void initializeMemoryArena( MemoryArena *arena, u8 *base, size_t size );
@@ -21,6 +25,8 @@ inline b32 isMemoryArenaInitialized( MemoryArena *arena )
 }
 
 void resetMemoryArena( MemoryArena *arena );
+// NOTE: starts a new high water mark measurement from the current state of the arena
+void resetMemoryArenaPeak( MemoryArena *arena );
 b32 addressIsInsideArena( MemoryArena *arena, void *address );
 b32 isPowerOfTwo( size_t number );
 size_t getAlignmentOffset( size_t top, size_t alignment );
@@ -124,7 +130,9 @@ void initializeMemoryArena( MemoryArena *arena, u8 *base, size_t size )
    arena->size = size;
    arena->previous_used = 0;
    arena->used = 0;
+   arena->peak_used = 0;
    arena->temporaryMemoryCount = 0;
+   arena->peak_temporaryMemoryCount = 0;
 
    ASAN_POISON_MEMORY_REGION( base, size );
 }
@@ -137,6 +145,12 @@ void resetMemoryArena( MemoryArena *arena )
    ASAN_POISON_MEMORY_REGION( arena->base, arena->size );
 }
 
+void resetMemoryArenaPeak( MemoryArena *arena )
+{
+   arena->peak_used = arena->used;
+   arena->peak_temporaryMemoryCount = arena->temporaryMemoryCount;
+}
+
 b32 addressIsInsideArena( MemoryArena *arena, void *address )
 {
    u8 *addressChar = (u8 *)address;
@@ -175,6 +189,10 @@ void *pushSize( MemoryArena *arena, size_t size, size_t alignment )
       void *address = arena->base + arena->used + alignmentOffset;
       arena->previous_used = arena->used + alignmentOffset;
       arena->used += size;
+      if ( arena->used > arena->peak_used )
+      {
+         arena->peak_used = arena->used;
+      }
 
       ASAN_UNPOISON_MEMORY_REGION( address, size );
 
@@ -276,6 +294,10 @@ TemporaryMemory beginTemporaryMemory( MemoryArena *arena )
    temporaryMemory.used = arena->used;
 
    ++arena->temporaryMemoryCount;
+   if ( arena->temporaryMemoryCount > arena->peak_temporaryMemoryCount )
+   {
+      arena->peak_temporaryMemoryCount = arena->temporaryMemoryCount;
+   }
 
    return temporaryMemory;
 }
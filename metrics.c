@@ -0,0 +1,303 @@
+#include "metrics.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// NOTE: how long one send to a metrics client may block, a client that stops reading is dropped after it
+#define METRICS_SEND_TIMEOUT_MS 1000
+
+static u64 metrics_load(atomic_ullong *value)
+{
+   return atomic_load_explicit(value, memory_order_relaxed);
+}
+
+void vadc_metrics_init(VADC_Metrics *metrics, int sample_rate)
+{
+   memset(metrics, 0, sizeof(*metrics));
+   metrics->start_ns = vadc_now_ns();
+   metrics->sample_rate = sample_rate;
+   metrics->listen_fd = -1;
+}
+
+typedef struct Metrics_Writer Metrics_Writer;
+struct Metrics_Writer
+{
+   char *buffer;
+   size_t size;
+   size_t used;
+};
+
+static void metrics_printf(Metrics_Writer *writer, const char *format, ...)
+{
+   if (writer->used + 1 >= writer->size)
+   {
+      return;
+   }
+
+   va_list args;
+   va_start(args, format);
+   int written = vsnprintf(writer->buffer + writer->used, writer->size - writer->used, format, args);
+   va_end(args);
+
+   if (written > 0)
+   {
+      writer->used += (size_t)written;
+      if (writer->used >= writer->size)
+      {
+         writer->used = writer->size - 1;
+      }
+   }
+}
+
+static void metrics_counter(Metrics_Writer *writer, const char *name, const char *help, double value)
+{
+   metrics_printf(writer, "# HELP %s %s\n# TYPE %s counter\n%s %.12g\n", name, help, name, name, value);
+}
+
+static void metrics_gauge(Metrics_Writer *writer, const char *name, const char *help, double value)
+{
+   metrics_printf(writer, "# HELP %s %s\n# TYPE %s gauge\n%s %.12g\n", name, help, name, name, value);
+}
+
+size_t vadc_metrics_format(VADC_Metrics *metrics, char *buffer, size_t buffer_size)
+{
+   Metrics_Writer writer = {buffer, buffer_size, 0};
+   if (buffer_size)
+   {
+      buffer[0] = 0;
+   }
+
+   u64 windows = metrics_load(&metrics->windows_processed);
+   u64 speech_windows = metrics_load(&metrics->speech_windows);
+   u64 samples = metrics_load(&metrics->samples_processed);
+   u64 inference_ns = metrics_load(&metrics->inference_ns);
+
+   double audio_seconds = metrics->sample_rate ? (double)samples / metrics->sample_rate : 0.0;
+   double inference_seconds = (double)inference_ns / 1e9;
+   double uptime_seconds = (double)(vadc_now_ns() - metrics->start_ns) / 1e9;
+
+   metrics_counter(&writer, "vadc_windows_processed_total", "Windows run through the model.", (double)windows);
+   metrics_counter(&writer, "vadc_speech_windows_total", "Windows inside a detected speech segment.", (double)speech_windows);
+   metrics_counter(&writer, "vadc_audio_seconds_total", "Seconds of audio read from the input.", audio_seconds);
+   metrics_counter(&writer, "vadc_inference_seconds_total", "Time spent in model inference.", inference_seconds);
+   metrics_counter(&writer, "vadc_input_reads_total", "Reads from the input stream.", (double)metrics_load(&metrics->input_reads));
+   metrics_counter(&writer, "vadc_input_underruns_total", "Input reads that returned less than a full buffer.", (double)metrics_load(&metrics->input_underruns));
+   metrics_counter(&writer, "vadc_segments_emitted_total", "Speech segments written to the output.", (double)metrics_load(&metrics->segments_emitted));
+   metrics_counter(&writer, "vadc_dropped_output_bytes_total", "Output bytes that could not be written.", (double)metrics_load(&metrics->dropped_output_bytes));
+
+   // NOTE: inference time per second of audio, the number to alert on for drift. 1.0 means the model alone
+   //       would only just keep up with real time.
+   metrics_gauge(&writer, "vadc_realtime_factor", "Inference seconds per second of audio since start.",
+                 audio_seconds > 0.0 ? inference_seconds / audio_seconds : 0.0);
+   metrics_gauge(&writer, "vadc_speech_ratio", "Fraction of windows inside speech segments since start.",
+                 windows ? (double)speech_windows / (double)windows : 0.0);
+   metrics_gauge(&writer, "vadc_arena_used_bytes", "Bytes in use in the run's memory arena.", (double)metrics_load(&metrics->arena_used_bytes));
+   metrics_gauge(&writer, "vadc_arena_peak_bytes", "High water mark of the run's memory arena.", (double)metrics_load(&metrics->arena_peak_bytes));
+   metrics_gauge(&writer, "vadc_arena_size_bytes", "Capacity of the run's memory arena.", (double)metrics_load(&metrics->arena_size_bytes));
+   metrics_gauge(&writer, "vadc_uptime_seconds", "Seconds since the metrics were initialized.", uptime_seconds);
+
+   return writer.used;
+}
+
+static void metrics_write_file(VADC_Metrics *metrics, char *buffer, size_t buffer_size)
+{
+   size_t length = vadc_metrics_format(metrics, buffer, buffer_size);
+
+   // NOTE: write next to the target and rename, so a scraper never reads a half written file
+   char temp_path[sizeof(metrics->target_path) + 8];
+   snprintf(temp_path, sizeof(temp_path), "%s.tmp", metrics->target_path);
+
+   FILE *file = fopen(temp_path, "w");
+   if (!file)
+   {
+      return;
+   }
+   size_t written = fwrite(buffer, 1, length, file);
+   b32 failed = (written != length);
+   failed |= (fclose(file) != 0);
+
+   if (!failed)
+   {
+      rename(temp_path, metrics->target_path);
+   }
+   else
+   {
+      unlink(temp_path);
+   }
+}
+
+static void metrics_serve_client(VADC_Metrics *metrics, int client_fd, char *buffer, size_t buffer_size)
+{
+   // NOTE: give an HTTP client a moment to send its request line, a plain `nc -U` just gets the text
+   char request[512];
+   ssize_t request_length = 0;
+   struct pollfd client_poll = {client_fd, POLLIN, 0};
+   if (poll(&client_poll, 1, 100) > 0)
+   {
+      request_length = recv(client_fd, request, sizeof(request) - 1, 0);
+   }
+   b32 is_http = (request_length >= 3 && memcmp(request, "GET", 3) == 0);
+
+   struct timeval send_timeout = {METRICS_SEND_TIMEOUT_MS / 1000, (METRICS_SEND_TIMEOUT_MS % 1000) * 1000};
+   setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+
+   size_t length = vadc_metrics_format(metrics, buffer, buffer_size);
+
+   if (is_http)
+   {
+      char header[160];
+      int header_length = snprintf(header, sizeof(header),
+                                   "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n",
+                                   length);
+      if (send(client_fd, header, (size_t)header_length, MSG_NOSIGNAL) != header_length)
+      {
+         return;
+      }
+   }
+
+   size_t sent = 0;
+   while (sent < length)
+   {
+      ssize_t result = send(client_fd, buffer + sent, length - sent, MSG_NOSIGNAL);
+      if (result <= 0)
+      {
+         break;
+      }
+      sent += (size_t)result;
+   }
+}
+
+static void *metrics_exporter_proc(void *param)
+{
+   VADC_Metrics *metrics = param;
+
+   // NOTE: on this thread's stack, every exporter formats into its own
+   char buffer[8192];
+   const int poll_step_ms = 200;
+
+   if (metrics->target_is_socket)
+   {
+      while (!atomic_load(&metrics->exporter_quit))
+      {
+         struct pollfd listen_poll = {metrics->listen_fd, POLLIN, 0};
+         if (poll(&listen_poll, 1, poll_step_ms) <= 0)
+         {
+            continue;
+         }
+
+         int client_fd = accept(metrics->listen_fd, NULL, NULL);
+         if (client_fd < 0)
+         {
+            continue;
+         }
+         metrics_serve_client(metrics, client_fd, buffer, sizeof(buffer));
+         close(client_fd);
+      }
+   }
+   else
+   {
+      s64 next_write_ns = 0;
+      while (!atomic_load(&metrics->exporter_quit))
+      {
+         s64 now_ns = vadc_now_ns();
+         if (now_ns >= next_write_ns)
+         {
+            metrics_write_file(metrics, buffer, sizeof(buffer));
+            next_write_ns = now_ns + (s64)metrics->interval_ms * 1000000LL;
+         }
+         poll(NULL, 0, poll_step_ms < metrics->interval_ms ? poll_step_ms : metrics->interval_ms);
+      }
+
+      // NOTE: final values, so the file reflects the whole run
+      metrics_write_file(metrics, buffer, sizeof(buffer));
+   }
+
+   return NULL;
+}
+
+int vadc_metrics_start_exporter(VADC_Metrics *metrics, const char *target, int interval_ms)
+{
+   if (!target || !target[0] || metrics->exporter_running)
+   {
+      return -1;
+   }
+
+   const char *socket_prefix = "unix:";
+   size_t socket_prefix_length = strlen(socket_prefix);
+   metrics->target_is_socket = (strncmp(target, socket_prefix, socket_prefix_length) == 0);
+   const char *path = metrics->target_is_socket ? target + socket_prefix_length : target;
+
+   if (strlen(path) >= sizeof(metrics->target_path))
+   {
+      return -1;
+   }
+   strcpy(metrics->target_path, path);
+   metrics->interval_ms = interval_ms > 0 ? interval_ms : 1000;
+
+   if (metrics->target_is_socket)
+   {
+      struct sockaddr_un address = {0};
+      address.sun_family = AF_UNIX;
+      if (strlen(path) >= sizeof(address.sun_path))
+      {
+         return -1;
+      }
+      strcpy(address.sun_path, path);
+
+      int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (listen_fd < 0)
+      {
+         return -1;
+      }
+
+      // NOTE: a socket left over from a previous run would make bind fail
+      unlink(path);
+      if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, 4) != 0)
+      {
+         close(listen_fd);
+         return -1;
+      }
+      metrics->listen_fd = listen_fd;
+   }
+
+   atomic_store(&metrics->exporter_quit, 0);
+   if (pthread_create(&metrics->exporter_thread, NULL, metrics_exporter_proc, metrics) != 0)
+   {
+      if (metrics->listen_fd >= 0)
+      {
+         close(metrics->listen_fd);
+         unlink(metrics->target_path);
+         metrics->listen_fd = -1;
+      }
+      return -1;
+   }
+   metrics->exporter_running = 1;
+
+   return 0;
+}
+
+void vadc_metrics_stop_exporter(VADC_Metrics *metrics)
+{
+   if (!metrics->exporter_running)
+   {
+      return;
+   }
+
+   atomic_store(&metrics->exporter_quit, 1);
+   pthread_join(metrics->exporter_thread, NULL);
+   metrics->exporter_running = 0;
+
+   if (metrics->listen_fd >= 0)
+   {
+      close(metrics->listen_fd);
+      unlink(metrics->target_path);
+      metrics->listen_fd = -1;
+   }
+}
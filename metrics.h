@@ -0,0 +1,61 @@
+#pragma once
+#include "utils.h"
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// NOTE: live counters of one long-running stream, exported in Prometheus text format by a background
+//       thread. The inference loop only does relaxed atomic adds/stores, all the formatting happens on
+//       the exporter thread.
+typedef struct VADC_Metrics VADC_Metrics;
+struct VADC_Metrics
+{
+   // NOTE: counters, only ever increase
+   atomic_ullong windows_processed;
+   atomic_ullong speech_windows;
+   atomic_ullong samples_processed;
+   atomic_ullong inference_ns;
+   atomic_ullong input_reads;
+   // NOTE: reads that returned less than a full buffer
+   atomic_ullong input_underruns;
+   atomic_ullong segments_emitted;
+   // NOTE: bytes that couldn't be written to the segment/probability output or the audio outputs
+   atomic_ullong dropped_output_bytes;
+
+   // NOTE: gauges
+   atomic_ullong arena_used_bytes;
+   atomic_ullong arena_peak_bytes;
+   atomic_ullong arena_size_bytes;
+
+   s64 start_ns;
+   int sample_rate;
+
+   // NOTE: exporter thread state
+   pthread_t exporter_thread;
+   b32 exporter_running;
+   atomic_int exporter_quit;
+   char target_path[512];
+   b32 target_is_socket;
+   int listen_fd;
+   int interval_ms;
+};
+
+#define VADC_METRIC_ADD(metrics, field, value) \
+   do { if (metrics) atomic_fetch_add_explicit(&(metrics)->field, (unsigned long long)(value), memory_order_relaxed); } while (0)
+
+#define VADC_METRIC_SET(metrics, field, value) \
+   do { if (metrics) atomic_store_explicit(&(metrics)->field, (unsigned long long)(value), memory_order_relaxed); } while (0)
+
+void vadc_metrics_init( VADC_Metrics *metrics, int sample_rate );
+
+// NOTE: target is a file path, rewritten atomically (write + rename) every interval_ms, for the
+//       node_exporter textfile collector; or "unix:<path>", a Unix socket that answers every
+//       connection with the current metrics (with an HTTP header if the client sent a GET).
+//       Returns 0 on success.
+int vadc_metrics_start_exporter( VADC_Metrics *metrics, const char *target, int interval_ms );
+
+// NOTE: writes the file one last time, stops the thread and removes the socket
+void vadc_metrics_stop_exporter( VADC_Metrics *metrics );
+
+// NOTE: Prometheus text exposition format. Returns the length, truncated to buffer_size - 1.
+size_t vadc_metrics_format( VADC_Metrics *metrics, char *buffer, size_t buffer_size );
@@ -64,7 +64,7 @@ static void adaptive_audio_normalization_inplace(MemoryArena *arena, TestTensor
 
    TestTensor *mean_padded = tensor_reflect_pad_last_dim(arena, mean, to_pad);
    TestTensor *conv1d_output = tensor_zeros_like(arena, mean);
-   conv_tensor(mean_padded, &filter_tensor, NULL, 1, conv1d_output);
+   conv_tensor(arena, mean_padded, &filter_tensor, NULL, 1, conv1d_output);
 
    TestTensor *mean_mean = tensor_zeros_3d(arena, batch_count, 1, 1);
 
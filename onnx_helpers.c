@@ -5,7 +5,16 @@
 #pragma comment(lib, "lib/onnxruntime.lib")
 #endif
 
+#include <pthread.h>
+
+// NOTE: written once under g_ort_once, read-only afterwards, so concurrent runs can share it
 static const OrtApi *g_ort = NULL;
+static pthread_once_t g_ort_once = PTHREAD_ONCE_INIT;
+
+static void ort_get_api_once(void)
+{
+   g_ort = OrtGetApiBase()->GetApi( ORT_API_VERSION );
+}
 
 void verify_input_output_count(OrtSession* session) {
    OrtAllocator *allocator;
@@ -82,9 +91,175 @@ int enable_cuda(OrtSessionOptions* session_options)
 
 static const wchar_t model_filename[] = SILERO_FILENAME;
 
+// NOTE: set by the CLI before any run starts. Library users, who don't go through the CLI, get
+//       VADC_MODEL_CACHE, read once by whichever ort_init comes first.
+static char g_model_cache_dir[512];
+static atomic_int g_model_cache_dir_set;
+static pthread_once_t g_model_cache_dir_once = PTHREAD_ONCE_INIT;
+
+static void ort_store_model_cache_dir(const char *dir)
+{
+   g_model_cache_dir[0] = 0;
+   if (dir && strlen(dir) < sizeof(g_model_cache_dir))
+   {
+      strcpy(g_model_cache_dir, dir);
+   }
+}
+
+void ort_set_model_cache_dir(const char *dir)
+{
+   ort_store_model_cache_dir(dir);
+   atomic_store(&g_model_cache_dir_set, 1);
+}
+
+static void ort_model_cache_dir_from_env_once(void)
+{
+   if (!atomic_load(&g_model_cache_dir_set))
+   {
+      ort_store_model_cache_dir(getenv("VADC_MODEL_CACHE"));
+   }
+}
+
+static const char *ort_model_cache_dir(void)
+{
+   pthread_once(&g_model_cache_dir_once, ort_model_cache_dir_from_env_once);
+   return g_model_cache_dir[0] ? g_model_cache_dir : NULL;
+}
+
+// NOTE: 2: the optimized graph is saved at ORT_ENABLE_EXTENDED, files of version 1 were saved at
+//       ORT_ENABLE_ALL, whose layout transforms only suit the CPU that wrote them
+#define ORT_MODEL_CACHE_VERSION 2
+
+// NOTE: FNV-1a of the model file, the onnxruntime version (the optimized graph is only valid for the
+//       version that wrote it) and the cache format. 0 if the model can't be read.
+static u64 ort_model_cache_key(const char *model_path)
+{
+   u64 hash = vadc_prob_cache_hash_file(model_path);
+   if (!hash)
+   {
+      return 0;
+   }
+
+   const char *ort_version = OrtGetApiBase()->GetVersionString();
+   hash = vadc_fnv1a(hash, ort_version, strlen(ort_version));
+   int cache_version = ORT_MODEL_CACHE_VERSION;
+   hash = vadc_fnv1a(hash, &cache_version, sizeof(cache_version));
+
+   return hash ? hash : 1;
+}
+
+// NOTE: <cache dir>/<model file name>-<key>.<extension>
+static void ort_model_cache_path(char *path, size_t path_size, const char *cache_dir, const char *model_path,
+                                 u64 key, const char *extension)
+{
+   const char *model_name = strrchr(model_path, '/');
+   model_name = model_name ? model_name + 1 : model_path;
+   snprintf(path, path_size, "%s/%s-%016llx.%s", cache_dir, model_name, (unsigned long long)key, extension);
+}
+
+static b32 ort_read_metadata_cache(const char *path, u64 key, ORT_Model_Metadata *metadata)
+{
+   FILE *file = fopen(path, "r");
+   if (!file)
+   {
+      return 0;
+   }
+
+   unsigned long long file_key = 0;
+   int version = 0;
+   ORT_Model_Metadata read = {0};
+   int fields = fscanf(file,
+                       "vadc-model-metadata %d\n"
+                       "key %llx\n"
+                       "inputs_count %d\n"
+                       "outputs_count %d\n"
+                       "batch_size_restriction %d\n"
+                       "sequence_count_restriction %d\n"
+                       "output_dims %d\n"
+                       "sr_input_index %d\n"
+                       "lstm_hidden_size %d\n"
+                       "lstm_batch_size %d\n",
+                       &version, &file_key,
+                       &read.inputs_count, &read.outputs_count,
+                       &read.batch_size_restriction, &read.sequence_count_restriction,
+                       &read.output_dims, &read.sr_input_index,
+                       &read.lstm_hidden_size, &read.lstm_batch_size);
+   fclose(file);
+
+   if (fields != 10 || version != ORT_MODEL_CACHE_VERSION || file_key != key)
+   {
+      return 0;
+   }
+   *metadata = read;
+   return 1;
+}
+
+// NOTE: a temp name no other process or thread writing the same cache file uses at the same time
+static atomic_int g_model_cache_temp_counter;
+
+static void ort_model_cache_temp_path(char *temp_path, size_t temp_path_size, const char *path, const char *extension)
+{
+   int counter = atomic_fetch_add(&g_model_cache_temp_counter, 1);
+   snprintf(temp_path, temp_path_size, "%s.%d.%d.%s", path, (int)getpid(), counter, extension);
+}
+
+// NOTE: written next to the target and renamed, so concurrently starting workers never read half a file
+static void ort_write_metadata_cache(const char *path, u64 key, const ORT_Model_Metadata *metadata)
+{
+   char temp_path[1100];
+   ort_model_cache_temp_path(temp_path, sizeof(temp_path), path, "tmp");
+
+   FILE *file = fopen(temp_path, "w");
+   if (!file)
+   {
+      return;
+   }
+   fprintf(file,
+           "vadc-model-metadata %d\n"
+           "key %016llx\n"
+           "inputs_count %d\n"
+           "outputs_count %d\n"
+           "batch_size_restriction %d\n"
+           "sequence_count_restriction %d\n"
+           "output_dims %d\n"
+           "sr_input_index %d\n"
+           "lstm_hidden_size %d\n"
+           "lstm_batch_size %d\n",
+           ORT_MODEL_CACHE_VERSION, (unsigned long long)key,
+           metadata->inputs_count, metadata->outputs_count,
+           metadata->batch_size_restriction, metadata->sequence_count_restriction,
+           metadata->output_dims, metadata->sr_input_index,
+           metadata->lstm_hidden_size, metadata->lstm_batch_size);
+
+   if (fclose(file) == 0)
+   {
+      rename(temp_path, path);
+   }
+   else
+   {
+      unlink(temp_path);
+   }
+}
+
+// NOTE: like CreateSession under ORT_ABORT_ON_ERROR, but a failure only returns NULL, for loading a
+//       cached optimized model that may be stale or truncated
+static OrtSession *ort_try_create_session(OrtEnv *env, const char *model_path, OrtSessionOptions *session_options)
+{
+   OrtSession *session = NULL;
+   OrtStatus *status = g_ort->CreateSession(env, (const ORTCHAR_T *)model_path, session_options, &session);
+   if (status)
+   {
+      fprintf(stderr, "Warning: couldn't load %s: %s\n", model_path, g_ort->GetErrorMessage(status));
+      g_ort->ReleaseStatus(status);
+      return NULL;
+   }
+   return session;
+}
+
 void *ort_init( MemoryArena *arena, String8 model_path_arg, Silero_Config *config)
 {
-   g_ort = OrtGetApiBase()->GetApi( ORT_API_VERSION );
+   s64 stage_start_ns = vadc_now_ns();
+   pthread_once( &g_ort_once, ort_get_api_once );
    if ( !g_ort )
    {
       fprintf( stderr, "Failed to init ONNX Runtime engine.\n" );
@@ -158,38 +333,122 @@ void *ort_init( MemoryArena *arena, String8 model_path_arg, Silero_Config *confi
    fprintf(stderr, "Loading ONNX model: %s\n", model_path_buf);
 
    ONNX_Specific *onnx = pushStruct(arena, ONNX_Specific);
+   onnx->env = env;
+
+   // NOTE: --model_cache/VADC_MODEL_CACHE keeps onnxruntime's optimized graph and the probed metadata
+   //       of each model, keyed by a hash of the model file, so a restarted worker skips both
+   const char *cache_dir = ort_model_cache_dir();
+   u64 cache_key = 0;
+   char optimized_model_path[1024];
+   char metadata_path[1024];
+   char optimized_model_temp_path[1100];
+   config->startup_ns[VADC_Startup_Env] = vadc_now_ns() - stage_start_ns;
+
+   stage_start_ns = vadc_now_ns();
+   if (cache_dir)
+   {
+      cache_key = ort_model_cache_key(model_path_buf);
+      if (cache_key)
+      {
+         ort_model_cache_path(optimized_model_path, sizeof(optimized_model_path), cache_dir, model_path_buf, cache_key, "opt.onnx");
+         ort_model_cache_path(metadata_path, sizeof(metadata_path), cache_dir, model_path_buf, cache_key, "meta");
+      }
+      else
+      {
+         fprintf(stderr, "Warning: couldn't hash %s, not using the model cache\n", model_path_buf);
+      }
+   }
+   if (vadc_prob_cache_dir() || config->model_file_hash_wanted)
+   {
+      config->model_file_hash = vadc_prob_cache_hash_file(model_path_buf);
+   }
+   config->startup_ns[VADC_Startup_ModelHash] = vadc_now_ns() - stage_start_ns;
 
-   ORT_ABORT_ON_ERROR( g_ort->CreateSession( env, (const wchar_t *)model_path_buf, session_options, &onnx->session ) );
+   stage_start_ns = vadc_now_ns();
+   if (cache_key)
+   {
+      FILE *optimized_model_file = fopen(optimized_model_path, "rb");
+      if (optimized_model_file)
+      {
+         fclose(optimized_model_file);
+
+         // NOTE: the graph optimizations are already done, the CPU specific layout transforms of
+         //       ORT_ENABLE_ALL (the session options' default level) run here, on this machine
+         onnx->session = ort_try_create_session( env, optimized_model_path, session_options );
+         if (onnx->session)
+         {
+            config->optimized_model_from_cache = 1;
+         }
+         else
+         {
+            unlink(optimized_model_path);
+         }
+      }
+
+      if (!onnx->session)
+      {
+         // NOTE: the cache may be shared by machines with different CPUs, so it gets the graph at
+         //       ORT_ENABLE_EXTENDED, the highest level onnxruntime keeps hardware independent. This one
+         //       run goes without the layout transforms.
+         ORT_ABORT_ON_ERROR( g_ort->SetSessionGraphOptimizationLevel( session_options, ORT_ENABLE_EXTENDED ) );
+         ort_model_cache_temp_path(optimized_model_temp_path, sizeof(optimized_model_temp_path), optimized_model_path, "tmp.onnx");
+         ORT_ABORT_ON_ERROR( g_ort->SetOptimizedModelFilePath( session_options, (const ORTCHAR_T *)optimized_model_temp_path ) );
+      }
+   }
+
+   if (!onnx->session)
+   {
+      ORT_ABORT_ON_ERROR( g_ort->CreateSession( env, (const ORTCHAR_T *)model_path_buf, session_options, &onnx->session ) );
+      if (cache_key && rename(optimized_model_temp_path, optimized_model_path) != 0)
+      {
+         unlink(optimized_model_temp_path);
+      }
+   }
+   g_ort->ReleaseSessionOptions( session_options );
+   config->startup_ns[VADC_Startup_Session] = vadc_now_ns() - stage_start_ns;
 
    if (onnx->session)
    {
+      stage_start_ns = vadc_now_ns();
       ORT_ABORT_ON_ERROR( g_ort->CreateCpuMemoryInfo( OrtArenaAllocator, OrtMemTypeDefault, &onnx->memory_info ) );
       ORT_ABORT_ON_ERROR( g_ort->CreateAllocator( onnx->session, onnx->memory_info, &onnx->ort_allocator ) );
 
-      s32 batch_size_restriction = ort_get_batch_size_restriction(onnx->session, onnx->ort_allocator);
+      ORT_Model_Metadata metadata = {0};
+      if (cache_key && ort_read_metadata_cache(metadata_path, cache_key, &metadata))
+      {
+         config->metadata_from_cache = 1;
+      }
+      else
+      {
+         ort_probe_model( onnx->session, onnx->ort_allocator, &metadata );
+         if (cache_key)
+         {
+            ort_write_metadata_cache(metadata_path, cache_key, &metadata);
+         }
+      }
+
+      s32 batch_size_restriction = metadata.batch_size_restriction;
+      config->input_batch_size = metadata.batch_size_restriction;
 
-      onnx->output_dims = ort_get_output_dims( onnx->session, onnx->ort_allocator);
+      onnx->output_dims = metadata.output_dims;
       config->output_dims = onnx->output_dims;
 
       {
-         size_t model_output_count = 0;
-         size_t model_input_count = 0;
-
-         ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputCount( onnx->session, &model_output_count ) );
-         ORT_ABORT_ON_ERROR( g_ort->SessionGetInputCount( onnx->session, &model_input_count ) );
-
-         Assert( model_input_count == 3 || model_input_count == 4 );
+         Assert( metadata.inputs_count == 3 || metadata.inputs_count == 4 );
 
-         onnx->outputs_count = model_output_count;
-         onnx->inputs_count = model_input_count;
+         onnx->outputs_count = metadata.outputs_count;
+         onnx->inputs_count = metadata.inputs_count;
 
-         onnx->sr_input_index = ort_sr_input_index( onnx->session, onnx->ort_allocator);
+         onnx->sr_input_index = metadata.sr_input_index;
          config->sr_input_index = onnx->sr_input_index;
 
-         s32 lstm_batch_size;
-         onnx->lstm_hidden_size = ort_lstm_hidden_size( onnx->session, onnx->ort_allocator, &lstm_batch_size);
+         s32 lstm_batch_size = metadata.lstm_batch_size;
+         onnx->lstm_hidden_size = metadata.lstm_hidden_size;
          config->lstm_hidden_size = onnx->lstm_hidden_size;
 
+         onnx->lstm_batch_size = lstm_batch_size;
+         config->lstm_batch_size = lstm_batch_size;
+
          if (batch_size_restriction == -1 && lstm_batch_size != 1)
          {
             // IMPORTANT(irwin): we don't want fully parallel batch, restrict to 1
@@ -208,7 +467,7 @@ void *ort_init( MemoryArena *arena, String8 model_path_arg, Silero_Config *confi
          }
          else
          {
-            s32 sequence_count_restriction = ort_sequence_count_restriction(onnx->session, onnx->ort_allocator);
+            s32 sequence_count_restriction = metadata.sequence_count_restriction;
             if (sequence_count_restriction == -1)
             {
                // TODO(irwin): 8kHz support
@@ -230,7 +489,7 @@ void *ort_init( MemoryArena *arena, String8 model_path_arg, Silero_Config *confi
          config->is_silero_v5 = onnx->is_silero_v5;
 
       }
-
+      config->startup_ns[VADC_Startup_Metadata] = vadc_now_ns() - stage_start_ns;
    }
 
    return onnx;
@@ -241,229 +500,117 @@ void *backend_init( MemoryArena *arena, String8 model_path_arg, Silero_Config *c
    return ort_init( arena, model_path_arg, config );
 }
 
-s32 ort_get_batch_size_restriction( OrtSession *session, OrtAllocator *ort_allocator )
+void backend_set_model_cache_dir(const char *dir)
 {
-   s32 batch_size_restriction = 1;
-
-   size_t model_input_count = 0;
-   ORT_ABORT_ON_ERROR( g_ort->SessionGetInputCount( session, &model_input_count ) );
-
-   for ( size_t i = 0; i < model_input_count; i++ )
-   {
-      char *input_name;
-      g_ort->SessionGetInputName( session, i, ort_allocator, &input_name );
-
-      if ( strcmp( input_name, "input" ) == 0 )
-      {
-         OrtTypeInfo *type_info;
-         g_ort->SessionGetInputTypeInfo( session, i, &type_info );
-
-         const OrtTensorTypeAndShapeInfo *tensor_info;
-         g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info );
-
-         int64_t dim_value;
-         g_ort->GetDimensions( tensor_info, &dim_value, 1 );
-
-         batch_size_restriction = (int)dim_value;
-
-         // fprintf(stderr, "Axis-0 dimension of 'input': %" PRId64 "\n", dim_value);
-
-         g_ort->ReleaseTypeInfo( type_info );
-         break;
-      }
-
-      g_ort->AllocatorFree( ort_allocator, input_name );
-   }
+   ort_set_model_cache_dir(dir);
+}
 
-   return batch_size_restriction;
+const char *backend_runtime_version(void)
+{
+   return OrtGetApiBase()->GetVersionString();
 }
 
-// NOTE(irwin): -1: unrestricted, 0:error, num:restriction
-s32 ort_sequence_count_restriction( OrtSession *session, OrtAllocator *ort_allocator )
+// NOTE: the input batch and sequence restrictions, output rank, sr input and lstm state shape, in one walk
+//       over the inputs and one over the outputs
+void ort_probe_model( OrtSession *session, OrtAllocator *ort_allocator, ORT_Model_Metadata *metadata )
 {
-   s32 sequence_count_restriction = -1;
+   metadata->batch_size_restriction = 1;
+   metadata->sequence_count_restriction = -1;
+   metadata->output_dims = 2;
+   metadata->sr_input_index = -1;
+   metadata->lstm_hidden_size = -1;
+   metadata->lstm_batch_size = 1;
 
    size_t model_input_count = 0;
+   size_t model_output_count = 0;
    ORT_ABORT_ON_ERROR( g_ort->SessionGetInputCount( session, &model_input_count ) );
+   ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputCount( session, &model_output_count ) );
+   metadata->inputs_count = (s32)model_input_count;
+   metadata->outputs_count = (s32)model_output_count;
 
+   b32 found_input = 0;
+   b32 found_lstm = 0;
    for ( size_t i = 0; i < model_input_count; i++ )
    {
-      char *input_name;
-      g_ort->SessionGetInputName( session, i, ort_allocator, &input_name );
+      OrtTypeInfo *type_info;
+      ORT_ABORT_ON_ERROR( g_ort->SessionGetInputTypeInfo( session, i, &type_info ) );
 
-      if ( strcmp( input_name, "input" ) == 0 )
-      {
-         OrtTypeInfo *type_info;
-         g_ort->SessionGetInputTypeInfo( session, i, &type_info );
+      const OrtTensorTypeAndShapeInfo *tensor_info;
+      ORT_ABORT_ON_ERROR( g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info ) );
 
-         const OrtTensorTypeAndShapeInfo *tensor_info;
-         g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info );
+      size_t dim_count;
+      ORT_ABORT_ON_ERROR( g_ort->GetDimensionsCount( tensor_info, &dim_count ) );
 
-         size_t dim_count;
-         g_ort->GetDimensionsCount( tensor_info, &dim_count );
+      ONNXTensorElementDataType data_type;
+      ORT_ABORT_ON_ERROR( g_ort->GetTensorElementType( tensor_info, &data_type ) );
 
+      int64_t dimensions[4] = {0};
+      if (dim_count <= ArrayCount(dimensions))
+      {
+         ORT_ABORT_ON_ERROR( g_ort->GetDimensions( tensor_info, dimensions, dim_count ) );
+      }
+
+      char *input_name;
+      ORT_ABORT_ON_ERROR( g_ort->SessionGetInputName( session, i, ort_allocator, &input_name ) );
+      if ( !found_input && strcmp( input_name, "input" ) == 0 )
+      {
+         found_input = 1;
+         metadata->batch_size_restriction = (s32)dimensions[0];
          if (dim_count >= 4)
          {
-            sequence_count_restriction = 0;
-            g_ort->ReleaseTypeInfo( type_info );
-            break;
+            metadata->sequence_count_restriction = 0;
+         }
+         else if (dim_count > 0)
+         {
+            metadata->sequence_count_restriction = (s32)dimensions[dim_count - 1];
          }
-
-         int64_t dim_value[4];
-         g_ort->GetDimensions( tensor_info, dim_value, dim_count );
-
-         sequence_count_restriction = (int)dim_value[dim_count - 1];
-
-         // fprintf(stderr, "Axis-0 dimension of 'input': %" PRId64 "\n", dim_value);
-
-         g_ort->ReleaseTypeInfo( type_info );
-         break;
       }
+      ORT_ABORT_ON_ERROR( g_ort->AllocatorFree( ort_allocator, input_name ) );
 
-      g_ort->AllocatorFree( ort_allocator, input_name );
-   }
-
-   return sequence_count_restriction;
-}
-
-s32 ort_get_output_dims( OrtSession *session, OrtAllocator *ort_allocator )
-{
-   s32 output_dims = 2;
-
-   size_t model_output_count = 0;
-   ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputCount( session, &model_output_count ) );
-
-   for ( size_t i = 0; i < model_output_count; i++ )
-   {
-      char *output_name;
-      g_ort->SessionGetOutputName( session, i, ort_allocator, &output_name );
-
-      if ( strcmp( output_name, "output" ) == 0 )
+      if (metadata->sr_input_index == -1 && dim_count == 0 && data_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
       {
-         OrtTypeInfo *type_info;
-         g_ort->SessionGetOutputTypeInfo( session, i, &type_info );
-
-         const OrtTensorTypeAndShapeInfo *tensor_info;
-         g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info );
-
-         size_t dim_count;
-         g_ort->GetDimensionsCount( tensor_info, &dim_count );
-
-         output_dims = (int)dim_count;
-
-         // fprintf(stderr, "Axis-0 dimension of 'input': %" PRId64 "\n", dim_value);
-
-         g_ort->ReleaseTypeInfo( type_info );
-         break;
+         metadata->sr_input_index = (s32)i;
       }
 
-      g_ort->AllocatorFree( ort_allocator, output_name );
-   }
-
-   return output_dims;
-}
-
-s32 ort_sr_input_index( OrtSession *session, OrtAllocator *ort_allocator )
-{
-   VAR_UNUSED(ort_allocator);
-   s32 input_index = -1;
-
-   size_t model_input_count = 0;
-   ORT_ABORT_ON_ERROR( g_ort->SessionGetInputCount( session, &model_input_count ) );
-
-   for ( size_t i = 0; i < model_input_count; i++ )
-   {
-      // char *input_name;
-      // g_ort->SessionGetInputName( session, i, ort_allocator, &input_name );
-
-      // if ( strcmp( input_name, "input" ) == 0 )
+      if (!found_lstm && i > 0 && dim_count == 3 && data_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
       {
-         OrtTypeInfo *type_info;
-         g_ort->SessionGetInputTypeInfo( session, i, &type_info );
-
-         const OrtTensorTypeAndShapeInfo *tensor_info;
-         g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info );
-
-         size_t dim_count;
-         g_ort->GetDimensionsCount( tensor_info, &dim_count );
-
-         ONNXTensorElementDataType data_type;
-         g_ort->GetTensorElementType( tensor_info, &data_type );
-
-         // fprintf(stderr, "Axis-0 dimension of 'input': %" PRId64 "\n", dim_value);
-
-         g_ort->ReleaseTypeInfo( type_info );
-
-         if (dim_count == 0 && data_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
-         {
-            input_index = (s32)i;
-            break;
-         }
-         // break;
+         found_lstm = 1;
+         metadata->lstm_batch_size = (s32)dimensions[1];
+         metadata->lstm_hidden_size = (s32)dimensions[2];
+         Assert(metadata->lstm_hidden_size == 64 || metadata->lstm_hidden_size == 128);
       }
 
-      // g_ort->AllocatorFree( ort_allocator, input_name );
+      g_ort->ReleaseTypeInfo( type_info );
    }
 
-   return input_index;
-}
-
-s32 ort_lstm_hidden_size( OrtSession *session, OrtAllocator *ort_allocator, s32 *lstm_batch_size )
-{
-   VAR_UNUSED(ort_allocator);
-   s32 hidden_size = -1;
-
-   size_t model_input_count = 0;
-   ORT_ABORT_ON_ERROR( g_ort->SessionGetInputCount( session, &model_input_count ) );
-
-   for ( size_t i = 1; i < model_input_count; i++ )
+   for ( size_t i = 0; i < model_output_count; i++ )
    {
-      // char *input_name;
-      // g_ort->SessionGetInputName( session, i, ort_allocator, &input_name );
+      char *output_name;
+      ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputName( session, i, ort_allocator, &output_name ) );
+      b32 is_output = ( strcmp( output_name, "output" ) == 0 );
+      ORT_ABORT_ON_ERROR( g_ort->AllocatorFree( ort_allocator, output_name ) );
 
-      // if ( strcmp( input_name, "input" ) == 0 )
+      if ( is_output )
       {
          OrtTypeInfo *type_info;
-         g_ort->SessionGetInputTypeInfo( session, i, &type_info );
+         ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputTypeInfo( session, i, &type_info ) );
 
          const OrtTensorTypeAndShapeInfo *tensor_info;
-         g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info );
+         ORT_ABORT_ON_ERROR( g_ort->CastTypeInfoToTensorInfo( type_info, &tensor_info ) );
 
          size_t dim_count;
-         g_ort->GetDimensionsCount( tensor_info, &dim_count );
-
-         ONNXTensorElementDataType data_type;
-         g_ort->GetTensorElementType( tensor_info, &data_type );
-
-         // fprintf(stderr, "Axis-0 dimension of 'input': %" PRId64 "\n", dim_value);
+         ORT_ABORT_ON_ERROR( g_ort->GetDimensionsCount( tensor_info, &dim_count ) );
+         metadata->output_dims = (s32)dim_count;
 
          g_ort->ReleaseTypeInfo( type_info );
-
-         if (dim_count == 3 && data_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
-         {
-            int64_t dimensions[3];
-            g_ort->GetDimensions(tensor_info, dimensions, dim_count);
-            if (lstm_batch_size)
-            {
-               *lstm_batch_size = (s32)dimensions[1];
-            }
-
-            hidden_size = (s32)dimensions[2];
-            Assert(hidden_size == 64 || hidden_size == 128);
-            break;
-         }
-         // break;
+         break;
       }
-
-      // g_ort->AllocatorFree( ort_allocator, input_name );
    }
-
-   return hidden_size;
 }
 
 void ort_create_tensors(Silero_Config config, ONNX_Specific *onnx, Tensor_Buffers buffers)
 {
-   s32 lstm_hidden_size = ort_lstm_hidden_size(onnx->session, onnx->ort_allocator, 0);
+   s32 lstm_hidden_size = onnx->lstm_hidden_size;
    b32 silero_v5 = config.is_silero_v5;
 
    s32 final_input_count = config.input_count;
@@ -555,34 +702,114 @@ void ort_create_tensors(Silero_Config config, ONNX_Specific *onnx, Tensor_Buffer
                  buffers.lstm_c_out,
                  buffers.lstm_count);
 
+   // NOTE: names are owned by the session's allocator, copies of onnx sharing the session share them too
+   if (!onnx->input_names[0])
+   {
+      ort_query_io_names(onnx);
+   }
+
+   // const char **input_names = config.is_silero_v4 ? INPUT_NAMES_V4 : INPUT_NAMES_V3;
+
+   // onnx->input_names = input_names;
+   // onnx->output_names = OUTPUT_NAMES_NORMAL;
+
+   // g_ort->ReleaseMemoryInfo(onnx.memory_info);
+}
+
+void ort_query_io_names(ONNX_Specific *onnx)
+{
    size_t model_input_count = 0;
    ORT_ABORT_ON_ERROR( g_ort->SessionGetInputCount( onnx->session, &model_input_count ) );
    Assert(model_input_count <= 4);
    for (size_t i = 0; i < model_input_count; ++i)
    {
-      g_ort->SessionGetInputName(onnx->session, i, onnx->ort_allocator, &onnx->input_names[i]);
+      ORT_ABORT_ON_ERROR( g_ort->SessionGetInputName(onnx->session, i, onnx->ort_allocator, &onnx->input_names[i]) );
    }
 
    size_t model_output_count = 0;
    ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputCount( onnx->session, &model_output_count ) );
-   Assert(model_input_count <= 4);
+   Assert(model_output_count <= 4);
    for (size_t i = 0; i < model_output_count; ++i)
    {
-      g_ort->SessionGetOutputName(onnx->session, i, onnx->ort_allocator, &onnx->output_names[i]);
+      ORT_ABORT_ON_ERROR( g_ort->SessionGetOutputName(onnx->session, i, onnx->ort_allocator, &onnx->output_names[i]) );
    }
 
-   // const char **input_names = config.is_silero_v4 ? INPUT_NAMES_V4 : INPUT_NAMES_V3;
+   onnx->inputs_count = model_input_count;
+}
 
-   // onnx->input_names = input_names;
-   // onnx->output_names = OUTPUT_NAMES_NORMAL;
+// NOTE: a copy of onnx sharing its env, session and io names, with no tensors of its own yet. Lets
+//       several threads run inputs through one loaded model. ort_query_io_names must have been called
+//       on onnx first so the copies don't each query (and leak) their own names.
+ONNX_Specific *ort_clone(MemoryArena *arena, ONNX_Specific *onnx)
+{
+   Assert(onnx->input_names[0]);
 
-   onnx->inputs_count = model_input_count;
+   ONNX_Specific *clone = pushStruct(arena, ONNX_Specific);
+   *clone = *onnx;
+   memset(clone->input_tensors, 0, sizeof(clone->input_tensors));
+   memset(clone->output_tensors, 0, sizeof(clone->output_tensors));
 
-   // g_ort->ReleaseMemoryInfo(onnx.memory_info);
+   return clone;
+}
+
+void ort_release_tensors(ONNX_Specific *onnx)
+{
+   for (size_t i = 0; i < ArrayCount(onnx->input_tensors); ++i)
+   {
+      if (onnx->input_tensors[i])
+      {
+         g_ort->ReleaseValue(onnx->input_tensors[i]);
+         onnx->input_tensors[i] = NULL;
+      }
+   }
+   for (size_t i = 0; i < ArrayCount(onnx->output_tensors); ++i)
+   {
+      if (onnx->output_tensors[i])
+      {
+         g_ort->ReleaseValue(onnx->output_tensors[i]);
+         onnx->output_tensors[i] = NULL;
+      }
+   }
+}
+
+// NOTE: releases everything ort_init created. Copies of onnx that share its session must have
+//       released their own tensors before this is called.
+void ort_release(ONNX_Specific *onnx)
+{
+   ort_release_tensors(onnx);
+
+   for (size_t i = 0; i < ArrayCount(onnx->input_names); ++i)
+   {
+      if (onnx->input_names[i])
+      {
+         ORT_ABORT_ON_ERROR( g_ort->AllocatorFree(onnx->ort_allocator, (void *)onnx->input_names[i]) );
+         onnx->input_names[i] = NULL;
+      }
+   }
+   for (size_t i = 0; i < ArrayCount(onnx->output_names); ++i)
+   {
+      if (onnx->output_names[i])
+      {
+         ORT_ABORT_ON_ERROR( g_ort->AllocatorFree(onnx->ort_allocator, (void *)onnx->output_names[i]) );
+         onnx->output_names[i] = NULL;
+      }
+   }
+
+   if (onnx->ort_allocator) g_ort->ReleaseAllocator(onnx->ort_allocator);
+   if (onnx->memory_info) g_ort->ReleaseMemoryInfo(onnx->memory_info);
+   if (onnx->session) g_ort->ReleaseSession(onnx->session);
+   if (onnx->env) g_ort->ReleaseEnv(onnx->env);
+
+   onnx->ort_allocator = NULL;
+   onnx->memory_info = NULL;
+   onnx->session = NULL;
+   onnx->env = NULL;
 }
 
 void ort_run(ONNX_Specific *onnx)
 {
+   TracyCZone(ort_run, true);
+
    ORT_ABORT_ON_ERROR( g_ort->Run( onnx->session,
                                    NULL,
                                    onnx->input_names,
@@ -598,16 +825,143 @@ void ort_run(ONNX_Specific *onnx)
    int is_tensor;
    ORT_ABORT_ON_ERROR( g_ort->IsTensor( onnx->output_tensors[0], &is_tensor ) );
    Assert( is_tensor );
+
+   TracyCZoneEnd(ort_run);
 }
 
 void backend_run(MemoryArena *arena, VADC_Context *context, Silero_Config config)
 {
+   TracyCZone(backend_run, true);
+
    VAR_UNUSED(arena);
    VAR_UNUSED(config);
    ort_run((ONNX_Specific *)context->backend);
+
+   TracyCZoneEnd(backend_run);
 }
 
 void backend_create_tensors(Silero_Config config, void *backend, Tensor_Buffers buffers)
 {
    ort_create_tensors(config, (ONNX_Specific *)backend, buffers);
 }
+
+void *backend_clone(MemoryArena *arena, void *backend)
+{
+   ONNX_Specific *onnx = (ONNX_Specific *)backend;
+   if (!onnx->input_names[0])
+   {
+      ort_query_io_names(onnx);
+   }
+   return ort_clone(arena, onnx);
+}
+
+// NOTE: the session keeps no state between runs, the lstm state is in the Tensor_Buffers
+size_t backend_state_bytes(void *backend)
+{
+   VAR_UNUSED(backend);
+   return 0;
+}
+
+void backend_save_state(void *backend, void *destination)
+{
+   VAR_UNUSED(backend);
+   VAR_UNUSED(destination);
+}
+
+void backend_load_state(void *backend, const void *source)
+{
+   VAR_UNUSED(backend);
+   VAR_UNUSED(source);
+}
+
+void backend_release_tensors(void *backend)
+{
+   ort_release_tensors((ONNX_Specific *)backend);
+}
+
+void backend_release(void *backend)
+{
+   ort_release((ONNX_Specific *)backend);
+}
+
+// NOTE: runs one batch of independent streams. Unlike ort_run, the tensors are created for the
+//       actual batch_size of this call (which may be anything up to the size the buffers were
+//       allocated for) and released again afterwards, so consecutive calls can use different batch
+//       sizes. buffers.lstm_h/c hold the gathered state in [layers, batch_size, hidden] layout.
+//       ort_query_io_names must have been called on onnx beforehand.
+void ort_run_batch(ONNX_Specific *onnx, Silero_Config config, s32 batch_size, Tensor_Buffers buffers)
+{
+   TracyCZone(ort_run_batch, true);
+   TracyCZoneValue(ort_run_batch, (uint64_t)batch_size);
+
+   b32 silero_v5 = config.is_silero_v5;
+
+   s32 final_input_count = config.input_count;
+   if (silero_v5)
+   {
+      final_input_count += config.context_size;
+   }
+
+   OrtValue *input_tensors[4] = {0};
+   OrtValue *output_tensors[3] = {0};
+
+   int64_t input_tensor_samples_shape[] = {batch_size, final_input_count};
+   create_tensor(onnx->memory_info,
+                 &input_tensors[0],
+                 input_tensor_samples_shape,
+                 ArrayCount( input_tensor_samples_shape ),
+                 buffers.input_samples,
+                 final_input_count * batch_size);
+
+   s32 layer_count = silero_v5 ? 1 : 2;
+   int64_t state_shape[3] = {layer_count, batch_size, onnx->lstm_hidden_size};
+   size_t state_element_count = layer_count * batch_size * onnx->lstm_hidden_size;
+
+   int h_index = config.sr_input_index != 1 ? 1 : 2;
+   int c_index = h_index + 1;
+
+   create_tensor(onnx->memory_info, &input_tensors[h_index], state_shape, ArrayCount( state_shape ), buffers.lstm_h, state_element_count);
+   create_tensor(onnx->memory_info, &input_tensors[c_index], state_shape, ArrayCount( state_shape ), buffers.lstm_c, state_element_count);
+
+   if ( config.sr_input_index != -1 )
+   {
+      static int64_t sr = 16000;
+      create_tensor_int64( onnx->memory_info, &input_tensors[config.sr_input_index], 0, 0, &sr, 1 );
+   }
+
+   int64_t prob_shape[4];
+   memcpy(prob_shape, config.prob_shape, sizeof(prob_shape));
+   prob_shape[0] = batch_size;
+   size_t prob_element_count = batch_size * config.output_stride;
+
+   create_tensor(onnx->memory_info, &output_tensors[0], prob_shape, config.prob_shape_count, buffers.output, prob_element_count);
+   create_tensor(onnx->memory_info, &output_tensors[1], state_shape, ArrayCount( state_shape ), buffers.lstm_h_out, state_element_count);
+   create_tensor(onnx->memory_info, &output_tensors[2], state_shape, ArrayCount( state_shape ), buffers.lstm_c_out, state_element_count);
+
+   ORT_ABORT_ON_ERROR( g_ort->Run( onnx->session,
+                                   NULL,
+                                   onnx->input_names,
+                                   (const OrtValue *const *)input_tensors,
+                                   onnx->inputs_count,
+                                   onnx->output_names,
+                                   onnx->outputs_count,
+                                   output_tensors )
+   );
+
+   for (size_t i = 0; i < ArrayCount(input_tensors); ++i)
+   {
+      if (input_tensors[i])
+      {
+         g_ort->ReleaseValue(input_tensors[i]);
+      }
+   }
+   for (size_t i = 0; i < ArrayCount(output_tensors); ++i)
+   {
+      if (output_tensors[i])
+      {
+         g_ort->ReleaseValue(output_tensors[i]);
+      }
+   }
+
+   TracyCZoneEnd(ort_run_batch);
+}
@@ -18,6 +18,7 @@ struct ONNX_Specific
 {
    OrtValue *input_tensors[4];
    OrtValue *output_tensors[3];
+   OrtEnv *env;
    OrtSession *session;
    OrtMemoryInfo *memory_info;
    OrtAllocator *ort_allocator;
@@ -36,10 +37,27 @@ struct ONNX_Specific
    s32 output_dims;
 
    s32 lstm_hidden_size;
+   s32 lstm_batch_size;
    b32 is_silero_v5;
 };
 
 
+// NOTE: everything ort_init needs to know about a model's inputs and outputs, what gets cached
+typedef struct ORT_Model_Metadata ORT_Model_Metadata;
+struct ORT_Model_Metadata
+{
+   s32 inputs_count;
+   s32 outputs_count;
+   s32 batch_size_restriction;
+   // NOTE(irwin): -1: unrestricted, 0:error, num:restriction
+   s32 sequence_count_restriction;
+   s32 output_dims;
+   s32 sr_input_index;
+   s32 lstm_hidden_size;
+   s32 lstm_batch_size;
+};
+
+
 void verify_input_output_count( OrtSession *session );
 
 void create_tensor( OrtMemoryInfo *memory_info,
@@ -61,12 +79,27 @@ int enable_cuda( OrtSessionOptions *session_options );
 void *ort_init( MemoryArena * arena, String8 model_path_arg, Silero_Config *config);
 void *backend_init( MemoryArena * arena, String8 model_path_arg, Silero_Config *config);
 
-s32 ort_get_batch_size_restriction( OrtSession * session, OrtAllocator * ort_allocator );
-s32 ort_sequence_count_restriction( OrtSession *session, OrtAllocator *ort_allocator );
-s32 ort_get_output_dims( OrtSession *session, OrtAllocator *ort_allocator );
-s32 ort_sr_input_index( OrtSession *session, OrtAllocator *ort_allocator );
-s32 ort_lstm_hidden_size( OrtSession *session, OrtAllocator *ort_allocator, s32 *lstm_batch_size );
+// NOTE: directory for the optimized model and metadata cache, NULL or "" to turn it off. Without a
+//       call the VADC_MODEL_CACHE environment variable is used.
+void ort_set_model_cache_dir( const char *dir );
+void backend_set_model_cache_dir( const char *dir );
+
+// NOTE: the runtime and its version, part of the probability cache key
+const char *backend_runtime_version( void );
+
+void ort_probe_model( OrtSession *session, OrtAllocator *ort_allocator, ORT_Model_Metadata *metadata );
 void ort_create_tensors(Silero_Config config, ONNX_Specific *onnx, Tensor_Buffers buffers);
+void ort_query_io_names(ONNX_Specific *onnx);
+ONNX_Specific *ort_clone(MemoryArena *arena, ONNX_Specific *onnx);
+void ort_release_tensors(ONNX_Specific *onnx);
+void ort_release(ONNX_Specific *onnx);
 void ort_run(ONNX_Specific *onnx);
+void ort_run_batch(ONNX_Specific *onnx, Silero_Config config, s32 batch_size, Tensor_Buffers buffers);
 void backend_run(MemoryArena *arena, VADC_Context *context, Silero_Config config);
 void backend_create_tensors(Silero_Config config, void *backend, Tensor_Buffers buffers);
+void *backend_clone(MemoryArena *arena, void *backend);
+void backend_release_tensors(void *backend);
+size_t backend_state_bytes(void *backend);
+void backend_save_state(void *backend, void *destination);
+void backend_load_state(void *backend, const void *source);
+void backend_release(void *backend);
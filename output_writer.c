@@ -0,0 +1,69 @@
+#include "output_writer.h"
+
+#include <string.h>
+
+void vadc_output_writer_init(VADC_Output_Writer *writer, FILE *file, u8 *buffer, size_t capacity,
+                             b32 live, s64 flush_interval_ns)
+{
+   memset(writer, 0, sizeof(*writer));
+   writer->file = file;
+   writer->buffer = buffer;
+   writer->capacity = buffer ? capacity : 0;
+   writer->live = live;
+   writer->flush_interval_ns = flush_interval_ns;
+   writer->last_flush_ns = vadc_now_ns();
+}
+
+// NOTE: fwrite and fflush, so data that sat in the stdio buffer and was lost on flush counts as dropped too
+static size_t output_writer_put(FILE *file, const void *data, size_t bytes)
+{
+   size_t written = bytes ? fwrite(data, 1, bytes, file) : 0;
+   if (fflush(file) != 0 && written == bytes)
+   {
+      written = 0;
+   }
+   return bytes - written;
+}
+
+size_t vadc_output_writer_flush(VADC_Output_Writer *writer)
+{
+   size_t dropped = 0;
+   if (writer->used)
+   {
+      dropped = output_writer_put(writer->file, writer->buffer, writer->used);
+      writer->used = 0;
+   }
+   writer->last_flush_ns = vadc_now_ns();
+   return dropped;
+}
+
+size_t vadc_output_writer_write(VADC_Output_Writer *writer, const void *data, size_t bytes)
+{
+   if (!writer->capacity)
+   {
+      return output_writer_put(writer->file, data, bytes);
+   }
+
+   size_t dropped = 0;
+   if (writer->used + bytes > writer->capacity)
+   {
+      dropped += vadc_output_writer_flush(writer);
+   }
+
+   if (bytes > writer->capacity)
+   {
+      // NOTE: larger than the whole buffer, e.g. a big block of packed probabilities
+      dropped += output_writer_put(writer->file, data, bytes);
+      writer->last_flush_ns = vadc_now_ns();
+      return dropped;
+   }
+
+   memcpy(writer->buffer + writer->used, data, bytes);
+   writer->used += bytes;
+
+   if (writer->live || vadc_now_ns() - writer->last_flush_ns >= writer->flush_interval_ns)
+   {
+      dropped += vadc_output_writer_flush(writer);
+   }
+   return dropped;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "utils.h"
+#include <stdio.h>
+
+// NOTE: buffered writer for what a run writes to its segments output, instead of an fwrite and fflush
+//       per line. The buffer goes out when the next write doesn't fit, when flush_interval_ns has passed
+//       since the last flush (checked on write), and after every write in live mode, where a consumer
+//       waits on each line. Without a buffer every write goes straight out and is flushed.
+
+#define VADC_OUTPUT_WRITER_BUFFER_BYTES (128 * 1024)
+#define VADC_OUTPUT_WRITER_DEFAULT_FLUSH_MS 250.0f
+
+typedef struct VADC_Output_Writer VADC_Output_Writer;
+struct VADC_Output_Writer
+{
+   FILE *file;
+   u8 *buffer;
+   size_t capacity;
+   size_t used;
+   b32 live;
+   s64 flush_interval_ns;
+   s64 last_flush_ns;
+};
+
+void vadc_output_writer_init( VADC_Output_Writer *writer, FILE *file, u8 *buffer, size_t capacity,
+                              b32 live, s64 flush_interval_ns );
+
+// NOTE: both return the bytes that couldn't be written (full disk, closed pipe), including earlier
+//       buffered ones that went out with this call
+size_t vadc_output_writer_write( VADC_Output_Writer *writer, const void *data, size_t bytes );
+size_t vadc_output_writer_flush( VADC_Output_Writer *writer );
@@ -0,0 +1,265 @@
+#include "prob_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char vadc_prob_cache_magic[8] = { 'V', 'A', 'D', 'C', 'P', 'R', 'O', 'B' };
+
+// NOTE: the environment default is read once, by whichever thread gets here first, unless the CLI set
+//       the directory before that
+static char g_prob_cache_dir[1024];
+static atomic_int g_prob_cache_dir_set;
+static pthread_once_t g_prob_cache_dir_once = PTHREAD_ONCE_INIT;
+
+static void prob_cache_store_dir(const char *dir)
+{
+   g_prob_cache_dir[0] = 0;
+   if (dir && strlen(dir) < sizeof(g_prob_cache_dir))
+   {
+      strcpy(g_prob_cache_dir, dir);
+   }
+}
+
+void vadc_prob_cache_set_dir(const char *dir)
+{
+   prob_cache_store_dir(dir);
+   atomic_store(&g_prob_cache_dir_set, 1);
+}
+
+static void prob_cache_dir_from_env_once(void)
+{
+   // NOTE: for library users, who don't go through the CLI
+   if (!atomic_load(&g_prob_cache_dir_set))
+   {
+      prob_cache_store_dir(getenv("VADC_PROB_CACHE"));
+   }
+}
+
+const char *vadc_prob_cache_dir(void)
+{
+   pthread_once(&g_prob_cache_dir_once, prob_cache_dir_from_env_once);
+   return g_prob_cache_dir[0] ? g_prob_cache_dir : NULL;
+}
+
+u64 vadc_fnv1a(u64 hash, const void *data, size_t size)
+{
+   const u8 *bytes = (const u8 *)data;
+   for (size_t i = 0; i < size; ++i)
+   {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ULL;
+   }
+   return hash;
+}
+
+u64 vadc_prob_cache_hash_bytes(const void *data, size_t size)
+{
+   u64 hash = vadc_fnv1a(VADC_FNV1A_BASIS, data, size);
+   return hash ? hash : 1;
+}
+
+u64 vadc_prob_cache_hash_file(const char *path)
+{
+   FILE *file = fopen(path, "rb");
+   if (!file)
+   {
+      return 0;
+   }
+
+   u64 hash = VADC_FNV1A_BASIS;
+   u8 chunk[64 * 1024];
+   size_t bytes_read;
+   while ((bytes_read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+   {
+      hash = vadc_fnv1a(hash, chunk, bytes_read);
+   }
+   b32 failed = ferror(file);
+   fclose(file);
+   if (failed)
+   {
+      return 0;
+   }
+   return hash ? hash : 1;
+}
+
+static b32 prob_cache_header_matches(const VADC_Prob_Cache_Header *header, const VADC_Prob_Cache_Header *key, size_t file_size)
+{
+   if (file_size < sizeof(VADC_Prob_Cache_Header) ||
+       memcmp(header->magic, vadc_prob_cache_magic, sizeof(header->magic)) != 0 ||
+       header->version != VADC_PROB_CACHE_VERSION ||
+       header->header_size < sizeof(VADC_Prob_Cache_Header))
+   {
+      return 0;
+   }
+
+   b32 same_key = header->model_hash == key->model_hash &&
+                  header->runtime_hash == key->runtime_hash &&
+                  header->audio_hash == key->audio_hash &&
+                  header->sequence_count == key->sequence_count &&
+                  header->sample_rate == key->sample_rate &&
+                  header->audio_source == key->audio_source &&
+                  header->start_seconds == key->start_seconds;
+
+   // NOTE: a truncated file is a miss, it gets written again
+   u64 expected_size = header->header_size + header->window_count * sizeof(float);
+   return same_key && expected_size == file_size;
+}
+
+b32 vadc_prob_cache_open(VADC_Prob_Cache *cache, const char *dir, u64 model_hash, const char *runtime_version,
+                         const char *audio_path,
+                         u32 sequence_count, u32 sample_rate, s32 audio_source, float start_seconds)
+{
+   memset(cache, 0, sizeof(*cache));
+
+   u64 audio_hash = vadc_prob_cache_hash_file(audio_path);
+   if (!dir || !model_hash || !audio_hash)
+   {
+      return 0;
+   }
+
+   VADC_Prob_Cache_Header *key = &cache->key;
+   memcpy(key->magic, vadc_prob_cache_magic, sizeof(key->magic));
+   key->version = VADC_PROB_CACHE_VERSION;
+   key->header_size = sizeof(VADC_Prob_Cache_Header);
+   key->model_hash = model_hash;
+   key->runtime_hash = vadc_prob_cache_hash_bytes(runtime_version, strlen(runtime_version));
+   key->audio_hash = audio_hash;
+   key->sequence_count = sequence_count;
+   key->sample_rate = sample_rate;
+   key->audio_source = audio_source;
+   key->start_seconds = start_seconds;
+
+   u64 file_key = vadc_fnv1a(VADC_FNV1A_BASIS, key, sizeof(*key));
+   int path_length = snprintf(cache->path, sizeof(cache->path), "%s/%016llx.vadcprob", dir, (unsigned long long)file_key);
+   if (path_length < 0 || (size_t)path_length >= sizeof(cache->path))
+   {
+      return 0;
+   }
+
+   int fd = open(cache->path, O_RDONLY);
+   if (fd >= 0)
+   {
+      struct stat file_stat;
+      if (fstat(fd, &file_stat) == 0 && (size_t)file_stat.st_size >= sizeof(VADC_Prob_Cache_Header))
+      {
+         void *mapped = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (mapped != MAP_FAILED)
+         {
+            const VADC_Prob_Cache_Header *header = (const VADC_Prob_Cache_Header *)mapped;
+            if (prob_cache_header_matches(header, key, (size_t)file_stat.st_size))
+            {
+               cache->mapped = mapped;
+               cache->mapped_size = (size_t)file_stat.st_size;
+               cache->probabilities = (const float *)((const u8 *)mapped + header->header_size);
+               key->window_count = header->window_count;
+               key->total_samples = header->total_samples;
+            }
+            else
+            {
+               munmap(mapped, (size_t)file_stat.st_size);
+            }
+         }
+      }
+      close(fd);
+   }
+
+   if (cache->mapped)
+   {
+      // NOTE: read front to back exactly once
+      madvise(cache->mapped, cache->mapped_size, MADV_SEQUENTIAL);
+      return 1;
+   }
+
+   cache->recording = 1;
+   return 0;
+}
+
+int vadc_prob_cache_next(VADC_Prob_Cache *cache, float *probabilities, int max_count)
+{
+   u64 remaining = cache->key.window_count - cache->cursor;
+   int count = remaining < (u64)max_count ? (int)remaining : max_count;
+   memcpy(probabilities, cache->probabilities + cache->cursor, count * sizeof(float));
+   cache->cursor += count;
+   return count;
+}
+
+void vadc_prob_cache_record(VADC_Prob_Cache *cache, const float *probabilities, int count)
+{
+   if (!cache->recording || count <= 0)
+   {
+      return;
+   }
+   if (cache->recorded_count + count > cache->recorded_capacity)
+   {
+      u64 new_capacity = cache->recorded_capacity ? cache->recorded_capacity * 2 : 4096;
+      while (new_capacity < cache->recorded_count + count)
+      {
+         new_capacity *= 2;
+      }
+      float *new_recorded = realloc(cache->recorded, new_capacity * sizeof(float));
+      if (!new_recorded)
+      {
+         // NOTE: out of memory only costs the cache, the run goes on
+         cache->recording = 0;
+         return;
+      }
+      cache->recorded = new_recorded;
+      cache->recorded_capacity = new_capacity;
+   }
+   memcpy(cache->recorded + cache->recorded_count, probabilities, count * sizeof(float));
+   cache->recorded_count += count;
+}
+
+// NOTE: a temp name no other process or thread storing the same cache file uses at the same time
+static atomic_int g_prob_cache_temp_counter;
+
+// NOTE: written next to the target and renamed, so concurrent runs never map half a file
+int vadc_prob_cache_store(VADC_Prob_Cache *cache, u64 total_samples)
+{
+   if (!cache->recording)
+   {
+      return -1;
+   }
+
+   VADC_Prob_Cache_Header header = cache->key;
+   header.window_count = cache->recorded_count;
+   header.total_samples = total_samples;
+
+   char temp_path[1100];
+   int counter = atomic_fetch_add(&g_prob_cache_temp_counter, 1);
+   snprintf(temp_path, sizeof(temp_path), "%s.%d.%d.tmp", cache->path, (int)getpid(), counter);
+   FILE *file = fopen(temp_path, "wb");
+   if (!file)
+   {
+      return -1;
+   }
+
+   b32 written = fwrite(&header, sizeof(header), 1, file) == 1;
+   if (written && cache->recorded_count)
+   {
+      written = fwrite(cache->recorded, sizeof(float), cache->recorded_count, file) == cache->recorded_count;
+   }
+   if (fclose(file) != 0 || !written || rename(temp_path, cache->path) != 0)
+   {
+      unlink(temp_path);
+      return -1;
+   }
+   return 0;
+}
+
+void vadc_prob_cache_close(VADC_Prob_Cache *cache)
+{
+   if (cache->mapped)
+   {
+      munmap(cache->mapped, cache->mapped_size);
+   }
+   free(cache->recorded);
+   memset(cache, 0, sizeof(*cache));
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "utils.h"
+
+// NOTE: per-window probabilities of one input file, kept on disk so running the same archive again with
+//       other segmentation settings skips decoding and inference. A cache file is a fixed header and the
+//       probabilities as raw floats right after it, mapped read-only on a hit. The file name is a hash of
+//       the model file, the inference runtime and its version, the input file, the window size, the
+//       sample rate and where in the input the run starts; the header repeats all of it and a mismatch
+//       counts as a miss.
+
+// NOTE: 2: runtime_hash
+#define VADC_PROB_CACHE_VERSION 2
+
+// NOTE: FNV-1a, also the hash of the model cache and the checkpoint keys. Start from VADC_FNV1A_BASIS.
+#define VADC_FNV1A_BASIS 0xcbf29ce484222325ULL
+u64 vadc_fnv1a( u64 hash, const void *data, size_t size );
+
+typedef struct VADC_Prob_Cache_Header VADC_Prob_Cache_Header;
+struct VADC_Prob_Cache_Header
+{
+   char magic[8];
+   u32 version;
+   // NOTE: offset of the probabilities, so later versions can grow the header
+   u32 header_size;
+   u64 model_hash;
+   // NOTE: the same model can score a little differently on another onnxruntime
+   u64 runtime_hash;
+   u64 audio_hash;
+   u32 sequence_count;
+   u32 sample_rate;
+   s32 audio_source;
+   float start_seconds;
+   u64 window_count;
+   // NOTE: samples decoded, which can be a partial window more than window_count covers
+   u64 total_samples;
+};
+
+typedef struct VADC_Prob_Cache VADC_Prob_Cache;
+struct VADC_Prob_Cache
+{
+   char path[1024];
+   VADC_Prob_Cache_Header key;
+
+   // NOTE: a hit, the mapped file
+   void *mapped;
+   size_t mapped_size;
+   const float *probabilities;
+   u64 cursor;
+
+   // NOTE: a miss, probabilities collected for vadc_prob_cache_store
+   b32 recording;
+   float *recorded;
+   u64 recorded_count;
+   u64 recorded_capacity;
+};
+
+// NOTE: set by --prob_cache, otherwise the VADC_PROB_CACHE environment variable on first use. NULL or
+//       "" turns the cache off.
+void vadc_prob_cache_set_dir( const char *dir );
+const char *vadc_prob_cache_dir( void );
+
+// NOTE: vadc_fnv1a of the whole file, 0 if it can't be read
+u64 vadc_prob_cache_hash_file( const char *path );
+u64 vadc_prob_cache_hash_bytes( const void *data, size_t size );
+
+// NOTE: maps the cache file for this key if there is a valid one, otherwise prepares recording.
+//       runtime_version names the inference runtime and its version. Returns whether it was a hit.
+b32 vadc_prob_cache_open( VADC_Prob_Cache *cache, const char *dir, u64 model_hash, const char *runtime_version,
+                          const char *audio_path,
+                          u32 sequence_count, u32 sample_rate, s32 audio_source, float start_seconds );
+
+// NOTE: a hit, the next (up to) max_count probabilities, returns how many
+int vadc_prob_cache_next( VADC_Prob_Cache *cache, float *probabilities, int max_count );
+
+// NOTE: a miss, appends what the model computed
+void vadc_prob_cache_record( VADC_Prob_Cache *cache, const float *probabilities, int count );
+
+// NOTE: a miss, writes the recorded probabilities next to the target and renames it into place. Only
+//       for runs that read their whole input.
+int vadc_prob_cache_store( VADC_Prob_Cache *cache, u64 total_samples );
+
+void vadc_prob_cache_close( VADC_Prob_Cache *cache );
@@ -16,7 +16,11 @@
 #define MATHS_IMPLEMENTATION
 #include "maths.h"
 
+// NOTE: the tests build this backend without the generated weights source, they read the tracked
+//       testdata/silero_v31_16k.testtensor (the same tensors) from VADC_SILERO_WEIGHTS_PATH instead
+#if !defined(VADC_SILERO_WEIGHTS_PATH)
 #include "silero_v31_16k_weights.c"
+#endif // VADC_SILERO_WEIGHTS_PATH
 
 static void *silero_init(MemoryArena *arena, String8 model_path_arg, Silero_Config *config)
 {
@@ -25,7 +29,16 @@ static void *silero_init(MemoryArena *arena, String8 model_path_arg, Silero_Conf
    Silero_Context *silero_context = pushStruct(arena, Silero_Context);
    LoadTesttensorResult silero_weights_res = {0};
 
+#if defined(VADC_SILERO_WEIGHTS_PATH)
+   silero_weights_res = load_testtensor(arena, VADC_SILERO_WEIGHTS_PATH);
+   if ( silero_weights_res.tensor_count == 0 )
+   {
+      fprintf(stderr, "Error: couldn't load the weights from %s\n", VADC_SILERO_WEIGHTS_PATH);
+      return 0;
+   }
+#else
    silero_weights_res = load_testtensor_from_bytes(arena, sizeof(silero_v31_16k_weights), silero_v31_16k_weights );
+#endif // VADC_SILERO_WEIGHTS_PATH
 
    Assert ( silero_weights_res.tensor_count > 0 );
    int encoder_weights_count = 24 + 24 + 22 + 24;
@@ -40,6 +53,14 @@ static void *silero_init(MemoryArena *arena, String8 model_path_arg, Silero_Conf
    config->is_silero_v5 = false;
    config->input_size_min = 1536;
    config->input_size_max = 1536;
+   if (vadc_prob_cache_dir() || config->model_file_hash_wanted)
+   {
+#if defined(VADC_SILERO_WEIGHTS_PATH)
+      config->model_file_hash = vadc_prob_cache_hash_file(VADC_SILERO_WEIGHTS_PATH);
+#else
+      config->model_file_hash = vadc_prob_cache_hash_bytes(silero_v31_16k_weights, sizeof(silero_v31_16k_weights));
+#endif // VADC_SILERO_WEIGHTS_PATH
+   }
    config->output_dims = 3;
 
    return silero_context;
@@ -52,6 +73,8 @@ static inline void *backend_init( MemoryArena *arena, String8 model_path_arg, Si
 
 static inline void backend_run(MemoryArena *arena, void *context_, Silero_Config config)
 {
+   TracyCZone(backend_run, true);
+
    VADC_Context *context = context_;
 
    // int output_stride = context->is_silero_v4 ? 1 : 2;
@@ -60,6 +83,10 @@ static inline void backend_run(MemoryArena *arena, void *context_, Silero_Config
    int output_stride = 2;
    // int silero_probability_out_index = 1;
 
+   // NOTE: the output tensor is pushed for every call, it goes once its values are copied out, or a
+   //       long run would grow the arena window by window
+   TemporaryMemory output_memory = beginTemporaryMemory(arena);
+
    // TODO(irwin): dehardcode one batch
    TestTensor *output = silero_run_one_batch_with_context(arena,
                                                           context->backend,
@@ -71,11 +98,78 @@ static inline void backend_run(MemoryArena *arena, void *context_, Silero_Config
       context->buffers.output[i * output_stride + 0] = output->data[i * output_stride + 0];
       context->buffers.output[i * output_stride + 1] = output->data[i * output_stride + 1];
    }
+
+   endTemporaryMemory(output_memory);
+
+   TracyCZoneEnd(backend_run);
 }
 
+// NOTE: called at the start of every run. The lstm state lives in the context here, not in the zeroed
+//       Tensor_Buffers, so a backend reused for the next file (a --jobs worker) starts it afresh too.
 static inline void backend_create_tensors(Silero_Config config, void *backend, Tensor_Buffers buffers)
 {
    VAR_UNUSED(config);
-   VAR_UNUSED(backend);
    VAR_UNUSED(buffers);
+
+   Silero_Context *silero_context = backend;
+   memset(silero_context->state_lstm_h->data, 0, silero_context->state_lstm_h->size * sizeof(float));
+   memset(silero_context->state_lstm_c->data, 0, silero_context->state_lstm_c->size * sizeof(float));
+}
+
+// NOTE: shares the weights, gets its own lstm state
+static inline void *backend_clone(MemoryArena *arena, void *backend)
+{
+   Silero_Context *source = backend;
+   Silero_Context *silero_context = pushStruct(arena, Silero_Context);
+   *silero_context = *source;
+   silero_context->state_lstm_h = tensor_zeros_3d(arena, 2, 1, 64);
+   silero_context->state_lstm_c = tensor_zeros_3d(arena, 2, 1, 64);
+
+   return silero_context;
+}
+
+// NOTE: the lstm state lives in the context here, not in the Tensor_Buffers. For checkpoints.
+static inline size_t backend_state_bytes(void *backend)
+{
+   Silero_Context *silero_context = backend;
+   return (silero_context->state_lstm_h->size + silero_context->state_lstm_c->size) * sizeof(float);
+}
+
+static inline void backend_save_state(void *backend, void *destination)
+{
+   Silero_Context *silero_context = backend;
+   size_t h_bytes = silero_context->state_lstm_h->size * sizeof(float);
+   memcpy(destination, silero_context->state_lstm_h->data, h_bytes);
+   memcpy((u8 *)destination + h_bytes, silero_context->state_lstm_c->data, silero_context->state_lstm_c->size * sizeof(float));
+}
+
+static inline void backend_load_state(void *backend, const void *source)
+{
+   Silero_Context *silero_context = backend;
+   size_t h_bytes = silero_context->state_lstm_h->size * sizeof(float);
+   memcpy(silero_context->state_lstm_h->data, source, h_bytes);
+   memcpy(silero_context->state_lstm_c->data, (const u8 *)source + h_bytes, silero_context->state_lstm_c->size * sizeof(float));
+}
+
+static inline void backend_release_tensors(void *backend)
+{
+   VAR_UNUSED(backend);
+}
+
+// NOTE: the weights are static and the context lives in the arena, nothing to free
+static inline void backend_release(void *backend)
+{
+   VAR_UNUSED(backend);
+}
+
+// NOTE: the weights are compiled in, there is no model to cache
+static inline void backend_set_model_cache_dir(const char *dir)
+{
+   VAR_UNUSED(dir);
+}
+
+// NOTE: no runtime, the engine is part of this build
+static inline const char *backend_runtime_version(void)
+{
+   return "silero_c";
 }
@@ -0,0 +1,55 @@
+#include "silero_c.h"
+
+#include <TracyC.h>
+
+#if !defined(VADC_SLOW)
+#define VADC_SLOW 0
+#endif // VADC_SLOW
+
+#include "tensor.h"
+
+#include "conv.c"
+#include "misc.c"
+#include "stft.c"
+#include "lstm.c"
+#include "transformer.c"
+#include "silero_v3.c"
+
+#define MATHS_IMPLEMENTATION
+#include "maths.h"
+
+Silero_Context *silero_c_init(MemoryArena *arena, const char *weights_path)
+{
+   LoadTesttensorResult silero_weights_res = load_testtensor(arena, weights_path);
+
+   // NOTE: same layout check as silero_init, 1 stft basis + encoder + lstm + decoder tensors
+   int encoder_weights_count = 24 + 24 + 22 + 24;
+   if ( silero_weights_res.tensor_count != (1 + encoder_weights_count + 2 + 2) )
+   {
+      return 0;
+   }
+
+   Silero_Context *silero_context = pushStruct(arena, Silero_Context);
+   silero_context->weights = silero_weights_init( silero_weights_res );
+   silero_context->state_lstm_h = tensor_zeros_3d(arena, 2, 1, 64);
+   silero_context->state_lstm_c = tensor_zeros_3d(arena, 2, 1, 64);
+
+   return silero_context;
+}
+
+float silero_c_run_window(MemoryArena *arena, Silero_Context *context, const float *samples)
+{
+   TracyCZone(silero_c_run_window, true);
+
+   TemporaryMemory mark = beginTemporaryMemory( arena );
+
+   // NOTE(irwin): v3.1 output is [batch, 2, 1], speech probability is the second one
+   TestTensor *output = silero_run_one_batch_with_context(arena, context, 1, SILERO_C_WINDOW_SAMPLES, (float *)samples);
+   float probability = output->data[1];
+
+   endTemporaryMemory( mark );
+
+   TracyCZoneEnd(silero_c_run_window);
+
+   return probability;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "utils.h"
+#include "memory.h"
+
+// NOTE: the pure C Silero v3.1 engine behind a small interface, compiled as its own translation unit so a
+//       build that runs inference through onnxruntime can still run it next to it (see run_crossval).
+//       The weights come from a .testtensor file instead of being embedded.
+#define SILERO_C_WINDOW_SAMPLES 1536
+
+typedef struct Silero_Context Silero_Context;
+
+// NOTE: returns 0 if the weights file can't be read or isn't a v3.1 16k weights file
+Silero_Context *silero_c_init( MemoryArena *arena, const char *weights_path );
+
+// NOTE: one window of SILERO_C_WINDOW_SAMPLES samples, carries the lstm state over to the next call.
+//       Returns the speech probability, scratch memory is released before returning.
+float silero_c_run_window( MemoryArena *arena, Silero_Context *context, const float *samples );
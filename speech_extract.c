@@ -0,0 +1,165 @@
+#include "speech_extract.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SPEECH_EXTRACT_WAV_HEADER_BYTES 44
+
+static void speech_extract_put_u32(u8 *at, u32 value)
+{
+   at[0] = (u8)value;
+   at[1] = (u8)(value >> 8);
+   at[2] = (u8)(value >> 16);
+   at[3] = (u8)(value >> 24);
+}
+
+static void speech_extract_put_u16(u8 *at, u16 value)
+{
+   at[0] = (u8)value;
+   at[1] = (u8)(value >> 8);
+}
+
+// NOTE: data_bytes 0xFFFFFFFF while the length isn't known, which most readers take as "until the end"
+static void speech_extract_wav_header(u8 *header, int sample_rate, u32 data_bytes)
+{
+   u32 riff_bytes = data_bytes == 0xFFFFFFFFu ? 0xFFFFFFFFu : data_bytes + SPEECH_EXTRACT_WAV_HEADER_BYTES - 8;
+   memcpy(header + 0, "RIFF", 4);
+   speech_extract_put_u32(header + 4, riff_bytes);
+   memcpy(header + 8, "WAVE", 4);
+   memcpy(header + 12, "fmt ", 4);
+   speech_extract_put_u32(header + 16, 16);
+   speech_extract_put_u16(header + 20, 1);                        // NOTE: PCM
+   speech_extract_put_u16(header + 22, 1);                        // NOTE: mono
+   speech_extract_put_u32(header + 24, (u32)sample_rate);
+   speech_extract_put_u32(header + 28, (u32)sample_rate * 2);     // NOTE: bytes per second
+   speech_extract_put_u16(header + 32, 2);                        // NOTE: bytes per frame
+   speech_extract_put_u16(header + 34, 16);
+   memcpy(header + 36, "data", 4);
+   speech_extract_put_u32(header + 40, data_bytes);
+}
+
+int vadc_speech_extract_open(VADC_Speech_Extractor *extractor, const char *path, int sample_rate, float lookbehind_seconds)
+{
+   memset(extractor, 0, sizeof(*extractor));
+
+   size_t path_length = strlen(path);
+   extractor->wav = path_length >= 4 && (strcmp(path + path_length - 4, ".wav") == 0 || strcmp(path + path_length - 4, ".WAV") == 0);
+   extractor->sample_rate = sample_rate;
+   extractor->ring_capacity = (s64)(lookbehind_seconds * sample_rate);
+   if (extractor->ring_capacity < sample_rate)
+   {
+      extractor->ring_capacity = sample_rate;
+   }
+
+   extractor->ring = (short *)malloc((size_t)extractor->ring_capacity * sizeof(short));
+   if (!extractor->ring)
+   {
+      return -1;
+   }
+
+   extractor->file = fopen(path, "wb");
+   if (!extractor->file)
+   {
+      free(extractor->ring);
+      extractor->ring = NULL;
+      return -1;
+   }
+
+   if (extractor->wav)
+   {
+      u8 header[SPEECH_EXTRACT_WAV_HEADER_BYTES];
+      speech_extract_wav_header(header, sample_rate, 0xFFFFFFFFu);
+      extractor->write_failed = fwrite(header, 1, sizeof(header), extractor->file) != sizeof(header);
+   }
+   return 0;
+}
+
+void vadc_speech_extract_push(VADC_Speech_Extractor *extractor, const short *samples, size_t count)
+{
+   // NOTE: only the newest ring_capacity samples can survive this push
+   if ((s64)count > extractor->ring_capacity)
+   {
+      s64 skipped = (s64)count - extractor->ring_capacity;
+      samples += skipped;
+      extractor->pushed += skipped;
+      count = (size_t)extractor->ring_capacity;
+   }
+
+   while (count > 0)
+   {
+      s64 offset = extractor->pushed % extractor->ring_capacity;
+      size_t chunk = (size_t)(extractor->ring_capacity - offset);
+      chunk = chunk < count ? chunk : count;
+      memcpy(extractor->ring + offset, samples, chunk * sizeof(short));
+      samples += chunk;
+      count -= chunk;
+      extractor->pushed += (s64)chunk;
+   }
+}
+
+void vadc_speech_extract_write(VADC_Speech_Extractor *extractor, s64 start_sample, s64 end_sample)
+{
+   if (start_sample < extractor->written_until)
+   {
+      start_sample = extractor->written_until;
+   }
+   if (end_sample > extractor->pushed)
+   {
+      end_sample = extractor->pushed;
+   }
+   if (end_sample <= start_sample)
+   {
+      return;
+   }
+
+   s64 oldest = extractor->pushed - extractor->ring_capacity;
+   if (start_sample < oldest)
+   {
+      s64 lost_end = end_sample < oldest ? end_sample : oldest;
+      extractor->lost_samples += lost_end - start_sample;
+      start_sample = lost_end;
+   }
+
+   while (start_sample < end_sample)
+   {
+      s64 offset = start_sample % extractor->ring_capacity;
+      s64 chunk = extractor->ring_capacity - offset;
+      chunk = chunk < end_sample - start_sample ? chunk : end_sample - start_sample;
+      if (fwrite(extractor->ring + offset, sizeof(short), (size_t)chunk, extractor->file) != (size_t)chunk)
+      {
+         extractor->write_failed = 1;
+      }
+      extractor->written_samples += chunk;
+      start_sample += chunk;
+   }
+   extractor->written_until = end_sample;
+}
+
+int vadc_speech_extract_close(VADC_Speech_Extractor *extractor)
+{
+   if (!extractor->file)
+   {
+      return 0;
+   }
+
+   if (extractor->wav && fseek(extractor->file, 0, SEEK_SET) == 0)
+   {
+      // NOTE: a pipe can't seek, it keeps the open-ended sizes
+      s64 data_bytes = extractor->written_samples * (s64)sizeof(short);
+      u8 header[SPEECH_EXTRACT_WAV_HEADER_BYTES];
+      speech_extract_wav_header(header, extractor->sample_rate, data_bytes < 0xFFFFFFFFll ? (u32)data_bytes : 0xFFFFFFFFu);
+      if (fwrite(header, 1, sizeof(header), extractor->file) != sizeof(header))
+      {
+         extractor->write_failed = 1;
+      }
+   }
+
+   if (fclose(extractor->file) != 0)
+   {
+      extractor->write_failed = 1;
+   }
+   free(extractor->ring);
+   extractor->file = NULL;
+   extractor->ring = NULL;
+   return extractor->write_failed ? -1 : 0;
+}
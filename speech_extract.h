@@ -0,0 +1,41 @@
+#pragma once
+#include "utils.h"
+#include <stdio.h>
+
+// NOTE: writes the speech of a run, cut at the final padded and merged segments, in the same decoding pass.
+//       Decoded samples go into a ring that keeps the last lookbehind's worth; a range that is certain to
+//       be speech is written from it as soon as it's known, so the ring only has to cover what the
+//       segmenter hasn't decided yet (padding, min_speech and the merge of close segments), not whole
+//       segments. Samples of a segment that already fell out of the ring are lost and counted.
+//       A .wav path gets a 16-bit mono WAV header (sizes filled in on close if the file can seek), any
+//       other path raw s16le.
+
+typedef struct VADC_Speech_Extractor VADC_Speech_Extractor;
+struct VADC_Speech_Extractor
+{
+   FILE *file;
+   b32 wav;
+   int sample_rate;
+
+   short *ring;
+   s64 ring_capacity;
+   // NOTE: absolute sample indices from the start of the run
+   s64 pushed;
+   s64 written_until;
+
+   s64 written_samples;
+   s64 lost_samples;
+   b32 write_failed;
+};
+
+// NOTE: returns 0 on success
+int vadc_speech_extract_open( VADC_Speech_Extractor *extractor, const char *path, int sample_rate, float lookbehind_seconds );
+
+void vadc_speech_extract_push( VADC_Speech_Extractor *extractor, const short *samples, size_t count );
+
+// NOTE: [start_sample, end_sample) is speech. Ranges come in stream order, the part of a range that was
+//       already written is skipped, so a growing segment can be written piece by piece.
+void vadc_speech_extract_write( VADC_Speech_Extractor *extractor, s64 start_sample, s64 end_sample );
+
+// NOTE: returns 0 if everything was written
+int vadc_speech_extract_close( VADC_Speech_Extractor *extractor );
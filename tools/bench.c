@@ -0,0 +1,683 @@
+// NOTE: vadc_bench - runs each hot kernel in isolation at the shapes the
+// Silero v3.1 graph actually feeds it and prints the timings as JSON, so
+// results can be diffed across compiler flags and hosts.
+//
+// usage: vadc_bench [--warmup N] [--reps N] [--min_time_us N] [--cpu N] [--filter substring]
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <TracyC.h>
+
+#if !defined(VADC_SLOW)
+#define VADC_SLOW 0
+#endif // VADC_SLOW
+
+#include "utils.h"
+#include "tensor.h"
+
+
+#include "conv.c"
+#include "misc.c"
+#include "stft.c"
+#include "lstm.c"
+#include "transformer.c"
+
+#define MATHS_IMPLEMENTATION
+#include "maths.h"
+
+#define MEMORY_IMPLEMENTATION
+#include "memory.h"
+
+
+typedef struct BenchCase BenchCase;
+typedef void BenchFunction( BenchCase *bench );
+
+struct BenchCase
+{
+   const char *kernel;
+   char shape[64];
+
+   // NOTE: work per call. flops counts a multiply-add as 2, bytes is the
+   // size of every tensor the kernel reads or writes once (inputs, weights,
+   // outputs), not the traffic that actually reaches memory.
+   double flops;
+   double bytes;
+
+   BenchFunction *run;
+   MemoryArena *arena;
+
+   TestTensor *input;
+   TestTensor *weights;
+   TestTensor *biases;
+   TestTensor *weights2;
+   TestTensor *biases2;
+   TestTensor *output;
+   TestTensor *state_h;
+   TestTensor *state_c;
+
+   int count;
+   int hop_length;
+   int seq_length;
+   int layers;
+};
+
+typedef struct BenchResult BenchResult;
+struct BenchResult
+{
+   s64 iterations;
+   double ns_median;
+   double ns_min;
+   double ns_max;
+};
+
+typedef struct BenchOptions BenchOptions;
+struct BenchOptions
+{
+   int warmup;
+   int reps;
+   int min_time_us;
+   int cpu;
+   const char *filter;
+};
+
+// NOTE: keeps the scalar kernels from being optimized away
+static volatile float bench_sink;
+
+static u32 bench_rng_state = 0x9E3779B9u;
+
+static float bench_random_float( void )
+{
+   // NOTE: xorshift32, fixed seed so every run benches the same data
+   u32 x = bench_rng_state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   bench_rng_state = x;
+
+   return ((float)(x >> 8) / (float)(1 << 24)) * 2.0f - 1.0f;
+}
+
+static TestTensor *bench_random_tensor( MemoryArena *arena, int ndim, int dims[], float scale )
+{
+   TestTensor *result = tensor_zeros( arena, ndim, dims );
+   for ( int i = 0; i < result->size; ++i )
+   {
+      result->data[i] = bench_random_float() * scale;
+   }
+
+   return result;
+}
+
+static TestTensor *bench_random_1d( MemoryArena *arena, int dim0, float scale )
+{
+   int dims[1] = {dim0};
+   return bench_random_tensor( arena, 1, dims, scale );
+}
+
+static TestTensor *bench_random_2d( MemoryArena *arena, int dim0, int dim1, float scale )
+{
+   int dims[2] = {dim0, dim1};
+   return bench_random_tensor( arena, 2, dims, scale );
+}
+
+static TestTensor *bench_random_3d( MemoryArena *arena, int dim0, int dim1, int dim2, float scale )
+{
+   int dims[3] = {dim0, dim1, dim2};
+   return bench_random_tensor( arena, 3, dims, scale );
+}
+
+static double tensor_bytes( TestTensor *tensor )
+{
+   return tensor ? (double)tensor->nbytes : 0.0;
+}
+
+
+static void run_dotproduct_simd( BenchCase *bench )
+{
+   bench_sink = dotproduct_simd( bench->input->data, bench->count, bench->weights->data, bench->count );
+}
+
+static void run_dotproduct_unrolled( BenchCase *bench )
+{
+   bench_sink = dotproduct_unrolled( bench->input->data, bench->count, bench->weights->data, bench->count );
+}
+
+static void run_dotproduct_unrolled2( BenchCase *bench )
+{
+   bench_sink = dotproduct_unrolled2( bench->input->data, bench->count, bench->weights->data, bench->count );
+}
+
+static void run_dotproduct_slow( BenchCase *bench )
+{
+   bench_sink = dotproduct_slow( bench->input->data, bench->count, bench->weights->data, bench->count );
+}
+
+static void run_stft( BenchCase *bench )
+{
+   my_stft_( bench->arena, bench->input, bench->weights, bench->output, bench->hop_length, 128, 128 );
+}
+
+static void run_conv_tensor( BenchCase *bench )
+{
+   conv_tensor( bench->arena, bench->input, bench->weights, bench->biases, bench->hop_length, bench->output );
+}
+
+static void run_dw_conv_tensor( BenchCase *bench )
+{
+   dw_conv_tensor( bench->input, bench->weights, bench->biases, bench->output );
+}
+
+static void run_pw_conv_tensor( BenchCase *bench )
+{
+   pw_conv_tensor( bench->arena, bench->input, bench->weights, bench->biases, bench->output );
+}
+
+static void run_lstm_cell( BenchCase *bench )
+{
+   int hidden_size = bench->count;
+   lstm_cell( bench->arena,
+              bench->input->data,
+              hidden_size,
+              bench->state_h->data,
+              bench->state_c->data,
+              bench->weights->data,
+              bench->biases->data,
+              bench->output->data,
+              bench->output->data + hidden_size );
+}
+
+static void run_lstm_seq( BenchCase *bench )
+{
+   lstm_seq( bench->arena,
+             bench->input->data,
+             bench->seq_length,
+             bench->count,
+             bench->state_h->data,
+             bench->state_c->data,
+             bench->weights->data,
+             bench->biases->data,
+             bench->output->data,
+             bench->layers );
+}
+
+static void run_dual_head_attention( BenchCase *bench )
+{
+   dual_head_attention( bench->arena, bench->input,
+                        bench->weights, bench->biases,
+                        bench->weights2, bench->biases2,
+                        bench->output );
+}
+
+static void run_layer_norm( BenchCase *bench )
+{
+   layer_norm( bench->arena, bench->input, bench->weights, bench->biases, bench->output );
+}
+
+static void run_softmax( BenchCase *bench )
+{
+   // NOTE: softmax works in place, so refill the scores first or every call
+   // after the first one would see an already normalized input
+   memcpy( bench->output->data, bench->input->data, bench->input->nbytes );
+   softmax_inplace_stable( bench->arena, bench->output );
+}
+
+
+static BenchCase *bench_push( BenchCase *cases, int *case_count, int case_capacity, MemoryArena *arena, const char *kernel, BenchFunction *run )
+{
+   Assert( *case_count < case_capacity );
+   VAR_UNUSED( case_capacity );
+
+   BenchCase *bench = cases + (*case_count)++;
+   memset( bench, 0, sizeof( *bench ) );
+   bench->kernel = kernel;
+   bench->run = run;
+   bench->arena = arena;
+
+   return bench;
+}
+
+static int bench_build_cases( MemoryArena *arena, BenchCase *cases, int case_capacity )
+{
+   int case_count = 0;
+
+   // NOTE: dot products at the row lengths the model uses: pw conv rows
+   // (16, 32, 129), attention rows (64) and the lstm [x, h] row (128)
+   {
+      static const int dot_lengths[] = {16, 32, 64, 128, 129};
+      static const struct { const char *name; BenchFunction *run; } dot_variants[] =
+      {
+         {"dotproduct_simd", run_dotproduct_simd},
+         {"dotproduct_unrolled", run_dotproduct_unrolled},
+         {"dotproduct_unrolled2", run_dotproduct_unrolled2},
+         {"dotproduct_slow", run_dotproduct_slow},
+      };
+
+      for ( int variant = 0; variant < (int)ArrayCount( dot_variants ); ++variant )
+      {
+         for ( int i = 0; i < (int)ArrayCount( dot_lengths ); ++i )
+         {
+            int n = dot_lengths[i];
+            BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, dot_variants[variant].name, dot_variants[variant].run );
+            bench->count = n;
+            bench->input = bench_random_1d( arena, n, 1.0f );
+            bench->weights = bench_random_1d( arena, n, 1.0f );
+            bench->flops = 2.0 * n;
+            bench->bytes = 2.0 * n * sizeof( float );
+            snprintf( bench->shape, sizeof( bench->shape ), "[%d]", n );
+         }
+      }
+   }
+
+   // NOTE: stft of one 1536 sample window, 258 filters of 256 taps, hop 64
+   {
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "my_stft_", run_stft );
+      bench->hop_length = 64;
+      bench->input = bench_random_2d( arena, 1, 1536, 1.0f );
+      bench->weights = bench_random_3d( arena, 258, 1, 256, 0.1f );
+      bench->output = tensor_zeros_3d( arena, 1, 129, 25 );
+      bench->flops = 2.0 * 258 * 256 * 25 + 3.0 * 129 * 25;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->weights ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[1,1536]x[258,1,256]/64" );
+   }
+
+   // NOTE: per layer shapes: channels in, channels out, sequence length in
+   // and the stride of the conv that closes the layer
+   static const struct { int in; int out; int seq; int stride; } layers[] =
+   {
+      {129, 16, 25, 2},
+      { 16, 32, 13, 2},
+      { 32, 32,  7, 1},
+      { 32, 64,  7, 1},
+   };
+
+   for ( int i = 0; i < (int)ArrayCount( layers ); ++i )
+   {
+      int c = layers[i].in;
+      int seq = layers[i].seq;
+
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "dw_conv_tensor", run_dw_conv_tensor );
+      bench->input = bench_random_3d( arena, 1, c, seq, 1.0f );
+      bench->weights = bench_random_2d( arena, c, 5, 0.5f );
+      bench->biases = bench_random_1d( arena, c, 0.1f );
+      bench->output = tensor_zeros_3d( arena, 1, c, seq );
+      bench->flops = 2.0 * c * seq * 5 + (double)c * seq;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[1,%d,%d]k5", c, seq );
+   }
+
+   for ( int i = 0; i < (int)ArrayCount( layers ); ++i )
+   {
+      int c_in = layers[i].in;
+      int c_out = layers[i].out;
+      int seq = layers[i].seq;
+
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "pw_conv_tensor", run_pw_conv_tensor );
+      bench->input = bench_random_3d( arena, 1, c_in, seq, 1.0f );
+      bench->weights = bench_random_3d( arena, c_out, c_in, 1, 0.5f );
+      bench->biases = bench_random_1d( arena, c_out, 0.1f );
+      bench->output = tensor_zeros_3d( arena, 1, c_out, seq );
+      bench->flops = 2.0 * c_out * c_in * seq + (double)c_out * seq;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[1,%d,%d]->%d", c_in, seq, c_out );
+   }
+
+   for ( int i = 0; i < (int)ArrayCount( layers ); ++i )
+   {
+      int c = layers[i].out;
+      int seq = layers[i].seq;
+      int stride = layers[i].stride;
+      int seq_out = 1 + (seq - 1) / stride;
+
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "conv_tensor", run_conv_tensor );
+      bench->hop_length = stride;
+      bench->input = bench_random_3d( arena, 1, c, seq, 1.0f );
+      bench->weights = bench_random_3d( arena, c, c, 1, 0.5f );
+      bench->biases = bench_random_1d( arena, c, 0.1f );
+      bench->output = tensor_zeros_3d( arena, 1, c, seq_out );
+      bench->flops = 2.0 * c * c * seq_out + (double)c * seq_out;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[1,%d,%d]k1/%d", c, seq, stride );
+   }
+
+   for ( int i = 0; i < (int)ArrayCount( layers ); ++i )
+   {
+      int f = layers[i].out;
+      int seq = layers[i].seq;
+
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "dual_head_attention", run_dual_head_attention );
+      bench->input = bench_random_2d( arena, seq, f, 1.0f );
+      bench->weights = bench_random_2d( arena, 3 * f, f, 0.25f );
+      bench->biases = bench_random_1d( arena, 3 * f, 0.1f );
+      bench->weights2 = bench_random_2d( arena, f, f, 0.25f );
+      bench->biases2 = bench_random_1d( arena, f, 0.1f );
+      bench->output = tensor_zeros_2d( arena, seq, f );
+      // NOTE: qkv projection, q.k scores and attention.v for both heads,
+      // output projection
+      bench->flops = 2.0 * seq * f * (3 * f) + 2.0 * seq * seq * f + 2.0 * seq * seq * f + 2.0 * seq * f * f;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) +
+                     tensor_bytes( bench->weights2 ) + tensor_bytes( bench->biases2 ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[%d,%d]", seq, f );
+   }
+
+   for ( int i = 0; i < (int)ArrayCount( layers ); ++i )
+   {
+      int f = layers[i].out;
+      int seq = layers[i].seq;
+
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "layer_norm", run_layer_norm );
+      bench->input = bench_random_2d( arena, seq, f, 1.0f );
+      bench->weights = bench_random_1d( arena, f, 1.0f );
+      bench->biases = bench_random_1d( arena, f, 0.1f );
+      bench->output = tensor_zeros_2d( arena, seq, f );
+      bench->flops = 8.0 * seq * f;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[%d,%d]", seq, f );
+   }
+
+   // NOTE: attention scores, one [seq, seq] matrix per head
+   {
+      static const int softmax_seq[] = {25, 13, 7};
+      for ( int i = 0; i < (int)ArrayCount( softmax_seq ); ++i )
+      {
+         int seq = softmax_seq[i];
+
+         BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "softmax_inplace_stable", run_softmax );
+         bench->input = bench_random_3d( arena, 2, seq, seq, 4.0f );
+         bench->output = tensor_zeros_like( arena, bench->input );
+         // NOTE: max, exp (counted as one), sum and scale per element
+         bench->flops = 4.0 * bench->input->size;
+         bench->bytes = 2.0 * tensor_bytes( bench->input );
+         snprintf( bench->shape, sizeof( bench->shape ), "[2,%d,%d]", seq, seq );
+      }
+   }
+
+   // NOTE: decoder lstm, hidden size 64, 2 layers, 7 steps per window
+   {
+      int hidden_size = 64;
+      int gates = 4 * hidden_size;
+      int combined = 2 * hidden_size;
+
+      BenchCase *bench = bench_push( cases, &case_count, case_capacity, arena, "lstm_cell", run_lstm_cell );
+      bench->count = hidden_size;
+      bench->input = bench_random_1d( arena, hidden_size, 1.0f );
+      bench->state_h = bench_random_1d( arena, hidden_size, 0.5f );
+      bench->state_c = bench_random_1d( arena, hidden_size, 0.5f );
+      bench->weights = bench_random_2d( arena, gates, combined, 0.1f );
+      bench->biases = bench_random_1d( arena, gates, 0.1f );
+      bench->output = tensor_zeros_1d( arena, 2 * hidden_size );
+      // NOTE: gate matvec, plus sigmoid/tanh and the state update per unit
+      bench->flops = 2.0 * gates * combined + 10.0 * hidden_size;
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->state_h ) + tensor_bytes( bench->state_c ) +
+                     tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "H%d", hidden_size );
+
+      int layer_count = 2;
+      int seq = 7;
+
+      bench = bench_push( cases, &case_count, case_capacity, arena, "lstm_seq", run_lstm_seq );
+      bench->count = hidden_size;
+      bench->seq_length = seq;
+      bench->layers = layer_count;
+      bench->input = bench_random_2d( arena, seq, hidden_size, 1.0f );
+      bench->state_h = bench_random_1d( arena, layer_count * hidden_size, 0.5f );
+      bench->state_c = bench_random_1d( arena, layer_count * hidden_size, 0.5f );
+      bench->weights = bench_random_3d( arena, layer_count, gates, combined, 0.1f );
+      bench->biases = bench_random_2d( arena, layer_count, gates, 0.1f );
+      bench->output = tensor_zeros_1d( arena, seq * hidden_size + 2 * layer_count * hidden_size );
+      bench->flops = (double)seq * layer_count * (2.0 * gates * combined + 10.0 * hidden_size);
+      bench->bytes = tensor_bytes( bench->input ) + tensor_bytes( bench->state_h ) + tensor_bytes( bench->state_c ) +
+                     tensor_bytes( bench->weights ) + tensor_bytes( bench->biases ) + tensor_bytes( bench->output );
+      snprintf( bench->shape, sizeof( bench->shape ), "[%d,%d]H%dL%d", seq, hidden_size, hidden_size, layer_count );
+   }
+
+   return case_count;
+}
+
+
+static int compare_doubles( const void *a, const void *b )
+{
+   double lhs = *(const double *)a;
+   double rhs = *(const double *)b;
+   return (lhs > rhs) - (lhs < rhs);
+}
+
+static BenchResult bench_run( BenchCase *bench, BenchOptions *options, double *rep_ns )
+{
+   BenchResult result = {0};
+
+   // NOTE: calibrate how many calls one rep makes, so that a rep of even
+   // the smallest kernel lasts min_time_us and the clock overhead vanishes
+   s64 iterations = 1;
+   s64 min_time_ns = (s64)options->min_time_us * 1000;
+   for ( ;; )
+   {
+      s64 start = vadc_now_ns();
+      for ( s64 i = 0; i < iterations; ++i )
+      {
+         bench->run( bench );
+      }
+      s64 elapsed = vadc_now_ns() - start;
+
+      if ( elapsed >= min_time_ns || iterations >= (1LL << 30) )
+      {
+         break;
+      }
+
+      if ( elapsed <= 0 )
+      {
+         iterations *= 10;
+      }
+      else
+      {
+         s64 estimate = (s64)((double)iterations * (double)min_time_ns / (double)elapsed * 1.1) + 1;
+         iterations = estimate > iterations * 10 ? iterations * 10 : estimate;
+      }
+   }
+
+   for ( int rep = 0; rep < options->warmup; ++rep )
+   {
+      for ( s64 i = 0; i < iterations; ++i )
+      {
+         bench->run( bench );
+      }
+   }
+
+   for ( int rep = 0; rep < options->reps; ++rep )
+   {
+      s64 start = vadc_now_ns();
+      for ( s64 i = 0; i < iterations; ++i )
+      {
+         bench->run( bench );
+      }
+      s64 elapsed = vadc_now_ns() - start;
+      rep_ns[rep] = (double)elapsed / (double)iterations;
+   }
+
+   qsort( rep_ns, options->reps, sizeof( double ), compare_doubles );
+
+   result.iterations = iterations;
+   result.ns_min = rep_ns[0];
+   result.ns_max = rep_ns[options->reps - 1];
+   if ( options->reps % 2 )
+   {
+      result.ns_median = rep_ns[options->reps / 2];
+   }
+   else
+   {
+      result.ns_median = 0.5 * (rep_ns[options->reps / 2 - 1] + rep_ns[options->reps / 2]);
+   }
+
+   return result;
+}
+
+static int bench_pin_cpu( int cpu )
+{
+#if defined(__linux__)
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu, &set );
+   if ( sched_setaffinity( 0, sizeof( set ), &set ) != 0 )
+   {
+      return 0;
+   }
+   return 1;
+#else
+   VAR_UNUSED( cpu );
+   return 0;
+#endif
+}
+
+static const char *bench_compiler_string( void )
+{
+#if defined(__clang__)
+   return "clang " __clang_version__;
+#elif defined(__GNUC__)
+   return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+   return "msvc";
+#else
+   return "unknown";
+#endif
+}
+
+static void print_usage( const char *program )
+{
+   fprintf( stderr, "usage: %s [--warmup N] [--reps N] [--min_time_us N] [--cpu N] [--filter substring]\n", program );
+   fprintf( stderr, "  --warmup N       untimed reps before measuring (default 3)\n" );
+   fprintf( stderr, "  --reps N         timed reps, the median is reported (default 15)\n" );
+   fprintf( stderr, "  --min_time_us N  minimum duration of one rep (default 2000)\n" );
+   fprintf( stderr, "  --cpu N          pin to cpu N, -1 to leave unpinned (default 0)\n" );
+   fprintf( stderr, "  --filter s       only run kernels whose name contains s\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+   BenchOptions options = {0};
+   options.warmup = 3;
+   options.reps = 15;
+   options.min_time_us = 2000;
+   options.cpu = 0;
+
+   for ( int i = 1; i < argc; ++i )
+   {
+      const char *arg = argv[i];
+      const char *value = (i + 1 < argc) ? argv[i + 1] : 0;
+
+      if ( strcmp( arg, "--help" ) == 0 || strcmp( arg, "-h" ) == 0 )
+      {
+         print_usage( argv[0] );
+         return 0;
+      }
+      else if ( !value )
+      {
+         fprintf( stderr, "Error: %s expects a value\n", arg );
+         print_usage( argv[0] );
+         return 1;
+      }
+      else if ( strcmp( arg, "--warmup" ) == 0 )
+      {
+         options.warmup = atoi( value );
+      }
+      else if ( strcmp( arg, "--reps" ) == 0 )
+      {
+         options.reps = atoi( value );
+      }
+      else if ( strcmp( arg, "--min_time_us" ) == 0 )
+      {
+         options.min_time_us = atoi( value );
+      }
+      else if ( strcmp( arg, "--cpu" ) == 0 )
+      {
+         options.cpu = atoi( value );
+      }
+      else if ( strcmp( arg, "--filter" ) == 0 )
+      {
+         options.filter = value;
+      }
+      else
+      {
+         fprintf( stderr, "Error: unknown option %s\n", arg );
+         print_usage( argv[0] );
+         return 1;
+      }
+      ++i;
+   }
+
+   if ( options.reps < 1 )
+   {
+      options.reps = 1;
+   }
+   if ( options.warmup < 0 )
+   {
+      options.warmup = 0;
+   }
+   if ( options.min_time_us < 1 )
+   {
+      options.min_time_us = 1;
+   }
+
+   int pinned = 0;
+   if ( options.cpu >= 0 )
+   {
+      pinned = bench_pin_cpu( options.cpu );
+      if ( !pinned )
+      {
+         fprintf( stderr, "Warning: could not pin to cpu %d, running unpinned\n", options.cpu );
+      }
+   }
+
+   MemoryArena *arena = DEBUG_getDebugArena();
+
+   BenchCase cases[64];
+   int case_count = bench_build_cases( arena, cases, ArrayCount( cases ) );
+
+   double *rep_ns = pushArray( arena, options.reps, double );
+
+   printf( "{\n" );
+   printf( "  \"compiler\": \"%s\",\n", bench_compiler_string() );
+   printf( "  \"vadc_slow\": %d,\n", VADC_SLOW );
+   printf( "  \"cpu\": %d,\n", pinned ? options.cpu : -1 );
+   printf( "  \"warmup\": %d,\n", options.warmup );
+   printf( "  \"reps\": %d,\n", options.reps );
+   printf( "  \"min_time_us\": %d,\n", options.min_time_us );
+   printf( "  \"results\": [" );
+
+   int printed = 0;
+   for ( int i = 0; i < case_count; ++i )
+   {
+      BenchCase *bench = cases + i;
+      if ( options.filter && !strstr( bench->kernel, options.filter ) )
+      {
+         continue;
+      }
+
+      fprintf( stderr, "%-24s %-28s", bench->kernel, bench->shape );
+      BenchResult result = bench_run( bench, &options, rep_ns );
+      fprintf( stderr, " %12.1f ns\n", result.ns_median );
+
+      double gflops = bench->flops / result.ns_median;
+      double bytes_per_second = bench->bytes / (result.ns_median * 1e-9);
+
+      printf( "%s\n    {\"kernel\": \"%s\", \"shape\": \"%s\", \"iterations\": %lld, "
+              "\"ns_per_call\": %.2f, \"ns_min\": %.2f, \"ns_max\": %.2f, "
+              "\"flops\": %.0f, \"bytes\": %.0f, \"gflops\": %.4f, \"bytes_per_sec\": %.0f}",
+              printed ? "," : "",
+              bench->kernel, bench->shape, (long long)result.iterations,
+              result.ns_median, result.ns_min, result.ns_max,
+              bench->flops, bench->bytes, gflops, bytes_per_second );
+      ++printed;
+   }
+
+   printf( "\n  ]\n}\n" );
+
+   return 0;
+}
@@ -112,7 +112,8 @@ static void dw_conv_tensor ( TestTensor *input, TestTensor *filters, TestTensor
    TracyCZoneEnd(dw_conv_tensor);
 }
 
-static inline void conv_tensor ( TestTensor *input, TestTensor *filters, TestTensor *biases, int hop_length, TestTensor *output )
+// NOTE: the pointwise path takes its scratch from arena, which must belong to the calling thread
+static inline void conv_tensor ( MemoryArena *arena, TestTensor *input, TestTensor *filters, TestTensor *biases, int hop_length, TestTensor *output )
 {
    TracyCZone(conv_tensor, true);
 
@@ -169,8 +170,6 @@ static inline void conv_tensor ( TestTensor *input, TestTensor *filters, TestTen
 
    if (kernel_size == 1 && hop_length == 1)
    {
-      MemoryArena *arena = DEBUG_getDebugArena();
-
       for ( int batch_index = 0; batch_index < batch_size; ++batch_index )
       {
          float *input_data_batch = input->data + batch_index * batch_stride_input;
@@ -717,17 +716,17 @@ static inline TestTensor *conv_tensor_out ( MemoryArena *arena, TestTensor *inpu
    // TracyCZone(conv_tensor_out, true);
 
    TestTensor *output = tensor_zeros_for_conv( arena, input, filters, hop_length );
-   conv_tensor( input, filters, biases, hop_length, output );
+   conv_tensor( arena, input, filters, biases, hop_length, output );
 
    // TracyCZoneEnd(conv_tensor_out);
    return output;
 }
 
-static inline void pw_conv_tensor ( TestTensor *input, TestTensor *filters, TestTensor *biases, TestTensor *output )
+static inline void pw_conv_tensor ( MemoryArena *arena, TestTensor *input, TestTensor *filters, TestTensor *biases, TestTensor *output )
 {
    TracyCZone(pw_conv_tensor, true);
 
-   conv_tensor( input, filters, biases, 1, output );
+   conv_tensor( arena, input, filters, biases, 1, output );
 
    TracyCZoneEnd(pw_conv_tensor);
 }
@@ -750,7 +749,7 @@ static void conv_tensor_stride64_nobias ( MemoryArena *arena, TestTensor *input,
    // int mock_biases_dims[1] = { filters->dims[0] };
    // TestTensor *biases = tensor_zeros( arena, ArrayCount(mock_biases_dims), mock_biases_dims );
 
-   conv_tensor( input, filters, NULL, 64, output );
+   conv_tensor( arena, input, filters, NULL, 64, output );
 
    endTemporaryMemory( mark );
    TracyCZoneEnd(conv_tensor_stride64_nobias);
@@ -790,12 +789,12 @@ static void conv_block(MemoryArena *arena,  TestTensor *input, b32 has_out_proj,
 
    TestTensor *pw_output = output;
    // TestTensor *pw_output = tensor_zeros_2d(debug_arena, pw_output_dims[0], pw_output_dims[1]);
-   pw_conv_tensor( dw_output, pw_weights, pw_biases, pw_output );
+   pw_conv_tensor( arena, dw_output, pw_weights, pw_biases, pw_output );
 
    if ( has_out_proj )
    {
       TestTensor *out_proj = tensor_zeros_like( debug_arena, pw_output );
-      pw_conv_tensor( input, proj_weights, proj_biases, out_proj );
+      pw_conv_tensor( arena, input, proj_weights, proj_biases, out_proj );
 
       add_arrays_inplace( pw_output->data, pw_output->size, out_proj->data );
    }
@@ -1,16 +1,37 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <dirent.h>
 
-#include <tracy\TracyC.h>
+#include <TracyC.h>
 
 #if !defined(VADC_SLOW)
 #define VADC_SLOW 0
 #endif // VADC_SLOW
 
-#include "utils.h"
+// NOTE: CMake passes the absolute path of testdata/, so the tests don't depend on the working directory.
+//       Fixtures under testdata/untracked/ aren't checked in, their tests are skipped when missing. A
+//       missing tracked fixture fails.
+#if !defined(VADC_TESTDATA_DIR)
+#define VADC_TESTDATA_DIR "testdata/"
+#endif // VADC_TESTDATA_DIR
+#define TESTDATA_PATH( name ) VADC_TESTDATA_DIR name
+
+#if !defined(ONNX_INFERENCE_ENABLED)
+#define ONNX_INFERENCE_ENABLED 0
+#endif // ONNX_INFERENCE_ENABLED
+
+// NOTE: the whole program is built in, so the behaviour tests reach the run, the engines and the
+//       writers through their static functions too. Its main is renamed out of the way.
+#define main vadc_main
+#include "vadc.c"
+#undef main
+#undef MEMORY_IMPLEMENTATION
+
+#if ONNX_INFERENCE_ENABLED
+// NOTE: with the ONNX backend vadc.c leaves the kernels to silero_c.c, the golden tensor tests need
+//       them here as well
 #include "tensor.h"
 
-
 #include "conv.c"
 #include "misc.c"
 #include "stft.c"
@@ -21,8 +42,9 @@
 #define MATHS_IMPLEMENTATION
 #include "maths.h"
 
-#define MEMORY_IMPLEMENTATION
-#include "memory.h"
+#include "libvadc_frame_api.h"
+#include "libvadc_batch_api.h"
+#endif // ONNX_INFERENCE_ENABLED
 
 #define STBIW_ASSERT(x) Assert(x)
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -90,11 +112,40 @@ typedef struct TestResult TestResult;
 struct TestResult
 {
    b32 pass;
+   // NOTE: an untracked fixture isn't there, counts neither as a pass nor as a failure
+   b32 skipped;
+   // NOTE: a tracked fixture isn't there, fails
+   b32 fixture_missing;
+   // NOTE: why a skipped test didn't run, an untracked fixture if not set
+   const char *skip_reason;
    float atol;
    float max_error;
    int error_magnitude;
 };
 
+static TestResult test_fixture_missing( const char *path )
+{
+   TestResult result = {0};
+   if ( strstr( path, "/untracked/" ) )
+   {
+      result.skipped = 1;
+   }
+   else
+   {
+      result.fixture_missing = 1;
+   }
+   return result;
+}
+
+// NOTE: the test needs something this build or machine doesn't have, e.g. a usable ONNX Runtime
+static TestResult test_unavailable( const char *reason )
+{
+   TestResult result = {0};
+   result.skipped = 1;
+   result.skip_reason = reason;
+   return result;
+}
+
 static float test_error_magnitudes[TestErrorMagnitude_COUNT] =
 {
    0.0f,
@@ -173,12 +224,11 @@ TestResult decoder_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\decoder_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "decoder_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "decoder_test.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -211,13 +261,12 @@ TestResult decoder_test_v5()
 
    LoadTesttensorResult decoder_testdata = {0};
 
-   decoder_testdata = load_testtensor(arena, "testdata\\untracked\\v5_decoder.testtensor" );
+   decoder_testdata = load_testtensor(arena, TESTDATA_PATH( "untracked/v5_decoder.testtensor" ) );
 
    if (decoder_testdata.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/v5_decoder.testtensor" ) );
    }
 
 
@@ -246,12 +295,11 @@ TestResult lstm_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult lstm_res = {0};
-   lstm_res = load_testtensor(debug_arena, "testdata\\lstm_nito_reference_randn.testtensor" );
+   lstm_res = load_testtensor(debug_arena, TESTDATA_PATH( "lstm_nito_reference_randn.testtensor" ) );
    if (lstm_res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "lstm_nito_reference_randn.testtensor" ) );
    }
 
    // Assert(memcmp(output, result->data, output_size) == 0);
@@ -300,17 +348,16 @@ TestResult lstm_test_RED()
    LoadTesttensorResult lstm_weights = {0};
    LoadTesttensorResult lstm_output = {0};
 
-   lstm_input = load_testtensor(debug_arena, "testdata\\untracked\\RED600_all_before_lstm.testtensor" );
-   lstm_weights = load_testtensor(debug_arena, "testdata\\untracked\\lstm_silero_3.1_16k_for_c.testtensor" );
-   lstm_output = load_testtensor(debug_arena, "testdata\\untracked\\RED600_all_lstm_output_lite.testtensor" );
+   lstm_input = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/RED600_all_before_lstm.testtensor" ) );
+   lstm_weights = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/lstm_silero_3.1_16k_for_c.testtensor" ) );
+   lstm_output = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/RED600_all_lstm_output_lite.testtensor" ) );
 
    if (lstm_input.tensor_count == 0 ||
        lstm_weights.tensor_count == 0 ||
        lstm_output.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/RED600_all_before_lstm.testtensor" ) );
    }
 
 
@@ -372,13 +419,12 @@ TestResult lstm_test_RED_new()
 
    LoadTesttensorResult lstm_testdata = {0};
 
-   lstm_testdata = load_testtensor(debug_arena, "testdata\\untracked\\RED600_lstm.testtensor" );
+   lstm_testdata = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/RED600_lstm.testtensor" ) );
 
    if (lstm_testdata.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/RED600_lstm.testtensor" ) );
    }
 
 
@@ -431,13 +477,12 @@ TestResult lstm_test_RED_1layer()
 
    LoadTesttensorResult lstm_testdata = {0};
 
-   lstm_testdata = load_testtensor(debug_arena, "testdata\\untracked\\RED600_lstm_1layer.testtensor" );
+   lstm_testdata = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/RED600_lstm_1layer.testtensor" ) );
 
    if (lstm_testdata.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/RED600_lstm_1layer.testtensor" ) );
    }
 
 
@@ -490,13 +535,12 @@ TestResult lstm_test_RED_v5()
 
    LoadTesttensorResult lstm_testdata = {0};
 
-   lstm_testdata = load_testtensor(debug_arena, "testdata\\untracked\\RED600_lstm_v5.testtensor" );
+   lstm_testdata = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/RED600_lstm_v5.testtensor" ) );
 
    if (lstm_testdata.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/RED600_lstm_v5.testtensor" ) );
    }
 
 
@@ -548,12 +592,11 @@ TestResult dw_conv_129_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\dw_conv_129.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "dw_conv_129.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "dw_conv_129.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -584,12 +627,11 @@ TestResult pw_conv_129_16_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\pw_conv_129_16.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "pw_conv_129_16.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "pw_conv_129_16.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -602,7 +644,7 @@ TestResult pw_conv_129_16_test()
 
    TestTensor *output_tensor = tensor_zeros_like( debug_arena, result );
 
-   pw_conv_tensor( input, weights, biases, output_tensor );
+   pw_conv_tensor( debug_arena, input, weights, biases, output_tensor );
 
    float atol = 1e-4f;
 
@@ -619,12 +661,11 @@ TestResult v5_reparam_conv_test()
    TemporaryMemory mark = beginTemporaryMemory( arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(arena, "testdata\\untracked\\v5_reparam_conv.testtensor" );
+   res = load_testtensor(arena, TESTDATA_PATH( "untracked/v5_reparam_conv.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/v5_reparam_conv.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -670,12 +711,11 @@ TestResult v5_reparam_conv2_test()
    TemporaryMemory mark = beginTemporaryMemory( arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(arena, "testdata\\untracked\\v5_reparam_conv2.testtensor" );
+   res = load_testtensor(arena, TESTDATA_PATH( "untracked/v5_reparam_conv2.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/v5_reparam_conv2.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -721,12 +761,11 @@ TestResult v5_reparam_conv3_test()
    TemporaryMemory mark = beginTemporaryMemory( arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(arena, "testdata\\untracked\\v5_reparam_conv3.testtensor" );
+   res = load_testtensor(arena, TESTDATA_PATH( "untracked/v5_reparam_conv3.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/v5_reparam_conv3.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -772,12 +811,11 @@ TestResult v5_reparam_conv4_test()
    TemporaryMemory mark = beginTemporaryMemory( arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(arena, "testdata\\untracked\\v5_reparam_conv4.testtensor" );
+   res = load_testtensor(arena, TESTDATA_PATH( "untracked/v5_reparam_conv4.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/v5_reparam_conv4.testtensor" ) );
    }
    TestTensor *input = res.tensor_array + 0;
    TestTensor *weights = res.tensor_array + 1;
@@ -823,12 +861,11 @@ TestResult first_layer_conv_block_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\first_layer_conv_block.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "first_layer_conv_block.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "first_layer_conv_block.testtensor" ) );
    }
 
    int test_data_index = 0;
@@ -903,12 +940,11 @@ TestResult softmax_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\softmax_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "softmax_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "softmax_test.testtensor" ) );
    }
 
    int test_data_index = 0;
@@ -934,12 +970,11 @@ TestResult layer_norm_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\layernorm_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "layernorm_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "layernorm_test.testtensor" ) );
    }
 
    // TODO(irwin): validate loaded tensor count helpers
@@ -969,12 +1004,11 @@ TestResult batch_norm_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\batchnorm_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "batchnorm_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "batchnorm_test.testtensor" ) );
    }
 
    // TODO(irwin): validate loaded tensor count helpers
@@ -1006,12 +1040,11 @@ TestResult stft_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\untracked\\stft_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/stft_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/stft_test.testtensor" ) );
    }
 
    // TODO(irwin): validate loaded tensor count helpers
@@ -1040,12 +1073,11 @@ TestResult stft_test_v5()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\untracked\\RED600_stft_v5.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/RED600_stft_v5.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/RED600_stft_v5.testtensor" ) );
    }
 
    // TODO(irwin): validate loaded tensor count helpers
@@ -1074,12 +1106,11 @@ TestResult adaptive_audio_normalization_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\adaptive_audio_normalization_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "adaptive_audio_normalization_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "adaptive_audio_normalization_test.testtensor" ) );
    }
 
    // TODO(irwin): validate loaded tensor count helpers
@@ -1108,12 +1139,11 @@ TestResult dual_head_attention_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\dual_head_attention_test.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "dual_head_attention_test.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "dual_head_attention_test.testtensor" ) );
    }
 
    int test_data_index = 0;
@@ -1146,12 +1176,11 @@ TestResult transformer_block_16_16_48_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\transformer_block_test_16_16_48.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "transformer_block_test_16_16_48.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "transformer_block_test_16_16_48.testtensor" ) );
    }
 
    int test_data_index = 0;
@@ -1199,12 +1228,11 @@ TestResult transformer_first_layer_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\transformer_first_layer.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "transformer_first_layer.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "transformer_first_layer.testtensor" ) );
    }
 
    Assert( res.tensor_count == 26 );
@@ -1242,12 +1270,11 @@ TestResult transformer_layers_1_2_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\transformer_layers_1_2.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "transformer_layers_1_2.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "transformer_layers_1_2.testtensor" ) );
    }
 
    Assert( res.tensor_count == (24 + 24 + 2) );
@@ -1323,12 +1350,11 @@ TestResult transformer_layers_1_2_3_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\transformer_layers_1_2_3.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "transformer_layers_1_2_3.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "transformer_layers_1_2_3.testtensor" ) );
    }
 
    Assert( res.tensor_count == (24 + 24 + 22 + 2) );
@@ -1395,12 +1421,11 @@ TestResult transformer_layers_1_2_3_4_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\transformer_layers_1_2_3_4.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "transformer_layers_1_2_3_4.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "transformer_layers_1_2_3_4.testtensor" ) );
    }
 
    int encoder_weights_count = 24 + 24 + 22 + 24;
@@ -1437,12 +1462,11 @@ TestResult adaptive_normalization_encoder_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\adaptive_normalization_encoder.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "adaptive_normalization_encoder.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "adaptive_normalization_encoder.testtensor" ) );
    }
 
    int encoder_weights_count = 24 + 24 + 22 + 24;
@@ -1483,12 +1507,11 @@ TestResult stft_normalization_encoder_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\untracked\\stft_normalization_encoder.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/stft_normalization_encoder.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/stft_normalization_encoder.testtensor" ) );
    }
 
    int encoder_weights_count = 24 + 24 + 22 + 24;
@@ -1545,14 +1568,13 @@ TestResult stft_normalization_encoder_lstm_test()
    LoadTesttensorResult res = {0};
    LoadTesttensorResult lstm_weights_res = {0};
 
-   res = load_testtensor(debug_arena, "testdata\\untracked\\stft_normalization_encoder_lstm.testtensor" );
-   lstm_weights_res = load_testtensor(debug_arena, "testdata\\untracked\\lstm_silero_3.1_16k_for_c.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/stft_normalization_encoder_lstm.testtensor" ) );
+   lstm_weights_res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/lstm_silero_3.1_16k_for_c.testtensor" ) );
 
    if ( res.tensor_count == 0 || lstm_weights_res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/stft_normalization_encoder_lstm.testtensor" ) );
    }
 
    int encoder_weights_count = 24 + 24 + 22 + 24;
@@ -1643,14 +1665,13 @@ TestResult stft_normalization_encoder_lstm_decoder_test()
    LoadTesttensorResult res = {0};
    LoadTesttensorResult lstm_weights_res = {0};
 
-   res = load_testtensor(debug_arena, "testdata\\untracked\\stft_normalization_encoder_lstm_decoder.testtensor" );
-   lstm_weights_res = load_testtensor(debug_arena, "testdata\\untracked\\lstm_silero_3.1_16k_for_c.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/stft_normalization_encoder_lstm_decoder.testtensor" ) );
+   lstm_weights_res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/lstm_silero_3.1_16k_for_c.testtensor" ) );
 
    if ( res.tensor_count == 0 || lstm_weights_res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/stft_normalization_encoder_lstm_decoder.testtensor" ) );
    }
 
    int encoder_weights_count = 24 + 24 + 22 + 24;
@@ -1753,25 +1774,64 @@ TestResult silero_test()
    LoadTesttensorResult res = {0};
    LoadTesttensorResult silero_weights_res = {0};
 
-   res = load_testtensor(debug_arena, "testdata\\untracked\\silero.testtensor" );
-   silero_weights_res = load_testtensor(debug_arena, "testdata\\silero_v31_16k.testtensor" );
-
-   if ( res.tensor_count == 0 || silero_weights_res.tensor_count == 0 )
+   silero_weights_res = load_testtensor(debug_arena, TESTDATA_PATH( "silero_v31_16k.testtensor" ) );
+   if ( silero_weights_res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "silero_v31_16k.testtensor" ) );
    }
 
    int encoder_weights_count = 24 + 24 + 22 + 24;
-   Assert( res.tensor_count == 2 );
    Assert( silero_weights_res.tensor_count == (1 + encoder_weights_count + 2 + 2) );
 
    Silero_Weights silero_weights = silero_weights_init( silero_weights_res );
 
-   int test_data_index = 0;
-   TestTensor *input_batches = res.tensor_array + test_data_index++;
-   TestTensor *result = res.tensor_array + test_data_index++;
+   TestTensor *input_batches = 0;
+   TestTensor *result = 0;
+
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "untracked/silero.testtensor" ) );
+   if ( res.tensor_count != 0 )
+   {
+      Assert( res.tensor_count == 2 );
+
+      int test_data_index = 0;
+      input_batches = res.tensor_array + test_data_index++;
+      result = res.tensor_array + test_data_index++;
+   }
+   else
+   {
+      // NOTE: the reference model's recorded input and output aren't checked in. Without them the layer
+      //       by layer pass below is checked against silero_run_one_batch_with_context, the path the C
+      //       backend runs, on a synthetic input: tones and noise bursts over a quiet floor.
+      int batch_count = 24;
+      int window_samples = 1536;
+      input_batches = tensor_zeros_2d( debug_arena, batch_count, window_samples );
+      u32 random_state = 12345;
+      for ( int i = 0; i < input_batches->size; ++i )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         float noise = (float)(random_state >> 8) / (float)(1 << 24) - 0.5f;
+         int burst = (i / 8000) % 2;
+         float tone = sinf( 2.0f * 3.14159265f * (180.0f + 40.0f * (i / 8000)) * i / 16000.0f );
+         input_batches->data[i] = burst ? 0.3f * tone + 0.1f * noise : 0.002f * noise;
+      }
+
+      Silero_Context reference_context = {0};
+      reference_context.weights = silero_weights;
+      reference_context.state_lstm_h = tensor_zeros_3d( debug_arena, 2, 1, 64 );
+      reference_context.state_lstm_c = tensor_zeros_3d( debug_arena, 2, 1, 64 );
+
+      result = tensor_zeros_3d( debug_arena, batch_count, 2, 1 );
+      for ( int batch_index = 0; batch_index < batch_count; ++batch_index )
+      {
+         TemporaryMemory batch_mark = beginTemporaryMemory( debug_arena );
+         TestTensor *reference_output = silero_run_one_batch_with_context( debug_arena, &reference_context, 1, window_samples,
+                                                                           input_batches->data + batch_index * window_samples );
+         result->data[batch_index * 2 + 0] = reference_output->data[0];
+         result->data[batch_index * 2 + 1] = reference_output->data[1];
+         endTemporaryMemory( batch_mark );
+      }
+   }
 
 
    TestTensor *lstm_input_h = tensor_zeros_3d(debug_arena, 2, 1, 64);
@@ -1921,12 +1981,11 @@ TestResult transformer_layers_3_test()
    TemporaryMemory mark = beginTemporaryMemory( debug_arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(debug_arena, "testdata\\transformer_layers_3.testtensor" );
+   res = load_testtensor(debug_arena, TESTDATA_PATH( "transformer_layers_3.testtensor" ) );
    if ( res.tensor_count == 0 )
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "transformer_layers_3.testtensor" ) );
    }
 
    Assert( res.tensor_count == (22 + 2) );
@@ -2030,12 +2089,11 @@ TestResult silero_v5_test()
    TemporaryMemory mark = beginTemporaryMemory( arena );
 
    LoadTesttensorResult res = {0};
-   res = load_testtensor(arena, "testdata\\untracked\\RED600_silero_v5.testtensor" );
+   res = load_testtensor(arena, TESTDATA_PATH( "untracked/RED600_silero_v5.testtensor" ) );
    if (res.tensor_count == 0)
    {
       endTemporaryMemory( mark );
-      TestResult test_result = {0};
-      return test_result;
+      return test_fixture_missing( TESTDATA_PATH( "untracked/RED600_silero_v5.testtensor" ) );
    }
 
    // TODO(irwin): validate loaded tensor count helpers
@@ -2196,97 +2254,2007 @@ TestResult silero_v5_test()
 }
 
 
-static const char *result_strings[] =
+// NOTE: behaviour tests of the run and the engines around the model, on synthetic audio: speech-like
+//       harmonic bursts of varying length over low noise, different for every seed
+static void test_synthesize_audio( short *samples, size_t count, u32 seed )
 {
-   "FAIL",
-   "PASS"
-};
+   u32 random_state = seed * 2654435761u + 1u;
+   const float pi = 3.14159265f;
+   size_t position = 0;
+   while ( position < count )
+   {
+      random_state = random_state * 1664525u + 1013904223u;
+      size_t burst_samples = 4000 + (random_state >> 8) % 20000;
+      random_state = random_state * 1664525u + 1013904223u;
+      size_t pause_samples = 2000 + (random_state >> 8) % 16000;
+      float pitch = 110.0f + (float)((random_state >> 4) % 160);
 
-typedef TestResult ( *TestFunction )();
+      for ( size_t i = 0; i < burst_samples + pause_samples && position < count; ++i, ++position )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         float noise = ((float)(random_state >> 8) / (float)(1 << 24) - 0.5f) * 0.01f;
+         float value = noise;
+         if ( i < burst_samples )
+         {
+            float envelope = sinf( pi * (float)i / (float)burst_samples );
+            float t = (float)position / HARDCODED_SAMPLE_RATE;
+            float voice = 0.0f;
+            for ( int harmonic = 1; harmonic <= 6; ++harmonic )
+            {
+               voice += sinf( 2.0f * pi * pitch * harmonic * t ) / harmonic;
+            }
+            value += 0.25f * envelope * voice;
+         }
+         value = value > 1.0f ? 1.0f : (value < -1.0f ? -1.0f : value);
+         samples[position] = (short)(value * 32767.0f);
+      }
+   }
+}
 
-typedef struct TestFunctionDescription TestFunctionDescription;
+// NOTE: a scratch directory for the run tests, with an ffmpeg first on PATH that stands in for the real
+//       one: the tests write their inputs as 16kHz mono s16le already, it only copies them to stdout.
+//       Removed at exit.
+static char test_run_dir_path[64];
 
-struct TestFunctionDescription
+static const char *test_run_dir( void )
 {
-   TestFunction function_pointer;
-   const char *test_name;
-};
+   if ( test_run_dir_path[0] )
+   {
+      return test_run_dir_path;
+   }
 
-#define TEST_FUNCTION_DESCRIPTION( test_function ) \
-   { test_function, VADC_TOSTRING( test_function ) }
+   char dir_template[] = "/tmp/vadc_test_XXXXXX";
+   if ( !mkdtemp( dir_template ) )
+   {
+      return NULL;
+   }
 
-TestFunctionDescription test_function_descriptions[] =
+   char path[128];
+   snprintf( path, sizeof( path ), "%s/ffmpeg", dir_template );
+   FILE *script = fopen( path, "wb" );
+   if ( !script )
+   {
+      return NULL;
+   }
+   // NOTE: VADC_TEST_FFMPEG_BYTES cuts the input short and fails, the way a killed run's ffmpeg goes
+   fprintf( script,
+            "#!/bin/sh\n"
+            "while [ $# -gt 0 ]; do\n"
+            "   if [ \"$1\" = \"-i\" ]; then\n"
+            "      if [ -n \"$VADC_TEST_FFMPEG_BYTES\" ]; then head -c \"$VADC_TEST_FFMPEG_BYTES\" \"$2\"; exit 1; fi\n"
+            "      exec cat \"$2\"\n"
+            "   fi\n"
+            "   shift\n"
+            "done\n"
+            "exit 1\n" );
+   fclose( script );
+   chmod( path, 0755 );
+
+   const char *old_path = getenv( "PATH" );
+   char *new_path = malloc( strlen( dir_template ) + (old_path ? strlen( old_path ) : 0) + 2 );
+   sprintf( new_path, "%s:%s", dir_template, old_path ? old_path : "" );
+   setenv( "PATH", new_path, 1 );
+   free( new_path );
+
+   snprintf( test_run_dir_path, sizeof( test_run_dir_path ), "%s", dir_template );
+   return test_run_dir_path;
+}
+
+static void test_remove_run_dir( void )
 {
-   TEST_FUNCTION_DESCRIPTION(dw_conv_129_test),
-   TEST_FUNCTION_DESCRIPTION(pw_conv_129_16_test),
-   TEST_FUNCTION_DESCRIPTION(first_layer_conv_block_test),
-   TEST_FUNCTION_DESCRIPTION(decoder_test),
-   TEST_FUNCTION_DESCRIPTION(transpose2d_test),
-   TEST_FUNCTION_DESCRIPTION(softmax_test),
-   TEST_FUNCTION_DESCRIPTION(layer_norm_test),
-   TEST_FUNCTION_DESCRIPTION(batch_norm_test),
-   TEST_FUNCTION_DESCRIPTION(dual_head_attention_test),
-   TEST_FUNCTION_DESCRIPTION(transformer_block_16_16_48_test),
-   TEST_FUNCTION_DESCRIPTION( transformer_first_layer_test ),
-   TEST_FUNCTION_DESCRIPTION( transformer_layers_1_2_test ),
-   TEST_FUNCTION_DESCRIPTION( transformer_layers_3_test ),
-   TEST_FUNCTION_DESCRIPTION( transformer_layers_1_2_3_test ),
-   TEST_FUNCTION_DESCRIPTION( transformer_layers_1_2_3_4_test ),
-   TEST_FUNCTION_DESCRIPTION( adaptive_normalization_encoder_test ),
-   TEST_FUNCTION_DESCRIPTION( stft_normalization_encoder_test ),
-   TEST_FUNCTION_DESCRIPTION( stft_normalization_encoder_lstm_test ),
-   TEST_FUNCTION_DESCRIPTION( stft_normalization_encoder_lstm_decoder_test ),
-   TEST_FUNCTION_DESCRIPTION( silero_test ),
-   TEST_FUNCTION_DESCRIPTION(stft_test),
-   TEST_FUNCTION_DESCRIPTION(adaptive_audio_normalization_test),
-   TEST_FUNCTION_DESCRIPTION(lstm_test),
-   TEST_FUNCTION_DESCRIPTION(lstm_test_RED),
-   TEST_FUNCTION_DESCRIPTION(lstm_test_RED_new),
-   TEST_FUNCTION_DESCRIPTION(lstm_test_RED_1layer),
-
-   TEST_FUNCTION_DESCRIPTION(stft_test_v5),
-   TEST_FUNCTION_DESCRIPTION(v5_reparam_conv_test),
-   TEST_FUNCTION_DESCRIPTION(v5_reparam_conv2_test),
-   TEST_FUNCTION_DESCRIPTION(v5_reparam_conv3_test),
-   TEST_FUNCTION_DESCRIPTION(v5_reparam_conv4_test),
-   TEST_FUNCTION_DESCRIPTION(lstm_test_RED_v5),
-   TEST_FUNCTION_DESCRIPTION(decoder_test_v5),
-   TEST_FUNCTION_DESCRIPTION(silero_v5_test),
-};
+   if ( test_run_dir_path[0] )
+   {
+      char command[128];
+      snprintf( command, sizeof( command ), "rm -rf '%s'", test_run_dir_path );
+      if ( system( command ) != 0 )
+      {
+         fprintf( stderr, "couldn't remove %s\n", test_run_dir_path );
+      }
+      test_run_dir_path[0] = 0;
+   }
+}
 
-// int main(int argc, char *argv[])
-int main()
+static b32 test_write_file( const char *path, const void *data, size_t size )
 {
-   b32 all_pass = 1;
-   int failed_count = 0;
-   int passed_count = 0;
+   FILE *file = fopen( path, "wb" );
+   if ( !file )
+   {
+      return 0;
+   }
+   b32 written = fwrite( data, 1, size, file ) == size;
+   return fclose( file ) == 0 && written;
+}
 
-   int test_count = ArrayCount( test_function_descriptions );
-   fprintf( stderr, "Total tests to run: %d\n", test_count );
+// NOTE: malloc'ed, NULL if it couldn't be read
+static u8 *test_read_file( const char *path, size_t *size )
+{
+   *size = 0;
+   FILE *file = fopen( path, "rb" );
+   if ( !file )
+   {
+      return NULL;
+   }
+   fseek( file, 0, SEEK_END );
+   long file_size = ftell( file );
+   fseek( file, 0, SEEK_SET );
+   u8 *data = malloc( file_size > 0 ? (size_t)file_size : 1 );
+   if ( data && fread( data, 1, (size_t)file_size, file ) == (size_t)file_size )
+   {
+      *size = (size_t)file_size;
+   }
+   else
+   {
+      free( data );
+      data = NULL;
+   }
+   fclose( file );
+   return data;
+}
 
-   for ( int i = 0; i < test_count; ++i )
+static b32 test_files_equal( const char *left_path, const char *right_path )
+{
+   size_t left_size = 0;
+   size_t right_size = 0;
+   u8 *left = test_read_file( left_path, &left_size );
+   u8 *right = test_read_file( right_path, &right_size );
+   b32 equal = left && right && left_size == right_size && memcmp( left, right, left_size ) == 0;
+   free( left );
+   free( right );
+   return equal;
+}
+
+// NOTE: the run tests go through whichever backend this build has: the C one on the tracked weights,
+//       or ONNX Runtime on silero_vad_v4.onnx when it can start
+#if ONNX_INFERENCE_ENABLED
+static b32 test_onnx_runtime_usable( void );
+#define TEST_RUN_MODEL_PATH VADC_MODELS_DIR "silero_vad_v4.onnx"
+#else
+#define TEST_RUN_MODEL_PATH ""
+#endif // ONNX_INFERENCE_ENABLED
+
+static b32 test_run_backend_usable( void )
+{
+#if ONNX_INFERENCE_ENABLED
+   return test_onnx_runtime_usable();
+#else
+   return 1;
+#endif // ONNX_INFERENCE_ENABLED
+}
+
+#define TEST_RUN_SEQUENCE_COUNT 1536.0f
+
+// NOTE: the CLI defaults
+static VADC_Options test_run_options( void )
+{
+   VADC_Options options = {0};
+   options.min_silence_duration_ms = 200.0f;
+   options.min_speech_duration_ms = 250.0f;
+   options.threshold = 0.5f;
+   options.neg_threshold = 0.5f - 0.15f;
+   options.speech_pad_ms = 30.0f;
+   options.output_format = Segment_Output_Format_Seconds;
+   return options;
+}
+
+// NOTE: one file on a freshly loaded backend of its own, the way a single-file CLI run goes. The output
+//       is opened with output_mode, "ab" is a run appending to its segments (>>), and the model batches
+//       batch_size windows where it can.
+static int test_run_file_mode( MemoryArena *arena, const VADC_Options *options, String8 filename, const char *output_path,
+                               const char *output_mode, s32 batch_size )
+{
+   TemporaryMemory mark = beginTemporaryMemory( arena );
+
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+   config.model_file_hash_wanted = options->checkpoint_path != NULL;
+   void *backend = backend_init( arena, String8FromCString( TEST_RUN_MODEL_PATH ), &config );
+   int result = -1;
+   if ( backend )
    {
-      TestFunctionDescription *desc = test_function_descriptions + i;
-      TestResult result = desc->function_pointer();
+      silero_config_finalize( &config, batch_size, TEST_RUN_SEQUENCE_COUNT );
+
+      FILE *output_file = fopen( output_path, output_mode );
+      if ( output_file )
+      {
+         VADC_Run run = {0};
+         run.segments_output = output_file;
+         run.quiet = 1;
+         result = run_inference_on_backend( &run, arena, backend, config, options, filename );
+         fclose( output_file );
+      }
+      backend_release( backend );
+   }
+
+   endTemporaryMemory( mark );
+   return result;
+}
+
+static int test_run_file( MemoryArena *arena, const VADC_Options *options, String8 filename, const char *output_path )
+{
+   return test_run_file_mode( arena, options, filename, output_path, "wb", 1 );
+}
+
+// NOTE: files spread over a worker pool sharing one model come out byte for byte as when each is run on
+//       its own, and two inputs that would write the same output under --output_dir are refused
+TestResult worker_pool_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   TemporaryMemory mark = beginTemporaryMemory( debug_arena );
+
+   enum { file_count = 7 };
+
+   String8 pool_dir = String8_pushf( debug_arena, "%s/pool", dir );
+   String8 output_dir = String8_pushf( debug_arena, "%s/pool/out", dir );
+   String8 collide_dir = String8_pushf( debug_arena, "%s/pool/collide", dir );
+   mkdir( pool_dir.begin, 0755 );
+   mkdir( output_dir.begin, 0755 );
+   mkdir( collide_dir.begin, 0755 );
+   for ( int input_dir = 0; input_dir < 2; ++input_dir )
+   {
+      mkdir( String8_pushf( debug_arena, "%s/pool/in%d", dir, input_dir ).begin, 0755 );
+   }
+
+   b32 pass = 1;
+   String8 filenames[file_count];
+   for ( int file_index = 0; file_index < file_count; ++file_index )
+   {
+      size_t sample_count = (size_t)(2 + file_index) * HARDCODED_SAMPLE_RATE + 777 * file_index;
+      short *samples = pushArray( debug_arena, sample_count, short );
+      test_synthesize_audio( samples, sample_count, 200 + file_index );
+      filenames[file_index] = String8_pushf( debug_arena, "%s/pool/in%d/file%d.raw", dir, file_index % 2, file_index );
+      pass = pass && test_write_file( filenames[file_index].begin, samples, sample_count * sizeof( short ) );
+   }
+
+   VADC_Options options = test_run_options();
+   int failed_count = run_inference_many( String8FromCString( TEST_RUN_MODEL_PATH ), debug_arena, &options, TEST_RUN_SEQUENCE_COUNT, 1,
+                                          filenames, file_count, output_dir, 3 );
+   pass = pass && failed_count == 0;
+
+   for ( int file_index = 0; file_index < file_count && pass; ++file_index )
+   {
+      String8 expected_path = String8_pushf( debug_arena, "%s/pool/expected%d.txt", dir, file_index );
+      String8 output_path = String8_pushf( debug_arena, "%s/pool/out/file%d.raw.txt", dir, file_index );
+      pass = test_run_file( debug_arena, &options, filenames[file_index], expected_path.begin ) == 0 &&
+             test_files_equal( expected_path.begin, output_path.begin );
+   }
+
+   String8 colliding[2] =
+   {
+      String8_pushf( debug_arena, "%s/pool/in0/same.raw", dir ),
+      String8_pushf( debug_arena, "%s/pool/in1/same.raw", dir ),
+   };
+   short silence[4096] = {0};
+   pass = pass && test_write_file( colliding[0].begin, silence, sizeof( silence ) );
+   pass = pass && test_write_file( colliding[1].begin, silence, sizeof( silence ) );
+   failed_count = run_inference_many( String8FromCString( TEST_RUN_MODEL_PATH ), debug_arena, &options, TEST_RUN_SEQUENCE_COUNT, 1,
+                                      colliding, 2, collide_dir, 2 );
+   pass = pass && failed_count == -1 && access( String8_pushf( debug_arena, "%s/pool/collide/same.raw.txt", dir ).begin, F_OK ) != 0;
+
+   endTemporaryMemory( mark );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: one gate window, a tone at level_dbfs (peak), or white noise at that peak when noisy
+static void test_gate_window( short *samples, int count, float level_dbfs, b32 noisy, u32 *random_state )
+{
+   float amplitude = 32767.0f * powf( 10.0f, level_dbfs / 20.0f );
+   for ( int i = 0; i < count; ++i )
+   {
+      float value = 0.0f;
+      if ( noisy )
+      {
+         *random_state = *random_state * 1664525u + 1013904223u;
+         value = ((float)(*random_state >> 8) / (float)(1 << 24)) * 2.0f - 1.0f;
+      }
+      else
+      {
+         value = sinf( 2.0f * 3.14159265f * 220.0f * (float)i / HARDCODED_SAMPLE_RATE );
+      }
+      samples[i] = (short)(value * amplitude);
+   }
+}
+
+// NOTE: speech from the first window isn't taken for the noise floor, digital silence is trusted only
+//       after the hangover, the floor follows steady hiss up until it's gated, and speech over the hiss
+//       still goes through
+TestResult energy_gate_test()
+{
+   VADC_Gate_Options options = {0};
+   options.enabled = 1;
+   options.margin_db = 6.0f;
+   options.absolute_floor_dbfs = -60.0f;
+   options.noise_zcr = 0.25f;
+   options.hangover_windows = 3;
+
+   enum { window = 512 };
+   short samples[window];
+   u32 random_state = 7;
+   b32 pass = 1;
+
+   VADC_Gate gate;
+   vadc_gate_init( &gate, &options );
+   for ( int i = 0; i < 50; ++i )
+   {
+      test_gate_window( samples, window, -20.0f, 0, &random_state );
+      pass = pass && !vadc_gate_window_is_silent( &gate, vadc_gate_measure( samples, window ) );
+   }
+
+   memset( samples, 0, sizeof( samples ) );
+   for ( int i = 0; i < 10; ++i )
+   {
+      b32 silent = vadc_gate_window_is_silent( &gate, vadc_gate_measure( samples, window ) );
+      pass = pass && silent == (i >= options.hangover_windows);
+   }
+
+   vadc_gate_init( &gate, &options );
+   b32 hiss_gated = 0;
+   for ( int i = 0; i < 1000; ++i )
+   {
+      test_gate_window( samples, window, -45.0f, 1, &random_state );
+      hiss_gated = vadc_gate_window_is_silent( &gate, vadc_gate_measure( samples, window ) );
+   }
+   pass = pass && hiss_gated;
+   test_gate_window( samples, window, -20.0f, 0, &random_state );
+   pass = pass && !vadc_gate_window_is_silent( &gate, vadc_gate_measure( samples, window ) );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: arena_bytes_required with the gate covers what a gated run actually takes, in every gate mode
+TestResult gate_arena_estimate_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char input_path[128];
+   snprintf( input_path, sizeof( input_path ), "%s/gate_arena.raw", dir );
+   char output_path[128];
+   snprintf( output_path, sizeof( output_path ), "%s/gate_arena.txt", dir );
+
+   // NOTE: a stretch of digital silence in the middle, so the gate skips and the warm-up replays
+   size_t sample_count = 12 * HARDCODED_SAMPLE_RATE;
+   short *samples = malloc( sample_count * sizeof( short ) );
+   test_synthesize_audio( samples, sample_count, 41 );
+   memset( samples + 4 * HARDCODED_SAMPLE_RATE, 0, 4 * HARDCODED_SAMPLE_RATE * sizeof( short ) );
+   b32 pass = test_write_file( input_path, samples, sample_count * sizeof( short ) );
+   free( samples );
+
+   VADC_Gate_Options modes[] =
+   {
+      { .enabled = 1, .margin_db = 6.0f, .absolute_floor_dbfs = -60.0f, .noise_zcr = 0.25f, .hangover_windows = 3, .rewarm_windows = 4 },
+      { .enabled = 1, .margin_db = 6.0f, .absolute_floor_dbfs = -60.0f, .noise_zcr = 0.25f, .hangover_windows = 3, .measure_drift = 1,
+        .lstm_policy = VADC_Gate_Lstm_Decay, .decay = 0.9f },
+#if ONNX_INFERENCE_ENABLED
+      { .enabled = 1, .stage = VADC_Gate_Stage_C, .hangover_windows = 3, .rewarm_windows = VADC_CASCADE_DEFAULT_LOOKBACK_WINDOWS,
+        .candidate_threshold = 0.2f },
+#endif // ONNX_INFERENCE_ENABLED
+   };
+
+   const size_t arena_size = VADC_DRY_RUN_SCRATCH_BYTES;
+   u8 *arena_memory = malloc( arena_size );
+   for ( int mode = 0; mode < (int)ArrayCount( modes ) && pass && arena_memory; ++mode )
+   {
+      size_t estimate = arena_bytes_required( String8FromCString( TEST_RUN_MODEL_PATH ), 1, TEST_RUN_SEQUENCE_COUNT, modes + mode,
+                                              String8FromCString( input_path ), 0, 0.0f );
+
+      MemoryArena arena = {0};
+      initializeMemoryArena( &arena, arena_memory, arena_size );
+
+      VADC_Options options = test_run_options();
+      options.gate = modes[mode];
+      pass = estimate > 0 && test_run_file( &arena, &options, String8FromCString( input_path ), output_path ) == 0 &&
+             arena.peak_used <= estimate;
+   }
+   free( arena_memory );
+
+   TestResult test_result = {0};
+   test_result.pass = pass && arena_memory;
+   return test_result;
+}
+
+// NOTE: the sweep's branch free step closes the same segments on the same windows as feed_probability
+//       run for each configuration on its own, over random probability streams with runs of speech and
+//       silence and values right at the thresholds
+TestResult sweep_step_test()
+{
+   enum { config_count = 37, stream_count = 20, window_count = 3000 };
+
+   float threshold[config_count];
+   float neg_threshold[config_count];
+   s32 min_silence_chunks[config_count];
+   s32 min_speech_chunks[config_count];
+   s32 temp_ends[config_count];
+   s32 starts[config_count];
+   s32 triggereds[config_count];
+   s32 ended[config_count];
+   s32 ended_start[config_count];
+   s32 ended_end[config_count];
+   FeedState feed_states[config_count];
+
+   u32 random_state = 43;
+   b32 pass = 1;
+   for ( int stream = 0; stream < stream_count && pass; ++stream )
+   {
+      for ( int k = 0; k < config_count; ++k )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         threshold[k] = 0.1f * (float)(1 + (random_state >> 8) % 9);
+         random_state = random_state * 1664525u + 1013904223u;
+         neg_threshold[k] = threshold[k] - 0.05f * (float)((random_state >> 8) % 5);
+         random_state = random_state * 1664525u + 1013904223u;
+         min_silence_chunks[k] = 1 + (s32)((random_state >> 8) % 12);
+         random_state = random_state * 1664525u + 1013904223u;
+         min_speech_chunks[k] = 1 + (s32)((random_state >> 8) % 12);
+      }
+      memset( temp_ends, 0, sizeof( temp_ends ) );
+      memset( starts, 0, sizeof( starts ) );
+      memset( triggereds, 0, sizeof( triggereds ) );
+      memset( feed_states, 0, sizeof( feed_states ) );
+
+      float level = 0.0f;
+      for ( s32 chunk_index = 0; chunk_index < window_count && pass; ++chunk_index )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         if ( (random_state >> 8) % 8 == 0 )
+         {
+            level = (random_state >> 4) % 2 ? 0.9f : 0.05f;
+         }
+         random_state = random_state * 1664525u + 1013904223u;
+         float probability = level + ((float)((random_state >> 8) % 1024) / 1024.0f - 0.5f) * 0.6f;
+         // NOTE: now and then exactly on a threshold, where >= and < have to agree
+         if ( (random_state >> 4) % 16 == 0 )
+         {
+            probability = threshold[(random_state >> 12) % config_count];
+         }
+
+         int ended_count = sweep_step_arrays( config_count, probability, chunk_index, threshold, neg_threshold,
+                                              min_silence_chunks, min_speech_chunks, temp_ends, starts, triggereds,
+                                              ended, ended_start, ended_end );
+         int expected_count = 0;
+         for ( int k = 0; k < config_count; ++k )
+         {
+            FeedProbabilityResult expected = feed_probability( feed_states + k, min_silence_chunks[k], min_speech_chunks[k],
+                                                               probability, threshold[k], neg_threshold[k], chunk_index );
+            expected_count += !!expected.is_valid;
+            pass = pass && !!ended[k] == !!expected.is_valid;
+            if ( expected.is_valid )
+            {
+               pass = pass && ended_start[k] == expected.speech_start && ended_end[k] == expected.speech_end;
+            }
+            pass = pass && !!triggereds[k] == !!feed_states[k].triggered && temp_ends[k] == feed_states[k].temp_end &&
+                   starts[k] == feed_states[k].current_speech_start;
+         }
+         pass = pass && ended_count == expected_count;
+      }
+   }
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: every configuration of a sweep gets a segment file of its own, also when its values are closer
+//       than the name prints them, and each file holds what a plain run with those settings writes
+TestResult sweep_files_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char input_path[128];
+   char sweep_dir[128];
+   char expected_path[128];
+   snprintf( input_path, sizeof( input_path ), "%s/sweep.raw", dir );
+   snprintf( sweep_dir, sizeof( sweep_dir ), "%s/sweep", dir );
+   snprintf( expected_path, sizeof( expected_path ), "%s/sweep_expected.txt", dir );
+   mkdir( sweep_dir, 0755 );
+
+   size_t sample_count = 10 * HARDCODED_SAMPLE_RATE;
+   short *samples = malloc( sample_count * sizeof( short ) );
+   test_synthesize_audio( samples, sample_count, 430 );
+   b32 pass = test_write_file( input_path, samples, sample_count * sizeof( short ) );
+   free( samples );
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   TemporaryMemory mark = beginTemporaryMemory( debug_arena );
+
+   const float thresholds[] = { 0.505f, 0.509f, 0.5091f, 0.3f };
+   enum { config_count = ArrayCount( thresholds ) };
+   VADC_Options options = test_run_options();
+   VADC_Sweep_Options sweep = {0};
+   for ( int i = 0; i < config_count; ++i )
+   {
+      sweep.values[VADC_Sweep_Param_Threshold][i] = thresholds[i];
+   }
+   sweep.value_counts[VADC_Sweep_Param_Threshold] = config_count;
+   sweep.values[VADC_Sweep_Param_NegThresholdRelative][0] = 0.15f;
+   sweep.value_counts[VADC_Sweep_Param_NegThresholdRelative] = 1;
+   sweep.preferred_batch_size = 1;
+   sweep.desired_sequence_count = TEST_RUN_SEQUENCE_COUNT;
+   sweep.output_dir = String8FromCString( sweep_dir );
+   sweep.options = &options;
+   pass = pass && run_sweep( String8FromCString( TEST_RUN_MODEL_PATH ), debug_arena, &sweep, String8FromCString( input_path ) ) == 0;
+
+   char paths[config_count][512];
+   int file_count = 0;
+   DIR *sweep_listing = opendir( sweep_dir );
+   pass = pass && sweep_listing;
+   for ( struct dirent *entry = sweep_listing ? readdir( sweep_listing ) : NULL; entry; entry = readdir( sweep_listing ) )
+   {
+      int index = -1;
+      if ( entry->d_name[0] == '.' )
+      {
+         continue;
+      }
+      ++file_count;
+      if ( sscanf( entry->d_name, "sweep_%d_", &index ) == 1 && index >= 0 && index < config_count )
+      {
+         snprintf( paths[index], sizeof( paths[index] ), "%s/%s", sweep_dir, entry->d_name );
+      }
+      else
+      {
+         pass = 0;
+      }
+   }
+   if ( sweep_listing )
+   {
+      closedir( sweep_listing );
+   }
+   pass = pass && file_count == config_count;
+
+   for ( int i = 0; i < config_count && pass; ++i )
+   {
+      VADC_Options run_options = options;
+      run_options.threshold = thresholds[i];
+      run_options.neg_threshold = thresholds[i] - 0.15f;
+      pass = test_run_file( debug_arena, &run_options, String8FromCString( input_path ), expected_path ) == 0 &&
+             test_files_equal( expected_path, paths[i] );
+   }
+
+   endTemporaryMemory( mark );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: unpadded and unmerged, speech_start/speech_end pairs, or segments
+typedef struct Test_Event_Segments Test_Event_Segments;
+struct Test_Event_Segments
+{
+   int count;
+   int starts[512];
+   int ends[512];
+};
+
+static void test_event_segments_push( Test_Event_Segments *segments, int start, int end )
+{
+   if ( segments->count < (int)ArrayCount( segments->starts ) )
+   {
+      segments->starts[segments->count] = start;
+      segments->ends[segments->count] = end;
+   }
+   ++segments->count;
+}
+
+// NOTE: probabilities through feed_probability and the event tracker the way run_inference_on_backend
+//       runs them, including the snap of speech still running at the end. Returns 0 if the events
+//       aren't start/end pairs.
+static b32 test_event_run( const float *probabilities, int count, int min_silence_chunks, int min_speech_chunks,
+                           Test_Event_Segments *segments, Test_Event_Segments *pairs )
+{
+   FeedState state = {0};
+   VADC_Event_Tracker tracker = {0};
+   tracker.provisional = 1;
+   tracker.min_speech_duration_chunks = min_speech_chunks;
+   memset( segments, 0, sizeof( *segments ) );
+   memset( pairs, 0, sizeof( *pairs ) );
+
+   VADC_Event events[VADC_EVENTS_PER_WINDOW_MAX];
+   int open_start = -1;
+   b32 paired = 1;
+   for ( int chunk_index = 0; chunk_index <= count; ++chunk_index )
+   {
+      int event_count = 0;
+      if ( chunk_index < count )
+      {
+         FeedProbabilityResult feed_result = feed_probability( &state, min_silence_chunks, min_speech_chunks,
+                                                               probabilities[chunk_index], 0.5f, 0.35f, chunk_index );
+         if ( feed_result.is_valid )
+         {
+            test_event_segments_push( segments, feed_result.speech_start, feed_result.speech_end );
+         }
+         event_count = vadc_event_tracker_feed( &tracker, &state, feed_result, chunk_index, events );
+      }
+      else
+      {
+         if ( state.triggered && (count - 1) - state.current_speech_start > min_speech_chunks )
+         {
+            test_event_segments_push( segments, state.current_speech_start, count - 1 );
+         }
+         event_count = vadc_event_tracker_finish( &tracker, count - 1, count, events );
+      }
+
+      for ( int i = 0; i < event_count; ++i )
+      {
+         if ( events[i].type == VADC_Event_SpeechStart )
+         {
+            paired = paired && open_start < 0;
+            open_start = events[i].chunk;
+         }
+         else if ( events[i].type == VADC_Event_SpeechEnd )
+         {
+            paired = paired && open_start >= 0;
+            test_event_segments_push( pairs, open_start, events[i].chunk );
+            open_start = -1;
+         }
+      }
+   }
+   return paired && open_start < 0;
+}
+
+static b32 test_event_segments_equal( const Test_Event_Segments *left, const Test_Event_Segments *right )
+{
+   int count = left->count < (int)ArrayCount( left->starts ) ? left->count : (int)ArrayCount( left->starts );
+   return left->count == right->count &&
+          memcmp( left->starts, right->starts, count * sizeof( int ) ) == 0 &&
+          memcmp( left->ends, right->ends, count * sizeof( int ) ) == 0;
+}
+
+// NOTE: the events' start/end pairs are exactly the segments, over random probability streams cut at
+//       every length, which puts the end of the input anywhere in and around the speech, and for speech
+//       running into the end at exactly min_speech and either side of it
+TestResult event_tracker_test()
+{
+   enum { window_count = 400 };
+   float probabilities[window_count];
+   Test_Event_Segments segments;
+   Test_Event_Segments pairs;
+   b32 pass = 1;
+
+   u32 random_state = 45;
+   for ( int stream = 0; stream < 10 && pass; ++stream )
+   {
+      float level = 0.0f;
+      for ( int i = 0; i < window_count; ++i )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         if ( (random_state >> 8) % 6 == 0 )
+         {
+            level = (random_state >> 4) % 2 ? 0.9f : 0.05f;
+         }
+         random_state = random_state * 1664525u + 1013904223u;
+         probabilities[i] = level + ((float)((random_state >> 8) % 1024) / 1024.0f - 0.5f) * 0.5f;
+      }
+
+      random_state = random_state * 1664525u + 1013904223u;
+      int min_silence_chunks = 1 + (int)((random_state >> 8) % 8);
+      int min_speech_chunks = 1 + (int)((random_state >> 16) % 8);
+      for ( int count = 1; count <= window_count && pass; ++count )
+      {
+         pass = test_event_run( probabilities, count, min_silence_chunks, min_speech_chunks, &segments, &pairs ) &&
+                test_event_segments_equal( &segments, &pairs );
+      }
+   }
+
+   const int min_speech_chunks = 4;
+   for ( int speech_chunks = min_speech_chunks - 1; speech_chunks <= min_speech_chunks + 2 && pass; ++speech_chunks )
+   {
+      int count = 3 + speech_chunks;
+      for ( int i = 0; i < count; ++i )
+      {
+         probabilities[i] = i < 3 ? 0.0f : 1.0f;
+      }
+      pass = test_event_run( probabilities, count, 2, min_speech_chunks, &segments, &pairs ) &&
+             test_event_segments_equal( &segments, &pairs ) &&
+             segments.count == (speech_chunks - 1 > min_speech_chunks);
+   }
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+static long test_file_size( const char *path )
+{
+   struct stat file_stat;
+   return stat( path, &file_stat ) == 0 ? (long)file_stat.st_size : -1;
+}
+
+// NOTE: the output writer keeps small writes until the buffer fills, the interval passes or it's
+//       flushed, and in live mode or without a buffer lets every write through at once. Whatever the
+//       mode and write sizes, the file ends up with exactly the bytes written, and a device that
+//       refuses them reports every byte as dropped.
+TestResult output_writer_test()
+{
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   enum { capacity = 1024, total_bytes = 64 * 1024 };
+   char path[128];
+   snprintf( path, sizeof( path ), "%s/output_writer.txt", dir );
+
+   u8 *expected = malloc( total_bytes );
+   u32 random_state = 46;
+   for ( int i = 0; i < total_bytes; ++i )
+   {
+      random_state = random_state * 1664525u + 1013904223u;
+      expected[i] = (u8)(random_state >> 24);
+   }
+
+   u8 buffer[capacity];
+   b32 pass = 1;
+   // NOTE: buffered, live, flushed on every write by a zero interval, and unbuffered
+   for ( int mode = 0; mode < 4 && pass; ++mode )
+   {
+      FILE *file = fopen( path, "wb" );
+      if ( !file )
+      {
+         pass = 0;
+         break;
+      }
+
+      VADC_Output_Writer writer;
+      vadc_output_writer_init( &writer, file, mode == 3 ? NULL : buffer, capacity, mode == 1,
+                               mode == 2 ? 0 : (s64)3600 * 1000000000LL );
+      b32 buffered = (mode == 0);
+
+      size_t written = 0;
+      size_t dropped = 0;
+      while ( written < total_bytes && pass )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         size_t bytes = (random_state >> 8) % 5 == 0 ? capacity + (random_state >> 12) % 300 : (random_state >> 12) % 200;
+         bytes = bytes < total_bytes - written ? bytes : total_bytes - written;
+
+         size_t used_before = writer.used;
+         dropped += vadc_output_writer_write( &writer, expected + written, bytes );
+         written += bytes;
+
+         // NOTE: a small write that fits stays in the buffer, anything else leaves the file complete
+         long size = test_file_size( path );
+         if ( buffered && bytes <= capacity && used_before + bytes <= capacity )
+         {
+            pass = pass && writer.used == used_before + bytes && size == (long)(written - writer.used);
+         }
+         else if ( !buffered )
+         {
+            pass = pass && writer.used == 0 && size == (long)written;
+         }
+         else
+         {
+            pass = pass && size == (long)(written - writer.used);
+         }
+      }
+      dropped += vadc_output_writer_flush( &writer );
+      fclose( file );
+
+      size_t size = 0;
+      u8 *data = test_read_file( path, &size );
+      pass = pass && dropped == 0 && data && size == total_bytes && memcmp( data, expected, total_bytes ) == 0;
+      free( data );
+   }
+
+   FILE *full = fopen( "/dev/full", "wb" );
+   if ( full )
+   {
+      VADC_Output_Writer writer;
+      vadc_output_writer_init( &writer, full, buffer, capacity, 0, (s64)3600 * 1000000000LL );
+      size_t dropped = vadc_output_writer_write( &writer, expected, 100 );
+      pass = pass && dropped == 0;
+      dropped += vadc_output_writer_write( &writer, expected + 100, capacity );
+      dropped += vadc_output_writer_flush( &writer );
+      pass = pass && dropped == 100 + capacity;
+      fclose( full );
+   }
+
+   free( expected );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: --extract_speech writes exactly the input's samples inside the segments the run outputs, for
+//       random segmentation settings: the pieces it writes early, while a segment is still growing or may
+//       merge with the next, add up to the final padded and merged segments and nothing else
+TestResult speech_extract_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char input_path[128];
+   char output_path[128];
+   char extract_path[128];
+   snprintf( input_path, sizeof( input_path ), "%s/extract.raw", dir );
+   snprintf( output_path, sizeof( output_path ), "%s/extract.f32", dir );
+   snprintf( extract_path, sizeof( extract_path ), "%s/extract_speech.raw", dir );
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   u32 random_state = 47;
+   b32 pass = 1;
+   for ( int run_index = 0; run_index < 6 && pass; ++run_index )
+   {
+      random_state = random_state * 1664525u + 1013904223u;
+      size_t sample_count = 8 * HARDCODED_SAMPLE_RATE + (random_state >> 8) % (4 * HARDCODED_SAMPLE_RATE);
+      short *samples = malloc( sample_count * sizeof( short ) );
+      test_synthesize_audio( samples, sample_count, 470 + run_index );
+      pass = test_write_file( input_path, samples, sample_count * sizeof( short ) );
+
+      VADC_Options options = test_run_options();
+      random_state = random_state * 1664525u + 1013904223u;
+      options.threshold = 0.3f + 0.1f * (float)((random_state >> 8) % 4);
+      options.neg_threshold = options.threshold - 0.15f;
+      options.min_silence_duration_ms = 50.0f + (float)((random_state >> 12) % 450);
+      random_state = random_state * 1664525u + 1013904223u;
+      options.min_speech_duration_ms = 50.0f + (float)((random_state >> 8) % 450);
+      options.speech_pad_ms = (float)((random_state >> 16) % 400);
+      options.output_format = Segment_Output_Format_Float32;
+      options.extract_speech_path = extract_path;
+      options.extract_lookbehind_s = 30.0f;
+
+      pass = pass && test_run_file( debug_arena, &options, String8FromCString( input_path ), output_path ) == 0;
+
+      size_t segments_size = 0;
+      size_t extracted_size = 0;
+      u8 *segments = test_read_file( output_path, &segments_size );
+      u8 *extracted = test_read_file( extract_path, &extracted_size );
+      pass = pass && segments && extracted && segments_size % (2 * sizeof( float )) == 0;
+
+      // NOTE: the segments' samples, rounded from the padded seconds the way the run does it
+      size_t expected_size = 0;
+      short *expected = malloc( sample_count * sizeof( short ) );
+      for ( size_t offset = 0; pass && offset < segments_size; offset += 2 * sizeof( float ) )
+      {
+         float pair[2];
+         memcpy( pair, segments + offset, sizeof( pair ) );
+         s64 start_sample = (s64)((double)pair[0] * HARDCODED_SAMPLE_RATE + 0.5);
+         s64 end_sample = (s64)((double)pair[1] * HARDCODED_SAMPLE_RATE + 0.5);
+         end_sample = end_sample < (s64)sample_count ? end_sample : (s64)sample_count;
+         for ( s64 i = start_sample; i < end_sample; ++i )
+         {
+            expected[expected_size++] = samples[i];
+         }
+      }
+      pass = pass && segments_size > 0 && extracted_size == expected_size * sizeof( short ) &&
+             memcmp( extracted, expected, extracted_size ) == 0;
+
+      free( expected );
+      free( segments );
+      free( extracted );
+      free( samples );
+   }
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: a model call returns batch_size probabilities however few windows a read filled. At batches
+//       above the windows of a read they still have to land in their own buffer, not in the output
+//       writer's bytes waiting to be written: the raw probabilities come out one per window and in
+//       [0, 1], and the segments in order and inside the input. Zero padded batches move the lstm
+//       state, so the values themselves differ from batch 1.
+TestResult output_writer_batch_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char input_path[128];
+   char output_path[128];
+   snprintf( input_path, sizeof( input_path ), "%s/batch.raw", dir );
+   snprintf( output_path, sizeof( output_path ), "%s/batch.f32", dir );
+
+   size_t sample_count = 8 * HARDCODED_SAMPLE_RATE;
+   short *samples = malloc( sample_count * sizeof( short ) );
+   test_synthesize_audio( samples, sample_count, 460 );
+   b32 pass = test_write_file( input_path, samples, sample_count * sizeof( short ) );
+   free( samples );
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   String8 filename = String8FromCString( input_path );
+   const s32 batch_sizes[] = { 1, 3, 24 };
+   size_t window_count = 0;
+   for ( int batch_index = 0; batch_index < (int)ArrayCount( batch_sizes ) && pass; ++batch_index )
+   {
+      VADC_Options options = test_run_options();
+      options.output_format = Segment_Output_Format_Float32;
+      options.raw_probabilities = 1;
+      pass = test_run_file_mode( debug_arena, &options, filename, output_path, "wb", batch_sizes[batch_index] ) == 0;
+
+      size_t size = 0;
+      float *probabilities = (float *)test_read_file( output_path, &size );
+      if ( batch_index == 0 )
+      {
+         window_count = size / sizeof( float );
+      }
+      pass = pass && probabilities && window_count > 0 && size == window_count * sizeof( float );
+      for ( size_t i = 0; pass && i < window_count; ++i )
+      {
+         pass = probabilities[i] >= 0.0f && probabilities[i] <= 1.0f;
+      }
+      free( probabilities );
+
+      options.raw_probabilities = 0;
+      pass = pass && test_run_file_mode( debug_arena, &options, filename, output_path, "wb", batch_sizes[batch_index] ) == 0;
+
+      float *segments = (float *)test_read_file( output_path, &size );
+      size_t segment_count = size / (2 * sizeof( float ));
+      pass = pass && segments && segment_count > 0 && size == segment_count * 2 * sizeof( float );
+      float previous_end = 0.0f;
+      for ( size_t i = 0; pass && i < segment_count; ++i )
+      {
+         float start = segments[2 * i];
+         float end = segments[2 * i + 1];
+         pass = start >= previous_end && start < end && end <= (float)sample_count / HARDCODED_SAMPLE_RATE + 0.01f;
+         previous_end = end;
+      }
+      free( segments );
+   }
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+#define TEST_SINK_BLOCK_BYTES 4096
+
+// NOTE: block index in its first bytes, the rest a pattern of the index, so reordered, torn or partly
+//       written blocks show
+static void test_sink_block( u8 *block, u32 index )
+{
+   memcpy( block, &index, sizeof( index ) );
+   for ( int i = sizeof( index ); i < TEST_SINK_BLOCK_BYTES; ++i )
+   {
+      block[i] = (u8)(index * 31u + i);
+   }
+}
+
+typedef struct Test_Pipe_Reader Test_Pipe_Reader;
+struct Test_Pipe_Reader
+{
+   int fd;
+   atomic_int go;
+   u8 *data;
+   size_t size;
+   size_t capacity;
+};
+
+// NOTE: a consumer that stalls until go is set, then reads the pipe to its end
+static void *test_pipe_reader_proc( void *param )
+{
+   Test_Pipe_Reader *reader = param;
+   while ( !atomic_load( &reader->go ) )
+   {
+      poll( NULL, 0, 1 );
+   }
+   for ( ;; )
+   {
+      if ( reader->size == reader->capacity )
+      {
+         reader->capacity = reader->capacity ? reader->capacity * 2 : 1 << 20;
+         reader->data = realloc( reader->data, reader->capacity );
+      }
+      ssize_t bytes_read = read( reader->fd, reader->data + reader->size, reader->capacity - reader->size );
+      if ( bytes_read <= 0 )
+      {
+         break;
+      }
+      reader->size += (size_t)bytes_read;
+   }
+   return NULL;
+}
+
+// NOTE: the audio sink rings hand every byte over in order, with blocks larger than the whole ring
+//       too. With drop, a pipe nobody reads fills its ring and loses whole blocks only, while a file
+//       sink next to it keeps up and gets everything.
+TestResult audio_sink_test()
+{
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char path[128];
+   snprintf( path, sizeof( path ), "%s/audio_sink.raw", dir );
+   b32 pass = 1;
+
+   // NOTE: block, random write sizes up to three rings
+   {
+      size_t total_bytes = 3 * VADC_AUDIO_SINK_RING_BYTES + 12345;
+      u8 *expected = malloc( total_bytes );
+      u32 random_state = 48;
+      for ( size_t i = 0; i < total_bytes; ++i )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         expected[i] = (u8)(random_state >> 24);
+      }
+
+      FILE *file = fopen( path, "wb" );
+      VADC_Audio_Sinks sinks;
+      vadc_audio_sinks_init( &sinks, VADC_Audio_Sink_Overflow_Block, NULL );
+      VADC_Audio_Sink *sink = vadc_audio_sinks_add( &sinks, file );
+      pass = file && sink && vadc_audio_sinks_start( &sinks ) == 0;
+
+      size_t written = 0;
+      while ( pass && written < total_bytes )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         size_t bytes = (random_state >> 8) % 64 == 0 ? (random_state >> 4) % (3 * VADC_AUDIO_SINK_RING_BYTES) : (random_state >> 8) % 5000;
+         bytes = bytes < total_bytes - written ? bytes : total_bytes - written;
+         vadc_audio_sink_write( &sinks, sink, expected + written, bytes );
+         written += bytes;
+      }
+      vadc_audio_sinks_stop( &sinks );
+      if ( file )
+      {
+         fclose( file );
+      }
+
+      size_t size = 0;
+      u8 *data = test_read_file( path, &size );
+      pass = pass && data && size == total_bytes && memcmp( data, expected, total_bytes ) == 0 &&
+             atomic_load( &sinks.written_bytes ) == total_bytes && atomic_load( &sinks.dropped_bytes ) == 0;
+      free( data );
+      free( expected );
+   }
+
+   // NOTE: drop, a stalled pipe and a file
+   int fds[2];
+   if ( pass && pipe( fds ) == 0 )
+   {
+      enum { pipe_blocks = 1024, file_blocks = 64 };
+
+      Test_Pipe_Reader reader = {0};
+      reader.fd = fds[0];
+      pthread_t reader_thread;
+      pthread_create( &reader_thread, NULL, test_pipe_reader_proc, &reader );
+
+      FILE *pipe_file = fdopen( fds[1], "wb" );
+      FILE *file = fopen( path, "wb" );
+      VADC_Audio_Sinks sinks;
+      vadc_audio_sinks_init( &sinks, VADC_Audio_Sink_Overflow_Drop, NULL );
+      VADC_Audio_Sink *pipe_sink = vadc_audio_sinks_add( &sinks, pipe_file );
+      VADC_Audio_Sink *file_sink = vadc_audio_sinks_add( &sinks, file );
+      pass = pipe_file && file && pipe_sink && file_sink && vadc_audio_sinks_start( &sinks ) == 0;
+
+      u8 block[TEST_SINK_BLOCK_BYTES];
+      for ( u32 index = 0; index < pipe_blocks && pass; ++index )
+      {
+         test_sink_block( block, index );
+         vadc_audio_sink_write( &sinks, pipe_sink, block, sizeof( block ) );
+         if ( index < file_blocks )
+         {
+            vadc_audio_sink_write( &sinks, file_sink, block, sizeof( block ) );
+            // NOTE: paced, the file's ring never fills
+            poll( NULL, 0, 1 );
+         }
+      }
+      unsigned long long dropped_bytes = atomic_load( &sinks.dropped_bytes );
+
+      // NOTE: while the pipe is still stalled, the file's own thread has written it all out
+      b32 file_kept_up = 0;
+      for ( int wait_ms = 0; wait_ms < 2000 && !file_kept_up; ++wait_ms )
+      {
+         file_kept_up = test_file_size( path ) == (long)file_blocks * TEST_SINK_BLOCK_BYTES;
+         poll( NULL, 0, file_kept_up ? 0 : 1 );
+      }
+      pass = pass && file_kept_up;
+
+      atomic_store( &reader.go, 1 );
+      vadc_audio_sinks_stop( &sinks );
+      if ( pipe_file )
+      {
+         fclose( pipe_file );
+      }
+      else
+      {
+         close( fds[1] );
+      }
+      pthread_join( reader_thread, NULL );
+      close( fds[0] );
+      if ( file )
+      {
+         fclose( file );
+      }
+
+      pass = pass && dropped_bytes > 0 && reader.size % TEST_SINK_BLOCK_BYTES == 0 &&
+             reader.size + dropped_bytes == (unsigned long long)pipe_blocks * TEST_SINK_BLOCK_BYTES;
+      u32 previous_index = 0;
+      for ( size_t offset = 0; pass && offset < reader.size; offset += TEST_SINK_BLOCK_BYTES )
+      {
+         u32 index = 0;
+         memcpy( &index, reader.data + offset, sizeof( index ) );
+         test_sink_block( block, index );
+         pass = (offset == 0 || index > previous_index) && memcmp( reader.data + offset, block, sizeof( block ) ) == 0;
+         previous_index = index;
+      }
+      free( reader.data );
+
+      size_t size = 0;
+      u8 *data = test_read_file( path, &size );
+      pass = pass && data && size == (size_t)file_blocks * TEST_SINK_BLOCK_BYTES;
+      for ( u32 index = 0; pass && index < file_blocks; ++index )
+      {
+         test_sink_block( block, index );
+         pass = memcmp( data + index * TEST_SINK_BLOCK_BYTES, block, sizeof( block ) ) == 0;
+      }
+      free( data );
+   }
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: a message the way the logger handles it: arguments copied into a record as big as log_push's,
+//       then formatted from the copy
+static size_t test_log_line( char *line, size_t line_size, const char *format, ... )
+{
+   u64 storage[(VADC_LOG_RECORD_MAX - sizeof( VADC_Log_Record )) / sizeof( u64 )];
+   Log_Payload payload = { (u8 *)storage, 0, sizeof( storage ) };
+   va_list args;
+   va_start( args, format );
+   log_capture( &payload, format, &args );
+   va_end( args );
+   return log_format( line, line_size, format, (const u8 *)storage, payload.size );
+}
+
+static void test_log_push( VADC_Log_Ring *ring, const char *format, ... )
+{
+   va_list args;
+   va_start( args, format );
+   log_push( ring, VADC_Log_Info, NULL, vadc_now_ns(), format, &args );
+   va_end( args );
+}
+
+// NOTE: the flusher's side of one ring, formats the next message into line. Returns 0 if it's empty.
+static b32 test_log_pop( VADC_Log_Ring *ring, char *line, size_t line_size )
+{
+   const VADC_Log_Record *record = log_peek( ring );
+   if ( !record )
+   {
+      return 0;
+   }
+   log_format( line, line_size, record->format, (const u8 *)(record + 1), record->size - sizeof( VADC_Log_Record ) );
+   ring->read += record->size;
+   atomic_store( &ring->tail, ring->read );
+   return 1;
+}
+
+// NOTE: the logger formats from its copy of the arguments what snprintf formats from the arguments: *
+//       width and precision, %.*s, length modifiers, %%, and a message longer than a record is cut
+//       where the record ends
+TestResult log_format_test()
+{
+   char line[2048];
+   char expected[2048];
+   b32 pass = 1;
+
+#define TEST_LOG_CHECK( ... ) \
+   do { \
+      test_log_line( line, sizeof( line ), __VA_ARGS__ ); \
+      snprintf( expected, sizeof( expected ), __VA_ARGS__ ); \
+      pass = pass && strcmp( line, expected ) == 0; \
+   } while ( 0 )
+
+   TEST_LOG_CHECK( "[%*d] [%-*d] [%.*f] [%*.*f]", 6, 42, 6, -42, 3, 3.14159, 10, 2, -2.5 );
+   TEST_LOG_CHECK( "[%*s] [%-*s] [%.*s]", 8, "abc", -8, "abc", 2, "abcdef" );
+   TEST_LOG_CHECK( "%.*s|%.*s|%.*s", 0, "abc", 5, "abc", 3, "abcdef" );
+   TEST_LOG_CHECK( "%zu %zd %lld %llu %ld %hd %hhu", (size_t)123456789012ull, (ptrdiff_t)-5, -9000000000ll,
+                   18000000000000000000ull, -77l, (short)-3, (unsigned char)250 );
+   TEST_LOG_CHECK( "100%% %d%% %%%s%%", 50, "x" );
+   TEST_LOG_CHECK( "%c%c %x %X %o %#x %+d % d %05d %e %g", 'o', 'k', 255u, 255u, 8u, 255u, 7, 7, 42, 12345.678, 0.0001 );
+
+#undef TEST_LOG_CHECK
+
+   test_log_line( line, sizeof( line ), "[%s]", (const char *)NULL );
+   pass = pass && strcmp( line, "[(null)]" ) == 0;
+
+   // NOTE: the string takes what is left of the record after its length, an argument after it no
+   //       longer fits and the line ends in "..."
+   static char long_string[3000];
+   memset( long_string, 'a', sizeof( long_string ) - 1 );
+   const int kept = (int)(VADC_LOG_RECORD_MAX - sizeof( VADC_Log_Record ) - sizeof( u64 ));
+   test_log_line( line, sizeof( line ), "%s", long_string );
+   snprintf( expected, sizeof( expected ), "%.*s", kept, long_string );
+   pass = pass && strcmp( line, expected ) == 0;
+   test_log_line( line, sizeof( line ), "%s %d", long_string, 7 );
+   snprintf( expected, sizeof( expected ), "%.*s ...", kept, long_string );
+   pass = pass && strcmp( line, expected ) == 0;
+
+   // NOTE: and the line is cut to the buffer it is formatted into, terminated
+   test_log_line( line, 16, "%d %s", 12345, "abcdefghijklmnop" );
+   pass = pass && strcmp( line, "12345 abcdefghi" ) == 0;
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+static const char test_log_text[VADC_LOG_RECORD_MAX] =
+   "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 "
+   "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 "
+   "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 "
+   "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 "
+   "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 "
+   "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789 ";
+
+// NOTE: a log ring wraps many times over with records of every size, the filler in front of a wrap is
+//       skipped and every message comes out whole and in order. A ring nobody drains drops the messages
+//       that don't fit, counts them, and takes messages again once it's drained.
+TestResult log_ring_test()
+{
+   VADC_Log_Ring ring;
+   memset( &ring, 0, sizeof( ring ) );
+   ring.buffer = malloc( VADC_LOG_RING_BYTES );
+
+   enum { message_count = 20000 };
+   static int text_lengths[message_count];
+   char line[2048];
+   char expected[2048];
+   b32 pass = ring.buffer != NULL;
+   u32 random_state = 49;
+   int popped = 0;
+   for ( int message = 0; message < message_count && pass; ++message )
+   {
+      // NOTE: the string's length sets the record size, up to half a record
+      random_state = random_state * 1664525u + 1013904223u;
+      text_lengths[message] = (int)((random_state >> 8) % (VADC_LOG_RECORD_MAX / 2));
+      test_log_push( &ring, "#%d %.*s", message, text_lengths[message], test_log_text );
+
+      // NOTE: the flusher falls behind by a few messages now and then
+      random_state = random_state * 1664525u + 1013904223u;
+      int pops = (random_state >> 8) % 4;
+      for ( int i = 0; i < pops && pass && test_log_pop( &ring, line, sizeof( line ) ); ++i, ++popped )
+      {
+         snprintf( expected, sizeof( expected ), "#%d %.*s", popped, text_lengths[popped], test_log_text );
+         pass = strcmp( line, expected ) == 0;
+      }
+   }
+   for ( ; pass && test_log_pop( &ring, line, sizeof( line ) ); ++popped )
+   {
+      snprintf( expected, sizeof( expected ), "#%d %.*s", popped, text_lengths[popped], test_log_text );
+      pass = strcmp( line, expected ) == 0;
+   }
+   pass = pass && popped == message_count && atomic_load( &ring.dropped ) == 0 &&
+          atomic_load( &ring.head ) > 8 * VADC_LOG_RING_BYTES;
+
+   // NOTE: not drained, the ring fills up
+   int pushed = 0;
+   while ( atomic_load( &ring.dropped ) < 100 )
+   {
+      test_log_push( &ring, "fill %d %s", pushed++, "0123456789012345678901234567890123456789" );
+   }
+   int kept = 0;
+   while ( pass && test_log_pop( &ring, line, sizeof( line ) ) )
+   {
+      snprintf( expected, sizeof( expected ), "fill %d 0123456789012345678901234567890123456789", kept++ );
+      pass = strcmp( line, expected ) == 0;
+   }
+   pass = pass && kept + (int)atomic_load( &ring.dropped ) == pushed && kept > VADC_LOG_RING_BYTES / 128;
+   test_log_push( &ring, "after %d", 1 );
+   pass = pass && test_log_pop( &ring, line, sizeof( line ) ) && strcmp( line, "after 1" ) == 0;
+
+   free( ring.buffer );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: a run killed part way, checkpointing after every read, and resumed appending to the same output
+//       comes out byte for byte as an uninterrupted run, whatever the killed run wrote after its last
+//       checkpoint is cut off
+TestResult checkpoint_resume_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char input_path[128];
+   char expected_path[128];
+   char output_path[128];
+   char checkpoint_path[128];
+   snprintf( input_path, sizeof( input_path ), "%s/checkpoint.raw", dir );
+   snprintf( expected_path, sizeof( expected_path ), "%s/checkpoint_expected.txt", dir );
+   snprintf( output_path, sizeof( output_path ), "%s/checkpoint_output.txt", dir );
+   snprintf( checkpoint_path, sizeof( checkpoint_path ), "%s/job.ckpt", dir );
+
+   size_t sample_count = 20 * HARDCODED_SAMPLE_RATE;
+   short *samples = malloc( sample_count * sizeof( short ) );
+   test_synthesize_audio( samples, sample_count, 500 );
+   b32 pass = test_write_file( input_path, samples, sample_count * sizeof( short ) );
+   free( samples );
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   String8 filename = String8FromCString( input_path );
+   const Segment_Output_Format formats[] = { Segment_Output_Format_Seconds, Segment_Output_Format_Float32 };
+   u32 random_state = 50;
+   for ( int run_index = 0; run_index < 4 && pass; ++run_index )
+   {
+      VADC_Options options = test_run_options();
+      options.output_format = formats[run_index % ArrayCount( formats )];
+      pass = test_run_file( debug_arena, &options, filename, expected_path ) == 0;
+
+      options.checkpoint_path = checkpoint_path;
+      options.checkpoint_interval_s = 0.0f;
+      options.resume = 1;
+      unlink( checkpoint_path );
+
+      random_state = random_state * 1664525u + 1013904223u;
+      size_t cut_samples = 2 * HARDCODED_SAMPLE_RATE + (random_state >> 8) % (sample_count - 4 * HARDCODED_SAMPLE_RATE);
+      char cut_bytes[32];
+      snprintf( cut_bytes, sizeof( cut_bytes ), "%zu", cut_samples * sizeof( short ) );
+      setenv( "VADC_TEST_FFMPEG_BYTES", cut_bytes, 1 );
+      pass = pass && test_run_file_mode( debug_arena, &options, filename, output_path, "wb", 1 ) != 0;
+      unsetenv( "VADC_TEST_FFMPEG_BYTES" );
+      pass = pass && test_file_size( checkpoint_path ) > 0;
+
+      pass = pass && test_run_file_mode( debug_arena, &options, filename, output_path, "ab", 1 ) == 0;
+      pass = pass && test_files_equal( expected_path, output_path ) && test_file_size( checkpoint_path ) < 0;
+   }
+   unlink( checkpoint_path );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+// NOTE: a run that hits the probability cache writes the same segments and raw probabilities, byte for
+//       byte, as the run that missed and filled it, and does read them from the cache. Another model,
+//       runtime, input or window size is a miss, never a stale hit.
+TestResult prob_cache_test()
+{
+   if ( !test_run_backend_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+   const char *dir = test_run_dir();
+   if ( !dir )
+   {
+      return test_unavailable( "no scratch directory" );
+   }
+
+   char input_path[128];
+   char other_input_path[128];
+   char cache_dir[128];
+   char expected_path[128];
+   char output_path[128];
+   snprintf( input_path, sizeof( input_path ), "%s/cache.raw", dir );
+   snprintf( other_input_path, sizeof( other_input_path ), "%s/cache_other.raw", dir );
+   snprintf( cache_dir, sizeof( cache_dir ), "%s/prob_cache", dir );
+   snprintf( expected_path, sizeof( expected_path ), "%s/cache_expected.out", dir );
+   snprintf( output_path, sizeof( output_path ), "%s/cache.out", dir );
+   mkdir( cache_dir, 0755 );
+
+   size_t sample_count = 10 * HARDCODED_SAMPLE_RATE;
+   short *samples = malloc( sample_count * sizeof( short ) );
+   test_synthesize_audio( samples, sample_count, 440 );
+   b32 pass = test_write_file( input_path, samples, sample_count * sizeof( short ) );
+   samples[sample_count / 2] ^= 1;
+   pass = pass && test_write_file( other_input_path, samples, sample_count * sizeof( short ) );
+   free( samples );
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   TemporaryMemory mark = beginTemporaryMemory( debug_arena );
+   vadc_prob_cache_set_dir( cache_dir );
+
+   // NOTE: the key the runs below use, from the backend the way run_inference_on_backend gets it
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+   void *backend = backend_init( debug_arena, String8FromCString( TEST_RUN_MODEL_PATH ), &config );
+   pass = pass && backend && config.model_file_hash;
+   if ( backend )
+   {
+      silero_config_finalize( &config, 1, TEST_RUN_SEQUENCE_COUNT );
+      backend_release( backend );
+   }
+   u64 model_hash = config.model_file_hash;
+   u32 sequence_count = (u32)config.input_count;
+   const char *runtime_version = backend_runtime_version();
+
+   String8 filename = String8FromCString( input_path );
+   for ( int raw = 0; raw < 2 && pass; ++raw )
+   {
+      VADC_Options options = test_run_options();
+      options.raw_probabilities = raw;
+      options.output_format = raw ? Segment_Output_Format_Float32 : Segment_Output_Format_Seconds;
+
+      VADC_Prob_Cache cache;
+      if ( raw == 0 )
+      {
+         pass = !vadc_prob_cache_open( &cache, cache_dir, model_hash, runtime_version, input_path, sequence_count, HARDCODED_SAMPLE_RATE, 0, 0.0f );
+         vadc_prob_cache_close( &cache );
+      }
+      pass = pass && test_run_file( debug_arena, &options, filename, expected_path ) == 0;
+      pass = pass && vadc_prob_cache_open( &cache, cache_dir, model_hash, runtime_version, input_path, sequence_count, HARDCODED_SAMPLE_RATE, 0, 0.0f );
+      vadc_prob_cache_close( &cache );
+
+      pass = pass && test_run_file( debug_arena, &options, filename, output_path ) == 0 &&
+             test_file_size( expected_path ) > 0 && test_files_equal( expected_path, output_path );
+   }
+
+   // NOTE: the hit really comes from the file: with its probabilities all 1 the whole input is speech
+   VADC_Prob_Cache cache;
+   pass = pass && vadc_prob_cache_open( &cache, cache_dir, model_hash, runtime_version, input_path, sequence_count, HARDCODED_SAMPLE_RATE, 0, 0.0f );
+   u64 window_count = cache.key.window_count;
+   char cache_path[sizeof( cache.path )];
+   memcpy( cache_path, cache.path, sizeof( cache_path ) );
+   vadc_prob_cache_close( &cache );
+   if ( pass )
+   {
+      size_t cache_size = 0;
+      u8 *cache_bytes = test_read_file( cache_path, &cache_size );
+      pass = cache_bytes && cache_size == sizeof( VADC_Prob_Cache_Header ) + window_count * sizeof( float );
+      for ( u64 i = 0; pass && i < window_count; ++i )
+      {
+         float one = 1.0f;
+         memcpy( cache_bytes + sizeof( VADC_Prob_Cache_Header ) + i * sizeof( float ), &one, sizeof( one ) );
+      }
+      pass = pass && test_write_file( cache_path, cache_bytes, cache_size );
+      free( cache_bytes );
+
+      VADC_Options options = test_run_options();
+      options.output_format = Segment_Output_Format_Float32;
+      size_t segments_size = 0;
+      pass = pass && test_run_file( debug_arena, &options, filename, output_path ) == 0;
+      float *segments = (float *)test_read_file( output_path, &segments_size );
+      pass = pass && segments && segments_size == 2 * sizeof( float ) && segments[0] == 0.0f;
+      free( segments );
+   }
+
+   // NOTE: any other part of the key misses
+   struct
+   {
+      u64 model_hash;
+      const char *runtime_version;
+      const char *audio_path;
+      u32 sequence_count;
+      s32 audio_source;
+      float start_seconds;
+   } other_keys[] =
+   {
+      { model_hash + 1, runtime_version, input_path, sequence_count, 0, 0.0f },
+      { model_hash, "another runtime", input_path, sequence_count, 0, 0.0f },
+      { model_hash, runtime_version, other_input_path, sequence_count, 0, 0.0f },
+      { model_hash, runtime_version, input_path, sequence_count * 2, 0, 0.0f },
+      { model_hash, runtime_version, input_path, sequence_count, 1, 0.0f },
+      { model_hash, runtime_version, input_path, sequence_count, 0, 1.0f },
+   };
+   for ( int i = 0; i < (int)ArrayCount( other_keys ) && pass; ++i )
+   {
+      pass = !vadc_prob_cache_open( &cache, cache_dir, other_keys[i].model_hash, other_keys[i].runtime_version, other_keys[i].audio_path,
+                                    other_keys[i].sequence_count, HARDCODED_SAMPLE_RATE, other_keys[i].audio_source, other_keys[i].start_seconds );
+      vadc_prob_cache_close( &cache );
+   }
+
+   // NOTE: a run of the other input doesn't pick up the first one's (tampered) probabilities
+   if ( pass )
+   {
+      VADC_Options options = test_run_options();
+      vadc_prob_cache_set_dir( NULL );
+      pass = test_run_file( debug_arena, &options, String8FromCString( other_input_path ), expected_path ) == 0;
+      vadc_prob_cache_set_dir( cache_dir );
+      pass = pass && test_run_file( debug_arena, &options, String8FromCString( other_input_path ), output_path ) == 0 &&
+             test_files_equal( expected_path, output_path );
+   }
+
+   vadc_prob_cache_set_dir( NULL );
+   endTemporaryMemory( mark );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+#if ONNX_INFERENCE_ENABLED
+
+// NOTE: the stub runtime some CI builds link against has no API, the ONNX tests skip there
+static b32 test_onnx_runtime_usable( void )
+{
+   const OrtApiBase *base = OrtGetApiBase();
+   return base && base->GetApi( ORT_API_VERSION ) != NULL;
+}
+
+// NOTE: v4 has a dynamic batch on its input and its lstm state, the batch engine needs both
+#define TEST_BATCH_MODEL_PATH VADC_MODELS_DIR "silero_vad_v4.onnx"
+
+typedef struct Test_Batch_Stream Test_Batch_Stream;
+struct Test_Batch_Stream
+{
+   float *probabilities;
+   int window_count;
+   int received_count;
+   b32 out_of_order;
+};
+
+static void test_batch_callback( VadcBatchStream *stream, void *user_data, int64_t window_index, float probability )
+{
+   VAR_UNUSED( stream );
+   Test_Batch_Stream *test_stream = user_data;
+   if ( window_index != test_stream->received_count || window_index >= test_stream->window_count )
+   {
+      test_stream->out_of_order = 1;
+   }
+   else
+   {
+      test_stream->probabilities[window_index] = probability;
+   }
+   ++test_stream->received_count;
+}
+
+// NOTE: streams interleaved through one engine, in batches that mix streams and windows, give the
+//       probabilities each stream gets on its own through a frame wrapper
+TestResult batch_engine_test()
+{
+   if ( !test_onnx_runtime_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   TemporaryMemory mark = beginTemporaryMemory( debug_arena );
+
+   enum { stream_count = 5, window_count = 60 };
+
+   VadcBatchEngine *engine = vadc_batch_engine_create( TEST_BATCH_MODEL_PATH, 3, 500 );
+   Assert( engine );
+   int window_samples = vadc_batch_engine_window_samples( engine );
+
+   short *audio[stream_count];
+   Test_Batch_Stream test_streams[stream_count] = {0};
+   VadcBatchStream *streams[stream_count];
+   for ( int stream_index = 0; stream_index < stream_count; ++stream_index )
+   {
+      audio[stream_index] = pushArray( debug_arena, window_count * window_samples, short );
+      test_synthesize_audio( audio[stream_index], window_count * window_samples, 100 + stream_index );
+      test_streams[stream_index].probabilities = pushArray( debug_arena, window_count, float );
+      test_streams[stream_index].window_count = window_count;
+      streams[stream_index] = vadc_batch_stream_open( engine, test_batch_callback, test_streams + stream_index );
+      Assert( streams[stream_index] );
+   }
+
+   // NOTE: uneven submission, so batches hold some streams more often than others
+   for ( int window_index = 0; window_index < window_count; ++window_index )
+   {
+      for ( int stream_index = 0; stream_index < stream_count; ++stream_index )
+      {
+         if ( (window_index + stream_index) % 4 == 3 )
+         {
+            vadc_batch_engine_flush( engine );
+         }
+         int result = vadc_batch_submit( streams[stream_index], audio[stream_index] + window_index * window_samples, window_samples );
+         Assert( result == 0 );
+      }
+   }
+
+   for ( int stream_index = 0; stream_index < stream_count; ++stream_index )
+   {
+      vadc_batch_stream_close( streams[stream_index] );
+   }
+   vadc_batch_engine_destroy( engine );
+
+   VadcModel *model = vadc_model_load( TEST_BATCH_MODEL_PATH );
+   Assert( model );
+
+   TestResult test_result = {0};
+   test_result.pass = 1;
+   test_result.atol = 1e-4f;
+   for ( int stream_index = 0; stream_index < stream_count; ++stream_index )
+   {
+      Test_Batch_Stream *test_stream = test_streams + stream_index;
+      if ( test_stream->out_of_order || test_stream->received_count != window_count )
+      {
+         test_result.pass = 0;
+         test_result.error_magnitude = TestErrorMagnitude_Above_1;
+         break;
+      }
+
+      float *expected = pushArray( debug_arena, window_count, float );
+      VadcWrapper *wrapper = vadc_wrapper_create_shared( model );
+      Assert( wrapper );
+      for ( int window_index = 0; window_index < window_count; ++window_index )
+      {
+         vadc_wrapper_process_frame( wrapper, audio[stream_index] + window_index * window_samples, window_samples, expected + window_index );
+      }
+      vadc_wrapper_destroy( wrapper );
+
+      TestResult stream_result = all_close( test_stream->probabilities, expected, window_count, test_result.atol );
+      if ( stream_result.max_error > test_result.max_error )
+      {
+         test_result.max_error = stream_result.max_error;
+         test_result.error_magnitude = stream_result.error_magnitude;
+      }
+      test_result.pass = test_result.pass && stream_result.pass;
+   }
+
+   vadc_model_release( model );
+
+   endTemporaryMemory( mark );
+
+   return test_result;
+}
+
+#define TEST_STREAM_SEGMENTS_MAX 256
+
+typedef struct Test_Stream_Segments Test_Stream_Segments;
+struct Test_Stream_Segments
+{
+   s64 segments[TEST_STREAM_SEGMENTS_MAX][2];
+   int segment_count;
+   s64 open_start;
+   b32 open;
+   // NOTE: a start without an end, an end without its start or more segments than fit
+   b32 broken;
+};
+
+static void test_stream_on_start( void *user_data, int64_t start_sample )
+{
+   Test_Stream_Segments *segments = user_data;
+   if ( segments->open )
+   {
+      segments->broken = 1;
+   }
+   segments->open = 1;
+   segments->open_start = start_sample;
+}
+
+static void test_stream_on_end( void *user_data, int64_t start_sample, int64_t end_sample )
+{
+   Test_Stream_Segments *segments = user_data;
+   if ( !segments->open || segments->open_start != start_sample || segments->segment_count == TEST_STREAM_SEGMENTS_MAX )
+   {
+      segments->broken = 1;
+      return;
+   }
+   segments->open = 0;
+   segments->segments[segments->segment_count][0] = start_sample;
+   segments->segments[segments->segment_count][1] = end_sample;
+   ++segments->segment_count;
+}
+
+static int test_ms_to_chunks( float ms, float chunk_ms )
+{
+   int chunks = (int)(ms / chunk_ms + 0.5f);
+   return chunks < 1 ? 1 : chunks;
+}
+
+// NOTE: the CLI's way of cutting segments, all probabilities known up front: feed_probability, merge
+//       what the padding joins, close the speech still running at the end
+static void test_offline_segments( float *probabilities, int count, VadcStreamParams params, int window_samples,
+                                   s64 samples_total, Test_Stream_Segments *out )
+{
+   const float chunk_ms = window_samples / (float)HARDCODED_SAMPLE_RATE * 1000.0f;
+   const float spc = (float)window_samples / HARDCODED_SAMPLE_RATE;
+   const int min_speech_chunks = test_ms_to_chunks( params.min_speech_ms, chunk_ms );
+   const int min_silence_chunks = test_ms_to_chunks( params.min_silence_ms, chunk_ms );
+   const s64 pad_samples = (s64)(params.speech_pad_ms * HARDCODED_SAMPLE_RATE / 1000.0f + 0.5f);
+
+   FeedState state = {0};
+   FeedProbabilityResult buffered = {0};
+   FeedProbabilityResult finished_segments[TEST_STREAM_SEGMENTS_MAX];
+   int finished_count = 0;
+   for ( int chunk_index = 0; chunk_index < count; ++chunk_index )
+   {
+      FeedProbabilityResult feed_result = feed_probability( &state, min_silence_chunks, min_speech_chunks, probabilities[chunk_index],
+                                                            params.threshold, params.neg_threshold, chunk_index );
+      if ( feed_result.is_valid )
+      {
+         FeedProbabilityResult finished = {0};
+         buffered = combine_speech_segment( buffered, feed_result, params.speech_pad_ms, spc, &finished );
+         if ( finished.is_valid && finished_count < TEST_STREAM_SEGMENTS_MAX )
+         {
+            finished_segments[finished_count++] = finished;
+         }
+      }
+   }
+   if ( state.triggered && count - state.current_speech_start > min_speech_chunks )
+   {
+      FeedProbabilityResult final_segment = {0};
+      final_segment.is_valid = 1;
+      final_segment.speech_start = state.current_speech_start;
+      final_segment.speech_end = count;
+
+      FeedProbabilityResult finished = {0};
+      buffered = combine_speech_segment( buffered, final_segment, params.speech_pad_ms, spc, &finished );
+      if ( finished.is_valid && finished_count < TEST_STREAM_SEGMENTS_MAX )
+      {
+         finished_segments[finished_count++] = finished;
+      }
+   }
+   if ( buffered.is_valid && finished_count < TEST_STREAM_SEGMENTS_MAX )
+   {
+      finished_segments[finished_count++] = buffered;
+   }
+
+   for ( int i = 0; i < finished_count; ++i )
+   {
+      s64 start_sample = (s64)finished_segments[i].speech_start * window_samples - pad_samples;
+      s64 end_sample = (s64)finished_segments[i].speech_end * window_samples + pad_samples;
+      test_stream_on_start( out, start_sample < 0 ? 0 : start_sample );
+      test_stream_on_end( out, start_sample < 0 ? 0 : start_sample, end_sample > samples_total ? samples_total : end_sample );
+   }
+}
+
+static b32 test_stream_segments_equal( Test_Stream_Segments *left, Test_Stream_Segments *right )
+{
+   if ( left->broken || right->broken || left->open || right->open || left->segment_count != right->segment_count )
+   {
+      return 0;
+   }
+   return memcmp( left->segments, right->segments, left->segment_count * sizeof(left->segments[0]) ) == 0;
+}
+
+// NOTE: the streaming API reports the segments the CLI would cut from the same probabilities, whatever
+//       the push sizes and windows per run, each start followed by exactly one end
+TestResult stream_segments_test()
+{
+   if ( !test_onnx_runtime_usable() )
+   {
+      return test_unavailable( "ONNX Runtime unavailable" );
+   }
+
+   MemoryArena *debug_arena = DEBUG_getDebugArena();
+   TemporaryMemory mark = beginTemporaryMemory( debug_arena );
+
+   VadcModel *model = vadc_model_load( TEST_BATCH_MODEL_PATH );
+   Assert( model );
+
+   const size_t sample_count = 40 * HARDCODED_SAMPLE_RATE + 300;
+   short *audio = pushArray( debug_arena, sample_count, short );
+   test_synthesize_audio( audio, sample_count, 7 );
+
+   VadcStreamParams params;
+   vadc_stream_params_default( &params );
+   // NOTE: lower than the defaults so the synthetic voice is cut into several segments
+   params.threshold = 0.3f;
+   params.neg_threshold = 0.15f;
+
+   VadcWrapper *wrapper = vadc_wrapper_create_shared( model );
+   Assert( wrapper );
+   const int window_samples = vadc_wrapper_frame_samples();
+   const int window_count = (int)(sample_count / window_samples);
+   float *probabilities = pushArray( debug_arena, window_count, float );
+   for ( int window_index = 0; window_index < window_count; ++window_index )
+   {
+      vadc_wrapper_process_frame( wrapper, audio + (size_t)window_index * window_samples, window_samples, probabilities + window_index );
+   }
+   vadc_wrapper_destroy( wrapper );
+
+   Test_Stream_Segments *expected = pushStruct( debug_arena, Test_Stream_Segments );
+   test_offline_segments( probabilities, window_count, params, window_samples, (s64)sample_count, expected );
+
+   b32 pass = !expected->broken;
+   for ( int max_batch = 1; max_batch <= 4; max_batch += 3 )
+   {
+      params.max_batch = max_batch;
+
+      Test_Stream_Segments *streamed = pushStruct( debug_arena, Test_Stream_Segments );
+      VadcStream *stream = vadc_stream_create( model, &params, test_stream_on_start, test_stream_on_end, streamed );
+      Assert( stream );
+
+      u32 random_state = 99u + max_batch;
+      size_t position = 0;
+      while ( position < sample_count )
+      {
+         random_state = random_state * 1664525u + 1013904223u;
+         size_t push_count = 1 + (random_state >> 8) % 3000;
+         if ( push_count > sample_count - position )
+         {
+            push_count = sample_count - position;
+         }
+         vadc_stream_push( stream, audio + position, push_count );
+         position += push_count;
+      }
+      vadc_stream_finish( stream );
+      vadc_stream_destroy( stream );
+
+      pass = pass && test_stream_segments_equal( streamed, expected );
+   }
+
+   vadc_model_release( model );
+
+   endTemporaryMemory( mark );
+
+   TestResult test_result = {0};
+   test_result.pass = pass;
+   return test_result;
+}
+
+#endif // ONNX_INFERENCE_ENABLED
+
+static const char *result_strings[] =
+{
+   "FAIL",
+   "PASS"
+};
+
+typedef TestResult ( *TestFunction )();
+
+typedef struct TestFunctionDescription TestFunctionDescription;
+
+struct TestFunctionDescription
+{
+   TestFunction function_pointer;
+   const char *test_name;
+   // NOTE: wall time the test may take, fixture loading included. Generous enough for a debug build
+   //       on a slow ARM board, meant to catch an order of magnitude regression, not to benchmark.
+   double budget_ms;
+};
+
+#define TEST_FUNCTION_DESCRIPTION( test_function, budget_ms ) \
+   { test_function, VADC_TOSTRING( test_function ), budget_ms }
+
+TestFunctionDescription test_function_descriptions[] =
+{
+   TEST_FUNCTION_DESCRIPTION( dw_conv_129_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( pw_conv_129_16_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( first_layer_conv_block_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( decoder_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( transpose2d_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( softmax_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( layer_norm_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( batch_norm_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( dual_head_attention_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( transformer_block_16_16_48_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( transformer_first_layer_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( transformer_layers_1_2_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( transformer_layers_3_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( transformer_layers_1_2_3_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( transformer_layers_1_2_3_4_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( adaptive_normalization_encoder_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( stft_normalization_encoder_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( stft_normalization_encoder_lstm_test, 500.0 ),
+   TEST_FUNCTION_DESCRIPTION( stft_normalization_encoder_lstm_decoder_test, 500.0 ),
+   TEST_FUNCTION_DESCRIPTION( silero_test, 1000.0 ),
+   TEST_FUNCTION_DESCRIPTION( stft_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( adaptive_audio_normalization_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( lstm_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( lstm_test_RED, 2000.0 ),
+   TEST_FUNCTION_DESCRIPTION( lstm_test_RED_new, 2000.0 ),
+   TEST_FUNCTION_DESCRIPTION( lstm_test_RED_1layer, 2000.0 ),
+
+   // NOTE: the RED600 fixtures are recorded audio instead of small random tensors, they get more room
+   TEST_FUNCTION_DESCRIPTION( stft_test_v5, 2000.0 ),
+   TEST_FUNCTION_DESCRIPTION( v5_reparam_conv_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( v5_reparam_conv2_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( v5_reparam_conv3_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( v5_reparam_conv4_test, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( lstm_test_RED_v5, 2000.0 ),
+   TEST_FUNCTION_DESCRIPTION( decoder_test_v5, 25.0 ),
+   TEST_FUNCTION_DESCRIPTION( silero_v5_test, 10000.0 ),
+
+   // NOTE: behaviour tests
+   TEST_FUNCTION_DESCRIPTION( worker_pool_test, 10000.0 ),
+   TEST_FUNCTION_DESCRIPTION( energy_gate_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( gate_arena_estimate_test, 10000.0 ),
+   TEST_FUNCTION_DESCRIPTION( sweep_step_test, 500.0 ),
+   TEST_FUNCTION_DESCRIPTION( sweep_files_test, 10000.0 ),
+   TEST_FUNCTION_DESCRIPTION( event_tracker_test, 500.0 ),
+   TEST_FUNCTION_DESCRIPTION( output_writer_test, 1000.0 ),
+   TEST_FUNCTION_DESCRIPTION( output_writer_batch_test, 10000.0 ),
+   TEST_FUNCTION_DESCRIPTION( speech_extract_test, 10000.0 ),
+   TEST_FUNCTION_DESCRIPTION( audio_sink_test, 5000.0 ),
+   TEST_FUNCTION_DESCRIPTION( log_format_test, 100.0 ),
+   TEST_FUNCTION_DESCRIPTION( log_ring_test, 1000.0 ),
+   TEST_FUNCTION_DESCRIPTION( checkpoint_resume_test, 10000.0 ),
+   TEST_FUNCTION_DESCRIPTION( prob_cache_test, 10000.0 ),
+
+#if ONNX_INFERENCE_ENABLED
+   TEST_FUNCTION_DESCRIPTION( batch_engine_test, 5000.0 ),
+   TEST_FUNCTION_DESCRIPTION( stream_segments_test, 5000.0 ),
+#endif // ONNX_INFERENCE_ENABLED
+};
+
+// NOTE: returns 1 if any test failed or went over its budget, so CTest fails the build
+// int main(int argc, char *argv[])
+int main()
+{
+   int failed_count = 0;
+   int passed_count = 0;
+   int skipped_count = 0;
+
+   int test_count = ArrayCount( test_function_descriptions );
+   fprintf( stderr, "Total tests to run: %d\n", test_count );
+
+   for ( int i = 0; i < test_count; ++i )
+   {
+      TestFunctionDescription *desc = test_function_descriptions + i;
+
+      s64 start_ns = vadc_now_ns();
+      TestResult result = desc->function_pointer();
+      double elapsed_ms = (vadc_now_ns() - start_ns) / 1e6;
+
+      if ( result.skipped )
+      {
+         ++skipped_count;
+         fprintf( stderr, "%-44s %s ... SKIP\n", desc->test_name,
+                  result.skip_reason ? result.skip_reason : "untracked fixture missing" );
+         continue;
+      }
+      if ( result.fixture_missing )
+      {
+         ++failed_count;
+         fprintf( stderr, "%-44s tracked fixture missing ... FAIL\n", desc->test_name );
+         continue;
+      }
 
-      all_pass &= result.pass;
-      passed_count += !!result.pass;
-      failed_count += !result.pass;
+      b32 in_budget = elapsed_ms <= desc->budget_ms;
+      b32 pass = result.pass && in_budget;
+      passed_count += !!pass;
+      failed_count += !pass;
 
-      fprintf( stderr, "%-34s max error magnitude: %-6s", desc->test_name, test_error_magnitude_names[result.error_magnitude] );
-      fprintf( stderr, " ... %s\n", result_strings[!!result.pass] );
+      fprintf( stderr, "%-44s max error magnitude: %-7s (atol %g) %9.3f ms / %6.0f ms", desc->test_name,
+               test_error_magnitude_names[result.error_magnitude], result.atol, elapsed_ms, desc->budget_ms );
+      fprintf( stderr, " ... %s%s\n", result_strings[!!pass], in_budget ? "" : " (over budget)" );
    }
 
    fprintf( stderr, "\n---\n" );
-   if ( all_pass )
+   if ( failed_count == 0 )
    {
-      fprintf( stderr, "All %d tests PASSED!\n", test_count );
+      fprintf( stderr, "All %d tests PASSED! (%d skipped)\n", passed_count, skipped_count );
    }
    else
    {
-      fprintf( stderr, "%d out of %d tests FAILED!\n", failed_count, test_count );
+      fprintf( stderr, "%d out of %d tests FAILED! (%d skipped)\n", failed_count, passed_count + failed_count, skipped_count );
    }
 
+   test_remove_run_dir();
 
-   return 0;
+   return failed_count ? 1 : 0;
 }
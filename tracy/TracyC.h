@@ -1,8 +1,44 @@
 #pragma once
 
-/* Stub Tracy profiler - disabled on non-Windows builds */
+/* Tracy profiler switch. Builds with TRACY_ENABLE defined (cmake -DVADC_PROFILE=ON)
+   get the real client API from tracy/TracyC.h, everything else gets no-op stubs. */
+#ifdef TRACY_ENABLE
+
+#include "tracy/TracyC.h"
+
+/* not part of Tracy, kept for the kernels that pair it with TracyCZoneC */
+#ifndef TracyCZoneEndC
+#define TracyCZoneEndC(name) TracyCZoneEnd(name)
+#endif
+
+#elif defined(VADC_ZONES) && VADC_ZONES
+
+/* cmake -DVADC_ZONES=ON: zones become cycle counter timers aggregated per call path and written as
+   folded stacks at exit (zones.h), everything else stays a no-op */
+#include "zones.h"
+
+#define TracyCZone(name, active) Vadc_Zone name = vadc_zone_begin(__func__)
+#define TracyCZoneN(name, label, active) Vadc_Zone name = vadc_zone_begin(label)
+#define TracyCZoneEnd(name) vadc_zone_end(&name)
+#define TracyCZoneC(name, color, active) Vadc_Zone name = vadc_zone_begin(__func__)
+#define TracyCZoneEndC(name) vadc_zone_end(&name)
+#define TracyCZoneValue(name, value) do { } while(0)
+#define TracyCFrameMark do { } while(0)
+#define TracyCFrameMarkNamed(name) do { } while(0)
+#define TracyCPlot(name, value) do { } while(0)
+#define TracyCSetThreadName(name) do { } while(0)
+
+#else
+
 #define TracyCZone(name, active) do { } while(0)
+#define TracyCZoneN(name, label, active) do { } while(0)
 #define TracyCZoneEnd(name) do { } while(0)
 #define TracyCZoneC(name, color, active) do { } while(0)
 #define TracyCZoneEndC(name) do { } while(0)
+#define TracyCZoneValue(name, value) do { } while(0)
+#define TracyCFrameMark do { } while(0)
+#define TracyCFrameMarkNamed(name) do { } while(0)
+#define TracyCPlot(name, value) do { } while(0)
+#define TracyCSetThreadName(name) do { } while(0)
 
+#endif
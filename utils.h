@@ -4,6 +4,7 @@
 #include <stdio.h> //fprintf, stderr
 #include <string.h> //memcpy, memset
 #include <assert.h> //assert
+#include <time.h> //clock_gettime
 
 typedef uint8_t u8;
 typedef int8_t s8;
@@ -71,3 +72,12 @@ typedef int32_t b32;
 #endif // !defined(NDEBUG)
 
 #define ArrayCount(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+// NOTE: monotonic clock in nanoseconds, for intervals, deadlines and timestamps within one process
+static inline s64 vadc_now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (s64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
@@ -8,13 +8,27 @@
 #include <time.h>
 #include <sys/stat.h>
 #include <stdarg.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "string8.c"
+#include "metrics.c"
+#include "energy_gate.c"
+#include "prob_cache.c"
+#include "output_writer.c"
+#include "speech_extract.c"
+#include "audio_sink.c"
+#include "logger.c"
+#include "checkpoint.c"
 
 #include "utils.h"
 
+#include <TracyC.h>
+
 #if ONNX_INFERENCE_ENABLED
 #include "onnx_helpers.c"
+#include "silero_c.h"
 #else
 #include "silero.h"
 #endif // ONNX_INFERENCE_ENABLED
@@ -23,26 +37,15 @@
 #define MEMORY_IMPLEMENTATION
 #include "memory.h"
 
+#if defined(VADC_ZONES) && VADC_ZONES && !defined(TRACY_ENABLE)
+#define ZONES_IMPLEMENTATION
+#include "zones.h"
+#endif
+
 #ifndef DEBUG_WRITE_STATE_TO_FILE
 #define DEBUG_WRITE_STATE_TO_FILE 0
 #endif
 
-// 全局变量用于日志和音频保存
-static FILE *g_audio_output_file = NULL;
-static FILE *g_log_file = NULL;
-static FILE *g_speech_audio_file = NULL;      // 说话音频文件
-static FILE *g_noise_audio_file = NULL;       // 噪音音频文件
-static FILE *g_speech_playback_pipe = NULL;   // 说话实时播放管道
-static FILE *g_noise_playback_pipe = NULL;    // 噪音实时播放管道
-static b32 g_save_audio = 0;
-static b32 g_save_speech_audio = 0;           // 单独保存说话
-static b32 g_save_noise_audio = 0;            // 单独保存噪音
-static b32 g_play_speech_audio = 0;           // 实时播放说话
-static b32 g_play_noise_audio = 0;            // 实时播放噪音
-static b32 g_verbose_logging = 0;
-static int g_current_speech_event = 0;
-
-
 // TODO(irwin):
 // - move win32-specific stuff to separate file
 
@@ -70,133 +73,144 @@ static FILE *getDebugFile()
 
 
 // 日志输出函数
-static void vad_log(const char *format, ...)
+// NOTE: formatted and written by the logger's flusher thread, see logger.h. format must be a literal.
+static void vad_log_at(VADC_Run *run, VADC_Log_Level level, const char *format, ...)
 {
    va_list args;
    va_start(args, format);
-   
-   // 输出到 stderr
-   vfprintf(stderr, format, args);
-   fprintf(stderr, "\n");
-   fflush(stderr);
-   
-   // 如果启用了日志文件，也输出到文件
-   if (g_log_file)
-   {
-      vfprintf(g_log_file, format, args);
-      fprintf(g_log_file, "\n");
-      fflush(g_log_file);
-   }
-   
+   vadc_log_write(level, run->log_file, format, args);
+   va_end(args);
+}
+
+#define vad_log(run, ...) vad_log_at(run, VADC_Log_Info, __VA_ARGS__)
+
+// NOTE: like vad_log_at, but to stderr only, not the --save_log file. Through the logger too, so the line
+//       keeps its place among the logged ones.
+static void vad_log_stderr(VADC_Log_Level level, const char *format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   vadc_log_write(level, NULL, format, args);
    va_end(args);
 }
 
 // 初始化音频和日志输出文件
-static void init_audio_logging(const char *audio_output_file, const char *log_output_file)
+static void init_audio_logging(VADC_Run *run, const char *audio_output_file, const char *log_output_file)
 {
    if (audio_output_file)
    {
-      g_audio_output_file = fopen(audio_output_file, "wb");
-      if (g_audio_output_file)
+      run->audio_output_file = fopen(audio_output_file, "wb");
+      if (run->audio_output_file)
       {
-         g_save_audio = 1;
-         vad_log("✓ 音频将保存到: %s", audio_output_file);
+         run->save_audio = 1;
+         vad_log(run, "✓ 音频将保存到: %s", audio_output_file);
       }
       else
       {
-         vad_log("✗ 无法打开音频文件: %s", audio_output_file);
+         vad_log_at(run, VADC_Log_Warn, "✗ 无法打开音频文件: %s", audio_output_file);
       }
    }
    
    if (log_output_file)
    {
-      g_log_file = fopen(log_output_file, "w");
-      if (g_log_file)
+      run->log_file = fopen(log_output_file, "w");
+      if (run->log_file)
       {
-         vad_log("✓ 日志将保存到: %s", log_output_file);
+         vad_log(run, "✓ 日志将保存到: %s", log_output_file);
       }
       else
       {
-         vad_log("✗ 无法打开日志文件: %s", log_output_file);
+         vad_log_at(run, VADC_Log_Warn, "✗ 无法打开日志文件: %s", log_output_file);
       }
    }
 }
 
 // 初始化分离保存说话和噪音的文件
-static void init_separated_audio_logging(const char *speech_audio_file, const char *noise_audio_file)
+static void init_separated_audio_logging(VADC_Run *run, const char *speech_audio_file, const char *noise_audio_file)
 {
    if (speech_audio_file)
    {
-      g_speech_audio_file = fopen(speech_audio_file, "wb");
-      if (g_speech_audio_file)
+      run->speech_audio_file = fopen(speech_audio_file, "wb");
+      if (run->speech_audio_file)
       {
-         g_save_speech_audio = 1;
-         vad_log("✓ 说话音频将保存到: %s", speech_audio_file);
+         run->save_speech_audio = 1;
+         vad_log(run, "✓ 说话音频将保存到: %s", speech_audio_file);
       }
       else
       {
-         vad_log("✗ 无法打开说话音频文件: %s", speech_audio_file);
+         vad_log_at(run, VADC_Log_Warn, "✗ 无法打开说话音频文件: %s", speech_audio_file);
       }
    }
    
    if (noise_audio_file)
    {
-      g_noise_audio_file = fopen(noise_audio_file, "wb");
-      if (g_noise_audio_file)
+      run->noise_audio_file = fopen(noise_audio_file, "wb");
+      if (run->noise_audio_file)
       {
-         g_save_noise_audio = 1;
-         vad_log("✓ 噪音音频将保存到: %s", noise_audio_file);
+         run->save_noise_audio = 1;
+         vad_log(run, "✓ 噪音音频将保存到: %s", noise_audio_file);
       }
       else
       {
-         vad_log("✗ 无法打开噪音音频文件: %s", noise_audio_file);
+         vad_log_at(run, VADC_Log_Warn, "✗ 无法打开噪音音频文件: %s", noise_audio_file);
       }
    }
 }
 
 // 清理日志和音频文件
-static void cleanup_audio_logging(void)
+static void cleanup_audio_logging(VADC_Run *run)
 {
-   if (g_audio_output_file)
+   // NOTE: before the files close, the I/O threads still write out what is queued
+   b32 sinks_were_running = run->audio_sinks.running;
+   vadc_audio_sinks_stop(&run->audio_sinks);
+   unsigned long long sink_dropped_bytes = atomic_load(&run->audio_sinks.dropped_bytes);
+   if (sinks_were_running && sink_dropped_bytes)
+   {
+      fprintf(stderr, "Warning: %.2fs of audio output dropped, the audio sinks could not keep up\n",
+              (double)sink_dropped_bytes / (sizeof(short) * HARDCODED_SAMPLE_RATE));
+   }
+
+   if (run->audio_output_file)
    {
-      fclose(g_audio_output_file);
-      g_audio_output_file = NULL;
+      fclose(run->audio_output_file);
+      run->audio_output_file = NULL;
    }
-   if (g_log_file)
+   if (run->log_file)
    {
-      fclose(g_log_file);
-      g_log_file = NULL;
+      vadc_log_flush();
+      fclose(run->log_file);
+      run->log_file = NULL;
    }
-   if (g_speech_audio_file)
+   if (run->speech_audio_file)
    {
-      fclose(g_speech_audio_file);
-      g_speech_audio_file = NULL;
+      fclose(run->speech_audio_file);
+      run->speech_audio_file = NULL;
    }
-   if (g_noise_audio_file)
+   if (run->noise_audio_file)
    {
-      fclose(g_noise_audio_file);
-      g_noise_audio_file = NULL;
+      fclose(run->noise_audio_file);
+      run->noise_audio_file = NULL;
    }
-   if (g_speech_playback_pipe)
+   if (run->speech_playback_pipe)
    {
-      pclose(g_speech_playback_pipe);
-      g_speech_playback_pipe = NULL;
+      pclose(run->speech_playback_pipe);
+      run->speech_playback_pipe = NULL;
    }
-   if (g_noise_playback_pipe)
+   if (run->noise_playback_pipe)
    {
-      pclose(g_noise_playback_pipe);
-      g_noise_playback_pipe = NULL;
+      pclose(run->noise_playback_pipe);
+      run->noise_playback_pipe = NULL;
    }
 }
 
 // 初始化实时播放管道
-static void init_playback_pipes(void)
+static void init_playback_pipes(VADC_Run *run)
 {
    // 创建 aplay 进程用于实时播放说话音频
-   if (g_play_speech_audio)
+   if (run->play_speech_audio)
    {
-      g_speech_playback_pipe = popen("aplay -f S16_LE -r 16000 -c 1 2>/dev/null", "w");
-      if (g_speech_playback_pipe)
+      run->speech_playback_pipe = popen("aplay -f S16_LE -r 16000 -c 1 2>/dev/null", "w");
+      if (run->speech_playback_pipe)
       {
          fprintf(stderr, "🔊 说话音频将实时播放\n");
          fflush(stderr);
@@ -204,16 +218,16 @@ static void init_playback_pipes(void)
       else
       {
          fprintf(stderr, "⚠️  无法启动说话音频播放 (aplay 不可用?)\n");
-         g_play_speech_audio = 0;
+         run->play_speech_audio = 0;
          fflush(stderr);
       }
    }
    
    // 创建 aplay 进程用于实时播放噪音音频
-   if (g_play_noise_audio)
+   if (run->play_noise_audio)
    {
-      g_noise_playback_pipe = popen("aplay -f S16_LE -r 16000 -c 1 2>/dev/null", "w");
-      if (g_noise_playback_pipe)
+      run->noise_playback_pipe = popen("aplay -f S16_LE -r 16000 -c 1 2>/dev/null", "w");
+      if (run->noise_playback_pipe)
       {
          fprintf(stderr, "🔊 噪音音频将实时播放\n");
          fflush(stderr);
@@ -221,67 +235,446 @@ static void init_playback_pipes(void)
       else
       {
          fprintf(stderr, "⚠️  无法启动噪音音频播放 (aplay 不可用?)\n");
-         g_play_noise_audio = 0;
+         run->play_noise_audio = 0;
          fflush(stderr);
       }
    }
 }
 
+// NOTE: the audio outputs are handed to their I/O threads when there is a sink for them, see audio_sink.h
+static void start_audio_sinks(VADC_Run *run, VADC_Audio_Sink_Overflow overflow)
+{
+   vadc_audio_sinks_init(&run->audio_sinks, overflow, run->metrics);
+   FILE *files[] = { run->audio_output_file, run->speech_audio_file, run->noise_audio_file,
+                     run->speech_playback_pipe, run->noise_playback_pipe };
+   for (int i = 0; i < (int)ArrayCount(files); ++i)
+   {
+      vadc_audio_sinks_add(&run->audio_sinks, files[i]);
+   }
+   if (vadc_audio_sinks_start(&run->audio_sinks) != 0)
+   {
+      // NOTE: no threads, the outputs are written inline like before
+      vadc_audio_sinks_stop(&run->audio_sinks);
+   }
+}
+
+// NOTE: every output of a run goes through here so short writes (full disk, closed pipe) show up
+//       as dropped bytes in the metrics instead of vanishing
+static void run_write_output(VADC_Run *run, FILE *file, const void *data, size_t bytes)
+{
+   VADC_Audio_Sink *sink = vadc_audio_sinks_find(&run->audio_sinks, file);
+   if (sink)
+   {
+      vadc_audio_sink_write(&run->audio_sinks, sink, data, bytes);
+      return;
+   }
+
+   size_t written = fwrite(data, 1, bytes, file);
+   if (fflush(file) != 0 && written == bytes)
+   {
+      // NOTE: the data sat in the stdio buffer and was lost on flush, count all of it
+      written = 0;
+   }
+   if (written < bytes)
+   {
+      VADC_METRIC_ADD(run->metrics, dropped_output_bytes, bytes - written);
+   }
+}
+
+// NOTE: segments, events and probabilities, through the run's buffered writer
+static void run_write_segments(VADC_Run *run, const void *data, size_t bytes)
+{
+   size_t dropped = vadc_output_writer_write(&run->output, data, bytes);
+   if (dropped)
+   {
+      VADC_METRIC_ADD(run->metrics, dropped_output_bytes, dropped);
+   }
+}
+
+static void run_flush_segments(VADC_Run *run)
+{
+   size_t dropped = vadc_output_writer_flush(&run->output);
+   if (dropped)
+   {
+      VADC_METRIC_ADD(run->metrics, dropped_output_bytes, dropped);
+   }
+}
+
 // 播放或保存分离的音频（说话/噪音）
-static void playback_or_save_separated_audio(const short *samples, size_t count, int is_speech)
+static void playback_or_save_separated_audio(VADC_Run *run, const short *samples, size_t count, int is_speech)
 {
    if (is_speech)
    {
       // 说话音频
-      if (g_save_speech_audio && g_speech_audio_file)
+      if (run->save_speech_audio && run->speech_audio_file)
       {
-         fwrite(samples, sizeof(short), count, g_speech_audio_file);
-         fflush(g_speech_audio_file);
+         run_write_output(run, run->speech_audio_file, samples, count * sizeof(short));
       }
-      if (g_play_speech_audio && g_speech_playback_pipe)
+      if (run->play_speech_audio && run->speech_playback_pipe)
       {
-         fwrite(samples, sizeof(short), count, g_speech_playback_pipe);
-         fflush(g_speech_playback_pipe);
+         run_write_output(run, run->speech_playback_pipe, samples, count * sizeof(short));
       }
    }
    else
    {
       // 噪音音频
-      if (g_save_noise_audio && g_noise_audio_file)
+      if (run->save_noise_audio && run->noise_audio_file)
       {
-         fwrite(samples, sizeof(short), count, g_noise_audio_file);
-         fflush(g_noise_audio_file);
+         run_write_output(run, run->noise_audio_file, samples, count * sizeof(short));
       }
-      if (g_play_noise_audio && g_noise_playback_pipe)
+      if (run->play_noise_audio && run->noise_playback_pipe)
       {
-         fwrite(samples, sizeof(short), count, g_noise_playback_pipe);
-         fflush(g_noise_playback_pipe);
+         run_write_output(run, run->noise_playback_pipe, samples, count * sizeof(short));
       }
    }
 }
 
 // 写入音频数据
-static void write_audio_samples(const short *samples, size_t count)
+static void write_audio_samples(VADC_Run *run, const short *samples, size_t count)
 {
-   if (g_save_audio && g_audio_output_file)
+   if (run->save_audio && run->audio_output_file)
    {
-      fwrite(samples, sizeof(short), count, g_audio_output_file);
-      fflush(g_audio_output_file);
+      run_write_output(run, run->audio_output_file, samples, count * sizeof(short));
    }
 }
 
 // 根据是否是说话来写入分离的音频
-static void write_separated_audio_samples(const short *samples, size_t count, b32 is_speech)
+static void write_separated_audio_samples(VADC_Run *run, const short *samples, size_t count, b32 is_speech)
+{
+   if (is_speech && run->save_speech_audio && run->speech_audio_file)
+   {
+      run_write_output(run, run->speech_audio_file, samples, count * sizeof(short));
+   }
+   else if (!is_speech && run->save_noise_audio && run->noise_audio_file)
+   {
+      run_write_output(run, run->noise_audio_file, samples, count * sizeof(short));
+   }
+}
+
+volatile sig_atomic_t vadc_stats_dump_requested = 0;
+
+static const char *vadc_stage_names[VADC_Stage_COUNT] =
+{
+   "input_wait",
+   "conversion",
+   "inference",
+   "emission",
+};
+
+static const char *vadc_startup_stage_names[VADC_Startup_COUNT] =
+{
+   "env",
+   "model_hash",
+   "session",
+   "metadata",
+   "first_probability",
+};
+
+static int vadc_histogram_bucket_index(u64 value)
+{
+   if (value < VADC_HISTOGRAM_SUB_BUCKETS)
+   {
+      return (int)value;
+   }
+
+   int msb = 63 - __builtin_clzll(value);
+   int shift = msb - VADC_HISTOGRAM_SUB_BUCKET_BITS;
+   int index = (shift + 1) * VADC_HISTOGRAM_SUB_BUCKETS + (int)((value >> shift) & (VADC_HISTOGRAM_SUB_BUCKETS - 1));
+   if (index >= VADC_HISTOGRAM_BUCKETS)
+   {
+      index = VADC_HISTOGRAM_BUCKETS - 1;
+   }
+   return index;
+}
+
+// NOTE: smallest value that lands in bucket index
+static u64 vadc_histogram_bucket_lower_bound(int index)
+{
+   if (index < VADC_HISTOGRAM_SUB_BUCKETS)
+   {
+      return (u64)index;
+   }
+
+   int shift = index / VADC_HISTOGRAM_SUB_BUCKETS - 1;
+   return (u64)(VADC_HISTOGRAM_SUB_BUCKETS + index % VADC_HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+void vadc_histogram_record(VADC_Histogram *histogram, s64 value_ns)
+{
+   u64 value = value_ns > 0 ? (u64)value_ns : 0;
+
+   histogram->counts[vadc_histogram_bucket_index(value)] += 1;
+   if (histogram->count == 0 || value < histogram->min_ns)
+   {
+      histogram->min_ns = value;
+   }
+   if (value > histogram->max_ns)
+   {
+      histogram->max_ns = value;
+   }
+   histogram->count += 1;
+   histogram->total_ns += value;
+}
+
+// NOTE: the highest value that is equivalent to the percentile's bucket, capped to the recorded maximum
+u64 vadc_histogram_percentile(const VADC_Histogram *histogram, double percentile)
+{
+   if (histogram->count == 0)
+   {
+      return 0;
+   }
+
+   u64 rank = (u64)(percentile / 100.0 * (double)histogram->count + 0.5);
+   if (rank < 1)
+   {
+      rank = 1;
+   }
+
+   u64 seen = 0;
+   for (int index = 0; index < VADC_HISTOGRAM_BUCKETS; ++index)
+   {
+      seen += histogram->counts[index];
+      if (seen >= rank)
+      {
+         u64 upper = index + 1 < VADC_HISTOGRAM_BUCKETS ? vadc_histogram_bucket_lower_bound(index + 1) - 1 : histogram->max_ns;
+         return upper < histogram->max_ns ? upper : histogram->max_ns;
+      }
+   }
+   return histogram->max_ns;
+}
+
+// NOTE: measures what a piece of code pushes on top of the arena. The outer high water mark is kept,
+//       so measurements can nest.
+typedef struct Arena_Measurement Arena_Measurement;
+struct Arena_Measurement
+{
+   MemoryArena *arena;
+   size_t used_before;
+   int temp_depth_before;
+   size_t outer_peak_used;
+   int outer_peak_temp_depth;
+   // NOTE: filled in by arena_measure_end
+   int peak_temp_depth;
+};
+
+static Arena_Measurement arena_measure_begin(MemoryArena *arena)
+{
+   Arena_Measurement measurement = {0};
+   measurement.arena = arena;
+   measurement.used_before = arena->used;
+   measurement.temp_depth_before = arena->temporaryMemoryCount;
+   measurement.outer_peak_used = arena->peak_used;
+   measurement.outer_peak_temp_depth = arena->peak_temporaryMemoryCount;
+   resetMemoryArenaPeak(arena);
+
+   return measurement;
+}
+
+// NOTE: returns the bytes pushed above the starting point at the peak
+static size_t arena_measure_end(Arena_Measurement *measurement)
+{
+   MemoryArena *arena = measurement->arena;
+   size_t peak_bytes = arena->peak_used - measurement->used_before;
+   measurement->peak_temp_depth = arena->peak_temporaryMemoryCount - measurement->temp_depth_before;
+
+   if (measurement->outer_peak_used > arena->peak_used)
+   {
+      arena->peak_used = measurement->outer_peak_used;
+   }
+   if (measurement->outer_peak_temp_depth > arena->peak_temporaryMemoryCount)
+   {
+      arena->peak_temporaryMemoryCount = measurement->outer_peak_temp_depth;
+   }
+
+   return peak_bytes;
+}
+
+static void vadc_record_stage_arena(VADC_Stats *stats, VADC_Stage stage, Arena_Measurement *measurement)
+{
+   size_t bytes = arena_measure_end(measurement);
+   if (bytes > stats->stage_arena_bytes[stage])
+   {
+      stats->stage_arena_bytes[stage] = bytes;
+   }
+}
+
+// NOTE: the run's high water mark so far, without ending its measurement
+static void vadc_record_run_arena(VADC_Stats *stats, const Arena_Measurement *measurement)
+{
+   MemoryArena *arena = measurement->arena;
+   stats->arena_peak_bytes = arena->peak_used - measurement->used_before;
+   stats->arena_peak_temp_depth = arena->peak_temporaryMemoryCount - measurement->temp_depth_before;
+}
+
+static void print_stage_latencies(VADC_Run *run, const VADC_Stats *stats)
+{
+   vad_log(run, "%-12s %10s %12s %12s %12s %12s %12s", "stage", "count", "mean_us", "p50_us", "p90_us", "p99_us", "max_us");
+   for (int stage = 0; stage < VADC_Stage_COUNT; ++stage)
+   {
+      const VADC_Histogram *histogram = stats->stage_latency + stage;
+      double mean_us = histogram->count ? (double)histogram->total_ns / (double)histogram->count / 1000.0 : 0.0;
+      vad_log(run, "%-12s %10" PRIu64 " %12.1f %12.1f %12.1f %12.1f %12.1f",
+              vadc_stage_names[stage],
+              histogram->count,
+              mean_us,
+              vadc_histogram_percentile(histogram, 50.0) / 1000.0,
+              vadc_histogram_percentile(histogram, 90.0) / 1000.0,
+              vadc_histogram_percentile(histogram, 99.0) / 1000.0,
+              histogram->max_ns / 1000.0);
+   }
+
+   vad_log(run, "arena: model %zu B, setup %zu B, peak %zu B, temp depth %d",
+           stats->arena_model_bytes, stats->arena_setup_bytes, stats->arena_peak_bytes, stats->arena_peak_temp_depth);
+   for (int stage = 0; stage < VADC_Stage_COUNT; ++stage)
+   {
+      vad_log(run, "  %-12s scratch %zu B", vadc_stage_names[stage], stats->stage_arena_bytes[stage]);
+   }
+
+   vad_log(run, "startup: metadata %s, optimized model %s",
+           stats->metadata_from_cache ? "cached" : "probed",
+           stats->optimized_model_from_cache ? "cached" : "not cached");
+   for (int stage = 0; stage < VADC_Startup_COUNT; ++stage)
+   {
+      vad_log(run, "  %-18s %10.2f ms", vadc_startup_stage_names[stage], stats->startup_ns[stage] / 1e6);
+   }
+   if (stats->prob_cache_enabled)
+   {
+      vad_log(run, "probabilities: %s", stats->prob_cache_hit ? "from the cache" : (stats->prob_cache_stored ? "computed, cached" : "computed"));
+   }
+}
+
+static void print_gate_stats(VADC_Run *run, const VADC_Stats *stats)
+{
+   double skipped_percent = stats->gate_windows ? 100.0 * stats->gate_skipped_windows / stats->gate_windows : 0.0;
+   vad_log(run, "gate (%s): skipped %" PRId64 " of %" PRId64 " windows (%.1f%%), %" PRId64 " model calls, %" PRId64 " warm-up calls",
+           vadc_gate_stage_name(stats->gate_stage),
+           stats->gate_skipped_windows, stats->gate_windows, skipped_percent, stats->gate_model_calls, stats->gate_warmup_calls);
+   if (stats->gate_first_stage_calls)
+   {
+      vad_log(run, "gate first stage: %" PRId64 " C engine calls, %.2f ms",
+              stats->gate_first_stage_calls, stats->gate_first_stage_ns / 1e6);
+   }
+   if (stats->gate_drift_measured)
+   {
+      vad_log(run, "gate drift: %d segments gated, %d ungated, %d/%d unmatched, max boundary diff %.3fs, max |p diff| %.4f",
+              stats->gate_drift_segments[0], stats->gate_drift_segments[1],
+              stats->gate_drift_unmatched[0], stats->gate_drift_unmatched[1],
+              stats->gate_drift_max_boundary_s, stats->gate_drift_max_abs_diff);
+   }
+}
+
+static void print_event_stats(VADC_Run *run, const VADC_Stats *stats)
+{
+   if (!stats->event_starts)
+   {
+      vad_log(run, "events: no speech_start");
+      return;
+   }
+   vad_log(run, "events: %" PRId64 " starts, %" PRId64 " ends, first start decided %.0f ms after the speech began (%.1f ms into the run), "
+           "mean start latency %.0f ms, mean end latency %.0f ms",
+           stats->event_starts, stats->event_ends,
+           stats->event_first_start_latency_s * 1000.0, stats->event_first_start_wall_ns / 1e6,
+           stats->event_start_latency_total_s * 1000.0 / stats->event_starts,
+           stats->event_ends ? stats->event_end_latency_total_s * 1000.0 / stats->event_ends : 0.0);
+}
+
+static void write_stage_latencies_json(FILE *out, const VADC_Stats *stats)
+{
+   fprintf(out, "{\"total_samples\": %" PRId64 ", \"total_duration_s\": %.3f, \"total_speech_s\": %.3f, \"stages\": {",
+           stats->total_samples, stats->total_duration, stats->total_speech);
+   for (int stage = 0; stage < VADC_Stage_COUNT; ++stage)
+   {
+      const VADC_Histogram *histogram = stats->stage_latency + stage;
+      fprintf(out, "%s\"%s\": {\"count\": %" PRIu64 ", \"total_ns\": %" PRIu64 ", \"min_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64
+                   ", \"p50_ns\": %" PRIu64 ", \"p90_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64 ", \"p999_ns\": %" PRIu64 ", \"buckets\": [",
+              stage ? ", " : "",
+              vadc_stage_names[stage],
+              histogram->count, histogram->total_ns, histogram->min_ns, histogram->max_ns,
+              vadc_histogram_percentile(histogram, 50.0),
+              vadc_histogram_percentile(histogram, 90.0),
+              vadc_histogram_percentile(histogram, 99.0),
+              vadc_histogram_percentile(histogram, 99.9));
+
+      // NOTE: [lower bound ns, count] of every non-empty bucket
+      b32 first = 1;
+      for (int index = 0; index < VADC_HISTOGRAM_BUCKETS; ++index)
+      {
+         if (histogram->counts[index])
+         {
+            fprintf(out, "%s[%" PRIu64 ", %" PRIu64 "]", first ? "" : ", ", vadc_histogram_bucket_lower_bound(index), histogram->counts[index]);
+            first = 0;
+         }
+      }
+      fprintf(out, "]}");
+   }
+   fprintf(out, "}, \"arena\": {\"model_bytes\": %zu, \"setup_bytes\": %zu, \"peak_bytes\": %zu, \"peak_temp_depth\": %d, \"stage_bytes\": {",
+           stats->arena_model_bytes, stats->arena_setup_bytes, stats->arena_peak_bytes, stats->arena_peak_temp_depth);
+   for (int stage = 0; stage < VADC_Stage_COUNT; ++stage)
+   {
+      fprintf(out, "%s\"%s\": %zu", stage ? ", " : "", vadc_stage_names[stage], stats->stage_arena_bytes[stage]);
+   }
+   fprintf(out, "}}, \"startup\": {\"metadata_from_cache\": %s, \"optimized_model_from_cache\": %s",
+           stats->metadata_from_cache ? "true" : "false", stats->optimized_model_from_cache ? "true" : "false");
+   for (int stage = 0; stage < VADC_Startup_COUNT; ++stage)
+   {
+      fprintf(out, ", \"%s_ns\": %" PRId64, vadc_startup_stage_names[stage], stats->startup_ns[stage]);
+   }
+   fprintf(out, "}");
+   if (stats->prob_cache_enabled)
+   {
+      fprintf(out, ", \"prob_cache\": {\"hit\": %s, \"stored\": %s}",
+              stats->prob_cache_hit ? "true" : "false", stats->prob_cache_stored ? "true" : "false");
+   }
+   if (stats->events_enabled)
+   {
+      fprintf(out, ", \"events\": {\"starts\": %" PRId64 ", \"ends\": %" PRId64 ", \"first_start_latency_ms\": %.1f, \"first_start_wall_ns\": %" PRId64
+                   ", \"start_latency_total_ms\": %.1f, \"end_latency_total_ms\": %.1f}",
+              stats->event_starts, stats->event_ends, stats->event_first_start_latency_s * 1000.0, stats->event_first_start_wall_ns,
+              stats->event_start_latency_total_s * 1000.0, stats->event_end_latency_total_s * 1000.0);
+   }
+   if (stats->extract_enabled)
+   {
+      fprintf(out, ", \"extract\": {\"written_s\": %.3f, \"lost_s\": %.3f}",
+              (double)stats->extract_written_samples / HARDCODED_SAMPLE_RATE, (double)stats->extract_lost_samples / HARDCODED_SAMPLE_RATE);
+   }
+   if (stats->gate_enabled)
+   {
+      fprintf(out, ", \"gate\": {\"stage\": \"%s\", \"windows\": %" PRId64 ", \"skipped_windows\": %" PRId64 ", \"model_calls\": %" PRId64 ", \"warmup_calls\": %" PRId64
+                   ", \"first_stage_calls\": %" PRId64 ", \"first_stage_ns\": %" PRId64,
+              vadc_gate_stage_name(stats->gate_stage),
+              stats->gate_windows, stats->gate_skipped_windows, stats->gate_model_calls, stats->gate_warmup_calls,
+              stats->gate_first_stage_calls, stats->gate_first_stage_ns);
+      if (stats->gate_drift_measured)
+      {
+         fprintf(out, ", \"drift\": {\"gated_segments\": %d, \"ungated_segments\": %d, \"gated_unmatched\": %d, \"ungated_unmatched\": %d, "
+                      "\"max_boundary_diff_s\": %.3f, \"max_abs_diff\": %.6f}",
+                 stats->gate_drift_segments[0], stats->gate_drift_segments[1],
+                 stats->gate_drift_unmatched[0], stats->gate_drift_unmatched[1],
+                 stats->gate_drift_max_boundary_s, stats->gate_drift_max_abs_diff);
+      }
+      fprintf(out, "}");
+   }
+   fprintf(out, "}\n");
+}
+
+// NOTE: rewrites the whole file each time, so readers always see one complete snapshot
+static void dump_stage_latencies(const VADC_Options *options, const VADC_Stats *stats)
 {
-   if (is_speech && g_save_speech_audio && g_speech_audio_file)
+   if (options->stats_json_path)
    {
-      fwrite(samples, sizeof(short), count, g_speech_audio_file);
-      fflush(g_speech_audio_file);
+      FILE *out = fopen(options->stats_json_path, "w");
+      if (!out)
+      {
+         fprintf(stderr, "Warning: couldn't write %s\n", options->stats_json_path);
+         return;
+      }
+      write_stage_latencies_json(out, stats);
+      fclose(out);
    }
-   else if (!is_speech && g_save_noise_audio && g_noise_audio_file)
+   else
    {
-      fwrite(samples, sizeof(short), count, g_noise_audio_file);
-      fflush(g_noise_audio_file);
+      write_stage_latencies_json(stderr, stats);
+      fflush(stderr);
    }
 }
 
@@ -452,11 +845,10 @@ FeedProbabilityResult feed_probability(FeedState *state,
    return result;
 }
 
-void emit_speech_segment(FeedProbabilityResult segment,
-                         float speech_pad_ms,
-                         Segment_Output_Format output_format,
-                         VADC_Stats *stats,
-                         float seconds_per_chunk)
+// NOTE: the padded segment as one line of output. Returns the line length, the padded duration goes to
+//       *speech_seconds.
+static int format_speech_segment(char *line, size_t line_size, FeedProbabilityResult segment, float speech_pad_ms,
+                                 Segment_Output_Format output_format, float seconds_per_chunk, double *speech_seconds)
 {
    const float spc = seconds_per_chunk;
 
@@ -471,85 +863,537 @@ void emit_speech_segment(FeedProbabilityResult segment,
       speech_start_padded = 0.0f;
    }
 
-   stats->total_speech += (double)speech_end_padded - (double)speech_start_padded;
+   *speech_seconds = (double)speech_end_padded - (double)speech_start_padded;
 
+   int line_length = 0;
    switch (output_format)
    {
       case Segment_Output_Format_Seconds:
       {
-         fprintf(stdout, "%.2f,%.2f\n", speech_start_padded, speech_end_padded);
+         line_length = snprintf(line, line_size, "%.2f,%.2f\n", speech_start_padded, speech_end_padded);
       } break;
 
       case Segment_Output_Format_CentiSeconds:
       {
          s64 start_centi = (s64)((double)speech_start_padded * 100.0 + 0.5);
          s64 end_centi = (s64)((double)speech_end_padded * 100.0 + 0.5);
-         fprintf(stdout, "%" PRId64 "," "%" PRId64 "\n", start_centi, end_centi);
+         line_length = snprintf(line, line_size, "%" PRId64 "," "%" PRId64 "\n", start_centi, end_centi);
+      } break;
+
+      case Segment_Output_Format_Ndjson:
+      {
+         line_length = snprintf(line, line_size, "{\"start\": %.2f, \"end\": %.2f}\n", speech_start_padded, speech_end_padded);
+      } break;
+
+      // NOTE: U8 is for probabilities only, segments stay float32 pairs
+      case Segment_Output_Format_Float32:
+      case Segment_Output_Format_U8:
+      {
+         float pair[2] = { speech_start_padded, speech_end_padded };
+         memcpy(line, pair, sizeof(pair));
+         line_length = (int)sizeof(pair);
+      } break;
+
+      default:
+      {
       } break;
    }
-   fflush(stdout);
-   print_speech_stats(*stats);
+   return line_length;
 }
 
-FeedProbabilityResult combine_or_emit_speech_segment(FeedProbabilityResult buffered, FeedProbabilityResult feed_result,
-                                                     float speech_pad_ms, Segment_Output_Format output_format, VADC_Stats *stats,
-                                                     float seconds_per_chunk)
+// NOTE: one probability of --raw_probabilities in the output format, returns the length
+static int format_probability(char *line, size_t line_size, float probability, int global_chunk_index,
+                              Segment_Output_Format output_format, float seconds_per_chunk)
 {
-   FeedProbabilityResult result = buffered;
-
-   const float spc = seconds_per_chunk;
+   int line_length = 0;
+   switch (output_format)
+   {
+      case Segment_Output_Format_Ndjson:
+      {
+         line_length = snprintf(line, line_size, "{\"time\": %.3f, \"p\": %f}\n", global_chunk_index * seconds_per_chunk, probability);
+      } break;
 
+      case Segment_Output_Format_Float32:
+      {
+         memcpy(line, &probability, sizeof(probability));
+         line_length = (int)sizeof(probability);
+      } break;
 
-   const float speech_pad_s = speech_pad_ms / 1000.0f;
+      case Segment_Output_Format_U8:
+      {
+         float clamped = probability < 0.0f ? 0.0f : (probability > 1.0f ? 1.0f : probability);
+         line[0] = (char)(u8)(clamped * 255.0f + 0.5f);
+         line_length = 1;
+      } break;
 
-   float current_speech_start_padded = (feed_result.speech_start * spc) - speech_pad_s;
-   if (current_speech_start_padded < 0.0f)
-   {
-      current_speech_start_padded = 0.0f;
+      default:
+      {
+         line_length = snprintf(line, line_size, "%f\n", probability);
+      } break;
    }
+   return line_length;
+}
 
-   if (result.is_valid)
+static const char *segment_output_format_names[Segment_Output_Format_COUNT] =
+{
+   "seconds",
+   "centi",
+   "ndjson",
+   "f32",
+   "u8",
+};
+
+// NOTE: Segment_Output_Format_COUNT for an unknown name
+static Segment_Output_Format segment_output_format_from_string(const char *name)
+{
+   for (int format = 0; format < Segment_Output_Format_COUNT; ++format)
    {
-      float buffered_speech_end_padded = (result.speech_end * spc) + speech_pad_s;
-      if (buffered_speech_end_padded >= current_speech_start_padded)
-      {
-         result.speech_end = feed_result.speech_end;
-      }
-      else
+      if (strcmp(name, segment_output_format_names[format]) == 0)
       {
-         emit_speech_segment(result, speech_pad_ms, output_format, stats, spc);
-
-         result = feed_result;
+         return (Segment_Output_Format)format;
       }
    }
-   else
+   return Segment_Output_Format_COUNT;
+}
+
+// NOTE: the padded segment in samples, rounded from the same padded seconds the output shows
+static void speech_segment_samples(FeedProbabilityResult segment, float speech_pad_ms, float seconds_per_chunk,
+                                   s64 *start_sample, s64 *end_sample)
+{
+   const float speech_pad_s = speech_pad_ms / 1000.0f;
+   float speech_start_padded = (segment.speech_start * seconds_per_chunk) - speech_pad_s;
+   if (speech_start_padded < 0.0f)
    {
-      result = feed_result;
+      speech_start_padded = 0.0f;
    }
+   float speech_end_padded = (segment.speech_end * seconds_per_chunk) + speech_pad_s;
 
-   return result;
+   *start_sample = (s64)((double)speech_start_padded * HARDCODED_SAMPLE_RATE + 0.5);
+   *end_sample = (s64)((double)speech_end_padded * HARDCODED_SAMPLE_RATE + 0.5);
 }
 
+static void extract_speech_segment(VADC_Run *run, FeedProbabilityResult segment, float speech_pad_ms, float seconds_per_chunk)
+{
+   s64 start_sample, end_sample;
+   speech_segment_samples(segment, speech_pad_ms, seconds_per_chunk, &start_sample, &end_sample);
+   vadc_speech_extract_write(run->extract, start_sample, end_sample);
+}
 
-#if 0
-void read_wav_ffmpeg( const char *fname_inp )
+// NOTE: writes what is already certain to end up in a segment, so a long segment doesn't have to fit in
+//       the ring. The buffered segment is final unless it grows. Running speech whose temp_end (or the
+//       next window) is more than min_speech past its start makes it through feed_probability and the
+//       end of stream snap alike, and ends no earlier than that. If it touches the buffered segment the
+//       two merge, and the gap between them is speech too.
+static void extract_speech_certain(VADC_Run *run, const FeedState *state, FeedProbabilityResult buffered, int global_chunk_index,
+                                   int min_speech_duration_chunks, float speech_pad_ms, float seconds_per_chunk)
 {
-   const wchar_t ffmpeg_to_s16le[] = L"ffmpeg -hide_banner -loglevel error -stats -i \"%s\" -map 0:a:0 -vn -sn -dn -ac 1 -ar 16k -f s16le -";
-   wchar_t *fname_widechar = nullptr;
-   if ( UTF8_ToWidechar( &fname_widechar, fname_inp, 0 ) )
+   FeedProbabilityResult running = {0};
+   if (state->triggered)
    {
-      wchar_t ffmpeg_final[4096];
-      swprintf( ffmpeg_final, 4096, ffmpeg_to_s16le, fname_widechar );
+      int end_candidate = (state->temp_end ? state->temp_end : global_chunk_index + 1) - 1;
+      if (end_candidate - state->current_speech_start > min_speech_duration_chunks)
+      {
+         running.is_valid = 1;
+         running.speech_start = state->current_speech_start;
+         running.speech_end = end_candidate;
+      }
+   }
 
-      free( fname_widechar );
+   if (buffered.is_valid && running.is_valid &&
+       speech_segments_touch(buffered, running.speech_start, speech_pad_ms, seconds_per_chunk))
+   {
+      running.speech_start = buffered.speech_start;
+      buffered.is_valid = 0;
+   }
+   if (buffered.is_valid)
+   {
+      extract_speech_segment(run, buffered, speech_pad_ms, seconds_per_chunk);
+   }
+   if (running.is_valid)
+   {
+      extract_speech_segment(run, running, speech_pad_ms, seconds_per_chunk);
+   }
+}
 
-      // Create the pipe
-      SECURITY_ATTRIBUTES saAttr = {sizeof( SECURITY_ATTRIBUTES )};
-      saAttr.bInheritHandle = FALSE;
+void emit_speech_segment(VADC_Run *run,
+                         FeedProbabilityResult segment,
+                         float speech_pad_ms,
+                         Segment_Output_Format output_format,
+                         VADC_Stats *stats,
+                         float seconds_per_chunk)
+{
+   TracyCZone(emit_speech_segment, true);
 
-      HANDLE ffmpeg_stdout_read, ffmpeg_stdout_write;
+   char line[64];
+   double speech_seconds = 0.0;
+   int line_length = format_speech_segment(line, sizeof(line), segment, speech_pad_ms, output_format, seconds_per_chunk, &speech_seconds);
+   stats->total_speech += speech_seconds;
 
-      if ( !CreatePipe( &ffmpeg_stdout_read, &ffmpeg_stdout_write, &saAttr, 0 ) )
+   // NOTE: with --events the segments only count towards the stats, the events are the output
+   if (!run->events)
+   {
+      run_write_segments(run, line, (size_t)line_length);
+   }
+   if (run->extract)
+   {
+      extract_speech_segment(run, segment, speech_pad_ms, seconds_per_chunk);
+   }
+   VADC_METRIC_ADD(run->metrics, segments_emitted, 1);
+   print_speech_stats(run, stats);
+
+   TracyCZoneEnd(emit_speech_segment);
+}
+
+b32 speech_segments_touch(FeedProbabilityResult buffered, int next_speech_start,
+                          float speech_pad_ms, float seconds_per_chunk)
+{
+   const float spc = seconds_per_chunk;
+   const float speech_pad_s = speech_pad_ms / 1000.0f;
+
+   float next_speech_start_padded = (next_speech_start * spc) - speech_pad_s;
+   if (next_speech_start_padded < 0.0f)
+   {
+      next_speech_start_padded = 0.0f;
+   }
+
+   float buffered_speech_end_padded = (buffered.speech_end * spc) + speech_pad_s;
+   return buffered_speech_end_padded >= next_speech_start_padded;
+}
+
+FeedProbabilityResult combine_speech_segment(FeedProbabilityResult buffered, FeedProbabilityResult feed_result,
+                                             float speech_pad_ms, float seconds_per_chunk,
+                                             FeedProbabilityResult *finished)
+{
+   FeedProbabilityResult result = buffered;
+   FeedProbabilityResult finished_segment = {0};
+
+   if (result.is_valid)
+   {
+      if (speech_segments_touch(result, feed_result.speech_start, speech_pad_ms, seconds_per_chunk))
+      {
+         result.speech_end = feed_result.speech_end;
+      }
+      else
+      {
+         finished_segment = result;
+
+         result = feed_result;
+      }
+   }
+   else
+   {
+      result = feed_result;
+   }
+
+   if (finished)
+   {
+      *finished = finished_segment;
+   }
+
+   return result;
+}
+
+FeedProbabilityResult combine_or_emit_speech_segment(VADC_Run *run, FeedProbabilityResult buffered, FeedProbabilityResult feed_result,
+                                                     float speech_pad_ms, Segment_Output_Format output_format, VADC_Stats *stats,
+                                                     float seconds_per_chunk)
+{
+   FeedProbabilityResult finished = {0};
+   FeedProbabilityResult result = combine_speech_segment(buffered, feed_result, speech_pad_ms, seconds_per_chunk, &finished);
+
+   if (finished.is_valid)
+   {
+      emit_speech_segment(run, finished, speech_pad_ms, output_format, stats, seconds_per_chunk);
+   }
+
+   return result;
+}
+
+static VADC_Event make_event(VADC_Event_Type type, int chunk, int decided_chunks)
+{
+   VADC_Event event = { type, chunk, decided_chunks };
+   return event;
+}
+
+int vadc_event_tracker_feed(VADC_Event_Tracker *tracker, const FeedState *state, FeedProbabilityResult feed_result,
+                            int global_chunk_index, VADC_Event *events)
+{
+   const FeedState previous = tracker->previous;
+   const int decided_chunks = global_chunk_index + 1;
+   int count = 0;
+
+   if (feed_result.is_valid)
+   {
+      // NOTE: can't happen, the start is always out before min_silence confirms the end, but a
+      //       consumer must never see an end without its start
+      if (!tracker->start_emitted)
+      {
+         events[count++] = make_event(VADC_Event_SpeechStart, feed_result.speech_start, decided_chunks);
+      }
+      events[count++] = make_event(VADC_Event_SpeechEnd, feed_result.speech_end, decided_chunks);
+      tracker->start_emitted = 0;
+   }
+   else if (previous.triggered && !state->triggered)
+   {
+      // NOTE: speech shorter than min_speech, feed_probability dropped it
+      if (tracker->provisional)
+      {
+         events[count++] = make_event(VADC_Event_StartRetracted, previous.current_speech_start, decided_chunks);
+      }
+   }
+   else if (state->triggered)
+   {
+      if (!previous.triggered && tracker->provisional)
+      {
+         events[count++] = make_event(VADC_Event_ProvisionalStart, state->current_speech_start, decided_chunks);
+      }
+
+      b32 end_was_pending = tracker->start_emitted && previous.temp_end;
+      if (!tracker->start_emitted)
+      {
+         // NOTE: feed_probability drops speech when temp_end - current_speech_start < min_speech, and the
+         //       temp_end it will settle on is never earlier than this one, or than the next window. If the
+         //       stream ends first, the speech is closed at the last window and kept only if it's more than
+         //       min_speech long, the same > as vadc_event_tracker_finish and the snap of the last segment.
+         int end_candidate = state->temp_end ? state->temp_end : decided_chunks;
+         if (end_candidate - state->current_speech_start >= tracker->min_speech_duration_chunks &&
+             global_chunk_index - state->current_speech_start > tracker->min_speech_duration_chunks)
+         {
+            events[count++] = make_event(VADC_Event_SpeechStart, state->current_speech_start, decided_chunks);
+            tracker->start_emitted = 1;
+         }
+      }
+
+      if (tracker->provisional && tracker->start_emitted)
+      {
+         if (!end_was_pending && state->temp_end)
+         {
+            events[count++] = make_event(VADC_Event_ProvisionalEnd, state->temp_end, decided_chunks);
+         }
+         else if (end_was_pending && !state->temp_end)
+         {
+            events[count++] = make_event(VADC_Event_EndRetracted, previous.temp_end, decided_chunks);
+         }
+      }
+   }
+
+   tracker->previous = *state;
+   return count;
+}
+
+int vadc_event_tracker_finish(VADC_Event_Tracker *tracker, int speech_end, int chunk_count, VADC_Event *events)
+{
+   const FeedState previous = tracker->previous;
+   int count = 0;
+
+   if (previous.triggered)
+   {
+      // NOTE: the same length check as the snap of the last segment to the audio length
+      if (!tracker->start_emitted && speech_end - previous.current_speech_start > tracker->min_speech_duration_chunks)
+      {
+         events[count++] = make_event(VADC_Event_SpeechStart, previous.current_speech_start, chunk_count);
+         tracker->start_emitted = 1;
+      }
+
+      if (tracker->start_emitted)
+      {
+         events[count++] = make_event(VADC_Event_SpeechEnd, speech_end, chunk_count);
+      }
+      else if (tracker->provisional)
+      {
+         events[count++] = make_event(VADC_Event_StartRetracted, previous.current_speech_start, chunk_count);
+      }
+   }
+
+   memset(&tracker->previous, 0, sizeof(tracker->previous));
+   tracker->start_emitted = 0;
+   return count;
+}
+
+static const char *vadc_event_type_names[VADC_Event_COUNT] =
+{
+   "speech_start",
+   "speech_end",
+   "provisional_start",
+   "provisional_end",
+   "start_retracted",
+   "end_retracted",
+};
+
+const char *vadc_event_type_name(VADC_Event_Type type)
+{
+   return type < VADC_Event_COUNT ? vadc_event_type_names[type] : "unknown";
+}
+
+float vadc_event_seconds(VADC_Event event, float speech_pad_ms, float seconds_per_chunk)
+{
+   const float speech_pad_s = speech_pad_ms / 1000.0f;
+   b32 is_end = (event.type == VADC_Event_SpeechEnd ||
+                 event.type == VADC_Event_ProvisionalEnd ||
+                 event.type == VADC_Event_EndRetracted);
+
+   float seconds = event.chunk * seconds_per_chunk + (is_end ? speech_pad_s : -speech_pad_s);
+   return seconds < 0.0f ? 0.0f : seconds;
+}
+
+// NOTE: one JSON line per event on the segments output
+static void emit_events(VADC_Run *run, const VADC_Event *events, int event_count, float speech_pad_ms,
+                        VADC_Stats *stats, float seconds_per_chunk)
+{
+   for (int i = 0; i < event_count; ++i)
+   {
+      VADC_Event event = events[i];
+      double latency_s = (event.decided_chunks - event.chunk) * (double)seconds_per_chunk;
+
+      if (event.type == VADC_Event_SpeechStart)
+      {
+         if (!stats->event_starts)
+         {
+            stats->event_first_start_latency_s = latency_s;
+            s64 run_start_ns = run->backend_init_start_ns ? run->backend_init_start_ns : stats->first_call_timestamp;
+            stats->event_first_start_wall_ns = vadc_now_ns() - run_start_ns;
+         }
+         ++stats->event_starts;
+         stats->event_start_latency_total_s += latency_s;
+      }
+      else if (event.type == VADC_Event_SpeechEnd)
+      {
+         ++stats->event_ends;
+         stats->event_end_latency_total_s += latency_s;
+      }
+
+      char line[160];
+      int line_length = snprintf(line, sizeof(line), "{\"event\": \"%s\", \"time\": %.3f, \"decided_at\": %.3f, \"latency_ms\": %.0f}\n",
+                                 vadc_event_type_name(event.type),
+                                 vadc_event_seconds(event, speech_pad_ms, seconds_per_chunk),
+                                 event.decided_chunks * (double)seconds_per_chunk,
+                                 latency_s * 1000.0);
+      run_write_segments(run, line, (size_t)line_length);
+   }
+}
+
+// NOTE: a segmenter of its own and the segments it produced, for comparing the segments of two
+//       probability streams (run_crossval, the energy gate's drift measurement)
+typedef struct Segment_Track Segment_Track;
+struct Segment_Track
+{
+   FeedState state;
+   FeedProbabilityResult buffered;
+   FeedProbabilityResult *segments;
+   int segment_count;
+   int segment_capacity;
+};
+
+static void segment_track_push(Segment_Track *side, FeedProbabilityResult segment)
+{
+   if (side->segment_count == side->segment_capacity)
+   {
+      int new_capacity = side->segment_capacity ? side->segment_capacity * 2 : 64;
+      FeedProbabilityResult *new_segments = realloc(side->segments, new_capacity * sizeof(FeedProbabilityResult));
+      if (!new_segments)
+      {
+         return;
+      }
+      side->segments = new_segments;
+      side->segment_capacity = new_capacity;
+   }
+   side->segments[side->segment_count++] = segment;
+}
+
+static void segment_track_feed(Segment_Track *side, const VADC_Options *options, float probability, int global_chunk_index,
+                          int min_silence_duration_chunks, int min_speech_duration_chunks, float seconds_per_chunk)
+{
+   FeedProbabilityResult feed_result = feed_probability(&side->state,
+                                                        min_silence_duration_chunks,
+                                                        min_speech_duration_chunks,
+                                                        probability,
+                                                        options->threshold,
+                                                        options->neg_threshold,
+                                                        global_chunk_index);
+   if (feed_result.is_valid)
+   {
+      FeedProbabilityResult finished = {0};
+      side->buffered = combine_speech_segment(side->buffered, feed_result, options->speech_pad_ms, seconds_per_chunk, &finished);
+      if (finished.is_valid)
+      {
+         segment_track_push(side, finished);
+      }
+   }
+}
+
+// NOTE: the end of stream handling of run_inference_on_backend
+static void segment_track_finish(Segment_Track *side, const VADC_Options *options, int global_chunk_index,
+                            int min_speech_duration_chunks, float seconds_per_chunk)
+{
+   if (side->state.triggered && global_chunk_index - 1 - side->state.current_speech_start > min_speech_duration_chunks)
+   {
+      FeedProbabilityResult final_segment = {0};
+      final_segment.is_valid = 1;
+      final_segment.speech_start = side->state.current_speech_start;
+      final_segment.speech_end = global_chunk_index - 1;
+
+      FeedProbabilityResult finished = {0};
+      side->buffered = combine_speech_segment(side->buffered, final_segment, options->speech_pad_ms, seconds_per_chunk, &finished);
+      if (finished.is_valid)
+      {
+         segment_track_push(side, finished);
+      }
+   }
+   if (side->buffered.is_valid)
+   {
+      segment_track_push(side, side->buffered);
+      side->buffered.is_valid = 0;
+   }
+}
+
+// NOTE: segments of `side` that overlap nothing in `other`, and the largest boundary difference (in
+//       windows) to the first overlapping segment of the ones that do
+static int segment_track_unmatched(const Segment_Track *side, const Segment_Track *other, int *max_boundary_diff)
+{
+   int unmatched = 0;
+   for (int i = 0; i < side->segment_count; ++i)
+   {
+      FeedProbabilityResult a = side->segments[i];
+      b32 matched = 0;
+      for (int j = 0; j < other->segment_count && !matched; ++j)
+      {
+         FeedProbabilityResult b = other->segments[j];
+         if (a.speech_start <= b.speech_end && b.speech_start <= a.speech_end)
+         {
+            int start_diff = abs(a.speech_start - b.speech_start);
+            int end_diff = abs(a.speech_end - b.speech_end);
+            int diff = start_diff > end_diff ? start_diff : end_diff;
+            if (diff > *max_boundary_diff)
+            {
+               *max_boundary_diff = diff;
+            }
+            matched = 1;
+         }
+      }
+      unmatched += !matched;
+   }
+   return unmatched;
+}
+
+
+#if 0
+void read_wav_ffmpeg( const char *fname_inp )
+{
+   const wchar_t ffmpeg_to_s16le[] = L"ffmpeg -hide_banner -loglevel error -stats -i \"%s\" -map 0:a:0 -vn -sn -dn -ac 1 -ar 16k -f s16le -";
+   wchar_t *fname_widechar = nullptr;
+   if ( UTF8_ToWidechar( &fname_widechar, fname_inp, 0 ) )
+   {
+      wchar_t ffmpeg_final[4096];
+      swprintf( ffmpeg_final, 4096, ffmpeg_to_s16le, fname_widechar );
+
+      free( fname_widechar );
+
+      // Create the pipe
+      SECURITY_ATTRIBUTES saAttr = {sizeof( SECURITY_ATTRIBUTES )};
+      saAttr.bInheritHandle = FALSE;
+
+      HANDLE ffmpeg_stdout_read, ffmpeg_stdout_write;
+
+      if ( !CreatePipe( &ffmpeg_stdout_read, &ffmpeg_stdout_write, &saAttr, 0 ) )
       {
          fprintf( stderr, "Error creating ffmpeg pipe\n" );
          return false;
@@ -660,6 +1504,9 @@ struct Buffered_Stream
 
    // NOTE(irwin): crt
    FILE *file_handle_internal;
+   // NOTE: popen'ed by us, pclose on deinit
+   b32 file_handle_is_pipe;
+   int pipe_exit_status;
 
    u8 *buffer_internal;
    size_t buffer_internal_size;
@@ -689,7 +1536,10 @@ BS_Error refill_FILE( Buffered_Stream *s )
 {
    if (s->cursor == s->end)
    {
+      // NOTE: this is where we block on ffmpeg or the stdin producer
+      TracyCZoneN(refill_FILE, "refill_FILE", true);
       size_t values_read = fread( s->buffer_internal, 1, s->buffer_internal_size, s->file_handle_internal );
+      TracyCZoneEnd(refill_FILE);
       if (values_read == s->buffer_internal_size)
       {
          s->start = s->buffer_internal;
@@ -718,12 +1568,8 @@ BS_Error refill_FILE( Buffered_Stream *s )
    return s->error_code;
 }
 
-static void init_buffered_stream_ffmpeg(MemoryArena *arena, Buffered_Stream *s, String8 fname_inp, size_t buffer_size,
-                  int audio_source,
-                  float start_seconds)
+static char *push_ffmpeg_command(MemoryArena *arena, String8 fname_inp, int audio_source, float start_seconds)
 {
-   memset( s, 0, sizeof( *s ) );
-
    const char *ffmpeg_to_s16le = "ffmpeg -hide_banner -loglevel error -nostats -ss %f -i \"%.*s\" -map 0:a:%d -vn -sn -dn -ac 1 -ar 16k -f s16le -";
    String8 ffmpeg_command = String8_pushf(arena, ffmpeg_to_s16le, start_seconds, fname_inp.size, fname_inp.begin, audio_source);
 
@@ -732,8 +1578,20 @@ static void init_buffered_stream_ffmpeg(MemoryArena *arena, Buffered_Stream *s,
    memcpy(cmd_str, ffmpeg_command.begin, ffmpeg_command.size);
    cmd_str[ffmpeg_command.size] = '\0';
 
+   return cmd_str;
+}
+
+static void init_buffered_stream_ffmpeg(MemoryArena *arena, Buffered_Stream *s, String8 fname_inp, size_t buffer_size,
+                  int audio_source,
+                  float start_seconds)
+{
+   memset( s, 0, sizeof( *s ) );
+
+   char *cmd_str = push_ffmpeg_command(arena, fname_inp, audio_source, start_seconds);
+
    // Use popen to run ffmpeg and get its output
-   FILE *ffmpeg_pipe = popen(cmd_str, "rb");
+   // NOTE: "r", glibc refuses "rb" with EINVAL, and POSIX pipes have no text mode anyway
+   FILE *ffmpeg_pipe = popen(cmd_str, "r");
    
    if (ffmpeg_pipe == NULL)
    {
@@ -746,6 +1604,7 @@ static void init_buffered_stream_ffmpeg(MemoryArena *arena, Buffered_Stream *s,
    if (s->buffer_internal)
    {
       s->file_handle_internal = ffmpeg_pipe;
+      s->file_handle_is_pipe = 1;
       s->refill = refill_FILE;
       s->buffer_internal_size = buffer_size;
       s->error_code = BS_Error_NoError;
@@ -806,6 +1665,11 @@ static void deinit_buffered_stream_file( Buffered_Stream *s )
 {
    if ( s->file_handle_internal )
    {
+      if ( s->file_handle_is_pipe )
+      {
+         s->pipe_exit_status = pclose( s->file_handle_internal );
+         s->file_handle_is_pipe = 0;
+      }
       s->file_handle_internal = NULL;
    }
 
@@ -818,149 +1682,91 @@ static void deinit_buffered_stream_file( Buffered_Stream *s )
 }
 
 
-int run_inference(String8 model_path_arg,
-                  MemoryArena *arena,
-                  float min_silence_duration_ms,
-                  float min_speech_duration_ms,
-                  float threshold,
-                  float neg_threshold,
-                  float speech_pad_ms,
-                  float desired_sequence_count,
-                  b32 raw_probabilities,
-                  Segment_Output_Format output_format,
-                  String8 filename,
-                  b32 stats_output_enabled,
-                  s32 preferred_batch_size,
-                  int audio_source,
-                  float start_seconds,
-                  const char *audio_output_file,
-                  const char *log_output_file,
-                  const char *speech_audio_file,
-                  const char *noise_audio_file,
-                  b32 verbose_logging )
+void silero_config_finalize( Silero_Config *config,
+                             s32 preferred_batch_size,
+                             float desired_sequence_count )
 {
-   Silero_Config config = {0};
-   config.batch_size_restriction = 1;
-   config.batch_size = 1;
-
-   // 初始化日志和音频输出
-   init_audio_logging(audio_output_file, log_output_file);
-   init_separated_audio_logging(speech_audio_file, noise_audio_file);
-
-   g_verbose_logging = verbose_logging;
-
-   // 始终输出初始化信息到 stderr
-   fprintf(stderr, "\n🚀 初始化推理引擎...\n");
-   fprintf(stderr, "  模型路径: %.*s\n", (int)model_path_arg.size, model_path_arg.begin);
-   fflush(stderr);
-
-   if (g_verbose_logging)
-   {
-      vad_log("════════════════════════════════════════════");
-      vad_log("VADC - 语音活动检测系统");
-      vad_log("════════════════════════════════════════════");
-      vad_log("参数配置:");
-      vad_log("  说话概率阈值: %.2f", threshold);
-      vad_log("  最小沉默时长: %.0fms", min_silence_duration_ms);
-      vad_log("  最小说话时长: %.0fms", min_speech_duration_ms);
-      vad_log("  语音边界填充: %.0fms", speech_pad_ms);
-      if (audio_output_file)
-      {
-         vad_log("  音频输出文件: %s", audio_output_file);
-      }
-      if (log_output_file)
-      {
-         vad_log("  日志输出文件: %s", log_output_file);
-      }
-      vad_log("════════════════════════════════════════════");
-   }
-
-   void *backend = backend_init( arena, model_path_arg, &config );
-
-   if ( !backend )
-   {
-      return -1;
-   }
-
-   b32 is_silero_v5 = config.is_silero_v5;
-   if (is_silero_v5)
+   if (config->is_silero_v5)
    {
-      fprintf(stderr, "%s", "Model arch is Silero v5\n");
-      config.context_size = SILERO_V5_CONTEXT_SIZE;
+      config->context_size = SILERO_V5_CONTEXT_SIZE;
    }
 
-   if (config.output_dims == 3)
+   if (config->output_dims == 3)
    {
-      config.silero_probability_out_index = 1;
-      config.output_stride = 2;
+      config->silero_probability_out_index = 1;
+      config->output_stride = 2;
    }
    else
    {
-      config.silero_probability_out_index = 0;
-      config.output_stride = 1;
+      config->silero_probability_out_index = 0;
+      config->output_stride = 1;
    }
 
-   config.batch_size = (config.batch_size_restriction == -1) ? preferred_batch_size : config.batch_size_restriction;
-   fprintf(stderr, "Running with batch size %d\n", config.batch_size);
+   config->batch_size = (config->batch_size_restriction == -1) ? preferred_batch_size : config->batch_size_restriction;
 
    {
-      Assert(config.output_dims == 2 || config.output_dims == 3);
-      if (config.output_dims == 2)
+      Assert(config->output_dims == 2 || config->output_dims == 3);
+      if (config->output_dims == 2)
       {
-         config.prob_shape_count = 2;
-         config.prob_shape[0] = config.batch_size;
-         config.prob_shape[1] = 1;
+         config->prob_shape_count = 2;
+         config->prob_shape[0] = config->batch_size;
+         config->prob_shape[1] = 1;
       }
       else
       {
-         config.prob_shape_count = 3;
-         config.prob_shape[0] = config.batch_size;
-         config.prob_shape[1] = 2;
-         config.prob_shape[2] = 1;
+         config->prob_shape_count = 3;
+         config->prob_shape[0] = config->batch_size;
+         config->prob_shape[1] = 2;
+         config->prob_shape[2] = 1;
       }
 
       size_t prob_tensor_element_count = 1;
-      for (int i = 0; i < config.prob_shape_count; ++i)
+      for (int i = 0; i < config->prob_shape_count; ++i)
       {
-         prob_tensor_element_count *= config.prob_shape[i];
+         prob_tensor_element_count *= config->prob_shape[i];
       }
-      config.prob_tensor_element_count = prob_tensor_element_count;
+      config->prob_tensor_element_count = prob_tensor_element_count;
    }
 
    {
       int sequence_count = (int)desired_sequence_count;
-      if (sequence_count < config.input_size_min)
+      if (sequence_count < config->input_size_min)
       {
-         sequence_count = config.input_size_min;
+         sequence_count = config->input_size_min;
       }
-      if (sequence_count > config.input_size_max)
+      if (sequence_count > config->input_size_max)
       {
-         sequence_count = config.input_size_max;
+         sequence_count = config->input_size_max;
       }
-      config.input_count = (s32)sequence_count;
-      fprintf(stderr, "Running with sequence count %d\n", config.input_count);
-   }
-
-   const float HARDCODED_CHUNK_DURATION_MS = config.input_count / (float)HARDCODED_SAMPLE_RATE * 1000.0f;
-
-   int min_speech_duration_chunks = (int)(min_speech_duration_ms / HARDCODED_CHUNK_DURATION_MS + 0.5f);
-   if (min_speech_duration_chunks < 1)
-   {
-      min_speech_duration_chunks = 1;
+      config->input_count = (s32)sequence_count;
    }
+}
 
-   int min_silence_duration_chunks = (int)(min_silence_duration_ms / HARDCODED_CHUNK_DURATION_MS + 0.5f);
-   if (min_silence_duration_chunks < 1)
-   {
-      min_silence_duration_chunks = 1;
-   }
+// NOTE(irwin): at 16000 sampling rate, one chunk is 96 ms or 1536 samples
+// NOTE(irwin): chunks count being 96, the same as one chunk's length in milliseconds,
+// is purely coincidental
+// NOTE: 减小到 4 以获得更好的实时响应（每 384ms 处理一次而不是每 9.2 秒）
+#define VADC_CHUNKS_PER_READ 2
 
+typedef struct Run_Buffers Run_Buffers;
+struct Run_Buffers
+{
+   Tensor_Buffers tensors;
+   // NOTE(irwin): buffered_samples_count is the normalization window size
+   size_t buffered_samples_count;
+   short *samples_s16;
+   float *samples_float32;
+   float *probabilities;
+   u8 *output_buffer;
+};
 
-   // NOTE(irwin): create tensors and allocate tensors backing memory buffers
+// NOTE(irwin): create tensors and allocate tensors backing memory buffers
+static Tensor_Buffers push_tensor_buffers(MemoryArena *arena, Silero_Config config)
+{
    Tensor_Buffers buffers = {0};
    buffers.window_size_samples = (int)config.input_count;
 
-   if (is_silero_v5)
+   if (config.is_silero_v5)
    {
       buffers.input_samples = pushArray(arena, (buffers.window_size_samples + config.context_size) * config.batch_size, float);
    }
@@ -978,25 +1784,607 @@ int run_inference(String8 model_path_arg,
    buffers.lstm_h_out = pushArray(arena, buffers.lstm_count, float);
    buffers.lstm_c_out = pushArray(arena, buffers.lstm_count, float);
 
-   backend_create_tensors(config, backend, buffers);
+   return buffers;
+}
 
-   // NOTE(irwin): read samples from a file or stdin and run inference
-   // NOTE(irwin): at 16000 sampling rate, one chunk is 96 ms or 1536 samples
-   // NOTE(irwin): chunks count being 96, the same as one chunk's length in milliseconds,
-   // is purely coincidental
-   // NOTE: 减小到 4 以获得更好的实时响应（每 384ms 处理一次而不是每 9.2 秒）
-   const int chunks_count = 2;
-   // NOTE(irwin): buffered_samples_count is the normalization window size
-   const size_t buffered_samples_count = buffers.window_size_samples * chunks_count;
+// NOTE: everything run_inference_on_backend pushes before the read stream
+static Run_Buffers push_run_buffers(MemoryArena *arena, Silero_Config config)
+{
+   Run_Buffers run_buffers = {0};
+   run_buffers.tensors = push_tensor_buffers(arena, config);
+   run_buffers.buffered_samples_count = run_buffers.tensors.window_size_samples * VADC_CHUNKS_PER_READ;
+
+   // NOTE: a model call takes and returns batch_size windows, however few of them a read filled
+   size_t probabilities_count = VADC_CHUNKS_PER_READ > config.batch_size ? VADC_CHUNKS_PER_READ : (size_t)config.batch_size;
+   run_buffers.samples_s16 = pushArray(arena, run_buffers.buffered_samples_count, short);
+   run_buffers.samples_float32 = pushArray(arena, run_buffers.tensors.window_size_samples * probabilities_count, float);
+   run_buffers.probabilities = pushArray(arena, probabilities_count, float);
+   run_buffers.output_buffer = pushArray(arena, VADC_OUTPUT_WRITER_BUFFER_BYTES, u8);
+
+   return run_buffers;
+}
+
+// NOTE: per-run state of the energy gate (--gate) or the cascade (--cascade) in run_inference_on_backend
+typedef struct Gate_Run Gate_Run;
+struct Gate_Run
+{
+   VADC_Gate gate;
+
+   // NOTE: --cascade c, the C engine always scores SILERO_C_WINDOW_SAMPLES at a time, so the model's
+   //       windows are collected here until one is full
+   Silero_Context *first_stage;
+   float *first_stage_samples;
+   int first_stage_count;
+   float first_stage_probability;
+
+   b32 skipping;
+   int skipped_windows;
+   // NOTE: samples of the most recent skipped model calls, replayed to warm the lstm back up
+   float *warmup_samples;
+   int warmup_slots;
+   int warmup_used;
+   int warmup_next;
+   float *warmup_probabilities;
+
+   // NOTE: --gate_drift, an ungated copy of the model and a segmenter per probability stream
+   void *shadow_backend;
+   VADC_Context shadow_context;
+   float *shadow_probabilities;
+   Segment_Track tracks[2];
+};
+
+static int gate_run_init(Gate_Run *gate_run, MemoryArena *arena, void *backend, Silero_Config config,
+                         const VADC_Gate_Options *options, size_t buffered_samples_count)
+{
+   memset(gate_run, 0, sizeof(*gate_run));
+   vadc_gate_init(&gate_run->gate, options);
+
+   if (options->stage == VADC_Gate_Stage_C)
+   {
+#if ONNX_INFERENCE_ENABLED
+      const char *weights_path = options->c_weights_path ? options->c_weights_path : VADC_CROSSVAL_DEFAULT_C_WEIGHTS;
+      gate_run->first_stage = silero_c_init(arena, weights_path);
+      if (!gate_run->first_stage)
+      {
+         fprintf(stderr, "Fatal: couldn't load C backend weights from %s\n", weights_path);
+         return -1;
+      }
+      gate_run->first_stage_samples = pushArray(arena, SILERO_C_WINDOW_SAMPLES, float);
+#else
+      fprintf(stderr, "Fatal: --cascade c needs the onnxruntime backend, this build only has the C one\n");
+      return -1;
+#endif // ONNX_INFERENCE_ENABLED
+   }
+
+   // NOTE: the model runs batch_size windows per call, so the warm-up replays whole calls
+   const size_t stride = (size_t)config.input_count * config.batch_size;
+   gate_run->warmup_slots = (options->rewarm_windows + config.batch_size - 1) / config.batch_size;
+   if (gate_run->warmup_slots > 0)
+   {
+      gate_run->warmup_samples = pushArray(arena, gate_run->warmup_slots * stride, float);
+   }
+   gate_run->warmup_probabilities = pushArray(arena, config.batch_size, float);
+
+   if (options->measure_drift)
+   {
+      gate_run->shadow_backend = backend_clone(arena, backend);
+      Tensor_Buffers shadow_buffers = push_tensor_buffers(arena, config);
+      backend_create_tensors(config, gate_run->shadow_backend, shadow_buffers);
+      gate_run->shadow_context.backend = gate_run->shadow_backend;
+      gate_run->shadow_context.buffers = shadow_buffers;
+
+      size_t probabilities_count = buffered_samples_count / config.input_count;
+      gate_run->shadow_probabilities = pushArray(arena, probabilities_count > (size_t)config.batch_size ? probabilities_count : (size_t)config.batch_size, float);
+   }
+   return 0;
+}
+
+static void gate_run_release(Gate_Run *gate_run)
+{
+   if (gate_run->shadow_backend)
+   {
+      backend_release_tensors(gate_run->shadow_backend);
+      gate_run->shadow_backend = NULL;
+   }
+   for (int track = 0; track < 2; ++track)
+   {
+      free(gate_run->tracks[track].segments);
+      gate_run->tracks[track].segments = NULL;
+   }
+}
+
+static void run_chunks(MemoryArena *arena, VADC_Context context, Silero_Config config,
+                       size_t samples_count, const float *samples, float *probabilities)
+{
+   if (config.is_silero_v5)
+   {
+      process_chunks_v5(arena, context, config, samples_count, samples, probabilities);
+   }
+   else
+   {
+      process_chunks(arena, context, config, samples_count, samples, probabilities);
+   }
+}
+
+// NOTE: the cascade's first stage for one window of the model. The verdict is the probability of the
+//       latest full C window, so it lags the model by up to one C window; the hangover and the warm-up
+//       replay (the lookback) cover that.
+static b32 gate_run_first_stage_is_silent(MemoryArena *arena, Gate_Run *gate_run, VADC_Stats *stats,
+                                          const float *samples, size_t count)
+{
+#if ONNX_INFERENCE_ENABLED
+   while (count)
+   {
+      size_t room = SILERO_C_WINDOW_SAMPLES - gate_run->first_stage_count;
+      size_t take = count < room ? count : room;
+      memcpy(gate_run->first_stage_samples + gate_run->first_stage_count, samples, take * sizeof(float));
+      gate_run->first_stage_count += (int)take;
+      samples += take;
+      count -= take;
+
+      if (gate_run->first_stage_count == SILERO_C_WINDOW_SAMPLES)
+      {
+         s64 start_ns = vadc_now_ns();
+         gate_run->first_stage_probability = silero_c_run_window(arena, gate_run->first_stage, gate_run->first_stage_samples);
+         stats->gate_first_stage_ns += vadc_now_ns() - start_ns;
+         ++stats->gate_first_stage_calls;
+         gate_run->first_stage_count = 0;
+      }
+   }
+#else
+   VAR_UNUSED(arena);
+   VAR_UNUSED(stats);
+   VAR_UNUSED(samples);
+   VAR_UNUSED(count);
+#endif // ONNX_INFERENCE_ENABLED
+
+   b32 silent = (gate_run->first_stage_probability < gate_run->gate.options.candidate_threshold);
+   return vadc_gate_window_hangover(&gate_run->gate, silent);
+}
+
+// NOTE: process_chunks with the energy gate or the cascade's first stage in front. A model call is skipped, and its windows get
+//       probability 0, only if every window in it is confidently silent. The lstm policy and the
+//       warm-up replay run right before the first call after a skipped stretch.
+static void process_chunks_gated(MemoryArena *arena, VADC_Context context, Silero_Config config,
+                                 Gate_Run *gate_run, VADC_Stats *stats,
+                                 const short *samples_s16, size_t values_read,
+                                 const float *samples_float32, float *probabilities)
+{
+   const size_t window = (size_t)config.input_count;
+   const size_t stride = window * config.batch_size;
+
+   for (size_t offset = 0; offset < values_read; offset += stride)
+   {
+      size_t slice_count = values_read - offset < stride ? values_read - offset : stride;
+      int slice_windows = (int)((slice_count + window - 1) / window);
+
+      // NOTE: every window goes through the gate, so the noise floor and the hangover see the whole stream
+      b32 silent = 1;
+      for (int window_index = 0; window_index < slice_windows; ++window_index)
+      {
+         size_t window_start = offset + window_index * window;
+         size_t window_count = values_read - window_start < window ? values_read - window_start : window;
+         if (gate_run->first_stage)
+         {
+            silent &= gate_run_first_stage_is_silent(arena, gate_run, stats, samples_float32 + window_start, window_count);
+         }
+         else
+         {
+            VADC_Gate_Features features = vadc_gate_measure(samples_s16 + window_start, (int)window_count);
+            silent &= vadc_gate_window_is_silent(&gate_run->gate, features);
+         }
+      }
+      stats->gate_windows += slice_windows;
+
+      float *slice_probabilities = probabilities + offset / window;
+      if (silent)
+      {
+         for (int window_index = 0; window_index < slice_windows; ++window_index)
+         {
+            slice_probabilities[window_index] = 0.0f;
+         }
+
+         if (gate_run->warmup_slots)
+         {
+            float *slot = gate_run->warmup_samples + gate_run->warmup_next * stride;
+            memset(slot, 0, stride * sizeof(float));
+            memcpy(slot, samples_float32 + offset, slice_count * sizeof(float));
+            gate_run->warmup_next = (gate_run->warmup_next + 1) % gate_run->warmup_slots;
+            if (gate_run->warmup_used < gate_run->warmup_slots)
+            {
+               ++gate_run->warmup_used;
+            }
+         }
+
+         gate_run->skipping = 1;
+         gate_run->skipped_windows += slice_windows;
+         stats->gate_skipped_windows += slice_windows;
+         continue;
+      }
+
+      if (gate_run->skipping)
+      {
+         vadc_gate_apply_lstm_policy(&gate_run->gate, context.buffers.lstm_h_out, context.buffers.lstm_c_out,
+                                     context.buffers.lstm_count, gate_run->skipped_windows);
+
+         // NOTE: oldest first, the outputs are thrown away
+         for (int replay = 0; replay < gate_run->warmup_used; ++replay)
+         {
+            int slot = (gate_run->warmup_next - gate_run->warmup_used + replay + gate_run->warmup_slots) % gate_run->warmup_slots;
+            run_chunks(arena, context, config, stride, gate_run->warmup_samples + slot * stride, gate_run->warmup_probabilities);
+            ++stats->gate_warmup_calls;
+         }
+
+         gate_run->warmup_used = 0;
+         gate_run->skipping = 0;
+         gate_run->skipped_windows = 0;
+      }
+
+      run_chunks(arena, context, config, slice_count, samples_float32 + offset, slice_probabilities);
+      ++stats->gate_model_calls;
+   }
+}
+
+int run_inference(String8 model_path_arg,
+                  MemoryArena *arena,
+                  const VADC_Options *options,
+                  float desired_sequence_count,
+                  s32 preferred_batch_size,
+                  String8 filename,
+                  const char *audio_output_file,
+                  const char *log_output_file,
+                  const char *speech_audio_file,
+                  const char *noise_audio_file,
+                  b32 verbose_logging,
+                  VADC_Metrics *metrics )
+{
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+   config.model_file_hash_wanted = options->checkpoint_path != NULL;
+
+   // NOTE: all per-run output state lives here, so concurrent runs in one process don't share anything
+   VADC_Run run_state = {0};
+   VADC_Run *run = &run_state;
+   run->segments_output = stdout;
+   run->metrics = metrics;
+
+   // 初始化日志和音频输出
+   init_audio_logging(run, audio_output_file, log_output_file);
+   init_separated_audio_logging(run, speech_audio_file, noise_audio_file);
+   start_audio_sinks(run, options->audio_overflow);
+
+   run->verbose_logging = verbose_logging;
+
+   // 始终输出初始化信息到 stderr
+   fprintf(stderr, "\n🚀 初始化推理引擎...\n");
+   fprintf(stderr, "  模型路径: %.*s\n", (int)model_path_arg.size, model_path_arg.begin);
+   fflush(stderr);
+
+   if (run->verbose_logging)
+   {
+      vad_log(run, "════════════════════════════════════════════");
+      vad_log(run, "VADC - 语音活动检测系统");
+      vad_log(run, "════════════════════════════════════════════");
+      vad_log(run, "参数配置:");
+      vad_log(run, "  说话概率阈值: %.2f", options->threshold);
+      vad_log(run, "  最小沉默时长: %.0fms", options->min_silence_duration_ms);
+      vad_log(run, "  最小说话时长: %.0fms", options->min_speech_duration_ms);
+      vad_log(run, "  语音边界填充: %.0fms", options->speech_pad_ms);
+      if (audio_output_file)
+      {
+         vad_log(run, "  音频输出文件: %s", audio_output_file);
+      }
+      if (log_output_file)
+      {
+         vad_log(run, "  日志输出文件: %s", log_output_file);
+      }
+      vad_log(run, "════════════════════════════════════════════");
+   }
+
+   Arena_Measurement model_measurement = arena_measure_begin(arena);
+   run->backend_init_start_ns = vadc_now_ns();
+   void *backend = backend_init( arena, model_path_arg, &config );
+   run->arena_model_bytes = arena_measure_end(&model_measurement);
+
+   if ( !backend )
+   {
+      cleanup_audio_logging(run);
+      return -1;
+   }
+
+   silero_config_finalize( &config, preferred_batch_size, desired_sequence_count );
+
+   if (config.is_silero_v5)
+   {
+      fprintf(stderr, "%s", "Model arch is Silero v5\n");
+   }
+   fprintf(stderr, "Running with batch size %d\n", config.batch_size);
+   fprintf(stderr, "Running with sequence count %d\n", config.input_count);
+
+   int result = run_inference_on_backend(run, arena, backend, config, options, filename);
+
+   cleanup_audio_logging(run);
+
+   return result;
+}
+
+// NOTE: the scalar part of a checkpoint, the tensors are sections of their own
+typedef struct Run_Checkpoint Run_Checkpoint;
+struct Run_Checkpoint
+{
+   FeedState state;
+   FeedProbabilityResult buffered;
+   VADC_Event_Tracker event_tracker;
+   int global_chunk_index;
+   int current_speech_event;
+   // NOTE: where segments_output stood, -1 if it isn't a regular file
+   s64 output_offset;
+
+   double total_speech;
+   s64 event_starts;
+   s64 event_ends;
+   double event_first_start_latency_s;
+   double event_start_latency_total_s;
+   double event_end_latency_total_s;
+};
+
+// NOTE: everything that changes the probabilities or the segments, a checkpoint of another run doesn't load
+static u64 run_checkpoint_key(Silero_Config config, const VADC_Options *options, String8 filename)
+{
+   struct
+   {
+      u64 model_hash;
+      u64 filename_hash;
+      s64 input_size;
+      s64 input_mtime;
+      s32 input_count;
+      s32 batch_size;
+      s32 context_size;
+      s32 is_silero_v5;
+      s32 audio_source;
+      float start_seconds;
+      float min_silence_duration_ms;
+      float min_speech_duration_ms;
+      float threshold;
+      float neg_threshold;
+      float speech_pad_ms;
+      s32 raw_probabilities;
+      s32 output_format;
+      s32 events;
+   } key;
+   memset(&key, 0, sizeof(key));
+
+   key.model_hash = config.model_file_hash;
+   key.filename_hash = vadc_prob_cache_hash_bytes(filename.begin, filename.size);
+   char path[4096];
+   if (filename.size < (int)sizeof(path))
+   {
+      memcpy(path, filename.begin, filename.size);
+      path[filename.size] = 0;
+      struct stat input_stat;
+      if (stat(path, &input_stat) == 0)
+      {
+         key.input_size = (s64)input_stat.st_size;
+         key.input_mtime = (s64)input_stat.st_mtime;
+      }
+   }
+   key.input_count = config.input_count;
+   key.batch_size = config.batch_size;
+   key.context_size = config.context_size;
+   key.is_silero_v5 = config.is_silero_v5;
+   key.audio_source = options->audio_source;
+   key.start_seconds = options->start_seconds;
+   key.min_silence_duration_ms = options->min_silence_duration_ms;
+   key.min_speech_duration_ms = options->min_speech_duration_ms;
+   key.threshold = options->threshold;
+   key.neg_threshold = options->neg_threshold;
+   key.speech_pad_ms = options->speech_pad_ms;
+   key.raw_probabilities = options->raw_probabilities;
+   key.output_format = options->output_format;
+   key.events = options->events;
+   return vadc_prob_cache_hash_bytes(&key, sizeof(key));
+}
+
+static s64 run_output_offset(VADC_Run *run)
+{
+   struct stat output_stat;
+   int fd = fileno(run->segments_output);
+   if (fd < 0 || fstat(fd, &output_stat) != 0 || !S_ISREG(output_stat.st_mode))
+   {
+      return -1;
+   }
+   return (s64)lseek(fd, 0, SEEK_CUR);
+}
+
+static void run_sync_segments(VADC_Run *run)
+{
+   int fd = fileno(run->segments_output);
+   if (fd >= 0)
+   {
+      // NOTE: fails on pipes and terminals, there's nothing to keep then
+      fsync(fd);
+   }
+}
+
+// NOTE: the interrupted run may have written past its last checkpoint. If the output is the same file
+//       (appended to with >>, or opened 1<>), that part is cut off so nothing shows up twice.
+static void run_resume_output(VADC_Run *run, s64 output_offset)
+{
+   struct stat output_stat;
+   int fd = fileno(run->segments_output);
+   if (output_offset < 0 || fd < 0 || fstat(fd, &output_stat) != 0 || !S_ISREG(output_stat.st_mode))
+   {
+      return;
+   }
+   if ((s64)output_stat.st_size < output_offset)
+   {
+      fprintf(stderr, "Warning: the output holds less than the interrupted run wrote, append to it (>>) to keep the segments before the checkpoint\n");
+      return;
+   }
+   fflush(run->segments_output);
+   if (ftruncate(fd, (off_t)output_offset) != 0 || fseeko(run->segments_output, (off_t)output_offset, SEEK_SET) != 0)
+   {
+      fprintf(stderr, "Warning: couldn't cut the output back to the checkpoint\n");
+   }
+}
+
+int run_inference_on_backend(VADC_Run *run,
+                             MemoryArena *arena,
+                             void *backend,
+                             Silero_Config config,
+                             const VADC_Options *options,
+                             String8 filename)
+{
+   const float min_silence_duration_ms = options->min_silence_duration_ms;
+   const float min_speech_duration_ms = options->min_speech_duration_ms;
+   const float threshold = options->threshold;
+   const float neg_threshold = options->neg_threshold;
+   const float speech_pad_ms = options->speech_pad_ms;
+   const b32 raw_probabilities = options->raw_probabilities;
+   const Segment_Output_Format output_format = options->output_format;
+   const b32 stats_output_enabled = options->stats_output_enabled;
+   const int audio_source = options->audio_source;
+   const float start_seconds = options->start_seconds;
+
+   b32 is_silero_v5 = config.is_silero_v5;
+   int result = 0;
+
+   const float HARDCODED_CHUNK_DURATION_MS = config.input_count / (float)HARDCODED_SAMPLE_RATE * 1000.0f;
+
+   int min_speech_duration_chunks = (int)(min_speech_duration_ms / HARDCODED_CHUNK_DURATION_MS + 0.5f);
+   if (min_speech_duration_chunks < 1)
+   {
+      min_speech_duration_chunks = 1;
+   }
+
+   int min_silence_duration_chunks = (int)(min_silence_duration_ms / HARDCODED_CHUNK_DURATION_MS + 0.5f);
+   if (min_silence_duration_chunks < 1)
+   {
+      min_silence_duration_chunks = 1;
+   }
+
+
+   // NOTE: the whole run, so the peak covers the setup as well as every stage
+   Arena_Measurement run_measurement = arena_measure_begin(arena);
+
+   Run_Buffers run_buffers = push_run_buffers(arena, config);
+   Tensor_Buffers buffers = run_buffers.tensors;
+
+   // NOTE: live streams flush every write, a consumer is waiting on each line
+   float output_flush_ms = options->output_flush_ms > 0.0f ? options->output_flush_ms : VADC_OUTPUT_WRITER_DEFAULT_FLUSH_MS;
+   vadc_output_writer_init(&run->output, run->segments_output, run_buffers.output_buffer, VADC_OUTPUT_WRITER_BUFFER_BYTES,
+                           options->output_live || !filename.size, (s64)(output_flush_ms * 1e6f));
+
+   backend_create_tensors(config, backend, buffers);
+
+   // NOTE(irwin): read samples from a file or stdin and run inference
+   const size_t buffered_samples_count = run_buffers.buffered_samples_count;
+
+   Gate_Run gate_run = {0};
+   if (options->gate.enabled)
+   {
+      if (gate_run_init(&gate_run, arena, backend, config, &options->gate, buffered_samples_count) != 0)
+      {
+         gate_run_release(&gate_run);
+         backend_release_tensors(backend);
+         arena_measure_end(&run_measurement);
+         return -1;
+      }
+   }
+
+   // NOTE: --checkpoint, everything the windows after a checkpoint depend on: the lstm state, the v5
+   //       context (the tail of input_samples), the last outputs (a short last batch reuses them) and
+   //       the segmenter. Only for files, which can be read again up to the checkpoint, and not with
+   //       the gate or the audio outputs, whose state isn't in it.
+   b32 checkpoint_usable = options->checkpoint_path && filename.size && !options->gate.enabled &&
+                           !run->save_audio && !run->save_speech_audio && !run->save_noise_audio &&
+                           !options->extract_speech_path;
+   if (options->checkpoint_path && !checkpoint_usable)
+   {
+      fprintf(stderr, "Warning: --checkpoint is for file runs without --gate, --extract_speech or saved audio, ignored\n");
+   }
+
+   Run_Checkpoint checkpoint = {0};
+   // NOTE: malloc'ed, not from the arena, arena_bytes_required doesn't know about checkpoints
+   size_t backend_state_size = checkpoint_usable ? backend_state_bytes(backend) : 0;
+   u8 *backend_state = backend_state_size ? malloc(backend_state_size) : NULL;
+   int input_samples_count = ((int)buffers.window_size_samples + (is_silero_v5 ? config.context_size : 0)) * config.batch_size;
+   VADC_Checkpoint_Section checkpoint_sections[] =
+   {
+      { &checkpoint, sizeof(checkpoint) },
+      { buffers.lstm_h_out, (u32)(buffers.lstm_count * sizeof(float)) },
+      { buffers.lstm_c_out, (u32)(buffers.lstm_count * sizeof(float)) },
+      { buffers.input_samples, (u32)(input_samples_count * sizeof(float)) },
+      { buffers.output, (u32)(config.prob_tensor_element_count * sizeof(float)) },
+      { backend_state, backend_state ? (u32)backend_state_size : 0 },
+   };
+   u64 checkpoint_key = checkpoint_usable ? run_checkpoint_key(config, options, filename) : 0;
+   b32 resumed = 0;
+   s64 resume_position = 0;
+   if (checkpoint_usable && options->resume)
+   {
+      VADC_Checkpoint_Result checkpoint_result = vadc_checkpoint_read(options->checkpoint_path, checkpoint_key, &resume_position,
+                                                                      checkpoint_sections, (int)ArrayCount(checkpoint_sections));
+      if (checkpoint_result == VADC_Checkpoint_Ok)
+      {
+         resumed = 1;
+         if (backend_state)
+         {
+            backend_load_state(backend, backend_state);
+         }
+         run_resume_output(run, checkpoint.output_offset);
+         if (!run->quiet)
+         {
+            fprintf(stderr, "Resuming from %s at %.2fs\n", options->checkpoint_path, (double)resume_position / HARDCODED_SAMPLE_RATE);
+         }
+      }
+      else if (checkpoint_result == VADC_Checkpoint_Missing)
+      {
+         if (!run->quiet)
+         {
+            fprintf(stderr, "No checkpoint at %s yet, starting from the beginning\n", options->checkpoint_path);
+         }
+      }
+      else
+      {
+         fprintf(stderr, "Error: %s isn't a checkpoint of this input, model and settings\n", options->checkpoint_path);
+         free(backend_state);
+         gate_run_release(&gate_run);
+         backend_release_tensors(backend);
+         arena_measure_end(&run_measurement);
+         return -1;
+      }
+   }
 
-   short *samples_buffer_s16 = pushArray(arena, buffered_samples_count, short);
-   float *samples_buffer_float32 = pushArray(arena, buffered_samples_count, float);
-   float *probabilities_buffer = pushArray(arena, chunks_count, float);
+   short *samples_buffer_s16 = run_buffers.samples_s16;
+   float *samples_buffer_float32 = run_buffers.samples_float32;
+   float *probabilities_buffer = run_buffers.probabilities;
+
+   // NOTE: --prob_cache, only for files and only when the run needs nothing but the model's probabilities:
+   //       the gate changes them, and saving or extracting audio needs the samples a hit never decodes
+   VADC_Prob_Cache prob_cache = {0};
+   b32 prob_cache_hit = 0;
+   b32 prob_cache_usable = filename.size && vadc_prob_cache_dir() && config.model_file_hash && !options->gate.enabled &&
+                           !run->save_audio && !run->save_speech_audio && !run->save_noise_audio &&
+                           !options->extract_speech_path && !checkpoint_usable;
+   if (prob_cache_usable)
+   {
+      TemporaryMemory path_memory = beginTemporaryMemory(arena);
+      prob_cache_hit = vadc_prob_cache_open(&prob_cache, vadc_prob_cache_dir(), config.model_file_hash, backend_runtime_version(),
+                                            String8ToCString(arena, filename).begin,
+                                            (u32)config.input_count, HARDCODED_SAMPLE_RATE, audio_source, start_seconds);
+      endTemporaryMemory(path_memory);
+   }
 
    Buffered_Stream read_stream = {0};
 
    size_t buffered_samples_size_in_bytes = sizeof( short ) * buffered_samples_count;
-   if (filename.size)
+   if (prob_cache_hit)
+   {
+      // NOTE: nothing to decode, the loop reads the probabilities from the cache instead
+   }
+   else if (filename.size)
    {
       init_buffered_stream_ffmpeg(arena, &read_stream, filename, buffered_samples_size_in_bytes,
                   audio_source,
@@ -1007,6 +2395,28 @@ int run_inference(String8 model_path_arg,
       init_buffered_stream_stdin(arena, &read_stream, buffered_samples_size_in_bytes );
    }
 
+   if (resumed)
+   {
+      // NOTE: decoded again from the same start and thrown away up to the checkpoint. Seeking ffmpeg
+      //       there instead starts its decoder and resampler afresh, and the samples come out different.
+      s64 skip_bytes = resume_position * (s64)sizeof(short);
+      while (skip_bytes > 0 && read_stream.refill(&read_stream) == BS_Error_NoError)
+      {
+         skip_bytes -= read_stream.end - read_stream.start;
+         read_stream.cursor = read_stream.end;
+      }
+      if (skip_bytes != 0)
+      {
+         fprintf(stderr, "Error: the input ends before the checkpoint\n");
+         deinit_buffered_stream_file(&read_stream);
+         free(backend_state);
+         gate_run_release(&gate_run);
+         backend_release_tensors(backend);
+         arena_measure_end(&run_measurement);
+         return -1;
+      }
+   }
+
 
    VADC_Context context =
    {
@@ -1019,8 +2429,39 @@ int run_inference(String8 model_path_arg,
 
    FeedProbabilityResult buffered = {0};
 
+   run->events = raw_probabilities ? VADC_Event_Mode_Off : options->events;
+   VADC_Event_Tracker event_tracker = {0};
+   event_tracker.provisional = (run->events == VADC_Event_Mode_Provisional);
+   event_tracker.min_speech_duration_chunks = min_speech_duration_chunks;
+   VADC_Event events[VADC_EVENTS_PER_WINDOW_MAX];
+
+   VADC_Speech_Extractor extractor = {0};
+   run->extract = NULL;
+   if (options->extract_speech_path && !raw_probabilities)
+   {
+      if (vadc_speech_extract_open(&extractor, options->extract_speech_path, HARDCODED_SAMPLE_RATE, options->extract_lookbehind_s) == 0)
+      {
+         run->extract = &extractor;
+      }
+      else
+      {
+         fprintf(stderr, "Error: couldn't open %s for the extracted speech\n", options->extract_speech_path);
+         result = -1;
+      }
+   }
+
    VADC_Stats stats = {0};
    stats.output_enabled = stats_output_enabled;
+   stats.arena_model_bytes = run->arena_model_bytes;
+   stats.arena_setup_bytes = arena->used - run_measurement.used_before;
+   memcpy(stats.startup_ns, config.startup_ns, sizeof(stats.startup_ns));
+   stats.metadata_from_cache = config.metadata_from_cache;
+   stats.optimized_model_from_cache = config.optimized_model_from_cache;
+   stats.prob_cache_enabled = prob_cache_usable;
+   stats.prob_cache_hit = prob_cache_hit;
+   stats.gate_enabled = options->gate.enabled;
+   stats.gate_stage = options->gate.stage;
+   stats.events_enabled = (run->events != VADC_Event_Mode_Off);
    {
       struct timespec first_timestamp;
       clock_gettime(CLOCK_MONOTONIC, &first_timestamp);
@@ -1035,10 +2476,32 @@ int run_inference(String8 model_path_arg,
 
    s64 total_samples_read = 0;
 
+   if (resumed)
+   {
+      state = checkpoint.state;
+      buffered = checkpoint.buffered;
+      event_tracker = checkpoint.event_tracker;
+      global_chunk_index = checkpoint.global_chunk_index;
+      run->current_speech_event = checkpoint.current_speech_event;
+      stats.total_speech = checkpoint.total_speech;
+      stats.event_starts = checkpoint.event_starts;
+      stats.event_ends = checkpoint.event_ends;
+      stats.event_first_start_latency_s = checkpoint.event_first_start_latency_s;
+      stats.event_start_latency_total_s = checkpoint.event_start_latency_total_s;
+      stats.event_end_latency_total_s = checkpoint.event_end_latency_total_s;
+      total_samples_read = resume_position;
+   }
+   s64 last_checkpoint_ns = vadc_now_ns();
+   const s64 checkpoint_interval_ns = (s64)((double)options->checkpoint_interval_s * 1e9);
+   b32 checkpoint_write_failed = 0;
+
    // 日志：初始化完成，开始处理音频
-   fprintf(stderr, "✓ 初始化完成\n");
-   fprintf(stderr, "🎵 开始处理音频数据...\n");
-   fflush(stderr);
+   if (!run->quiet)
+   {
+      fprintf(stderr, "✓ 初始化完成\n");
+      fprintf(stderr, "🎵 开始处理音频数据...\n");
+      fflush(stderr);
+   }
 
    // NOTE(irwin): values_read is only accessed inside the for loop
    size_t values_read = 0;
@@ -1046,13 +2509,74 @@ int run_inference(String8 model_path_arg,
    {
       BS_Error read_error_code = 0;
 
-      // TODO(irwin): what do we do about errors that arose in refilling the buffered stream
-      // but some data was still read? Like EOF, or closed pipe?
-
-      read_error_code = read_stream.refill( &read_stream );
+      // NOTE: only after a full read, the windows of the reads after it then line up as they would have
+      if (checkpoint_usable && values_read == buffered_samples_count &&
+          vadc_now_ns() - last_checkpoint_ns >= checkpoint_interval_ns)
+      {
+         // NOTE: the segments up to here on disk before the checkpoint that says they were written,
+         //       or a power cut could resume past segments that never made it
+         run_flush_segments(run);
+         run_sync_segments(run);
+
+         memset(&checkpoint, 0, sizeof(checkpoint));
+         checkpoint.state = state;
+         checkpoint.buffered = buffered;
+         checkpoint.event_tracker = event_tracker;
+         checkpoint.global_chunk_index = global_chunk_index;
+         checkpoint.current_speech_event = run->current_speech_event;
+         checkpoint.output_offset = run_output_offset(run);
+         checkpoint.total_speech = stats.total_speech;
+         checkpoint.event_starts = stats.event_starts;
+         checkpoint.event_ends = stats.event_ends;
+         checkpoint.event_first_start_latency_s = stats.event_first_start_latency_s;
+         checkpoint.event_start_latency_total_s = stats.event_start_latency_total_s;
+         checkpoint.event_end_latency_total_s = stats.event_end_latency_total_s;
+         if (backend_state)
+         {
+            backend_save_state(backend, backend_state);
+         }
+
+         if (vadc_checkpoint_write(options->checkpoint_path, checkpoint_key, total_samples_read,
+                                   checkpoint_sections, (int)ArrayCount(checkpoint_sections)) == 0)
+         {
+            vad_log_at(run, VADC_Log_Debug, "checkpoint at %.2fs", (double)total_samples_read / HARDCODED_SAMPLE_RATE);
+         }
+         else if (!checkpoint_write_failed)
+         {
+            fprintf(stderr, "Warning: couldn't write the checkpoint %s\n", options->checkpoint_path);
+            checkpoint_write_failed = 1;
+         }
+         last_checkpoint_ns = vadc_now_ns();
+      }
+
+      // TODO(irwin): what do we do about errors that arose in refilling the buffered stream
+      // but some data was still read? Like EOF, or closed pipe?
+
+      s64 input_wait_start_ns = vadc_now_ns();
+      Arena_Measurement stage_measurement = arena_measure_begin(arena);
+      if (prob_cache_hit)
+      {
+         int cached_count = vadc_prob_cache_next(&prob_cache, probabilities_buffer, VADC_CHUNKS_PER_READ);
+         read_error_code = cached_count ? BS_Error_NoError : BS_Error_EndOfFile;
+         read_stream.error_code = read_error_code;
+         values_read = (size_t)cached_count * config.input_count;
+      }
+      else
+      {
+         read_error_code = read_stream.refill( &read_stream );
+         values_read = (read_stream.end - read_stream.start) / sizeof(short);
+      }
+      vadc_record_stage_arena(&stats, VADC_Stage_InputWait, &stage_measurement);
+      vadc_histogram_record(&stats.stage_latency[VADC_Stage_InputWait], vadc_now_ns() - input_wait_start_ns);
 
-      values_read = (read_stream.end - read_stream.start) / sizeof(short);
       total_samples_read += values_read;
+      VADC_METRIC_ADD(run->metrics, input_reads, 1);
+      VADC_METRIC_ADD(run->metrics, samples_processed, values_read);
+      if (read_error_code == BS_Error_NoError && values_read < buffered_samples_count)
+      {
+         // NOTE: the source couldn't keep the buffer full, on a live stream this means we're waiting on it
+         VADC_METRIC_ADD(run->metrics, input_underruns, 1);
+      }
       stats.total_samples = total_samples_read;
       stats.total_duration = (double)total_samples_read / HARDCODED_SAMPLE_RATE;
 
@@ -1061,16 +2585,28 @@ int run_inference(String8 model_path_arg,
       // fprintf(stderr, "%zu\n", values_read);
 
       //if (values_read > 0)
-      if ( read_error_code == BS_Error_NoError )
+      if ( read_error_code == BS_Error_NoError && prob_cache_hit )
+      {
+         // NOTE: the probabilities are already in probabilities_buffer
+      }
+      else if ( read_error_code == BS_Error_NoError )
       {
+         TracyCZoneN(convert_samples, "convert s16 to f32", true);
+
          memmove( samples_buffer_s16, read_stream.start, read_stream.end - read_stream.start );
          
          // 保存音频数据
-         if (g_save_audio)
+         if (run->save_audio)
          {
-            write_audio_samples(samples_buffer_s16, values_read);
+            write_audio_samples(run, samples_buffer_s16, values_read);
          }
-         
+         if (run->extract)
+         {
+            vadc_speech_extract_push(run->extract, samples_buffer_s16, values_read);
+         }
+
+         s64 conversion_start_ns = vadc_now_ns();
+         stage_measurement = arena_measure_begin(arena);
          float max_value = 0.0f;
          for (size_t i = 0; i < values_read; ++i)
          {
@@ -1107,6 +2643,10 @@ int run_inference(String8 model_path_arg,
                samples_buffer_float32[i] = 0.0f;
             }
          }
+         vadc_record_stage_arena(&stats, VADC_Stage_Conversion, &stage_measurement);
+         vadc_histogram_record(&stats.stage_latency[VADC_Stage_Conversion], vadc_now_ns() - conversion_start_ns);
+
+         TracyCZoneEnd(convert_samples);
       }
       else
       {
@@ -1115,21 +2655,27 @@ int run_inference(String8 model_path_arg,
             case BS_Error_CantOpenFile:
             {
                fprintf( stderr, "Error: BS_Error_CantOpenFile\n" );
+               result = -1;
             } break;
 
             case BS_Error_EndOfFile:
             {
-               fprintf( stderr, "Error: BS_Error_EndOfFile\n" );
+               if (!run->quiet)
+               {
+                  fprintf( stderr, "Error: BS_Error_EndOfFile\n" );
+               }
             } break;
 
             case BS_Error_Error:
             {
                fprintf( stderr, "Error: BS_Error_Error\n" );
+               result = -1;
             } break;
 
             case BS_Error_Memory:
             {
                fprintf( stderr, "Error: BS_Error_Memory\n" );
+               result = -1;
             } break;
 
             case BS_Error_NoError:
@@ -1146,7 +2692,20 @@ int run_inference(String8 model_path_arg,
          break;
       }
 
-      if (is_silero_v5)
+      s64 inference_start_ns = vadc_now_ns();
+      stage_measurement = arena_measure_begin(arena);
+      if (prob_cache_hit)
+      {
+      }
+      else if (options->gate.enabled)
+      {
+         process_chunks_gated( arena, context, config, &gate_run, &stats,
+                               samples_buffer_s16,
+                               values_read,
+                               samples_buffer_float32,
+                               probabilities_buffer);
+      }
+      else if (is_silero_v5)
       {
          process_chunks_v5( arena, context, config,
                         values_read,
@@ -1160,13 +2719,46 @@ int run_inference(String8 model_path_arg,
                         samples_buffer_float32,
                         probabilities_buffer);
       }
+      vadc_record_stage_arena(&stats, VADC_Stage_Inference, &stage_measurement);
+      s64 emission_start_ns = vadc_now_ns();
+      if (!stats.startup_ns[VADC_Startup_FirstProbability] && values_read >= (size_t)config.input_count)
+      {
+         s64 startup_start_ns = run->backend_init_start_ns ? run->backend_init_start_ns : stats.first_call_timestamp;
+         stats.startup_ns[VADC_Startup_FirstProbability] = emission_start_ns - startup_start_ns;
+      }
+      vadc_histogram_record(&stats.stage_latency[VADC_Stage_Inference], emission_start_ns - inference_start_ns);
+      stage_measurement = arena_measure_begin(arena);
 
       int probabilities_count = (int)(values_read / (float)config.input_count);
+      vadc_prob_cache_record(&prob_cache, probabilities_buffer, probabilities_count);
+      VADC_METRIC_ADD(run->metrics, inference_ns, emission_start_ns - inference_start_ns);
+      VADC_METRIC_ADD(run->metrics, windows_processed, probabilities_count);
+
+      if (gate_run.shadow_backend)
+      {
+         // NOTE: --gate_drift, the same windows without the gate, outside the stage timings
+         run_chunks(arena, gate_run.shadow_context, config, values_read, samples_buffer_float32, gate_run.shadow_probabilities);
+         for (int i = 0; i < probabilities_count; ++i)
+         {
+            float gated = probabilities_buffer[i];
+            float ungated = gate_run.shadow_probabilities[i];
+            double abs_diff = fabs((double)gated - (double)ungated);
+            if (abs_diff > stats.gate_drift_max_abs_diff)
+            {
+               stats.gate_drift_max_abs_diff = abs_diff;
+            }
+            segment_track_feed(gate_run.tracks + 0, options, gated, global_chunk_index + i,
+                               min_silence_duration_chunks, min_speech_duration_chunks, HARDCODED_SECONDS_PER_CHUNK);
+            segment_track_feed(gate_run.tracks + 1, options, ungated, global_chunk_index + i,
+                               min_silence_duration_chunks, min_speech_duration_chunks, HARDCODED_SECONDS_PER_CHUNK);
+         }
+      }
       if (!raw_probabilities)
       {
          for (int i = 0; i < probabilities_count; ++i)
          {
             float probability = probabilities_buffer[i];
+            TracyCPlot("probability", probability);
             
             // 根据概率分离保存音频
             size_t chunk_start = i * config.input_count;
@@ -1176,10 +2768,10 @@ int run_inference(String8 model_path_arg,
                chunk_size = values_read - chunk_start;
             }
             
-            if (chunk_size > 0 && (g_save_speech_audio || g_save_noise_audio))
+            if (chunk_size > 0 && (run->save_speech_audio || run->save_noise_audio))
             {
                b32 is_speech = (probability > threshold);
-               write_separated_audio_samples(&samples_buffer_s16[chunk_start], chunk_size, is_speech);
+               write_separated_audio_samples(run, &samples_buffer_s16[chunk_start], chunk_size, is_speech);
             }
 
             FeedProbabilityResult feed_result = feed_probability(&state,
@@ -1190,45 +2782,63 @@ int run_inference(String8 model_path_arg,
                           neg_threshold,
                           global_chunk_index
                           );
+            if (state.triggered)
+            {
+               VADC_METRIC_ADD(run->metrics, speech_windows, 1);
+            }
+            if (run->events)
+            {
+               int event_count = vadc_event_tracker_feed(&event_tracker, &state, feed_result, global_chunk_index, events);
+               emit_events(run, events, event_count, speech_pad_ms, &stats, HARDCODED_SECONDS_PER_CHUNK);
+            }
 
          if (feed_result.is_valid)
          {
-            buffered = combine_or_emit_speech_segment(buffered, feed_result,
+            buffered = combine_or_emit_speech_segment(run, buffered, feed_result,
                                                       speech_pad_ms, output_format, &stats, HARDCODED_SECONDS_PER_CHUNK);
             
             // 日志：检测到语音事件（总是输出到 stderr）
-            double start_time = feed_result.speech_start * HARDCODED_SECONDS_PER_CHUNK;
-            double end_time = feed_result.speech_end * HARDCODED_SECONDS_PER_CHUNK;
-            fprintf(stderr, "🎤 检测到语音事件 | 时间: %.2f-%.2f秒 (时长: %.2f秒) | 概率: %.1f%%\n",
-                    start_time, end_time, end_time - start_time, probability * 100.0f);
-            fflush(stderr);
+            if (!run->quiet)
+            {
+               double start_time = feed_result.speech_start * HARDCODED_SECONDS_PER_CHUNK;
+               double end_time = feed_result.speech_end * HARDCODED_SECONDS_PER_CHUNK;
+               vad_log_stderr(VADC_Log_Info, "🎤 检测到语音事件 | 时间: %.2f-%.2f秒 (时长: %.2f秒) | 概率: %.1f%%",
+                              start_time, end_time, end_time - start_time, probability * 100.0f);
+            }
             
-            if (g_verbose_logging)
+            if (run->verbose_logging)
             {
                double start_time = feed_result.speech_start * HARDCODED_SECONDS_PER_CHUNK;
                double end_time = feed_result.speech_end * HARDCODED_SECONDS_PER_CHUNK;
-               vad_log("🎤 事件 #%d | 说话: %.2f-%.2f秒 (时长: %.2f秒) | 概率: %.2f%%",
-                       ++g_current_speech_event,
+               vad_log(run, "🎤 事件 #%d | 说话: %.2f-%.2f秒 (时长: %.2f秒) | 概率: %.2f%%",
+                       ++run->current_speech_event,
                        start_time, end_time,
                        end_time - start_time,
                        probability * 100.0f);
             }
          }
          
-         if (g_verbose_logging && (global_chunk_index % 10 == 0))
+         if (run->extract)
+         {
+            extract_speech_certain(run, &state, buffered, global_chunk_index, min_speech_duration_chunks,
+                                   speech_pad_ms, HARDCODED_SECONDS_PER_CHUNK);
+         }
+
+         if (run->verbose_logging && (global_chunk_index % 10 == 0))
          {
             if (probability > threshold)
             {
-               vad_log("  [▶] 正在说话: %.2f%%", probability * 100.0f);
+               vad_log_at(run, VADC_Log_Debug, "  [▶] 正在说话: %.2f%%", probability * 100.0f);
             }
             else if (state.triggered)
             {
-               vad_log("  [─] 继续说话: %.2f%%", probability * 100.0f);
+               vad_log_at(run, VADC_Log_Debug, "  [─] 继续说话: %.2f%%", probability * 100.0f);
             }
          }
 
             // printf("%f\n", probability);
             ++global_chunk_index;
+            TracyCFrameMark;
          }
       }
       else
@@ -1241,75 +2851,1559 @@ int run_inference(String8 model_path_arg,
          for (int i = 0; i < probabilities_count; ++i)
          {
             float probability = probabilities_buffer[i];
-            printf("%f\n", probability);
-            fflush(stdout);  // 立即刷新输出
+            TracyCPlot("probability", probability);
+            char line[64];
+            int line_length = format_probability(line, sizeof(line), probability, global_chunk_index, output_format, HARDCODED_SECONDS_PER_CHUNK);
+            run_write_segments(run, line, (size_t)line_length);
             ++global_chunk_index;
+            TracyCFrameMark;
          }
          
          // 记录处理速度（仅在详细日志模式下）
-         if (g_verbose_logging && probabilities_count > 0)
+         if (run->verbose_logging && probabilities_count > 0)
+         {
+            vad_log_at(run, VADC_Log_Debug, "📊 [%.0fms] 已处理 %d 个概率 | 总时长: %.2fs",
+                       elapsed_ms,
+                       probabilities_count,
+                       stats.total_duration);
+         }
+      }
+      vadc_record_stage_arena(&stats, VADC_Stage_Emission, &stage_measurement);
+      vadc_histogram_record(&stats.stage_latency[VADC_Stage_Emission], vadc_now_ns() - emission_start_ns);
+      vadc_record_run_arena(&stats, &run_measurement);
+
+      VADC_METRIC_SET(run->metrics, arena_used_bytes, arena->used);
+      VADC_METRIC_SET(run->metrics, arena_peak_bytes, arena->peak_used);
+      VADC_METRIC_SET(run->metrics, arena_size_bytes, arena->size);
+
+      if (vadc_stats_dump_requested)
+      {
+         vadc_stats_dump_requested = 0;
+         dump_stage_latencies(options, &stats);
+      }
+
+   }
+
+   // TODO(irwin):
+   deinit_buffered_stream_file( &read_stream );
+   if ( read_stream.pipe_exit_status != 0 )
+   {
+      // NOTE: ffmpeg failed, e.g. missing or undecodable input, which otherwise just looks like an empty stream
+      result = -1;
+   }
+
+   if (prob_cache_hit)
+   {
+      stats.total_samples = (s64)prob_cache.key.total_samples;
+      stats.total_duration = (double)stats.total_samples / HARDCODED_SAMPLE_RATE;
+   }
+   else if (prob_cache.recording && result == 0)
+   {
+      stats.prob_cache_stored = (vadc_prob_cache_store(&prob_cache, (u64)total_samples_read) == 0);
+   }
+   vadc_prob_cache_close(&prob_cache);
+
+   if (!raw_probabilities)
+   {
+      // NOTE(irwin): snap last speech segment to actual audio length
+      if (state.triggered)
+      {
+         int audio_length_samples = (int)((global_chunk_index - 1) * config.input_count);
+         if (audio_length_samples - (state.current_speech_start * config.input_count) > (min_speech_duration_chunks * config.input_count))
+         {
+            FeedProbabilityResult final_segment;
+            final_segment.is_valid = 1;
+            final_segment.speech_start = state.current_speech_start;
+            final_segment.speech_end = (int)(audio_length_samples / config.input_count);
+
+            buffered = combine_or_emit_speech_segment(run, buffered, final_segment,
+                                                         speech_pad_ms, output_format, &stats, HARDCODED_SECONDS_PER_CHUNK);
+         }
+      }
+
+      if (run->events)
+      {
+         int event_count = vadc_event_tracker_finish(&event_tracker, global_chunk_index - 1, global_chunk_index, events);
+         emit_events(run, events, event_count, speech_pad_ms, &stats, HARDCODED_SECONDS_PER_CHUNK);
+      }
+
+      if (buffered.is_valid)
+      {
+         emit_speech_segment(run, buffered, speech_pad_ms, output_format, &stats, HARDCODED_SECONDS_PER_CHUNK);
+      }
+   }
+
+   if (run->extract)
+   {
+      stats.extract_enabled = 1;
+      stats.extract_written_samples = extractor.written_samples;
+      stats.extract_lost_samples = extractor.lost_samples;
+      if (vadc_speech_extract_close(&extractor) != 0)
+      {
+         fprintf(stderr, "Error: couldn't write all of %s\n", options->extract_speech_path);
+         result = -1;
+      }
+      if (extractor.lost_samples)
+      {
+         fprintf(stderr, "Warning: %.2fs of speech had already left the %.0fs extraction ring, raise --extract_lookbehind\n",
+                 (double)extractor.lost_samples / HARDCODED_SAMPLE_RATE, (double)options->extract_lookbehind_s);
+      }
+      run->extract = NULL;
+   }
+   run_flush_segments(run);
+
+   if (checkpoint_usable && result == 0)
+   {
+      // NOTE: done, a --resume of the same job starts over instead of going on from a stale checkpoint
+      unlink(options->checkpoint_path);
+   }
+   free(backend_state);
+
+   if (gate_run.shadow_backend)
+   {
+      int max_boundary_diff = 0;
+      for (int track = 0; track < 2; ++track)
+      {
+         segment_track_finish(gate_run.tracks + track, options, global_chunk_index, min_speech_duration_chunks, HARDCODED_SECONDS_PER_CHUNK);
+      }
+      for (int track = 0; track < 2; ++track)
+      {
+         stats.gate_drift_segments[track] = gate_run.tracks[track].segment_count;
+         stats.gate_drift_unmatched[track] = segment_track_unmatched(gate_run.tracks + track, gate_run.tracks + !track, &max_boundary_diff);
+      }
+      stats.gate_drift_max_boundary_s = max_boundary_diff * (double)HARDCODED_SECONDS_PER_CHUNK;
+      stats.gate_drift_measured = 1;
+   }
+   gate_run_release(&gate_run);
+
+   vadc_record_run_arena(&stats, &run_measurement);
+   arena_measure_end(&run_measurement);
+
+   print_speech_stats(run, &stats);
+   if (stats_output_enabled)
+   {
+      print_stage_latencies(run, &stats);
+   }
+   if (options->gate.enabled && (stats_output_enabled || stats.gate_drift_measured))
+   {
+      print_gate_stats(run, &stats);
+   }
+   if (stats.events_enabled && stats_output_enabled)
+   {
+      print_event_stats(run, &stats);
+   }
+   if (stats.extract_enabled && stats_output_enabled)
+   {
+      vad_log(run, "extracted speech: %.2fs written, %.2fs lost",
+              (double)stats.extract_written_samples / HARDCODED_SAMPLE_RATE, (double)stats.extract_lost_samples / HARDCODED_SAMPLE_RATE);
+   }
+   if (stats_output_enabled || options->stats_json_path)
+   {
+      dump_stage_latencies(options, &stats);
+   }
+   
+   if (run->verbose_logging)
+   {
+      vad_log(run, "════════════════════════════════════════════");
+      vad_log(run, "检测完成");
+      vad_log(run, "  总处理时长: %.2f秒", stats.total_duration);
+      vad_log(run, "  检测到语音事件: %d", run->current_speech_event);
+      if (run->save_audio)
+      {
+         vad_log(run, "  ✓ 音频已保存");
+      }
+      vad_log(run, "════════════════════════════════════════════");
+   }
+
+   backend_release_tensors(backend);
+
+   // NOTE: the run's messages are out before the caller goes on writing to stderr
+   vadc_log_flush();
+
+   // g_ort->ReleaseValue(output_tensor);
+   // g_ort->ReleaseValue(input_tensor);
+   // return ret;
+   return result;
+}
+
+// NOTE: the allocations run_inference_on_backend makes for a run on backend, in the same order so
+//       alignment padding comes out the same too, and one full read's worth of inference on silence for
+//       the scratch memory, through every model the gate (if enabled) runs as well. arena->peak_used
+//       covers the run afterwards. Returns -1 if the gate's first stage couldn't be loaded.
+static int run_arena_dry_run(MemoryArena *arena,
+                             void *backend,
+                             Silero_Config config,
+                             const VADC_Gate_Options *gate,
+                             String8 filename,
+                             int audio_source,
+                             float start_seconds)
+{
+   Run_Buffers run_buffers = push_run_buffers(arena, config);
+   backend_create_tensors(config, backend, run_buffers.tensors);
+
+   Gate_Run gate_run = {0};
+   if (gate && gate->enabled)
+   {
+      if (gate_run_init(&gate_run, arena, backend, config, gate, run_buffers.buffered_samples_count) != 0)
+      {
+         gate_run_release(&gate_run);
+         backend_release_tensors(backend);
+         return -1;
+      }
+   }
+
+   size_t buffered_samples_size_in_bytes = sizeof( short ) * run_buffers.buffered_samples_count;
+   if (filename.size)
+   {
+      push_ffmpeg_command(arena, filename, audio_source, start_seconds);
+   }
+   pushSizeZeroed(arena, buffered_samples_size_in_bytes, TEMP_DEFAULT_ALIGNMENT);
+
+   VADC_Context context =
+   {
+      .backend = backend,
+      .buffers = run_buffers.tensors,
+   };
+   run_chunks(arena, context, config, run_buffers.buffered_samples_count, run_buffers.samples_float32, run_buffers.probabilities);
+   if (gate_run.shadow_backend)
+   {
+      run_chunks(arena, gate_run.shadow_context, config, run_buffers.buffered_samples_count, run_buffers.samples_float32, gate_run.shadow_probabilities);
+   }
+#if ONNX_INFERENCE_ENABLED
+   if (gate_run.first_stage)
+   {
+      silero_c_run_window(arena, gate_run.first_stage, gate_run.first_stage_samples);
+   }
+#endif // ONNX_INFERENCE_ENABLED
+
+   gate_run_release(&gate_run);
+   backend_release_tensors(backend);
+   return 0;
+}
+
+// NOTE: room for any model we load, only the pages a dry run touches get committed
+#define VADC_DRY_RUN_SCRATCH_BYTES Megabytes(256)
+
+size_t arena_bytes_required(String8 model_path_arg,
+                            s32 preferred_batch_size,
+                            float desired_sequence_count,
+                            const VADC_Gate_Options *gate,
+                            String8 filename,
+                            int audio_source,
+                            float start_seconds)
+{
+   const size_t scratch_size = VADC_DRY_RUN_SCRATCH_BYTES;
+   u8 *scratch_memory = malloc(scratch_size);
+   if (!scratch_memory)
+   {
+      return 0;
+   }
+   MemoryArena scratch_arena = {0};
+   initializeMemoryArena(&scratch_arena, scratch_memory, scratch_size);
+   MemoryArena *arena = &scratch_arena;
+
+   // NOTE: the same allocations in the same order as run_inference
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+
+   size_t result = 0;
+   void *backend = backend_init( arena, model_path_arg, &config );
+   if (backend)
+   {
+      silero_config_finalize( &config, preferred_batch_size, desired_sequence_count );
+
+      if (run_arena_dry_run(arena, backend, config, gate, filename, audio_source, start_seconds) == 0)
+      {
+         result = arena->peak_used;
+      }
+
+      backend_release(backend);
+   }
+
+   free(scratch_memory);
+   return result;
+}
+
+typedef struct Inference_Many_Queue Inference_Many_Queue;
+struct Inference_Many_Queue
+{
+   const VADC_Options *options;
+   Silero_Config config;
+   String8 *filenames;
+   int file_count;
+   String8 output_dir;
+
+   // NOTE: next file to take; workers pull one file at a time, so long and short files even out
+   atomic_int next_file_index;
+   atomic_int failed_count;
+};
+
+typedef struct Inference_Many_Worker Inference_Many_Worker;
+struct Inference_Many_Worker
+{
+   pthread_t thread;
+   Inference_Many_Queue *queue;
+   MemoryArena arena;
+   void *backend;
+};
+
+static String8 inference_many_output_path(MemoryArena *arena, String8 filename, String8 output_dir)
+{
+   if (!output_dir.size)
+   {
+      return String8_pushf(arena, "%.*s.txt", (int)filename.size, filename.begin);
+   }
+
+   strSize name_start = filename.size;
+   while (name_start > 0 && filename.begin[name_start - 1] != '/')
+   {
+      --name_start;
+   }
+
+   return String8_pushf(arena, "%.*s/%.*s.txt",
+                        (int)output_dir.size, output_dir.begin,
+                        (int)(filename.size - name_start), filename.begin + name_start);
+}
+
+static int inference_many_compare_paths(const void *left, const void *right)
+{
+   const String8 *left_path = left;
+   const String8 *right_path = right;
+   strSize common = left_path->size < right_path->size ? left_path->size : right_path->size;
+   int order = memcmp(left_path->begin, right_path->begin, common);
+   if (order == 0)
+   {
+      order = (left_path->size > right_path->size) - (left_path->size < right_path->size);
+   }
+   return order;
+}
+
+// NOTE: with output_dir only the file names are kept, a/x.wav and b/x.wav would both write x.wav.txt
+//       and the later one would silently replace the earlier. Reports the first such pair.
+static b32 inference_many_find_collision(MemoryArena *arena, String8 *filenames, int file_count, String8 output_dir)
+{
+   if (!output_dir.size || file_count < 2)
+   {
+      return 0;
+   }
+
+   TemporaryMemory paths_memory = beginTemporaryMemory(arena);
+
+   String8 *output_paths = pushArray(arena, file_count, String8);
+   for (int file_index = 0; file_index < file_count; ++file_index)
+   {
+      output_paths[file_index] = inference_many_output_path(arena, filenames[file_index], output_dir);
+   }
+   qsort(output_paths, file_count, sizeof(String8), inference_many_compare_paths);
+
+   b32 collision = 0;
+   for (int path_index = 1; path_index < file_count && !collision; ++path_index)
+   {
+      if (inference_many_compare_paths(output_paths + path_index - 1, output_paths + path_index) == 0)
+      {
+         fprintf(stderr, "Fatal: more than one input file would write %.*s, give them different names or "
+                         "run them without --output_dir\n", (int)output_paths[path_index].size, output_paths[path_index].begin);
+         collision = 1;
+      }
+   }
+
+   endTemporaryMemory(paths_memory);
+   return collision;
+}
+
+// NOTE: a worker's arena holds its backend clone and, for one file at a time, the output path and
+//       everything run_inference_on_backend takes. Sized by a dry run on a clone, with the longest file
+//       name, which gives the longest path and ffmpeg command line.
+static size_t inference_many_worker_arena_bytes(void *backend,
+                                                Silero_Config config,
+                                                const VADC_Options *options,
+                                                String8 *filenames,
+                                                int file_count,
+                                                String8 output_dir)
+{
+   const size_t scratch_size = VADC_DRY_RUN_SCRATCH_BYTES;
+   u8 *scratch_memory = malloc(scratch_size);
+   if (!scratch_memory)
+   {
+      return 0;
+   }
+   MemoryArena scratch_arena = {0};
+   initializeMemoryArena(&scratch_arena, scratch_memory, scratch_size);
+   MemoryArena *arena = &scratch_arena;
+
+   String8 longest_filename = {0};
+   for (int file_index = 0; file_index < file_count; ++file_index)
+   {
+      if (filenames[file_index].size > longest_filename.size)
+      {
+         longest_filename = filenames[file_index];
+      }
+   }
+
+   void *clone = backend_clone(arena, backend);
+   inference_many_output_path(arena, longest_filename, output_dir);
+   size_t result = 0;
+   if (run_arena_dry_run(arena, clone, config, &options->gate, longest_filename, options->audio_source, options->start_seconds) == 0)
+   {
+      result = arena->peak_used;
+   }
+
+   free(scratch_memory);
+   return result;
+}
+
+static void *inference_many_worker_proc(void *param)
+{
+   Inference_Many_Worker *worker = param;
+   Inference_Many_Queue *queue = worker->queue;
+
+   for (;;)
+   {
+      int file_index = atomic_fetch_add(&queue->next_file_index, 1);
+      if (file_index >= queue->file_count)
+      {
+         break;
+      }
+
+      String8 filename = queue->filenames[file_index];
+
+      TemporaryMemory file_memory = beginTemporaryMemory(&worker->arena);
+
+      String8 output_path = inference_many_output_path(&worker->arena, filename, queue->output_dir);
+
+      int result = -1;
+      FILE *output_file = fopen(output_path.begin, "wb");
+      if (output_file)
+      {
+         VADC_Run run = {0};
+         run.segments_output = output_file;
+         run.quiet = 1;
+
+         result = run_inference_on_backend(&run, &worker->arena, worker->backend, queue->config, queue->options, filename);
+         fclose(output_file);
+      }
+      else
+      {
+         fprintf(stderr, "Error: couldn't open %s for writing\n", output_path.begin);
+      }
+
+      if (result != 0)
+      {
+         fprintf(stderr, "Error: failed to process %.*s\n", (int)filename.size, filename.begin);
+         atomic_fetch_add(&queue->failed_count, 1);
+      }
+
+      endTemporaryMemory(file_memory);
+   }
+
+   return NULL;
+}
+
+int run_inference_many(String8 model_path_arg,
+                       MemoryArena *arena,
+                       const VADC_Options *options,
+                       float desired_sequence_count,
+                       s32 preferred_batch_size,
+                       String8 *filenames,
+                       int file_count,
+                       String8 output_dir,
+                       int jobs)
+{
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+
+   void *backend = backend_init( arena, model_path_arg, &config );
+   if ( !backend )
+   {
+      return -1;
+   }
+
+   silero_config_finalize( &config, preferred_batch_size, desired_sequence_count );
+
+   if (inference_many_find_collision(arena, filenames, file_count, output_dir))
+   {
+      backend_release(backend);
+      return -1;
+   }
+
+   size_t worker_arena_size = inference_many_worker_arena_bytes(backend, config, options, filenames, file_count, output_dir);
+   if (!worker_arena_size)
+   {
+      fprintf(stderr, "Fatal: couldn't size the worker arenas\n");
+      backend_release(backend);
+      return -1;
+   }
+
+   if (jobs < 1)
+   {
+      jobs = 1;
+   }
+   if (jobs > file_count)
+   {
+      jobs = file_count > 0 ? file_count : 1;
+   }
+
+   fprintf(stderr, "Processing %d files with %d jobs\n", file_count, jobs);
+
+   Inference_Many_Queue queue = {0};
+   queue.options = options;
+   queue.config = config;
+   queue.filenames = filenames;
+   queue.file_count = file_count;
+   queue.output_dir = output_dir;
+   atomic_init(&queue.next_file_index, 0);
+   atomic_init(&queue.failed_count, 0);
+
+   Inference_Many_Worker *workers = pushArray(arena, jobs, Inference_Many_Worker);
+   int started_count = 0;
+   for (int worker_index = 0; worker_index < jobs; ++worker_index)
+   {
+      Inference_Many_Worker *worker = workers + worker_index;
+      u8 *worker_memory = malloc(worker_arena_size);
+      if (!worker_memory)
+      {
+         break;
+      }
+      initializeMemoryArena(&worker->arena, worker_memory, worker_arena_size);
+      worker->queue = &queue;
+      worker->backend = backend_clone(&worker->arena, backend);
+
+      if (pthread_create(&worker->thread, NULL, inference_many_worker_proc, worker) != 0)
+      {
+         free(worker_memory);
+         break;
+      }
+      ++started_count;
+   }
+
+   if (started_count == 0)
+   {
+      fprintf(stderr, "Fatal: couldn't start any worker\n");
+      backend_release(backend);
+      return -1;
+   }
+
+   for (int worker_index = 0; worker_index < started_count; ++worker_index)
+   {
+      pthread_join(workers[worker_index].thread, NULL);
+      free(workers[worker_index].arena.base);
+   }
+
+   // NOTE: the workers' clones share its session, it goes once they are all done
+   backend_release(backend);
+
+   int failed_count = atomic_load(&queue.failed_count);
+   fprintf(stderr, "Done: %d files, %d failed\n", file_count, failed_count);
+
+   return failed_count;
+}
+
+// NOTE: a deterministic speech-like test signal: 1.5s bursts of a harmonic voice-ish tone with a slow
+//       amplitude envelope, separated by 1s of low noise, so the segmenter sees both states
+static void bench_synthesize_audio(short *samples, size_t count)
+{
+   u32 noise_state = 0x12345678u;
+   const float pi = 3.14159265f;
+   const size_t burst_samples = (size_t)(1.5f * HARDCODED_SAMPLE_RATE);
+   const size_t pause_samples = (size_t)(1.0f * HARDCODED_SAMPLE_RATE);
+   const size_t period_samples = burst_samples + pause_samples;
+
+   for (size_t i = 0; i < count; ++i)
+   {
+      noise_state = noise_state * 1664525u + 1013904223u;
+      float noise = ((float)(noise_state >> 9) / (float)(1 << 23)) * 2.0f - 1.0f;
+
+      size_t period_index = i / period_samples;
+      size_t position = i % period_samples;
+      float value = noise * 0.005f;
+      if (position < burst_samples)
+      {
+         float t = (float)i / HARDCODED_SAMPLE_RATE;
+         float fundamental = 110.0f + 40.0f * (float)(period_index % 4);
+         float envelope = 0.5f - 0.5f * cosf(2.0f * pi * (float)position / (float)burst_samples);
+         float syllables = 0.6f + 0.4f * sinf(2.0f * pi * 4.0f * t);
+         float voice = 0.0f;
+         for (int harmonic = 1; harmonic <= 8; ++harmonic)
+         {
+            voice += sinf(2.0f * pi * fundamental * harmonic * t) / (float)harmonic;
+         }
+         value += voice * envelope * syllables * 0.2f + noise * 0.02f;
+      }
+
+      if (value > 1.0f) value = 1.0f;
+      if (value < -1.0f) value = -1.0f;
+      samples[i] = (short)(value * 32767.0f);
+   }
+}
+
+// NOTE: the whole file in malloc'ed memory, it can be far larger than the main arena
+static short *bench_read_raw_file(const char *path, size_t *out_count)
+{
+   FILE *file = fopen(path, "rb");
+   if (!file)
+   {
+      return NULL;
+   }
+
+   fseek(file, 0, SEEK_END);
+   long file_size = ftell(file);
+   fseek(file, 0, SEEK_SET);
+   if (file_size <= 0)
+   {
+      fclose(file);
+      return NULL;
+   }
+
+   size_t count = (size_t)file_size / sizeof(short);
+   short *samples = malloc(count * sizeof(short));
+   if (samples)
+   {
+      count = fread(samples, sizeof(short), count, file);
+   }
+   fclose(file);
+
+   *out_count = count;
+   return samples;
+}
+
+static int bench_compare_s64(const void *a, const void *b)
+{
+   s64 lhs = *(const s64 *)a;
+   s64 rhs = *(const s64 *)b;
+   return (lhs > rhs) - (lhs < rhs);
+}
+
+// NOTE: nearest-rank percentile of sorted values
+static s64 bench_percentile(const s64 *sorted, size_t count, double percentile)
+{
+   if (count == 0)
+   {
+      return 0;
+   }
+
+   size_t rank = (size_t)(percentile / 100.0 * (double)count + 0.999999);
+   if (rank < 1)
+   {
+      rank = 1;
+   }
+   if (rank > count)
+   {
+      rank = count;
+   }
+   return sorted[rank - 1];
+}
+
+typedef struct Bench_Result Bench_Result;
+struct Bench_Result
+{
+   s32 batch_size;
+   s32 sequence_count;
+   s64 windows;
+   s64 calls;
+   double wall_seconds;
+   s64 latency_p50_ns;
+   s64 latency_p95_ns;
+   s64 latency_p99_ns;
+   s64 latency_max_ns;
+   size_t peak_arena_bytes;
+   int segments;
+};
+
+// NOTE: sorts and frees latencies (result->calls of them)
+static void bench_summarize_latencies(Bench_Result *result, s64 *latencies)
+{
+   if (latencies)
+   {
+      qsort(latencies, (size_t)result->calls, sizeof(s64), bench_compare_s64);
+      result->latency_p50_ns = bench_percentile(latencies, (size_t)result->calls, 50.0);
+      result->latency_p95_ns = bench_percentile(latencies, (size_t)result->calls, 95.0);
+      result->latency_p99_ns = bench_percentile(latencies, (size_t)result->calls, 99.0);
+      result->latency_max_ns = result->calls ? latencies[result->calls - 1] : 0;
+      free(latencies);
+   }
+}
+
+static Bench_Result bench_run_config(MemoryArena *arena, void *backend, Silero_Config config,
+                                     const VADC_Options *options,
+                                     const short *samples, size_t sample_count)
+{
+   Bench_Result result = {0};
+   result.batch_size = config.batch_size;
+   result.sequence_count = config.input_count;
+
+   TemporaryMemory mark = beginTemporaryMemory(arena);
+   Arena_Measurement measurement = arena_measure_begin(arena);
+
+   // NOTE: same tensor buffers run_inference_on_backend sets up
+   Tensor_Buffers buffers = push_tensor_buffers(arena, config);
+
+   backend_create_tensors(config, backend, buffers);
+
+   VADC_Context context =
+   {
+      .backend = backend,
+      .buffers = buffers,
+   };
+
+   // NOTE: one call covers batch_size windows, which all finish together, so every window in it sees
+   //       the latency of the whole call
+   const size_t block_samples = (size_t)config.input_count * config.batch_size;
+   float *block_float32 = pushArray(arena, block_samples, float);
+   float *probabilities = pushArray(arena, config.batch_size, float);
+
+   s64 call_count = (s64)((sample_count + block_samples - 1) / block_samples);
+   s64 *latencies = malloc((call_count > 0 ? call_count : 1) * sizeof(s64));
+
+   const float seconds_per_chunk = (float)config.input_count / HARDCODED_SAMPLE_RATE;
+   const float chunk_duration_ms = seconds_per_chunk * 1000.0f;
+   int min_speech_duration_chunks = (int)(options->min_speech_duration_ms / chunk_duration_ms + 0.5f);
+   int min_silence_duration_chunks = (int)(options->min_silence_duration_ms / chunk_duration_ms + 0.5f);
+   if (min_speech_duration_chunks < 1) min_speech_duration_chunks = 1;
+   if (min_silence_duration_chunks < 1) min_silence_duration_chunks = 1;
+
+   FeedState state = {0};
+   FeedProbabilityResult buffered = {0};
+   int global_chunk_index = 0;
+
+   // NOTE: one untimed call to get lazy allocations and first-touch page faults out of the measurement
+   if (call_count > 0 && latencies)
+   {
+      memset(block_float32, 0, block_samples * sizeof(float));
+      if (config.is_silero_v5)
+      {
+         process_chunks_v5(arena, context, config, block_samples, block_float32, probabilities);
+      }
+      else
+      {
+         process_chunks(arena, context, config, block_samples, block_float32, probabilities);
+      }
+      memset(buffers.input_samples, 0, (config.is_silero_v5 ? (buffers.window_size_samples + config.context_size) : buffers.window_size_samples) * config.batch_size * sizeof(float));
+      memset(buffers.lstm_h_out, 0, buffers.lstm_count * sizeof(float));
+      memset(buffers.lstm_c_out, 0, buffers.lstm_count * sizeof(float));
+   }
+
+   s64 start_ns = vadc_now_ns();
+   for (s64 call_index = 0; latencies && call_index < call_count; ++call_index)
+   {
+      s64 call_start_ns = vadc_now_ns();
+
+      size_t offset = (size_t)call_index * block_samples;
+      size_t values_read = sample_count - offset;
+      if (values_read > block_samples)
+      {
+         values_read = block_samples;
+      }
+
+      for (size_t i = 0; i < values_read; ++i)
+      {
+         block_float32[i] = samples[offset + i] / 32768.0f;
+      }
+      for (size_t i = values_read; i < block_samples; ++i)
+      {
+         block_float32[i] = 0.0f;
+      }
+
+      if (config.is_silero_v5)
+      {
+         process_chunks_v5(arena, context, config, values_read, block_float32, probabilities);
+      }
+      else
+      {
+         process_chunks(arena, context, config, values_read, block_float32, probabilities);
+      }
+
+      int probabilities_count = (int)(values_read / (float)config.input_count);
+      for (int i = 0; i < probabilities_count; ++i)
+      {
+         FeedProbabilityResult feed_result = feed_probability(&state,
+                                                              min_silence_duration_chunks,
+                                                              min_speech_duration_chunks,
+                                                              probabilities[i],
+                                                              options->threshold,
+                                                              options->neg_threshold,
+                                                              global_chunk_index);
+         if (feed_result.is_valid)
+         {
+            FeedProbabilityResult finished = {0};
+            buffered = combine_speech_segment(buffered, feed_result, options->speech_pad_ms, seconds_per_chunk, &finished);
+            result.segments += finished.is_valid;
+         }
+         ++global_chunk_index;
+      }
+
+      latencies[call_index] = vadc_now_ns() - call_start_ns;
+   }
+   s64 end_ns = vadc_now_ns();
+
+   result.segments += buffered.is_valid;
+   result.windows = global_chunk_index;
+   result.calls = latencies ? call_count : 0;
+   result.wall_seconds = (double)(end_ns - start_ns) / 1e9;
+   result.peak_arena_bytes = arena_measure_end(&measurement);
+
+   bench_summarize_latencies(&result, latencies);
+
+   backend_release_tensors(backend);
+   endTemporaryMemory(mark);
+
+   return result;
+}
+
+#if ONNX_INFERENCE_ENABLED
+// NOTE: the pure C engine of silero_c.c, one SILERO_C_WINDOW_SAMPLES window per call as it has no
+//       batching, with the same segmentation as bench_run_config
+static Bench_Result bench_run_silero_c(MemoryArena *arena, Silero_Context *c_backend,
+                                       const VADC_Options *options,
+                                       const short *samples, size_t sample_count)
+{
+   Bench_Result result = {0};
+   result.batch_size = 1;
+   result.sequence_count = SILERO_C_WINDOW_SAMPLES;
+
+   TemporaryMemory mark = beginTemporaryMemory(arena);
+   Arena_Measurement measurement = arena_measure_begin(arena);
+
+   float *window = pushArray(arena, SILERO_C_WINDOW_SAMPLES, float);
+
+   s64 call_count = (s64)((sample_count + SILERO_C_WINDOW_SAMPLES - 1) / SILERO_C_WINDOW_SAMPLES);
+   s64 *latencies = malloc((call_count > 0 ? call_count : 1) * sizeof(s64));
+
+   const float seconds_per_chunk = (float)SILERO_C_WINDOW_SAMPLES / HARDCODED_SAMPLE_RATE;
+   const float chunk_duration_ms = seconds_per_chunk * 1000.0f;
+   int min_speech_duration_chunks = (int)(options->min_speech_duration_ms / chunk_duration_ms + 0.5f);
+   int min_silence_duration_chunks = (int)(options->min_silence_duration_ms / chunk_duration_ms + 0.5f);
+   if (min_speech_duration_chunks < 1) min_speech_duration_chunks = 1;
+   if (min_silence_duration_chunks < 1) min_silence_duration_chunks = 1;
+
+   FeedState state = {0};
+   FeedProbabilityResult buffered = {0};
+
+   s64 start_ns = vadc_now_ns();
+   for (s64 call_index = 0; latencies && call_index < call_count; ++call_index)
+   {
+      s64 call_start_ns = vadc_now_ns();
+
+      size_t offset = (size_t)call_index * SILERO_C_WINDOW_SAMPLES;
+      size_t values_read = sample_count - offset;
+      if (values_read > SILERO_C_WINDOW_SAMPLES)
+      {
+         values_read = SILERO_C_WINDOW_SAMPLES;
+      }
+      for (size_t i = 0; i < values_read; ++i)
+      {
+         window[i] = samples[offset + i] / 32768.0f;
+      }
+      for (size_t i = values_read; i < SILERO_C_WINDOW_SAMPLES; ++i)
+      {
+         window[i] = 0.0f;
+      }
+
+      float probability = silero_c_run_window(arena, c_backend, window);
+
+      // NOTE: like process_chunks, a partial last window isn't a chunk of its own
+      if (values_read == SILERO_C_WINDOW_SAMPLES)
+      {
+         FeedProbabilityResult feed_result = feed_probability(&state,
+                                                              min_silence_duration_chunks,
+                                                              min_speech_duration_chunks,
+                                                              probability,
+                                                              options->threshold,
+                                                              options->neg_threshold,
+                                                              (int)result.windows);
+         if (feed_result.is_valid)
+         {
+            FeedProbabilityResult finished = {0};
+            buffered = combine_speech_segment(buffered, feed_result, options->speech_pad_ms, seconds_per_chunk, &finished);
+            result.segments += finished.is_valid;
+         }
+         ++result.windows;
+      }
+
+      latencies[call_index] = vadc_now_ns() - call_start_ns;
+   }
+   s64 end_ns = vadc_now_ns();
+
+   result.segments += buffered.is_valid;
+   result.calls = latencies ? call_count : 0;
+   result.wall_seconds = (double)(end_ns - start_ns) / 1e9;
+   result.peak_arena_bytes = arena_measure_end(&measurement);
+
+   bench_summarize_latencies(&result, latencies);
+
+   endTemporaryMemory(mark);
+
+   return result;
+}
+#endif // ONNX_INFERENCE_ENABLED
+
+static void bench_print_result(const char *backend_name, Bench_Result result, double audio_seconds, b32 first)
+{
+   double throughput = result.wall_seconds > 0.0 ? audio_seconds / result.wall_seconds : 0.0;
+
+   fprintf(stderr, "  %-5s batch %3d  sequence %5d  %8.1fx real time  p50 %8.1fus  p99 %8.1fus\n",
+           backend_name, result.batch_size, result.sequence_count, throughput,
+           result.latency_p50_ns / 1000.0, result.latency_p99_ns / 1000.0);
+
+   printf("%s\n    {\"backend\": \"%s\", \"batch_size\": %d, \"sequence_count\": %d, \"windows\": %lld, \"calls\": %lld, "
+          "\"wall_seconds\": %.6f, \"audio_seconds_per_wall_second\": %.3f, "
+          "\"window_latency_us\": {\"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}, "
+          "\"peak_arena_bytes\": %zu, \"segments\": %d}",
+          first ? "" : ",", backend_name,
+          result.batch_size, result.sequence_count, (long long)result.windows, (long long)result.calls,
+          result.wall_seconds, throughput,
+          result.latency_p50_ns / 1000.0, result.latency_p95_ns / 1000.0,
+          result.latency_p99_ns / 1000.0, result.latency_max_ns / 1000.0,
+          result.peak_arena_bytes, result.segments);
+   fflush(stdout);
+}
+
+int run_benchmark(String8 model_path_arg,
+                  MemoryArena *arena,
+                  const VADC_Bench_Options *bench)
+{
+#if ONNX_INFERENCE_ENABLED
+   const char *backend_name = "onnx";
+#else
+   const char *backend_name = "c";
+#endif // ONNX_INFERENCE_ENABLED
+
+   Silero_Config base_config = {0};
+   base_config.batch_size_restriction = 1;
+   base_config.batch_size = 1;
+
+   void *backend = backend_init( arena, model_path_arg, &base_config );
+   if ( !backend )
+   {
+      return -1;
+   }
+
+   size_t sample_count = 0;
+   short *samples = NULL;
+   if (bench->input_path)
+   {
+      samples = bench_read_raw_file(bench->input_path, &sample_count);
+      if (!samples)
+      {
+         fprintf(stderr, "Fatal: couldn't read benchmark input %s\n", bench->input_path);
+         backend_release(backend);
+         return -1;
+      }
+   }
+   else
+   {
+      sample_count = (size_t)(bench->synthetic_seconds * HARDCODED_SAMPLE_RATE);
+      samples = malloc(sample_count * sizeof(short));
+      if (!samples)
+      {
+         fprintf(stderr, "Fatal: couldn't allocate benchmark audio\n");
+         backend_release(backend);
+         return -1;
+      }
+      bench_synthesize_audio(samples, sample_count);
+   }
+
+   double audio_seconds = (double)sample_count / HARDCODED_SAMPLE_RATE;
+   fprintf(stderr, "Benchmarking %s backend on %.1fs of %s audio\n",
+           backend_name, audio_seconds, bench->input_path ? "file" : "synthetic");
+
+   printf("{\n");
+   printf("  \"backend\": \"%s\",\n", backend_name);
+   printf("  \"model\": \"%.*s\",\n", (int)model_path_arg.size, model_path_arg.begin);
+   printf("  \"is_silero_v5\": %d,\n", base_config.is_silero_v5 ? 1 : 0);
+   printf("  \"audio_seconds\": %.3f,\n", audio_seconds);
+   printf("  \"results\": [");
+
+   // NOTE: the model restricts what it accepts, so different requests can land on the same config
+   s32 done_batch[VADC_BENCH_MAX_SWEEP * VADC_BENCH_MAX_SWEEP];
+   s32 done_sequence[VADC_BENCH_MAX_SWEEP * VADC_BENCH_MAX_SWEEP];
+   int done_count = 0;
+
+   for (int batch_index = 0; batch_index < bench->batch_size_count; ++batch_index)
+   {
+      for (int sequence_index = 0; sequence_index < bench->sequence_count_count; ++sequence_index)
+      {
+         Silero_Config config = base_config;
+         silero_config_finalize(&config, bench->batch_sizes[batch_index], (float)bench->sequence_counts[sequence_index]);
+
+         b32 already_done = 0;
+         for (int i = 0; i < done_count; ++i)
+         {
+            if (done_batch[i] == config.batch_size && done_sequence[i] == config.input_count)
+            {
+               already_done = 1;
+            }
+         }
+         if (already_done)
+         {
+            continue;
+         }
+         done_batch[done_count] = config.batch_size;
+         done_sequence[done_count] = config.input_count;
+
+         Bench_Result result = bench_run_config(arena, backend, config, bench->options, samples, sample_count);
+         bench_print_result(backend_name, result, audio_seconds, done_count == 0);
+
+         ++done_count;
+      }
+   }
+
+#if ONNX_INFERENCE_ENABLED
+   // NOTE: the pure C engine on the same audio, for comparison. Its weights are optional here, the
+   //       default path is relative to the working directory.
+   {
+      const char *c_weights_path = bench->c_weights_path ? bench->c_weights_path : VADC_CROSSVAL_DEFAULT_C_WEIGHTS;
+      TemporaryMemory c_memory = beginTemporaryMemory(arena);
+      Silero_Context *c_backend = silero_c_init(arena, c_weights_path);
+      if (c_backend)
+      {
+         Bench_Result result = bench_run_silero_c(arena, c_backend, bench->options, samples, sample_count);
+         bench_print_result("c", result, audio_seconds, done_count == 0);
+         ++done_count;
+      }
+      else
+      {
+         fprintf(stderr, "Warning: couldn't load C backend weights from %s, the c backend isn't benchmarked\n", c_weights_path);
+      }
+      endTemporaryMemory(c_memory);
+   }
+#endif // ONNX_INFERENCE_ENABLED
+
+   printf("\n  ]\n}\n");
+
+   free(samples);
+   backend_release(backend);
+   return 0;
+}
+
+int run_crossval(String8 model_path_arg,
+                 MemoryArena *arena,
+                 const char *c_weights_path,
+                 const VADC_Options *options,
+                 String8 filename,
+                 VADC_Crossval_Report *report)
+{
+   memset(report, 0, sizeof(*report));
+
+#if ONNX_INFERENCE_ENABLED
+   if (!c_weights_path)
+   {
+      c_weights_path = VADC_CROSSVAL_DEFAULT_C_WEIGHTS;
+   }
+
+   Silero_Context *c_backend = silero_c_init(arena, c_weights_path);
+   if (!c_backend)
+   {
+      fprintf(stderr, "Fatal: couldn't load C backend weights from %s\n", c_weights_path);
+      return -1;
+   }
+
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+
+   void *backend = backend_init( arena, model_path_arg, &config );
+   if ( !backend )
+   {
+      return -1;
+   }
+   if (config.is_silero_v5)
+   {
+      fprintf(stderr, "Fatal: the C backend only implements Silero v3.1, pass a v3 model\n");
+      backend_release(backend);
+      return -1;
+   }
+
+   // NOTE: one window per call on both sides, the C backend has no batching
+   silero_config_finalize( &config, 1, (float)SILERO_C_WINDOW_SAMPLES );
+   if (config.input_count != SILERO_C_WINDOW_SAMPLES || config.batch_size != 1)
+   {
+      fprintf(stderr, "Fatal: the model doesn't take single windows of %d samples\n", SILERO_C_WINDOW_SAMPLES);
+      backend_release(backend);
+      return -1;
+   }
+
+   Tensor_Buffers buffers = push_tensor_buffers(arena, config);
+   backend_create_tensors(config, backend, buffers);
+   VADC_Context context =
+   {
+      .backend = backend,
+      .buffers = buffers,
+   };
+
+   float *window = pushArray(arena, SILERO_C_WINDOW_SAMPLES, float);
+   size_t window_size_in_bytes = sizeof( short ) * SILERO_C_WINDOW_SAMPLES;
+
+   Buffered_Stream read_stream = {0};
+   if (filename.size)
+   {
+      init_buffered_stream_ffmpeg(arena, &read_stream, filename, window_size_in_bytes,
+                                  options->audio_source, options->start_seconds);
+   }
+   else
+   {
+      init_buffered_stream_stdin(arena, &read_stream, window_size_in_bytes);
+   }
+
+   const float seconds_per_chunk = (float)SILERO_C_WINDOW_SAMPLES / HARDCODED_SAMPLE_RATE;
+   const float chunk_duration_ms = seconds_per_chunk * 1000.0f;
+   int min_speech_duration_chunks = (int)(options->min_speech_duration_ms / chunk_duration_ms + 0.5f);
+   int min_silence_duration_chunks = (int)(options->min_silence_duration_ms / chunk_duration_ms + 0.5f);
+   if (min_speech_duration_chunks < 1) min_speech_duration_chunks = 1;
+   if (min_silence_duration_chunks < 1) min_silence_duration_chunks = 1;
+
+   Segment_Track sides[VADC_Crossval_Backend_COUNT] = {0};
+   s64 inference_ns[VADC_Crossval_Backend_COUNT] = {0};
+   double total_abs_diff = 0.0;
+   int global_chunk_index = 0;
+
+   while ( read_stream.error_code == BS_Error_NoError )
+   {
+      size_t values_read = (read_stream.end - read_stream.start) / sizeof(short);
+      // NOTE: a partial last window gives no probability in a normal run either
+      if (values_read < SILERO_C_WINDOW_SAMPLES)
+      {
+         break;
+      }
+
+      const short *samples = (const short *)read_stream.start;
+      for (size_t i = 0; i < SILERO_C_WINDOW_SAMPLES; ++i)
+      {
+         window[i] = samples[i] / 32768.0f;
+      }
+      read_stream.cursor = read_stream.end;
+
+      float probabilities[VADC_Crossval_Backend_COUNT];
+
+      s64 onnx_start_ns = vadc_now_ns();
+      process_chunks( arena, context, config, SILERO_C_WINDOW_SAMPLES, window, &probabilities[VADC_Crossval_Backend_Onnx] );
+      s64 c_start_ns = vadc_now_ns();
+      probabilities[VADC_Crossval_Backend_C] = silero_c_run_window( arena, c_backend, window );
+      s64 c_end_ns = vadc_now_ns();
+
+      inference_ns[VADC_Crossval_Backend_Onnx] += c_start_ns - onnx_start_ns;
+      inference_ns[VADC_Crossval_Backend_C] += c_end_ns - c_start_ns;
+
+      double abs_diff = fabs((double)probabilities[0] - (double)probabilities[1]);
+      total_abs_diff += abs_diff;
+      if (abs_diff > report->max_abs_diff)
+      {
+         report->max_abs_diff = abs_diff;
+         report->max_abs_diff_window = global_chunk_index;
+      }
+      report->threshold_disagreements += ((probabilities[0] >= options->threshold) != (probabilities[1] >= options->threshold));
+
+      for (int side = 0; side < VADC_Crossval_Backend_COUNT; ++side)
+      {
+         segment_track_feed(sides + side, options, probabilities[side], global_chunk_index,
+                       min_silence_duration_chunks, min_speech_duration_chunks, seconds_per_chunk);
+      }
+      report->speech_state_disagreements += (!sides[0].state.triggered != !sides[1].state.triggered);
+
+      ++global_chunk_index;
+      read_stream.refill( &read_stream );
+   }
+
+   deinit_buffered_stream_file( &read_stream );
+   int result = 0;
+   if ( read_stream.error_code != BS_Error_EndOfFile && read_stream.error_code != BS_Error_NoError )
+   {
+      result = -1;
+   }
+   if ( read_stream.pipe_exit_status != 0 )
+   {
+      result = -1;
+   }
+
+   int max_boundary_diff = 0;
+   for (int side = 0; side < VADC_Crossval_Backend_COUNT; ++side)
+   {
+      segment_track_finish(sides + side, options, global_chunk_index, min_speech_duration_chunks, seconds_per_chunk);
+   }
+   for (int side = 0; side < VADC_Crossval_Backend_COUNT; ++side)
+   {
+      report->segments[side] = sides[side].segment_count;
+      report->unmatched_segments[side] = segment_track_unmatched(sides + side, sides + !side, &max_boundary_diff);
+      report->inference_seconds[side] = inference_ns[side] / 1e9;
+      free(sides[side].segments);
+   }
+
+   report->windows = global_chunk_index;
+   report->audio_seconds = global_chunk_index * (double)seconds_per_chunk;
+   report->mean_abs_diff = global_chunk_index ? total_abs_diff / global_chunk_index : 0.0;
+   report->max_boundary_diff_s = max_boundary_diff * (double)seconds_per_chunk;
+
+   backend_release_tensors(backend);
+   backend_release(backend);
+
+   return result;
+#else
+   VAR_UNUSED(model_path_arg);
+   VAR_UNUSED(arena);
+   VAR_UNUSED(c_weights_path);
+   VAR_UNUSED(options);
+   VAR_UNUSED(filename);
+   fprintf(stderr, "Fatal: cross-validation needs the onnxruntime build, this one only has the C backend\n");
+   return -1;
+#endif // ONNX_INFERENCE_ENABLED
+}
+
+static void print_crossval_report(const VADC_Crossval_Report *report, String8 model_path_arg, const char *c_weights_path)
+{
+   static const char *backend_names[VADC_Crossval_Backend_COUNT] = { "onnx", "c" };
+
+   fprintf(stderr, "Cross-validated %lld windows (%.1fs of audio)\n", (long long)report->windows, report->audio_seconds);
+   fprintf(stderr, "  probability |diff|  max %.6f (window %lld)  mean %.6f\n",
+           report->max_abs_diff, (long long)report->max_abs_diff_window, report->mean_abs_diff);
+   fprintf(stderr, "  disagreeing windows: %lld on threshold, %lld on speech state\n",
+           (long long)report->threshold_disagreements, (long long)report->speech_state_disagreements);
+   for (int side = 0; side < VADC_Crossval_Backend_COUNT; ++side)
+   {
+      double speed = report->inference_seconds[side] > 0.0 ? report->audio_seconds / report->inference_seconds[side] : 0.0;
+      fprintf(stderr, "  %-4s  %d segments, %d unmatched, %.3fs inference, %.1fx real time\n",
+              backend_names[side], report->segments[side], report->unmatched_segments[side],
+              report->inference_seconds[side], speed);
+   }
+   fprintf(stderr, "  max boundary difference of overlapping segments: %.3fs\n", report->max_boundary_diff_s);
+
+   printf("{\"model\": \"%.*s\", \"c_weights\": \"%s\", \"windows\": %lld, \"audio_seconds\": %.3f, "
+          "\"max_abs_diff\": %.9f, \"max_abs_diff_window\": %lld, \"mean_abs_diff\": %.9f, "
+          "\"threshold_disagreements\": %lld, \"speech_state_disagreements\": %lld, \"max_boundary_diff_s\": %.3f, \"backends\": {",
+          (int)model_path_arg.size, model_path_arg.begin, c_weights_path,
+          (long long)report->windows, report->audio_seconds,
+          report->max_abs_diff, (long long)report->max_abs_diff_window, report->mean_abs_diff,
+          (long long)report->threshold_disagreements, (long long)report->speech_state_disagreements,
+          report->max_boundary_diff_s);
+   for (int side = 0; side < VADC_Crossval_Backend_COUNT; ++side)
+   {
+      printf("%s\"%s\": {\"segments\": %d, \"unmatched_segments\": %d, \"inference_seconds\": %.6f}",
+             side ? ", " : "", backend_names[side], report->segments[side], report->unmatched_segments[side],
+             report->inference_seconds[side]);
+   }
+   printf("}}\n");
+   fflush(stdout);
+}
+
+// NOTE: feed_probability for many configurations at once, one array per field so the per-window step is a
+//       plain loop over configurations the compiler vectorizes. Closed segments are rare, they are merged
+//       and stored one configuration at a time afterwards.
+typedef struct Sweep_State Sweep_State;
+struct Sweep_State
+{
+   int count;
+   float *threshold;
+   float *neg_threshold;
+   s32 *min_silence_chunks;
+   s32 *min_speech_chunks;
+
+   s32 *temp_end;
+   s32 *current_speech_start;
+   s32 *triggered;
+
+   // NOTE: written by every step, ended is set for the configurations that closed a long enough segment
+   s32 *ended;
+   s32 *ended_start;
+   s32 *ended_end;
+};
+
+// NOTE: restrict only counts on parameters, without it the compiler gives up on the alias checks between
+//       the arrays. Conditions are 0/-1 masks and x = (a & mask) | (b & ~mask) selects, so there's no
+//       control flow left in the loop either.
+static int sweep_step_arrays(int count, float probability, s32 global_chunk_index,
+                             const float *restrict threshold, const float *restrict neg_threshold,
+                             const s32 *restrict min_silence_chunks, const s32 *restrict min_speech_chunks,
+                             s32 *restrict temp_ends, s32 *restrict starts, s32 *restrict triggereds,
+                             s32 *restrict ended, s32 *restrict ended_start, s32 *restrict ended_end)
+{
+   int ended_count = 0;
+   for (int k = 0; k < count; ++k)
+   {
+      s32 above = -(s32)(probability >= threshold[k]);
+      s32 below = -(s32)(probability < neg_threshold[k]);
+      s32 triggered = -triggereds[k];
+      s32 start = starts[k];
+      s32 temp_end = temp_ends[k] & ~above;
+
+      s32 trigger = ~triggered & above;
+      start = (global_chunk_index & trigger) | (start & ~trigger);
+
+      s32 silent = triggered & below;
+      s32 mark_end = silent & -(s32)(temp_end == 0);
+      temp_end = (global_chunk_index & mark_end) | (temp_end & ~mark_end);
+      s32 close = silent & -(s32)(global_chunk_index - temp_end >= min_silence_chunks[k]);
+      s32 valid = close & -(s32)(temp_end - start >= min_speech_chunks[k]);
+
+      ended[k] = -valid;
+      ended_start[k] = start;
+      ended_end[k] = temp_end;
+      ended_count -= valid;
+
+      triggereds[k] = -((triggered | trigger) & ~close);
+      starts[k] = start & ~close;
+      temp_ends[k] = temp_end & ~close;
+   }
+   return ended_count;
+}
+
+// NOTE: one probability for every configuration, returns how many closed a segment
+static int sweep_step(Sweep_State *sweep, float probability, s32 global_chunk_index)
+{
+   return sweep_step_arrays(sweep->count, probability, global_chunk_index,
+                            sweep->threshold, sweep->neg_threshold,
+                            sweep->min_silence_chunks, sweep->min_speech_chunks,
+                            sweep->temp_end, sweep->current_speech_start, sweep->triggered,
+                            sweep->ended, sweep->ended_start, sweep->ended_end);
+}
+
+static float sweep_config_value(const VADC_Sweep_Options *sweep, VADC_Sweep_Param param, int value_index)
+{
+   if (sweep->value_counts[param] == 0)
+   {
+      const VADC_Options *options = sweep->options;
+      switch (param)
+      {
+         case VADC_Sweep_Param_Threshold:            return options->threshold;
+         case VADC_Sweep_Param_NegThresholdRelative: return options->threshold - options->neg_threshold;
+         case VADC_Sweep_Param_MinSilence:           return options->min_silence_duration_ms;
+         case VADC_Sweep_Param_MinSpeech:            return options->min_speech_duration_ms;
+         case VADC_Sweep_Param_SpeechPad:            return options->speech_pad_ms;
+         default:                                    return 0.0f;
+      }
+   }
+   return sweep->values[param][value_index];
+}
+
+int run_sweep(String8 model_path_arg,
+              MemoryArena *arena,
+              const VADC_Sweep_Options *sweep,
+              String8 filename)
+{
+   const VADC_Options *options = sweep->options;
+
+   int config_count = 1;
+   for (int param = 0; param < VADC_Sweep_Param_COUNT; ++param)
+   {
+      int value_count = sweep->value_counts[param] ? sweep->value_counts[param] : 1;
+      config_count *= value_count;
+      if (config_count > VADC_SWEEP_MAX_CONFIGS)
+      {
+         fprintf(stderr, "Fatal: the sweep has more than %d configurations\n", VADC_SWEEP_MAX_CONFIGS);
+         return -1;
+      }
+   }
+
+   Silero_Config config = {0};
+   config.batch_size_restriction = 1;
+   config.batch_size = 1;
+
+   void *backend = backend_init( arena, model_path_arg, &config );
+   if ( !backend )
+   {
+      return -1;
+   }
+   silero_config_finalize( &config, sweep->preferred_batch_size, sweep->desired_sequence_count );
+
+   Run_Buffers run_buffers = push_run_buffers(arena, config);
+   backend_create_tensors(config, backend, run_buffers.tensors);
+   VADC_Context context =
+   {
+      .backend = backend,
+      .buffers = run_buffers.tensors,
+   };
+
+   const float seconds_per_chunk = (float)config.input_count / HARDCODED_SAMPLE_RATE;
+   const float chunk_duration_ms = seconds_per_chunk * 1000.0f;
+
+   // NOTE: configuration k takes value (k / stride) % count of each parameter, the first parameter varies slowest
+   float *config_values = pushArray(arena, config_count * VADC_Sweep_Param_COUNT, float);
+   Sweep_State state = {0};
+   state.count = config_count;
+   state.threshold = pushArray(arena, config_count, float);
+   state.neg_threshold = pushArray(arena, config_count, float);
+   state.min_silence_chunks = pushArray(arena, config_count, s32);
+   state.min_speech_chunks = pushArray(arena, config_count, s32);
+   state.temp_end = pushArray(arena, config_count, s32);
+   state.current_speech_start = pushArray(arena, config_count, s32);
+   state.triggered = pushArray(arena, config_count, s32);
+   state.ended = pushArray(arena, config_count, s32);
+   state.ended_start = pushArray(arena, config_count, s32);
+   state.ended_end = pushArray(arena, config_count, s32);
+   Segment_Track *tracks = pushArray(arena, config_count, Segment_Track);
+
+   for (int k = 0; k < config_count; ++k)
+   {
+      int stride = config_count;
+      for (int param = 0; param < VADC_Sweep_Param_COUNT; ++param)
+      {
+         int value_count = sweep->value_counts[param] ? sweep->value_counts[param] : 1;
+         stride /= value_count;
+         config_values[k * VADC_Sweep_Param_COUNT + param] = sweep_config_value(sweep, (VADC_Sweep_Param)param, (k / stride) % value_count);
+      }
+
+      // NOTE: the same rounding as run_inference_on_backend
+      const float *values = config_values + k * VADC_Sweep_Param_COUNT;
+      s32 min_silence_chunks = (s32)(values[VADC_Sweep_Param_MinSilence] / chunk_duration_ms + 0.5f);
+      s32 min_speech_chunks = (s32)(values[VADC_Sweep_Param_MinSpeech] / chunk_duration_ms + 0.5f);
+      state.threshold[k] = values[VADC_Sweep_Param_Threshold];
+      state.neg_threshold[k] = state.threshold[k] - values[VADC_Sweep_Param_NegThresholdRelative];
+      state.min_silence_chunks[k] = min_silence_chunks < 1 ? 1 : min_silence_chunks;
+      state.min_speech_chunks[k] = min_speech_chunks < 1 ? 1 : min_speech_chunks;
+   }
+
+   const size_t buffered_samples_count = run_buffers.buffered_samples_count;
+   Buffered_Stream read_stream = {0};
+   if (filename.size)
+   {
+      init_buffered_stream_ffmpeg(arena, &read_stream, filename, sizeof(short) * buffered_samples_count,
+                                  options->audio_source, options->start_seconds);
+   }
+   else
+   {
+      init_buffered_stream_stdin(arena, &read_stream, sizeof(short) * buffered_samples_count);
+   }
+
+   int global_chunk_index = 0;
+   s64 inference_ns = 0;
+   s64 segmentation_ns = 0;
+   for (;;)
+   {
+      BS_Error read_error_code = read_stream.refill( &read_stream );
+      if (read_error_code != BS_Error_NoError)
+      {
+         break;
+      }
+
+      size_t values_read = (read_stream.end - read_stream.start) / sizeof(short);
+      const short *samples = (const short *)read_stream.start;
+      for (size_t i = 0; i < values_read; ++i)
+      {
+         run_buffers.samples_float32[i] = samples[i] / 32768.0f;
+      }
+      for (size_t i = values_read; i < buffered_samples_count; ++i)
+      {
+         run_buffers.samples_float32[i] = 0.0f;
+      }
+      read_stream.cursor = read_stream.end;
+
+      s64 inference_start_ns = vadc_now_ns();
+      run_chunks(arena, context, config, values_read, run_buffers.samples_float32, run_buffers.probabilities);
+      s64 segmentation_start_ns = vadc_now_ns();
+
+      int probabilities_count = (int)(values_read / (float)config.input_count);
+      for (int i = 0; i < probabilities_count; ++i)
+      {
+         if (sweep_step(&state, run_buffers.probabilities[i], global_chunk_index))
          {
-            fprintf(stderr, "📊 [%.0fms] 已处理 %d 个概率 | 总时长: %.2fs\n",
-                    elapsed_ms,
-                    probabilities_count,
-                    stats.total_duration);
-            fflush(stderr);
+            for (int k = 0; k < config_count; ++k)
+            {
+               if (!state.ended[k])
+               {
+                  continue;
+               }
+               FeedProbabilityResult feed_result = { state.ended_start[k], state.ended_end[k], 1 };
+               FeedProbabilityResult finished = {0};
+               tracks[k].buffered = combine_speech_segment(tracks[k].buffered, feed_result, config_values[k * VADC_Sweep_Param_COUNT + VADC_Sweep_Param_SpeechPad],
+                                                           seconds_per_chunk, &finished);
+               if (finished.is_valid)
+               {
+                  segment_track_push(tracks + k, finished);
+               }
+            }
          }
+         ++global_chunk_index;
       }
 
+      s64 segmentation_end_ns = vadc_now_ns();
+      inference_ns += segmentation_start_ns - inference_start_ns;
+      segmentation_ns += segmentation_end_ns - segmentation_start_ns;
    }
 
-   // TODO(irwin):
    deinit_buffered_stream_file( &read_stream );
+   int result = 0;
+   if ( read_stream.error_code != BS_Error_EndOfFile && read_stream.error_code != BS_Error_NoError )
+   {
+      result = -1;
+   }
+   if ( read_stream.pipe_exit_status != 0 )
+   {
+      result = -1;
+   }
 
-   if (!raw_probabilities)
+   const double audio_seconds = global_chunk_index * (double)seconds_per_chunk;
+   fprintf(stderr, "Swept %d configurations over %d windows (%.1fs of audio): %.3fs inference, %.3fs segmentation\n",
+           config_count, global_chunk_index, audio_seconds, inference_ns / 1e9, segmentation_ns / 1e9);
+
+   for (int k = 0; k < config_count && result == 0; ++k)
    {
-      // NOTE(irwin): snap last speech segment to actual audio length
-      if (state.triggered)
+      const float *values = config_values + k * VADC_Sweep_Param_COUNT;
+
+      VADC_Options track_options = *options;
+      track_options.speech_pad_ms = values[VADC_Sweep_Param_SpeechPad];
+      tracks[k].state.temp_end = state.temp_end[k];
+      tracks[k].state.current_speech_start = state.current_speech_start[k];
+      tracks[k].state.triggered = state.triggered[k];
+      segment_track_finish(tracks + k, &track_options, global_chunk_index, state.min_speech_chunks[k], seconds_per_chunk);
+
+      TemporaryMemory path_memory = beginTemporaryMemory(arena);
+      // NOTE: the configuration index keeps the names apart, values are only as exact as %g prints them
+      String8 file_name = String8_pushf(arena, "sweep_%04d_t%g_n%g_sil%g_sp%g_pad%g.txt", k,
+                                        values[VADC_Sweep_Param_Threshold], values[VADC_Sweep_Param_NegThresholdRelative],
+                                        values[VADC_Sweep_Param_MinSilence], values[VADC_Sweep_Param_MinSpeech],
+                                        values[VADC_Sweep_Param_SpeechPad]);
+      String8 output_path = sweep->output_dir.size ?
+                            String8_pushf(arena, "%.*s/%.*s", (int)sweep->output_dir.size, sweep->output_dir.begin, (int)file_name.size, file_name.begin) :
+                            file_name;
+      const char *output_path_c = output_path.begin;
+
+      double total_speech = 0.0;
+      FILE *output = fopen(output_path_c, "wb");
+      if (output)
       {
-         int audio_length_samples = (int)((global_chunk_index - 1) * config.input_count);
-         if (audio_length_samples - (state.current_speech_start * config.input_count) > (min_speech_duration_chunks * config.input_count))
+         for (int i = 0; i < tracks[k].segment_count; ++i)
          {
-            FeedProbabilityResult final_segment;
-            final_segment.is_valid = 1;
-            final_segment.speech_start = state.current_speech_start;
-            final_segment.speech_end = (int)(audio_length_samples / config.input_count);
-
-            buffered = combine_or_emit_speech_segment(buffered, final_segment,
-                                                         speech_pad_ms, output_format, &stats, HARDCODED_SECONDS_PER_CHUNK);
+            char line[64];
+            double speech_seconds = 0.0;
+            int line_length = format_speech_segment(line, sizeof(line), tracks[k].segments[i], values[VADC_Sweep_Param_SpeechPad],
+                                                    options->output_format, seconds_per_chunk, &speech_seconds);
+            fwrite(line, 1, (size_t)line_length, output);
+            total_speech += speech_seconds;
+         }
+         if (fclose(output) != 0)
+         {
+            result = -1;
          }
       }
-
-      if (buffered.is_valid)
+      else
       {
-         emit_speech_segment(buffered, speech_pad_ms, output_format, &stats, HARDCODED_SECONDS_PER_CHUNK);
+         fprintf(stderr, "Fatal: couldn't write %s\n", output_path_c);
+         result = -1;
       }
+
+      int segment_count = tracks[k].segment_count;
+      printf("{\"threshold\": %.4f, \"neg_threshold_relative\": %.4f, \"min_silence_ms\": %.1f, \"min_speech_ms\": %.1f, \"speech_pad_ms\": %.1f, "
+             "\"file\": \"%s\", \"segments\": %d, \"speech_seconds\": %.3f, \"speech_ratio\": %.4f, \"mean_segment_seconds\": %.3f}\n",
+             values[VADC_Sweep_Param_Threshold], values[VADC_Sweep_Param_NegThresholdRelative],
+             values[VADC_Sweep_Param_MinSilence], values[VADC_Sweep_Param_MinSpeech], values[VADC_Sweep_Param_SpeechPad],
+             output_path_c, segment_count, total_speech,
+             audio_seconds > 0.0 ? total_speech / audio_seconds : 0.0,
+             segment_count ? total_speech / segment_count : 0.0);
+      endTemporaryMemory(path_memory);
    }
+   fflush(stdout);
 
-   print_speech_stats(stats);
-   
-   if (g_verbose_logging)
+   for (int k = 0; k < config_count; ++k)
    {
-      vad_log("════════════════════════════════════════════");
-      vad_log("检测完成");
-      vad_log("  总处理时长: %.2f秒", stats.total_duration);
-      vad_log("  检测到语音事件: %d", g_current_speech_event);
-      if (g_save_audio)
-      {
-         vad_log("  ✓ 音频已保存");
-      }
-      vad_log("════════════════════════════════════════════");
+      free(tracks[k].segments);
    }
 
-   cleanup_audio_logging();
+   backend_release_tensors(backend);
+   backend_release(backend);
 
-   // g_ort->ReleaseValue(output_tensor);
-   // g_ort->ReleaseValue(input_tensor);
-   // return ret;
-   return 0;
+   return result;
 }
 
-static inline void print_speech_stats(VADC_Stats stats)
+static inline void print_speech_stats(VADC_Run *run, const VADC_Stats *stats)
 {
 #if 0
    VAR_UNUSED(stats);
@@ -1318,18 +4412,18 @@ static inline void print_speech_stats(VADC_Stats stats)
    clock_gettime(CLOCK_MONOTONIC, &current);
    s64 current_timestamp = current.tv_sec * 1000000000LL + current.tv_nsec;
 
-   double total_speech = stats.total_speech;
-   double total_duration = stats.total_duration;
+   double total_speech = stats->total_speech;
+   double total_duration = stats->total_duration;
    // double total_non_speech = total_duration - total_speech;
 
    double total_speech_percent = total_speech / total_duration * 100.0;
 
-   s64 ticks = current_timestamp - stats.first_call_timestamp;
+   s64 ticks = current_timestamp - stats->first_call_timestamp;
 
    // ticks / freq = how many ticks in 1s
    // samples in 1s = usually 16k (sample_rate global)
    // samples / 16k * freq
-   s64 ticks_worth_total_processed = stats.total_samples * stats.timer_frequency;
+   s64 ticks_worth_total_processed = stats->total_samples * stats->timer_frequency;
    s64 ratio = ticks_worth_total_processed / ticks;
    double ratio_seconds = ratio / (double)HARDCODED_SAMPLE_RATE;
 
@@ -1338,9 +4432,9 @@ static inline void print_speech_stats(VADC_Stats stats)
    int seconds = (int)(total_duration - hours * 3600.0 - minutes * 60.0);
    int milliseconds = (int)((total_duration - hours * 3600.0 - minutes * 60.0 - seconds) * 1000.0);
 
-   if (stats.output_enabled)
+   if (stats->output_enabled)
    {
-      vad_log("time=%02d:%02d:%02d.%04d | speech=%.2fs (%.1f%%) | total=%.1fs | speed=%.1fx",
+      vad_log(run, "time=%02d:%02d:%02d.%04d | speech=%.2fs (%.1f%%) | total=%.1fs | speed=%.1fx",
               hours, minutes, seconds, milliseconds,
               total_speech,
               total_speech_percent,
@@ -1381,6 +4475,53 @@ enum ArgOptionIndex
    ArgOptionIndex_SaveSpeechAudio,
    ArgOptionIndex_SaveNoiseAudio,
    ArgOptionIndex_Verbose,
+   ArgOptionIndex_Jobs,
+   ArgOptionIndex_FileList,
+   ArgOptionIndex_OutputDir,
+   ArgOptionIndex_Bench,
+   ArgOptionIndex_BenchBatch,
+   ArgOptionIndex_BenchSequence,
+   ArgOptionIndex_BenchSeconds,
+   ArgOptionIndex_BenchInput,
+   ArgOptionIndex_StatsJson,
+   ArgOptionIndex_Metrics,
+   ArgOptionIndex_MetricsInterval,
+   ArgOptionIndex_ArenaSize,
+   ArgOptionIndex_ArenaBytes,
+   ArgOptionIndex_Crossval,
+   ArgOptionIndex_CWeights,
+   ArgOptionIndex_CrossvalTolerance,
+   ArgOptionIndex_ZonesOut,
+   ArgOptionIndex_ModelCache,
+   ArgOptionIndex_Gate,
+   ArgOptionIndex_GateMarginDb,
+   ArgOptionIndex_GateHangover,
+   ArgOptionIndex_GateRewarm,
+   ArgOptionIndex_GateLstm,
+   ArgOptionIndex_GateDecay,
+   ArgOptionIndex_GateDrift,
+   ArgOptionIndex_Cascade,
+   ArgOptionIndex_CascadeThreshold,
+   ArgOptionIndex_Sweep,
+   ArgOptionIndex_SweepThreshold,
+   ArgOptionIndex_SweepNegThresholdRelative,
+   ArgOptionIndex_SweepMinSilence,
+   ArgOptionIndex_SweepMinSpeech,
+   ArgOptionIndex_SweepSpeechPad,
+   ArgOptionIndex_ProbCache,
+   ArgOptionIndex_Events,
+   ArgOptionIndex_EventsProvisional,
+   ArgOptionIndex_OutputFormat,
+   ArgOptionIndex_OutputFlushMs,
+   ArgOptionIndex_Live,
+   ArgOptionIndex_ExtractSpeech,
+   ArgOptionIndex_ExtractLookbehind,
+   ArgOptionIndex_AudioOverflow,
+   ArgOptionIndex_LogLevel,
+   ArgOptionIndex_LogRate,
+   ArgOptionIndex_Checkpoint,
+   ArgOptionIndex_CheckpointInterval,
+   ArgOptionIndex_Resume,
 
    ArgOptionIndex_COUNT
 };
@@ -1404,8 +4545,181 @@ ArgOption options[] = {
    {String8FromLiteral("--save_speech_audio"),        0.0f  },
    {String8FromLiteral("--save_noise_audio"),         0.0f  },
    {String8FromLiteral("--verbose"),                  0.0f  },
+   {String8FromLiteral("--jobs"),                     0.0f  },
+   {String8FromLiteral("--file_list"),                0.0f  },
+   {String8FromLiteral("--output_dir"),               0.0f  },
+   {String8FromLiteral("--bench"),                    0.0f  },
+   {String8FromLiteral("--bench_batch"),              0.0f  },
+   {String8FromLiteral("--bench_sequence"),           0.0f  },
+   {String8FromLiteral("--bench_seconds"),           60.0f  },
+   {String8FromLiteral("--bench_input"),              0.0f  },
+   {String8FromLiteral("--stats_json"),               0.0f  },
+   {String8FromLiteral("--metrics"),                  0.0f  },
+   {String8FromLiteral("--metrics_interval_ms"),   1000.0f  },
+   {String8FromLiteral("--arena_size"),               0.0f  },
+   {String8FromLiteral("--arena_bytes"),              0.0f  },
+   {String8FromLiteral("--crossval"),                 0.0f  },
+   {String8FromLiteral("--c_weights"),                0.0f  },
+   {String8FromLiteral("--crossval_tolerance"),       0.0f  },
+   {String8FromLiteral("--zones_out"),                0.0f  },
+   {String8FromLiteral("--model_cache"),              0.0f  },
+   {String8FromLiteral("--gate"),                     0.0f  },
+   {String8FromLiteral("--gate_margin_db"),           6.0f  },
+   {String8FromLiteral("--gate_hangover"),            3.0f  },
+   {String8FromLiteral("--gate_rewarm"),              0.0f  },
+   {String8FromLiteral("--gate_lstm"),                0.0f  },
+   {String8FromLiteral("--gate_decay"),               0.9f  },
+   {String8FromLiteral("--gate_drift"),               0.0f  },
+   {String8FromLiteral("--cascade"),                  0.0f  },
+   {String8FromLiteral("--cascade_threshold"),        0.2f  },
+   {String8FromLiteral("--sweep"),                    0.0f  },
+   {String8FromLiteral("--sweep_threshold"),          0.0f  },
+   {String8FromLiteral("--sweep_neg_threshold_relative"), 0.0f },
+   {String8FromLiteral("--sweep_min_silence"),        0.0f  },
+   {String8FromLiteral("--sweep_min_speech"),         0.0f  },
+   {String8FromLiteral("--sweep_speech_pad"),         0.0f  },
+   {String8FromLiteral("--prob_cache"),               0.0f  },
+   {String8FromLiteral("--events"),                   0.0f  },
+   {String8FromLiteral("--events_provisional"),       0.0f  },
+   {String8FromLiteral("--output_format"),            0.0f  },
+   {String8FromLiteral("--output_flush_ms"),        250.0f  },
+   {String8FromLiteral("--live"),                     0.0f  },
+   {String8FromLiteral("--extract_speech"),           0.0f  },
+   {String8FromLiteral("--extract_lookbehind"),      30.0f  },
+   {String8FromLiteral("--audio_overflow"),           0.0f  },
+   {String8FromLiteral("--log_level"),                0.0f  },
+   {String8FromLiteral("--log_rate"),                 0.0f  },
+   {String8FromLiteral("--checkpoint"),               0.0f  },
+   {String8FromLiteral("--checkpoint_interval"),     30.0f  },
+   {String8FromLiteral("--resume"),                   0.0f  },
 };
 
+// NOTE: "1,4,16" -> {1, 4, 16}, at most max_count values, non-positive ones skipped
+static int parse_int_list(const char *list, s32 *values, int max_count)
+{
+   int count = 0;
+   const char *cursor = list;
+   while (*cursor && count < max_count)
+   {
+      char *end = NULL;
+      long value = strtol(cursor, &end, 10);
+      if (end == cursor)
+      {
+         ++cursor;
+         continue;
+      }
+      if (value > 0)
+      {
+         values[count++] = (s32)value;
+      }
+      cursor = end;
+   }
+   return count;
+}
+
+
+// NOTE: "0.3,0.5" -> {0.3, 0.5}, at most max_count values, negative ones skipped
+static int parse_float_list(const char *list, float *values, int max_count)
+{
+   int count = 0;
+   const char *cursor = list;
+   while (*cursor && count < max_count)
+   {
+      char *end = NULL;
+      float value = strtof(cursor, &end);
+      if (end == cursor)
+      {
+         ++cursor;
+         continue;
+      }
+      if (value >= 0.0f)
+      {
+         values[count++] = value;
+      }
+      cursor = end;
+   }
+   return count;
+}
+
+// NOTE: one path per line, empty lines skipped. The list can be far larger than the main arena, so it
+//       lives in malloc'ed memory for the rest of the process. Returns the path count or -1.
+static int read_file_list(const char *list_path, String8 **out_filenames)
+{
+   FILE *list_file = fopen(list_path, "rb");
+   if (!list_file)
+   {
+      return -1;
+   }
+
+   fseek(list_file, 0, SEEK_END);
+   long list_size = ftell(list_file);
+   fseek(list_file, 0, SEEK_SET);
+   if (list_size < 0)
+   {
+      fclose(list_file);
+      return -1;
+   }
+
+   char *list_data = malloc((size_t)list_size + 1);
+   if (!list_data)
+   {
+      fclose(list_file);
+      return -1;
+   }
+   size_t bytes_read = fread(list_data, 1, (size_t)list_size, list_file);
+   fclose(list_file);
+   list_data[bytes_read] = '\0';
+
+   int line_count = 1;
+   for (size_t i = 0; i < bytes_read; ++i)
+   {
+      if (list_data[i] == '\n')
+      {
+         ++line_count;
+      }
+   }
+
+   String8 *filenames = malloc(sizeof(String8) * line_count);
+   if (!filenames)
+   {
+      free(list_data);
+      return -1;
+   }
+
+   int file_count = 0;
+   char *line = list_data;
+   char *data_end = list_data + bytes_read;
+   while (line < data_end)
+   {
+      char *line_end = line;
+      while (line_end < data_end && *line_end != '\n')
+      {
+         ++line_end;
+      }
+      char *next_line = line_end + 1;
+
+      while (line_end > line && (line_end[-1] == '\r' || line_end[-1] == ' '))
+      {
+         --line_end;
+      }
+      *line_end = '\0';
+
+      if (line_end > line)
+      {
+         filenames[file_count++] = String8FromPointerSize((const s8 *)line, line_end - line);
+      }
+      line = next_line;
+   }
+
+   *out_filenames = filenames;
+   return file_count;
+}
+
+static void request_stats_dump(int signal_number)
+{
+   VAR_UNUSED(signal_number);
+   vadc_stats_dump_requested = 1;
+}
 
 int main(int argc, char **argv)
 {
@@ -1431,6 +4745,16 @@ int main(int argc, char **argv)
    /* Initialize command line argument processing */
    set_command_line_args(argc, argv);
 
+   // NOTE: kill -USR1 <pid> dumps the stage latency histograms of the running stream.
+   //       SA_RESTART so a blocking read of the input isn't cut short by it.
+   {
+      struct sigaction action = {0};
+      action.sa_handler = request_stats_dump;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+      sigaction(SIGUSR1, &action, NULL);
+   }
+
    float min_silence_duration_ms;
    float min_speech_duration_ms;
    float threshold;
@@ -1448,10 +4772,33 @@ int main(int argc, char **argv)
    const char *speech_audio_file = NULL;
    const char *noise_audio_file = NULL;
 
+   const char *file_list_path = NULL;
+   String8 output_dir = {0};
+
+   const char *bench_batch_list = "1,4,16,96";
+   const char *bench_sequence_list = "512,1024,1536";
+   const char *bench_input_path = NULL;
+   const char *stats_json_path = NULL;
+   const char *metrics_target = NULL;
+   const char *arena_bytes_arg = NULL;
+   const char *c_weights_path = NULL;
+   const char *gate_lstm_arg = NULL;
+   const char *cascade_arg = NULL;
+   const char *output_format_arg = NULL;
+   const char *extract_speech_path = NULL;
+   const char *audio_overflow_arg = NULL;
+   const char *log_level_arg = NULL;
+   const char *checkpoint_path = NULL;
+   VADC_Sweep_Options sweep = {0};
+
    b32 raw_probabilities = 0;
 
    int arg_count_u8 = 0;
    String8 *arg_array_u8 = get_command_line_as_utf8(arena, &arg_count_u8);
+
+   // NOTE: every positional argument, more than one means batch mode
+   String8 *input_filenames = pushArray(arena, arg_count_u8, String8);
+   int input_file_count = 0;
    for (int arg_index = 1; arg_index < arg_count_u8; ++arg_index)
    {
       String8 arg_string = arg_array_u8[arg_index];
@@ -1470,12 +4817,46 @@ int main(int argc, char **argv)
             if (arg_option_index == ArgOptionIndex_RawProbabilities ||
                 arg_option_index == ArgOptionIndex_Stats ||
                 arg_option_index == ArgOptionIndex_OutputFormatCentiSeconds ||
-                arg_option_index == ArgOptionIndex_Verbose)
+                arg_option_index == ArgOptionIndex_Verbose ||
+                arg_option_index == ArgOptionIndex_Bench ||
+                arg_option_index == ArgOptionIndex_ArenaSize ||
+                arg_option_index == ArgOptionIndex_Crossval ||
+                arg_option_index == ArgOptionIndex_Gate ||
+                arg_option_index == ArgOptionIndex_GateDrift ||
+                arg_option_index == ArgOptionIndex_Sweep ||
+                arg_option_index == ArgOptionIndex_Events ||
+                arg_option_index == ArgOptionIndex_EventsProvisional ||
+                arg_option_index == ArgOptionIndex_Live ||
+                arg_option_index == ArgOptionIndex_Resume)
             {
                // TODO(irwin): bool options
                option->value = 1.0f;
             }
             else if ( arg_option_index == ArgOptionIndex_Model ||
+                     arg_option_index == ArgOptionIndex_FileList ||
+                     arg_option_index == ArgOptionIndex_OutputDir ||
+                     arg_option_index == ArgOptionIndex_BenchBatch ||
+                     arg_option_index == ArgOptionIndex_BenchSequence ||
+                     arg_option_index == ArgOptionIndex_BenchInput ||
+                     arg_option_index == ArgOptionIndex_StatsJson ||
+                     arg_option_index == ArgOptionIndex_Metrics ||
+                     arg_option_index == ArgOptionIndex_ArenaBytes ||
+                     arg_option_index == ArgOptionIndex_CWeights ||
+                     arg_option_index == ArgOptionIndex_ZonesOut ||
+                     arg_option_index == ArgOptionIndex_ModelCache ||
+                     arg_option_index == ArgOptionIndex_ProbCache ||
+                     arg_option_index == ArgOptionIndex_GateLstm ||
+                     arg_option_index == ArgOptionIndex_Cascade ||
+                     arg_option_index == ArgOptionIndex_OutputFormat ||
+                     arg_option_index == ArgOptionIndex_ExtractSpeech ||
+                     arg_option_index == ArgOptionIndex_AudioOverflow ||
+                     arg_option_index == ArgOptionIndex_LogLevel ||
+                     arg_option_index == ArgOptionIndex_Checkpoint ||
+                     arg_option_index == ArgOptionIndex_SweepThreshold ||
+                     arg_option_index == ArgOptionIndex_SweepNegThresholdRelative ||
+                     arg_option_index == ArgOptionIndex_SweepMinSilence ||
+                     arg_option_index == ArgOptionIndex_SweepMinSpeech ||
+                     arg_option_index == ArgOptionIndex_SweepSpeechPad ||
                      arg_option_index == ArgOptionIndex_SaveAudio ||
                      arg_option_index == ArgOptionIndex_SaveLog ||
                      arg_option_index == ArgOptionIndex_SaveSpeechAudio ||
@@ -1490,6 +4871,92 @@ int main(int argc, char **argv)
                   {
                      model_path_arg = arg_value_string;
                   }
+                  else if (arg_option_index == ArgOptionIndex_FileList)
+                  {
+                     file_list_path = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_OutputDir)
+                  {
+                     output_dir = arg_value_string;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_BenchBatch)
+                  {
+                     bench_batch_list = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_BenchSequence)
+                  {
+                     bench_sequence_list = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_BenchInput)
+                  {
+                     bench_input_path = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_StatsJson)
+                  {
+                     stats_json_path = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_Metrics)
+                  {
+                     metrics_target = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_ArenaBytes)
+                  {
+                     arena_bytes_arg = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_CWeights)
+                  {
+                     c_weights_path = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_ModelCache)
+                  {
+                     backend_set_model_cache_dir(String8ToCString(arena, arg_value_string).begin);
+                  }
+                  else if (arg_option_index == ArgOptionIndex_ProbCache)
+                  {
+                     vadc_prob_cache_set_dir(String8ToCString(arena, arg_value_string).begin);
+                  }
+                  else if (arg_option_index == ArgOptionIndex_GateLstm)
+                  {
+                     gate_lstm_arg = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_Cascade)
+                  {
+                     cascade_arg = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_OutputFormat)
+                  {
+                     output_format_arg = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_ExtractSpeech)
+                  {
+                     extract_speech_path = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_AudioOverflow)
+                  {
+                     audio_overflow_arg = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_LogLevel)
+                  {
+                     log_level_arg = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index == ArgOptionIndex_Checkpoint)
+                  {
+                     checkpoint_path = String8ToCString(arena, arg_value_string).begin;
+                  }
+                  else if (arg_option_index >= ArgOptionIndex_SweepThreshold && arg_option_index <= ArgOptionIndex_SweepSpeechPad)
+                  {
+                     // NOTE: the sweep options are in VADC_Sweep_Param order
+                     int param = arg_option_index - ArgOptionIndex_SweepThreshold;
+                     sweep.value_counts[param] = parse_float_list(String8ToCString(arena, arg_value_string).begin, sweep.values[param], VADC_SWEEP_MAX_VALUES);
+                  }
+                  else if (arg_option_index == ArgOptionIndex_ZonesOut)
+                  {
+#if defined(VADC_ZONES) && VADC_ZONES && !defined(TRACY_ENABLE)
+                     vadc_zones_set_output(String8ToCString(arena, arg_value_string).begin);
+#else
+                     fprintf(stderr, "Warning: --zones_out needs a build with -DVADC_ZONES=ON, ignored\n");
+#endif
+                  }
                   else if (arg_option_index == ArgOptionIndex_SaveAudio)
                   {
                      const char *cstr = String8ToCString(arena, arg_value_string).begin;
@@ -1548,6 +5015,7 @@ int main(int argc, char **argv)
          {
             // TODO(irwin): trim quotes?
             input_filename = arg_string;
+            input_filenames[input_file_count++] = arg_string;
          }
       }
    }
@@ -1562,11 +5030,281 @@ int main(int argc, char **argv)
    {
       output_format = Segment_Output_Format_CentiSeconds;
    }
+   if (output_format_arg)
+   {
+      output_format = segment_output_format_from_string(output_format_arg);
+      if (output_format == Segment_Output_Format_COUNT)
+      {
+         fprintf(stderr, "Fatal: --output_format must be seconds, centi, ndjson, f32 or u8, got %s\n", output_format_arg);
+         return 1;
+      }
+      if (output_format == Segment_Output_Format_U8 && !raw_probabilities)
+      {
+         fprintf(stderr, "Fatal: --output_format u8 is only for --raw_probabilities\n");
+         return 1;
+      }
+   }
+   float output_flush_ms = options[ArgOptionIndex_OutputFlushMs].value;
+   b32 output_live = (options[ArgOptionIndex_Live].value != 0.0f);
+   // NOTE: a live stream can't wait for the disk, a file can, and then nothing is lost
+   VADC_Audio_Sink_Overflow audio_overflow = (output_live || !input_filename.size) ? VADC_Audio_Sink_Overflow_Drop : VADC_Audio_Sink_Overflow_Block;
+   if (audio_overflow_arg)
+   {
+      audio_overflow = vadc_audio_sink_overflow_from_string(audio_overflow_arg);
+      if (audio_overflow == VADC_Audio_Sink_Overflow_COUNT)
+      {
+         fprintf(stderr, "Fatal: --audio_overflow must be block or drop, got %s\n", audio_overflow_arg);
+         return 1;
+      }
+   }
    b32 stats_output_enabled = (options[ArgOptionIndex_Stats].value != 0.0f);
    b32 verbose_logging = (options[ArgOptionIndex_Verbose].value != 0.0f);
 
+   // NOTE: --verbose logs everything unless --log_level says otherwise
+   VADC_Log_Level log_level = verbose_logging ? VADC_Log_Debug : VADC_Log_Info;
+   if (log_level_arg)
+   {
+      log_level = vadc_log_level_from_string(log_level_arg);
+      if (log_level == VADC_Log_COUNT)
+      {
+         fprintf(stderr, "Fatal: --log_level must be error, warn, info or debug, got %s\n", log_level_arg);
+         return 1;
+      }
+   }
+   vadc_log_set_level(log_level);
+
+   b32 resume = (options[ArgOptionIndex_Resume].value != 0.0f);
+   if (resume && !checkpoint_path)
+   {
+      fprintf(stderr, "Fatal: --resume needs --checkpoint <path>\n");
+      return 1;
+   }
+   if (checkpoint_path && !input_filename.size)
+   {
+      fprintf(stderr, "Fatal: --checkpoint needs an input file, stdin can't be read again\n");
+      return 1;
+   }
+   vadc_log_set_rate((int)options[ArgOptionIndex_LogRate].value);
+
+   // NOTE: --events_provisional implies --events
+   VADC_Event_Mode events_mode = VADC_Event_Mode_Off;
+   if (options[ArgOptionIndex_EventsProvisional].value != 0.0f)
+   {
+      events_mode = VADC_Event_Mode_Provisional;
+   }
+   else if (options[ArgOptionIndex_Events].value != 0.0f)
+   {
+      events_mode = VADC_Event_Mode_Confirmed;
+   }
+
    neg_threshold           = threshold - neg_threshold_relative;
 
+   // NOTE: --gate_drift and --cascade imply --gate, the cascade is the gate with another first stage
+   VADC_Gate_Options gate_options =
+   {
+      .enabled = (options[ArgOptionIndex_Gate].value != 0.0f || options[ArgOptionIndex_GateDrift].value != 0.0f || cascade_arg),
+      .margin_db = options[ArgOptionIndex_GateMarginDb].value,
+      .absolute_floor_dbfs = -60.0f,
+      .noise_zcr = 0.25f,
+      .hangover_windows = (int)options[ArgOptionIndex_GateHangover].value,
+      .lstm_policy = VADC_Gate_Lstm_Hold,
+      .decay = options[ArgOptionIndex_GateDecay].value,
+      .rewarm_windows = (int)options[ArgOptionIndex_GateRewarm].value,
+      .measure_drift = (options[ArgOptionIndex_GateDrift].value != 0.0f),
+      .candidate_threshold = options[ArgOptionIndex_CascadeThreshold].value,
+      .c_weights_path = c_weights_path,
+   };
+   if (cascade_arg)
+   {
+      gate_options.stage = vadc_gate_stage_from_string(cascade_arg);
+      if (gate_options.stage == VADC_Gate_Stage_COUNT)
+      {
+         fprintf(stderr, "Fatal: --cascade must be energy or c, got %s\n", cascade_arg);
+         return 1;
+      }
+      // NOTE: a cascade primes the model with the audio before a candidate unless told otherwise
+      if (gate_options.rewarm_windows == 0)
+      {
+         gate_options.rewarm_windows = VADC_CASCADE_DEFAULT_LOOKBACK_WINDOWS;
+      }
+   }
+   if (gate_lstm_arg)
+   {
+      gate_options.lstm_policy = vadc_gate_lstm_from_string(gate_lstm_arg);
+      if (gate_options.lstm_policy == VADC_Gate_Lstm_COUNT)
+      {
+         fprintf(stderr, "Fatal: --gate_lstm must be hold, reset or decay, got %s\n", gate_lstm_arg);
+         return 1;
+      }
+   }
+
+   size_t required_arena_bytes = 0;
+
+   if (options[ArgOptionIndex_Bench].value != 0.0f)
+   {
+      VADC_Options run_options =
+      {
+         .min_silence_duration_ms = min_silence_duration_ms,
+         .min_speech_duration_ms = min_speech_duration_ms,
+         .threshold = threshold,
+         .neg_threshold = neg_threshold,
+         .speech_pad_ms = speech_pad_ms,
+         .output_format = output_format,
+      };
+
+      VADC_Bench_Options bench = {0};
+      bench.batch_size_count = parse_int_list(bench_batch_list, bench.batch_sizes, VADC_BENCH_MAX_SWEEP);
+      bench.sequence_count_count = parse_int_list(bench_sequence_list, bench.sequence_counts, VADC_BENCH_MAX_SWEEP);
+      bench.input_path = bench_input_path;
+      bench.synthetic_seconds = options[ArgOptionIndex_BenchSeconds].value;
+      bench.c_weights_path = c_weights_path;
+      bench.options = &run_options;
+
+      if (bench.batch_size_count == 0 || bench.sequence_count_count == 0)
+      {
+         fprintf(stderr, "Fatal: --bench_batch and --bench_sequence need at least one positive value\n");
+         return 1;
+      }
+
+      return run_benchmark(model_path_arg, arena, &bench) == 0 ? 0 : 1;
+   }
+
+   if (options[ArgOptionIndex_Crossval].value != 0.0f)
+   {
+      VADC_Options run_options =
+      {
+         .min_silence_duration_ms = min_silence_duration_ms,
+         .min_speech_duration_ms = min_speech_duration_ms,
+         .threshold = threshold,
+         .neg_threshold = neg_threshold,
+         .speech_pad_ms = speech_pad_ms,
+         .output_format = output_format,
+         .audio_source = (int)options[ArgOptionIndex_AudioSource].value,
+         .start_seconds = options[ArgOptionIndex_StartSeconds].value,
+      };
+
+      VADC_Crossval_Report report;
+      if (run_crossval(model_path_arg, arena, c_weights_path, &run_options, input_filename, &report) != 0)
+      {
+         return 1;
+      }
+      print_crossval_report(&report, model_path_arg, c_weights_path ? c_weights_path : VADC_CROSSVAL_DEFAULT_C_WEIGHTS);
+
+      // NOTE: --crossval_tolerance makes it a regression check, e.g. after changing a kernel of the C backend
+      float tolerance = options[ArgOptionIndex_CrossvalTolerance].value;
+      if (tolerance > 0.0f)
+      {
+         b32 failed = (report.max_abs_diff > tolerance);
+         failed |= (report.unmatched_segments[VADC_Crossval_Backend_Onnx] != 0);
+         failed |= (report.unmatched_segments[VADC_Crossval_Backend_C] != 0);
+         if (failed)
+         {
+            fprintf(stderr, "FAIL: backends differ beyond --crossval_tolerance %g\n", tolerance);
+            return 1;
+         }
+      }
+      return 0;
+   }
+
+   if (options[ArgOptionIndex_Sweep].value != 0.0f)
+   {
+      VADC_Options run_options =
+      {
+         .min_silence_duration_ms = min_silence_duration_ms,
+         .min_speech_duration_ms = min_speech_duration_ms,
+         .threshold = threshold,
+         .neg_threshold = neg_threshold,
+         .speech_pad_ms = speech_pad_ms,
+         .output_format = output_format,
+         .audio_source = (int)options[ArgOptionIndex_AudioSource].value,
+         .start_seconds = options[ArgOptionIndex_StartSeconds].value,
+      };
+
+      sweep.preferred_batch_size = (s32)options[ArgOptionIndex_Batch].value;
+      sweep.desired_sequence_count = options[ArgOptionIndex_SequenceCount].value;
+      sweep.output_dir = output_dir;
+      sweep.options = &run_options;
+      return run_sweep(model_path_arg, arena, &sweep, input_filename) == 0 ? 0 : 1;
+   }
+
+   if (options[ArgOptionIndex_ArenaSize].value != 0.0f || (arena_bytes_arg && strcmp(arena_bytes_arg, "auto") == 0))
+   {
+      required_arena_bytes = arena_bytes_required(model_path_arg,
+                                                  (int)options[ArgOptionIndex_Batch].value,
+                                                  options[ArgOptionIndex_SequenceCount].value,
+                                                  &gate_options,
+                                                  input_filename,
+                                                  (int)options[ArgOptionIndex_AudioSource].value,
+                                                  options[ArgOptionIndex_StartSeconds].value);
+      if (required_arena_bytes == 0)
+      {
+         fprintf(stderr, "Fatal: couldn't size the arena, the model or the cascade's first stage didn't load\n");
+         return 1;
+      }
+
+      if (options[ArgOptionIndex_ArenaSize].value != 0.0f)
+      {
+         printf("%zu\n", required_arena_bytes);
+         return 0;
+      }
+   }
+
+   VADC_Options run_options =
+   {
+      .min_silence_duration_ms = min_silence_duration_ms,
+      .min_speech_duration_ms = min_speech_duration_ms,
+      .threshold = threshold,
+      .neg_threshold = neg_threshold,
+      .speech_pad_ms = speech_pad_ms,
+      .raw_probabilities = raw_probabilities,
+      .output_format = output_format,
+      .stats_output_enabled = stats_output_enabled,
+      .audio_source = (int)options[ArgOptionIndex_AudioSource].value,
+      .start_seconds = options[ArgOptionIndex_StartSeconds].value,
+      .gate = gate_options,
+      .events = events_mode,
+      .output_flush_ms = output_flush_ms,
+      .output_live = output_live,
+   };
+
+   int jobs = (int)options[ArgOptionIndex_Jobs].value;
+   if (jobs > 0 || file_list_path || input_file_count > 1)
+   {
+      if (extract_speech_path)
+      {
+         fprintf(stderr, "Fatal: --extract_speech is for single-file runs\n");
+         return 1;
+      }
+      if (checkpoint_path)
+      {
+         fprintf(stderr, "Fatal: --checkpoint is for single-file runs\n");
+         return 1;
+      }
+
+      String8 *filenames = input_filenames;
+      int file_count = input_file_count;
+      if (file_list_path)
+      {
+         file_count = read_file_list(file_list_path, &filenames);
+         if (file_count < 0)
+         {
+            fprintf(stderr, "Fatal: couldn't read file list %s\n", file_list_path);
+            return 1;
+         }
+      }
+
+      int failed_count = run_inference_many(model_path_arg,
+                                            arena,
+                                            &run_options,
+                                            options[ArgOptionIndex_SequenceCount].value,
+                                            (int)options[ArgOptionIndex_Batch].value,
+                                            filenames,
+                                            file_count,
+                                            output_dir,
+                                            jobs);
+      return failed_count == 0 ? 0 : 1;
+   }
+
    // 打印参数摘要到 stderr
    fprintf(stderr, "\n════════════════════════════════════════════\n");
    fprintf(stderr, "📋 程序参数配置:\n");
@@ -1595,35 +5333,80 @@ int main(int argc, char **argv)
 //       fwprintf( stderr, L"%s", model_path_arg );
 //    }
 
+   // NOTE: a failed run, e.g. ffmpeg failing or a checkpoint of another job, exits 1 so a wrapper
+   //       that resumes it can tell
+   int run_result = 0;
    {
 
       // verify_input_output_count(session);
 
-      run_inference( model_path_arg,
-                    arena,
-                    min_silence_duration_ms,
-                    min_speech_duration_ms,
-                    threshold,
-                    neg_threshold,
-                    speech_pad_ms,
-                    options[ArgOptionIndex_SequenceCount].value,
-                    raw_probabilities,
-                    output_format,
-                    input_filename,
-                    stats_output_enabled,
-                    (int)options[ArgOptionIndex_Batch].value,
-                    (int)options[ArgOptionIndex_AudioSource].value,
-                    options[ArgOptionIndex_StartSeconds].value,
-                    audio_output_file,
-                    log_output_file,
-                    speech_audio_file,
-                    noise_audio_file,
-                    verbose_logging);
+      // NOTE: --arena_bytes gives the run an arena of its own of exactly that size, "auto" the size
+      //       arena_bytes_required measured above
+      MemoryArena run_arena = {0};
+      MemoryArena *inference_arena = arena;
+      if (arena_bytes_arg)
+      {
+         size_t run_arena_size = required_arena_bytes ? required_arena_bytes : strtoull(arena_bytes_arg, NULL, 10);
+         u8 *run_memory = run_arena_size ? malloc(run_arena_size) : NULL;
+         if (!run_memory)
+         {
+            fprintf(stderr, "Fatal: couldn't allocate a %zu byte arena\n", run_arena_size);
+            return 1;
+         }
+         initializeMemoryArena(&run_arena, run_memory, run_arena_size);
+         inference_arena = &run_arena;
+      }
+
+      // NOTE: lives as long as the run, the exporter thread reads it until stop returns
+      VADC_Metrics metrics;
+      VADC_Metrics *run_metrics = NULL;
+      if (metrics_target)
+      {
+         vadc_metrics_init(&metrics, HARDCODED_SAMPLE_RATE);
+         if (vadc_metrics_start_exporter(&metrics, metrics_target, (int)options[ArgOptionIndex_MetricsInterval].value) == 0)
+         {
+            run_metrics = &metrics;
+         }
+         else
+         {
+            fprintf(stderr, "Warning: couldn't export metrics to %s\n", metrics_target);
+         }
+      }
 
+      // NOTE: the settings only a single-file run has
+      run_options.stats_json_path = stats_json_path;
+      run_options.extract_speech_path = extract_speech_path;
+      run_options.extract_lookbehind_s = options[ArgOptionIndex_ExtractLookbehind].value;
+      run_options.checkpoint_path = checkpoint_path;
+      run_options.checkpoint_interval_s = options[ArgOptionIndex_CheckpointInterval].value;
+      run_options.resume = resume;
+      run_options.audio_overflow = audio_overflow;
+
+      run_result = run_inference( model_path_arg,
+                                  inference_arena,
+                                  &run_options,
+                                  options[ArgOptionIndex_SequenceCount].value,
+                                  (int)options[ArgOptionIndex_Batch].value,
+                                  input_filename,
+                                  audio_output_file,
+                                  log_output_file,
+                                  speech_audio_file,
+                                  noise_audio_file,
+                                  verbose_logging,
+                                  run_metrics );
+
+      if (run_metrics)
+      {
+         vadc_metrics_stop_exporter(run_metrics);
+      }
+      if (run_arena.base)
+      {
+         free(run_arena.base);
+      }
    }
 
 
-   return 0;
+   return run_result == 0 ? 0 : 1;
 }
 
 /*
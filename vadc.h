@@ -2,11 +2,31 @@
 #include "utils.h"
 #include "memory.h"
 #include "string8.h"
+#include "metrics.h"
+#include "energy_gate.h"
+#include "prob_cache.h"
+#include "output_writer.h"
+#include "speech_extract.h"
+#include "audio_sink.h"
+#include "logger.h"
+#include "checkpoint.h"
 
 #if !defined(ONNX_INFERENCE_ENABLED)
 #define ONNX_INFERENCE_ENABLED 1
 #endif // ONNX_INFERENCE_ENABLED
 
+// NOTE: where the time between starting a run and its first probability goes
+typedef enum VADC_Startup_Stage
+{
+   VADC_Startup_Env = 0,            // NOTE: onnxruntime api, env and session options
+   VADC_Startup_ModelHash,          // NOTE: hashing the model file for the model cache
+   VADC_Startup_Session,            // NOTE: CreateSession, i.e. loading and optimizing the graph
+   VADC_Startup_Metadata,           // NOTE: probing the model's inputs/outputs, or reading them from the cache
+   VADC_Startup_FirstProbability,   // NOTE: from backend_init to the first probability of the run
+
+   VADC_Startup_COUNT
+} VADC_Startup_Stage;
+
 typedef struct Silero_Config Silero_Config;
 struct Silero_Config
 {
@@ -15,6 +35,9 @@ struct Silero_Config
 
    s32 batch_size_restriction;
    s32 batch_size;
+   // NOTE: batch dimension of the sample input as the model declares it, -1 if dynamic. The CLI
+   //       narrows batch_size_restriction to 1 for such models when their lstm state batch is dynamic too.
+   s32 input_batch_size;
 
    // NOTE(irwin): v5 only, 32 or 64
    s32 context_size;
@@ -39,7 +62,20 @@ struct Silero_Config
    // s32 output_dims;
 
    s32 lstm_hidden_size;
+   // NOTE: batch dimension of the lstm state inputs, -1 if dynamic. Only models with a dynamic
+   //       state batch can run independent streams side by side in one batch.
+   s32 lstm_batch_size;
    b32 is_silero_v5;
+
+   // NOTE: filled by backend_init
+   s64 startup_ns[VADC_Startup_COUNT];
+   b32 metadata_from_cache;
+   b32 optimized_model_from_cache;
+
+   // NOTE: hash of the model file for the probability cache and the checkpoint key, 0 when neither
+   //       is used. Set model_file_hash_wanted before backend_init to have it without the cache.
+   u64 model_file_hash;
+   b32 model_file_hash_wanted;
 };
 
 typedef struct Tensor_Buffers Tensor_Buffers;
@@ -74,6 +110,7 @@ struct VADC_Context
 #endif // ONNX_INFERENCE_ENABLED
 
 #include <stdio.h>
+#include <signal.h>
 
 #define SILERO_FILENAME_V3_B_DYNAMIC L"silero_restored_v3.1_16k_v3_dyn.onnx"
 #define SILERO_FILENAME_V4 L"silero_vad_v4.onnx"
@@ -121,6 +158,37 @@ typedef struct FeedProbabilityResult
    b32 is_valid;
 } FeedProbabilityResult;
 
+// NOTE: log-bucketed (HDR-style) latency histogram. Values below VADC_HISTOGRAM_SUB_BUCKETS ns get a
+//       bucket each, above that every power of two is split into VADC_HISTOGRAM_SUB_BUCKETS linear
+//       buckets, so any recorded value is off by at most 1/8 of itself. The last bucket also takes
+//       everything above ~34 minutes.
+#define VADC_HISTOGRAM_SUB_BUCKET_BITS 3
+#define VADC_HISTOGRAM_SUB_BUCKETS (1 << VADC_HISTOGRAM_SUB_BUCKET_BITS)
+#define VADC_HISTOGRAM_BUCKETS (39 * VADC_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct VADC_Histogram VADC_Histogram;
+struct VADC_Histogram
+{
+   u64 counts[VADC_HISTOGRAM_BUCKETS];
+   u64 count;
+   u64 total_ns;
+   u64 min_ns;
+   u64 max_ns;
+};
+
+typedef enum VADC_Stage
+{
+   VADC_Stage_InputWait = 0,     // NOTE: blocked reading ffmpeg's pipe or stdin
+   VADC_Stage_Conversion,        // NOTE: int16 -> float
+   VADC_Stage_Inference,         // NOTE: process_chunks, i.e. the backend
+   VADC_Stage_Emission,          // NOTE: feed_probability, segment merging and output
+
+   VADC_Stage_COUNT
+} VADC_Stage;
+
+void vadc_histogram_record( VADC_Histogram *histogram, s64 value_ns );
+u64 vadc_histogram_percentile( const VADC_Histogram *histogram, double percentile );
+
 typedef struct VADC_Stats VADC_Stats;
 struct VADC_Stats
 {
@@ -133,43 +201,339 @@ struct VADC_Stats
    s64 total_samples;
 
    b32 output_enabled;
+
+   VADC_Histogram stage_latency[VADC_Stage_COUNT];
+
+   // NOTE: arena bytes of the run. Model is what loading it took (0 when the backend was loaded
+   //       elsewhere), setup the tensor, sample and read buffers, stage the most scratch one stage
+   //       pushed on top of that. peak is the high water mark above where the run started.
+   size_t arena_model_bytes;
+   size_t arena_setup_bytes;
+   size_t stage_arena_bytes[VADC_Stage_COUNT];
+   size_t arena_peak_bytes;
+   int arena_peak_temp_depth;
+
+   // NOTE: 0 for stages the backend doesn't have, see VADC_Startup_Stage
+   s64 startup_ns[VADC_Startup_COUNT];
+   b32 metadata_from_cache;
+   b32 optimized_model_from_cache;
+
+   // NOTE: --prob_cache, whether the probabilities came from the cache or were stored in it
+   b32 prob_cache_enabled;
+   b32 prob_cache_hit;
+   b32 prob_cache_stored;
+
+   // NOTE: energy gate, windows it saw and skipped, model calls it let through and warm-up replays
+   b32 gate_enabled;
+   VADC_Gate_Stage gate_stage;
+   s64 gate_windows;
+   s64 gate_skipped_windows;
+   s64 gate_model_calls;
+   s64 gate_warmup_calls;
+   // NOTE: --cascade c, calls of the C engine and the time they took
+   s64 gate_first_stage_calls;
+   s64 gate_first_stage_ns;
+   // NOTE: --gate_drift, index 0 the gated segments, 1 the ungated ones
+   b32 gate_drift_measured;
+   int gate_drift_segments[2];
+   int gate_drift_unmatched[2];
+   double gate_drift_max_boundary_s;
+   double gate_drift_max_abs_diff;
+
+   // NOTE: --events, confirmed starts and ends and how long after the boundary they were decided, in
+   //       audio time. first_start_wall_ns is from the start of the run to writing the first start.
+   b32 events_enabled;
+   s64 event_starts;
+   s64 event_ends;
+   double event_first_start_latency_s;
+   double event_start_latency_total_s;
+   double event_end_latency_total_s;
+   s64 event_first_start_wall_ns;
+
+   // NOTE: --extract_speech, samples written and samples of segments that had left the ring already
+   b32 extract_enabled;
+   s64 extract_written_samples;
+   s64 extract_lost_samples;
+};
+
+typedef enum VADC_Event_Mode
+{
+   VADC_Event_Mode_Off = 0,
+   VADC_Event_Mode_Confirmed,       // NOTE: speech_start and speech_end only
+   VADC_Event_Mode_Provisional,     // NOTE: also the provisional events and their retractions
+
+   VADC_Event_Mode_COUNT
+} VADC_Event_Mode;
+
+// NOTE: output files, pipes and logging state of one run_inference call. Lives on the caller's
+//       stack instead of in globals so independent runs can go on in parallel threads.
+typedef struct VADC_Run VADC_Run;
+struct VADC_Run
+{
+   // NOTE: segments or raw probabilities, stdout for the CLI
+   FILE *segments_output;
+
+   FILE *audio_output_file;
+   FILE *log_file;
+   FILE *speech_audio_file;
+   FILE *noise_audio_file;
+   FILE *speech_playback_pipe;
+   FILE *noise_playback_pipe;
+   b32 save_audio;
+   b32 save_speech_audio;
+   b32 save_noise_audio;
+   b32 play_speech_audio;
+   b32 play_noise_audio;
+   b32 verbose_logging;
+   // NOTE: no per-run progress chatter on stderr, for batch runs over many files
+   b32 quiet;
+   int current_speech_event;
+   // NOTE: arena bytes backend_init took, for the stats of the run
+   size_t arena_model_bytes;
+   // NOTE: when backend_init started, the time to first probability counts from here. 0 when the
+   //       backend was loaded elsewhere, then it counts from the start of the run.
+   s64 backend_init_start_ns;
+   // NOTE: live counters for the metrics exporter, NULL when not exporting
+   VADC_Metrics *metrics;
+   // NOTE: --events, the event stream replaces the segment lines on segments_output
+   VADC_Event_Mode events;
+   // NOTE: everything for segments_output goes through here, set up by run_inference_on_backend
+   VADC_Output_Writer output;
+   // NOTE: --extract_speech, NULL when off
+   VADC_Speech_Extractor *extract;
+   // NOTE: the audio files and playback pipes, written by an I/O thread
+   VADC_Audio_Sinks audio_sinks;
 };
 
 typedef enum Segment_Output_Format
 {
    Segment_Output_Format_Seconds = 0,
    Segment_Output_Format_CentiSeconds, // NOTE(irwin): hundredths of seconds, 500 -> 5 seconds
+   Segment_Output_Format_Ndjson,       // NOTE: {"start": 1.25, "end": 2.5} per segment, {"time": 0.032, "p": 0.1} per probability
+   Segment_Output_Format_Float32,      // NOTE: packed native float32, start and end seconds per segment, or the probabilities
+   Segment_Output_Format_U8,           // NOTE: probabilities only, one byte each, p * 255 rounded
 
    Segment_Output_Format_COUNT
 } Segment_Output_Format;
 
 
+// NOTE: segmentation and input settings of one run, everything run_inference takes that
+//       isn't the model, the output files or the backend config
+typedef struct VADC_Options VADC_Options;
+struct VADC_Options
+{
+   float min_silence_duration_ms;
+   float min_speech_duration_ms;
+   float threshold;
+   float neg_threshold;
+   float speech_pad_ms;
+   b32 raw_probabilities;
+   Segment_Output_Format output_format;
+   b32 stats_output_enabled;
+   // NOTE: where the stage latency JSON goes at exit and on SIGUSR1, NULL for stderr (only with --stats)
+   const char *stats_json_path;
+   int audio_source;
+   float start_seconds;
+   VADC_Gate_Options gate;
+   VADC_Event_Mode events;
+   // NOTE: how often buffered output is flushed (0 for VADC_OUTPUT_WRITER_DEFAULT_FLUSH_MS), and whether
+   //       every write is flushed right away. stdin runs are always live.
+   float output_flush_ms;
+   b32 output_live;
+   // NOTE: where the speech of the final segments goes, .wav or raw s16le, NULL for none. The ring
+   //       holds extract_lookbehind_s seconds of samples.
+   const char *extract_speech_path;
+   float extract_lookbehind_s;
+   // NOTE: the stream state is written to checkpoint_path every checkpoint_interval_s seconds of wall
+   //       time, and with resume the run goes on from there. Only for file runs without the gate, audio
+   //       outputs or extraction. The key holds config.model_file_hash, see model_file_hash_wanted.
+   const char *checkpoint_path;
+   float checkpoint_interval_s;
+   b32 resume;
+   // NOTE: what the audio outputs of run_inference do when their I/O thread falls behind
+   VADC_Audio_Sink_Overflow audio_overflow;
+};
+
+// NOTE: one input through the model at model_path_arg, segments to stdout. The audio and log files
+//       are NULL for none, metrics NULL for no counters. Returns 0 on success.
 int run_inference( String8 model_path_arg,
+                   MemoryArena *arena,
+                   const VADC_Options *options,
+                   float desired_sequence_count,
+                   s32 preferred_batch_size,
+                   String8 filename,
+                   const char *audio_output_file,
+                   const char *log_output_file,
+                   const char *speech_audio_file,
+                   const char *noise_audio_file,
+                   b32 verbose_logging,
+                   VADC_Metrics *metrics );
+
+// NOTE: the part of run_inference after the model is loaded. backend must not be used by another
+//       run at the same time, see backend_clone. Returns 0 on success.
+int run_inference_on_backend( VADC_Run *run,
+                              MemoryArena *arena,
+                              void *backend,
+                              Silero_Config config,
+                              const VADC_Options *options,
+                              String8 filename );
+
+// NOTE: dry run of run_inference: loads the model into a scratch arena and makes every allocation a
+//       run with these settings makes, including one inference call on silence. Returns the exact
+//       arena bytes such a run needs, 0 if the model couldn't be loaded. An empty filename sizes a
+//       stdin run, a file run also holds its ffmpeg command line. gate (NULL for none) adds what the
+//       gate's run takes: the cascade's first stage, the warm-up buffers and the --gate_drift copy.
+size_t arena_bytes_required( String8 model_path_arg,
+                             s32 preferred_batch_size,
+                             float desired_sequence_count,
+                             const VADC_Gate_Options *gate,
+                             String8 filename,
+                             int audio_source,
+                             float start_seconds );
+
+// NOTE: runs every file in filenames through one loaded model with jobs worker threads. Each file's
+//       segments go to <output_dir>/<file name>.txt, or <file>.txt next to it if output_dir is empty.
+//       Returns the number of files that failed, or -1 if the model couldn't be loaded or two files
+//       have the same name and output_dir would have them write the same output.
+int run_inference_many( String8 model_path_arg,
+                        MemoryArena *arena,
+                        const VADC_Options *options,
+                        float desired_sequence_count,
+                        s32 preferred_batch_size,
+                        String8 *filenames,
+                        int file_count,
+                        String8 output_dir,
+                        int jobs );
+
+// NOTE: settings of the --bench mode. Every batch size is paired with every sequence count.
+#define VADC_BENCH_MAX_SWEEP 16
+typedef struct VADC_Bench_Options VADC_Bench_Options;
+struct VADC_Bench_Options
+{
+   s32 batch_sizes[VADC_BENCH_MAX_SWEEP];
+   int batch_size_count;
+   s32 sequence_counts[VADC_BENCH_MAX_SWEEP];
+   int sequence_count_count;
+
+   // NOTE: raw s16le 16kHz mono samples to feed, or NULL for a synthetic signal of synthetic_seconds
+   const char *input_path;
+   float synthetic_seconds;
+
+   // NOTE: weights of the pure C engine, benchmarked after the model in the onnxruntime build. NULL for
+   //       VADC_CROSSVAL_DEFAULT_C_WEIGHTS, skipped if they can't be loaded.
+   const char *c_weights_path;
+
+   // NOTE: segmentation settings, so the feed_probability state machine runs as it would for real
+   const VADC_Options *options;
+};
+
+// NOTE: end-to-end throughput benchmark. Feeds an in-memory buffer through process_chunks/process_chunks_v5
+//       for every batch size/sequence count pair, without ffmpeg and without segment output, and prints a
+//       JSON report to stdout. Returns 0 on success.
+int run_benchmark( String8 model_path_arg,
+                   MemoryArena *arena,
+                   const VADC_Bench_Options *bench );
+
+// NOTE: v3.1 16k weights in the layout silero_weights_init expects, relative to the working directory
+#define VADC_CROSSVAL_DEFAULT_C_WEIGHTS "testdata/silero_v31_16k.testtensor"
+
+// NOTE: --cascade without --gate_rewarm, windows of audio replayed to prime the model before a candidate
+#define VADC_CASCADE_DEFAULT_LOOKBACK_WINDOWS 4
+
+typedef enum VADC_Crossval_Backend
+{
+   VADC_Crossval_Backend_Onnx = 0,
+   VADC_Crossval_Backend_C,
+
+   VADC_Crossval_Backend_COUNT
+} VADC_Crossval_Backend;
+
+// NOTE: how far the onnx and the C backend were apart on one stream, see run_crossval
+typedef struct VADC_Crossval_Report VADC_Crossval_Report;
+struct VADC_Crossval_Report
+{
+   s64 windows;
+   double audio_seconds;
+   double max_abs_diff;
+   double mean_abs_diff;
+   // NOTE: window with the largest difference
+   s64 max_abs_diff_window;
+   // NOTE: windows where one probability is above the threshold and the other isn't
+   s64 threshold_disagreements;
+   // NOTE: windows where one backend's segmenter is in speech and the other's isn't
+   s64 speech_state_disagreements;
+   int segments[VADC_Crossval_Backend_COUNT];
+   // NOTE: segments that overlap no segment of the other backend
+   int unmatched_segments[VADC_Crossval_Backend_COUNT];
+   // NOTE: largest start or end difference between overlapping segments
+   double max_boundary_diff_s;
+   double inference_seconds[VADC_Crossval_Backend_COUNT];
+};
+
+// NOTE: runs the onnx backend (model_path_arg, must be a v3 model) and the pure C backend (weights from
+//       c_weights_path, a .testtensor file) in lockstep on the same stream, window by window, each with
+//       its own lstm and segmenter state. Only in onnxruntime builds. Returns 0 on success.
+int run_crossval( String8 model_path_arg,
                   MemoryArena *arena,
-                  float min_silence_duration_ms,
-                  float min_speech_duration_ms,
-                  float threshold,
-                  float neg_threshold,
-                  float speech_pad_ms,
-                  float desired_sequence_count,
-                  b32 raw_probabilities,
-                  Segment_Output_Format output_format,
+                  const char *c_weights_path,
+                  const VADC_Options *options,
                   String8 filename,
-                  b32 stats_output_enabled,
-                  s32 preferred_batch_size,
-                  int audio_source,
-                  float start_seconds,
-                  const char *audio_output_file,
-                  const char *log_output_file,
-                  const char *speech_audio_file,
-                  const char *noise_audio_file,
-                  b32 verbose_logging );
+                  VADC_Crossval_Report *report );
+
+typedef enum VADC_Sweep_Param
+{
+   VADC_Sweep_Param_Threshold = 0,
+   VADC_Sweep_Param_NegThresholdRelative,
+   VADC_Sweep_Param_MinSilence,
+   VADC_Sweep_Param_MinSpeech,
+   VADC_Sweep_Param_SpeechPad,
+
+   VADC_Sweep_Param_COUNT
+} VADC_Sweep_Param;
+
+#define VADC_SWEEP_MAX_VALUES 16
+#define VADC_SWEEP_MAX_CONFIGS 4096
+
+// NOTE: every combination of the values given per parameter. A parameter without values keeps the
+//       one in options, which also has the output format.
+typedef struct VADC_Sweep_Options VADC_Sweep_Options;
+struct VADC_Sweep_Options
+{
+   float values[VADC_Sweep_Param_COUNT][VADC_SWEEP_MAX_VALUES];
+   int value_counts[VADC_Sweep_Param_COUNT];
+
+   s32 preferred_batch_size;
+   float desired_sequence_count;
+   // NOTE: where the per-configuration segment files go, the current directory if empty
+   String8 output_dir;
+
+   const VADC_Options *options;
+};
+
+// NOTE: runs the model over the stream once and segments its probabilities with every configuration of
+//       the sweep at the same time. Writes one segment file per configuration and prints a JSON summary
+//       line per configuration to stdout. Returns 0 on success.
+int run_sweep( String8 model_path_arg,
+               MemoryArena *arena,
+               const VADC_Sweep_Options *sweep,
+               String8 filename );
+
+// NOTE: derives the run-time parts of the config (context size, output stride, batch size,
+//       probability tensor shape, sequence count) from what the backend reported in backend_init
+void silero_config_finalize( Silero_Config *config,
+                             s32 preferred_batch_size,
+                             float desired_sequence_count );
 
 void process_chunks( MemoryArena *arena, VADC_Context context, Silero_Config config,
                     const size_t buffered_samples_count,
                     const float *samples_buffer_float32,
                     float *probabilities_buffer );
 
+void process_chunks_v5( MemoryArena *arena, VADC_Context context, Silero_Config config,
+                        const size_t buffered_samples_count,
+                        const float *samples_buffer_float32,
+                        float *probabilities_buffer );
+
 
 FeedProbabilityResult feed_probability( FeedState *state,
                                        int min_silence_duration_chunks,
@@ -179,19 +543,99 @@ FeedProbabilityResult feed_probability( FeedState *state,
                                        float neg_threshold,
                                        int global_chunk_index );
 
-void emit_speech_segment( FeedProbabilityResult segment,
+// NOTE: true if a segment starting at next_speech_start would be merged into buffered once both are padded
+b32 speech_segments_touch( FeedProbabilityResult buffered,
+                           int next_speech_start,
+                           float speech_pad_ms,
+                           float seconds_per_chunk );
+
+// NOTE: merges feed_result into buffered if they touch, otherwise returns feed_result as the new buffered
+//       segment and hands the previous one back in *finished. No output, combine_or_emit_speech_segment
+//       is the printing wrapper around it.
+FeedProbabilityResult combine_speech_segment( FeedProbabilityResult buffered,
+                                              FeedProbabilityResult feed_result,
+                                              float speech_pad_ms,
+                                              float seconds_per_chunk,
+                                              FeedProbabilityResult *finished );
+
+void emit_speech_segment( VADC_Run *run,
+                          FeedProbabilityResult segment,
                          float speech_pad_ms,
                          Segment_Output_Format output_format,
                          VADC_Stats *stats,
                          float seconds_per_chunk );
 
-FeedProbabilityResult combine_or_emit_speech_segment( FeedProbabilityResult buffered,
+FeedProbabilityResult combine_or_emit_speech_segment( VADC_Run *run,
+                                                     FeedProbabilityResult buffered,
                                                      FeedProbabilityResult feed_result,
                                                      float speech_pad_ms,
                                                      Segment_Output_Format output_format,
                                                      VADC_Stats *stats,
                                                      float seconds_per_chunk );
 
+// NOTE: endpoint events, for consumers that act on speech while it's still going on. Segments only come
+//       out once min_silence has confirmed their end (and later still if padding merges them with the
+//       next one); a speech_start comes out as soon as the running speech is long enough that
+//       feed_probability can't drop it any more, a speech_end as soon as feed_probability confirms it.
+//       Events are never merged, two segments that padding would join are two start/end pairs.
+typedef enum VADC_Event_Type
+{
+   VADC_Event_SpeechStart = 0,
+   VADC_Event_SpeechEnd,
+   VADC_Event_ProvisionalStart,     // NOTE: first window at or above threshold, may still be too short
+   VADC_Event_ProvisionalEnd,       // NOTE: first window below neg_threshold after a speech_start
+   VADC_Event_StartRetracted,       // NOTE: the provisional start ended shorter than min_speech
+   VADC_Event_EndRetracted,         // NOTE: speech resumed before min_silence was reached
+
+   VADC_Event_COUNT
+} VADC_Event_Type;
+
+// NOTE: a window can produce a provisional start, a speech_start and a provisional end at most
+#define VADC_EVENTS_PER_WINDOW_MAX 3
+
+typedef struct VADC_Event VADC_Event;
+struct VADC_Event
+{
+   VADC_Event_Type type;
+   // NOTE: the boundary, unpadded, in windows
+   int chunk;
+   // NOTE: windows seen when the event was decided, the decision latency is decided_chunks - chunk
+   int decided_chunks;
+};
+
+typedef struct VADC_Event_Tracker VADC_Event_Tracker;
+struct VADC_Event_Tracker
+{
+   b32 provisional;
+   int min_speech_duration_chunks;
+   // NOTE: the FeedState after the previous window
+   FeedState previous;
+   b32 start_emitted;
+};
+
+// NOTE: call after every feed_probability with the state and result it left. Writes the events of the
+//       window to events (VADC_EVENTS_PER_WINDOW_MAX at most) and returns how many.
+int vadc_event_tracker_feed( VADC_Event_Tracker *tracker,
+                             const FeedState *state,
+                             FeedProbabilityResult feed_result,
+                             int global_chunk_index,
+                             VADC_Event *events );
+
+// NOTE: end of the stream, closes speech still running at speech_end. Speech too short for a segment
+//       is retracted, except a started one, every speech_start gets its speech_end.
+int vadc_event_tracker_finish( VADC_Event_Tracker *tracker,
+                               int speech_end,
+                               int chunk_count,
+                               VADC_Event *events );
+
+const char *vadc_event_type_name( VADC_Event_Type type );
+
+// NOTE: time of the event padded like the segments are, starts earlier and ends later
+float vadc_event_seconds( VADC_Event event, float speech_pad_ms, float seconds_per_chunk );
+
 // NOTE(irwin): onnx helper routines
 
-static inline void print_speech_stats(VADC_Stats stats);
+static inline void print_speech_stats(VADC_Run *run, const VADC_Stats *stats);
+
+// NOTE: set from a SIGUSR1 handler; the running inference loop writes its stage latency JSON and clears it
+extern volatile sig_atomic_t vadc_stats_dump_requested;
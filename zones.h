@@ -0,0 +1,282 @@
+#ifndef ZONES_INCLUDE_H
+#define ZONES_INCLUDE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// NOTE: always-on zone timing for builds without Tracy (cmake -DVADC_ZONES=ON). The TracyCZone* sites
+//       become scoped timers on the cycle counter (rdtsc on x86, cntvct_el0 on arm64). Every thread
+//       aggregates count and ticks per call path in a buffer only it writes, nothing is locked or
+//       allocated per zone. At exit the paths are written as flamegraph folded stacks
+//       ("a;b;c <self nanoseconds>"), ready for flamegraph.pl or speedscope.
+
+#define VADC_ZONES_MAX_NODES 512
+#define VADC_ZONES_MAX_DEPTH 32
+
+typedef struct Vadc_Zone_Node Vadc_Zone_Node;
+struct Vadc_Zone_Node
+{
+   const char *name;
+   int parent;
+   int first_child;
+   int next_sibling;
+   // NOTE: only the owning thread stores these, the exit dump may read them while it still runs
+   atomic_ullong count;
+   atomic_ullong ticks;
+};
+
+typedef struct Vadc_Zone_Thread Vadc_Zone_Thread;
+struct Vadc_Zone_Thread
+{
+   Vadc_Zone_Thread *next;
+   atomic_int node_count;
+   int current;
+   // NOTE: zones that didn't fit in nodes, counted instead of timed
+   atomic_ullong dropped;
+   Vadc_Zone_Node nodes[VADC_ZONES_MAX_NODES];
+};
+
+typedef struct Vadc_Zone Vadc_Zone;
+struct Vadc_Zone
+{
+   int node;
+   int parent;
+   uint64_t start;
+};
+
+Vadc_Zone vadc_zone_begin( const char *name );
+void vadc_zone_end( Vadc_Zone *zone );
+
+// NOTE: writes the folded stacks to path at exit. Without a call, the VADC_ZONES_OUT environment
+//       variable is used if set, so library users get the same without code changes.
+void vadc_zones_set_output( const char *path );
+
+// NOTE: folded stacks of every thread seen so far. Returns 0 on success.
+int vadc_zones_write( const char *path );
+
+#endif // ZONES_INCLUDE_H
+
+
+#ifdef ZONES_IMPLEMENTATION
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static _Atomic(Vadc_Zone_Thread *) vadc_zones_threads;
+static _Thread_local Vadc_Zone_Thread *vadc_zones_this_thread;
+static char vadc_zones_output_path[512];
+static atomic_int vadc_zones_output_registered;
+
+// NOTE: cycle counter and wall clock when the first thread registered, to convert ticks to nanoseconds
+//       at the dump without a calibration loop at startup
+static uint64_t vadc_zones_start_ticks;
+static int64_t vadc_zones_start_ns;
+static atomic_int vadc_zones_started;
+
+static inline uint64_t vadc_zones_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#elif defined(__aarch64__)
+   uint64_t value;
+   __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+   return value;
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void vadc_zones_write_at_exit(void)
+{
+   vadc_zones_write(vadc_zones_output_path);
+}
+
+void vadc_zones_set_output(const char *path)
+{
+   if (!path || strlen(path) >= sizeof(vadc_zones_output_path))
+   {
+      return;
+   }
+   strcpy(vadc_zones_output_path, path);
+   if (atomic_exchange(&vadc_zones_output_registered, 1) == 0)
+   {
+      atexit(vadc_zones_write_at_exit);
+   }
+}
+
+static Vadc_Zone_Thread *vadc_zones_register_thread(void)
+{
+   if (atomic_exchange(&vadc_zones_started, 1) == 0)
+   {
+      vadc_zones_start_ns = vadc_now_ns();
+      vadc_zones_start_ticks = vadc_zones_ticks();
+
+      const char *env_path = getenv("VADC_ZONES_OUT");
+      if (env_path && env_path[0] && !atomic_load(&vadc_zones_output_registered))
+      {
+         vadc_zones_set_output(env_path);
+      }
+   }
+
+   // NOTE: never freed, a worker's zones have to outlive it until the dump at exit
+   Vadc_Zone_Thread *thread = calloc(1, sizeof(Vadc_Zone_Thread));
+   if (!thread)
+   {
+      return NULL;
+   }
+   thread->nodes[0].name = "root";
+   thread->nodes[0].parent = -1;
+   thread->nodes[0].first_child = -1;
+   thread->nodes[0].next_sibling = -1;
+   atomic_store(&thread->node_count, 1);
+   thread->current = 0;
+
+   Vadc_Zone_Thread *head = atomic_load(&vadc_zones_threads);
+   do
+   {
+      thread->next = head;
+   } while (!atomic_compare_exchange_weak(&vadc_zones_threads, &head, thread));
+
+   return thread;
+}
+
+static inline void vadc_zones_add(atomic_ullong *value, uint64_t amount)
+{
+   // NOTE: single writer, so a relaxed load + store is enough and compiles to a plain add
+   atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+Vadc_Zone vadc_zone_begin(const char *name)
+{
+   Vadc_Zone zone = {-1, -1, 0};
+
+   Vadc_Zone_Thread *thread = vadc_zones_this_thread;
+   if (!thread)
+   {
+      thread = vadc_zones_this_thread = vadc_zones_register_thread();
+      if (!thread)
+      {
+         return zone;
+      }
+   }
+
+   int parent = thread->current;
+   int node = thread->nodes[parent].first_child;
+   while (node >= 0 && thread->nodes[node].name != name)
+   {
+      node = thread->nodes[node].next_sibling;
+   }
+
+   if (node < 0)
+   {
+      int node_count = atomic_load_explicit(&thread->node_count, memory_order_relaxed);
+      if (node_count == VADC_ZONES_MAX_NODES)
+      {
+         vadc_zones_add(&thread->dropped, 1);
+         return zone;
+      }
+      node = node_count;
+      Vadc_Zone_Node *new_node = thread->nodes + node;
+      new_node->name = name;
+      new_node->parent = parent;
+      new_node->first_child = -1;
+      new_node->next_sibling = thread->nodes[parent].first_child;
+      thread->nodes[parent].first_child = node;
+      // NOTE: release, so the dump sees a fully linked node
+      atomic_store_explicit(&thread->node_count, node_count + 1, memory_order_release);
+   }
+
+   thread->current = node;
+   zone.node = node;
+   zone.parent = parent;
+   zone.start = vadc_zones_ticks();
+   return zone;
+}
+
+void vadc_zone_end(Vadc_Zone *zone)
+{
+   if (zone->node < 0)
+   {
+      return;
+   }
+   uint64_t end = vadc_zones_ticks();
+
+   Vadc_Zone_Thread *thread = vadc_zones_this_thread;
+   Vadc_Zone_Node *node = thread->nodes + zone->node;
+   vadc_zones_add(&node->count, 1);
+   vadc_zones_add(&node->ticks, end - zone->start);
+
+   // NOTE: back to the parent of this zone rather than of the current one, so a zone left open by an
+   //       early return only misattributes until the enclosing zone ends
+   thread->current = zone->parent;
+}
+
+int vadc_zones_write(const char *path)
+{
+   FILE *file = fopen(path, "w");
+   if (!file)
+   {
+      return -1;
+   }
+
+   double ns_per_tick = 1.0;
+   uint64_t elapsed_ticks = vadc_zones_ticks() - vadc_zones_start_ticks;
+   int64_t elapsed_ns = vadc_now_ns() - vadc_zones_start_ns;
+   if (elapsed_ticks > 0 && elapsed_ns > 0)
+   {
+      ns_per_tick = (double)elapsed_ns / (double)elapsed_ticks;
+   }
+
+   for (Vadc_Zone_Thread *thread = atomic_load(&vadc_zones_threads); thread; thread = thread->next)
+   {
+      int node_count = atomic_load_explicit(&thread->node_count, memory_order_acquire);
+      for (int node_index = 1; node_index < node_count; ++node_index)
+      {
+         Vadc_Zone_Node *node = thread->nodes + node_index;
+
+         // NOTE: folded stacks weigh each path by its self time, the inclusive time minus the children's
+         uint64_t ticks = atomic_load_explicit(&node->ticks, memory_order_relaxed);
+         uint64_t children_ticks = 0;
+         for (int child = node->first_child; child >= 0 && child < node_count; child = thread->nodes[child].next_sibling)
+         {
+            children_ticks += atomic_load_explicit(&thread->nodes[child].ticks, memory_order_relaxed);
+         }
+         uint64_t self_ticks = ticks > children_ticks ? ticks - children_ticks : 0;
+         uint64_t self_ns = (uint64_t)(self_ticks * ns_per_tick);
+         if (self_ns == 0)
+         {
+            continue;
+         }
+
+         const char *path_names[VADC_ZONES_MAX_DEPTH];
+         int depth = 0;
+         for (int parent = node_index; parent > 0 && depth < VADC_ZONES_MAX_DEPTH; parent = thread->nodes[parent].parent)
+         {
+            path_names[depth++] = thread->nodes[parent].name;
+         }
+         for (int i = depth - 1; i >= 0; --i)
+         {
+            fprintf(file, "%s%s", path_names[i], i ? ";" : " ");
+         }
+         fprintf(file, "%llu\n", (unsigned long long)self_ns);
+      }
+
+      unsigned long long dropped = atomic_load_explicit(&thread->dropped, memory_order_relaxed);
+      if (dropped)
+      {
+         fprintf(stderr, "zones: %llu zones of one thread didn't fit in %d call paths\n", dropped, VADC_ZONES_MAX_NODES);
+      }
+   }
+
+   return fclose(file) == 0 ? 0 : -1;
+}
+
+#endif // ZONES_IMPLEMENTATION